@@ -22,139 +22,49 @@ log() {
     echo "$(date '+%Y-%m-%d %H:%M:%S') - $1" >> "$LOG_FILE"
 }
 
-send_at() {
-    # Check if port is busy before trying
-    if fuser "$USB_AT" >/dev/null 2>&1; then
-        sleep 1
+run_app() {
+    # Hand the task to the resident daemon if it is up, otherwise run it directly
+    # (CAPTURE_ARGS are picture options: only capture gets them)
+    if [ -S "$DAEMON_SOCKET" ]; then
+        $APP_PATH --task ctl --socket "$DAEMON_SOCKET" --cmd "$1"
+    elif [ "$1" == "capture" ]; then
+        $APP_PATH --task "$1" $CAPTURE_ARGS
+    else
+        $APP_PATH --task "$1"
     fi
-    echo -e "$1\r" > "$USB_AT"
-    sleep 0.2
 }
 
-# --- START ROUTINE ---
-log "========================================"
-log "STARTING ROUTINE ($PROJECT_NAME)"
-
-# 0. RESTORE TIME FROM BATTERY (RTC)
-sudo hwclock -s
-log "[Time] System clock synced from RTC Battery: $(date)"
-
-# 1. TAKE PICTURE FIRST (Captures the state before we mess with the modem)
-log "[rpicam-jpeg Camera] Taking picture..."
-IMG_NAME="img_$(date '+%Y-%m-%dT%H_%M_%S').jpg"
-TODAY_DIR="$DATA_DIR/$(date +%F)"
-mkdir -p "$TODAY_DIR"
-# Capture Command
-# -t 2000: Warm up for 2s (Auto Exposure/White Balance)
-# --width 4608 --height 2592: Full Res (IMX708)
-if rpicam-jpeg -o "$TODAY_DIR/$IMG_NAME" --nopreview -t 3000; then
-    log "[Camera] Saved: $TODAY_DIR/$IMG_NAME"
-else
-    log "[Camera] ERROR: Capture failed."
-fi
-
-
-# 2. HARDWARE WAKE UP
-log "[Modem] Triggering Hardware Reset (GPIO $PIN_RST)..."
-pinctrl set $PIN_RST op
-pinctrl set $PIN_RST dh
-sleep 1
-pinctrl set $PIN_RST dl
-sleep 5 # Wait for boot
-
-# 3. DRIVER INJECTION (Critical for ID 9018)
-log "[Modem] Re-applying USB Drivers..."
-sudo modprobe option
-sudo modprobe usb_wwan
-echo 1e0e 9018 | sudo tee /sys/bus/usb-serial/drivers/option1/new_id > /dev/null 2>&1
-
-# Wait for Port
-log "[Modem] Waiting for $USB_AT..."
-for i in {1..20}; do
-    if [ -e "$USB_AT" ]; then
-        break
-    fi
-    sleep 1
-done
-
-if [ ! -e "$USB_AT" ]; then
-    log "[ERROR] Modem port not found. Aborting."
-    exit 1
-fi
-
-# 4. ENABLE RADIO & GPS
-log "[Modem] Enabling Radio (AT+CFUN=1)..."
-stty -F $USB_AT 115200 raw -echo -echoe -echok -crtscts > /dev/null 2>&1
-send_at "AT+CFUN=1"
-sleep 20 # Allow network negotiation
-
-log "[GPS] Enabling module..."
-send_at "AT+CGPS=1"
-sleep 2
-
-# 5. GET GPS FIX (Safe Mode)
-log "[GPS] Attempting fix..."
-GPS_FIX="No Fix"
-
-# Prepare the command but don't execute yet
-echo -e "AT+CGPSINFO\r" > "$USB_AT"
-
-# Read the response safely using a temporary file descriptor capture
-# We read for 2 seconds then kill the read process
-RAW=$(timeout 2s cat "$USB_AT" | grep "+CGPSINFO:")
-
-if [[ "$RAW" == *"+CGPSINFO:"* && "$RAW" != *",,,,,,"* ]]; then
-    GPS_FIX=${RAW#"+CGPSINFO: "}
-    log "[GPS] Fix Obtained: $GPS_FIX"
-else
-    log "[GPS] No Fix obtained."
-fi
-
-# Append to CSV (Permissions should be fixed now)
-echo "$(date '+%Y-%m-%d %H:%M:%S'),$GPS_FIX" >> "$DATA_DIR/gps_history.csv"
-
-
-# 5.1 TURN OFF GPS TO SAVE POWER:
-log "[GPS] Disabling module..."
-send_at "AT+CGPS=0"
-sleep 2
-
-# 6. CONNECT INTERFACE (DHCP)
-LTE_IFACE=$(ip -o link show | awk -F': ' '{print $2}' | grep -E 'usb|wwan|ppp' | head -n 1)
-if [ ! -z "$LTE_IFACE" ]; then
-    sudo ip link set "$LTE_IFACE" up
-    sudo dhclient "$LTE_IFACE" -v > /dev/null 2>&1
-    log "[Network] Interface $LTE_IFACE configured."
-fi
-
-# 7. RUN SENSORS & CAMERA
-log "[Sensors] Reading BME280..."
-$APP_PATH --task monitor_env >> "$LOG_FILE" 2>&1
-
-log "[Camera] Taking picture..."
-$APP_PATH --task capture >> "$LOG_FILE" 2>&1
-
-# 8. UPLOAD TO CLOUD
-if [ "$CLOUD_ENABLED" == "true" ]; then
-    log "[Cloud] Syncing to S3..."
-    
+rclone_upload() {
+    # The rclone copy passes (UPLOADER="rclone"), in either DAILY_MODE
     # Define Dates
     TODAY=$(date +%F)
     YESTERDAY=$(date -d "yesterday" +%F)
     
+    # In-flight writes live in hidden ".<name>.tmp" files until renamed: never upload them
+    # 0. Previews first (smallest level first): a short or flaky link still gets every
+    # picture at some resolution, the full-size copies follow in the passes below.
+    for DAY in "$YESTERDAY" "$TODAY"; do
+        if [ -d "$DATA_DIR/$DAY" ]; then
+            for LEVEL in p8 p4 p2; do
+                rclone copy "$DATA_DIR/$DAY" "$RCLONE_REMOTE:$S3_BUCKET/$DAY" \
+                    --config "$RCLONE_CONF" --transfers 4 --include "*_$LEVEL.jpg" --log-file="$LOG_FILE"
+            done
+        fi
+    done
+
     # 1. Upload YESTERDAY'S Folder (Catches the afternoon data missed by previous upload)
     # Rclone will skip files that are already there (Morning data) and just add the new ones.
     if [ -d "$DATA_DIR/$YESTERDAY" ]; then
         log "[Cloud] Syncing incomplete data from $YESTERDAY..."
         rclone copy "$DATA_DIR/$YESTERDAY" "$RCLONE_REMOTE:$S3_BUCKET/$YESTERDAY" \
-            --config "$RCLONE_CONF" --transfers 4 --log-file="$LOG_FILE"
+            --config "$RCLONE_CONF" --transfers 4 --exclude ".*.tmp" --log-file="$LOG_FILE"
     fi
 
     # 2. Upload TODAY'S Folder (Catches the morning data so far)
     if [ -d "$DATA_DIR/$TODAY" ]; then
         log "[Cloud] Syncing data from $TODAY..."
         rclone copy "$DATA_DIR/$TODAY" "$RCLONE_REMOTE:$S3_BUCKET/$TODAY" \
-            --config "$RCLONE_CONF" --transfers 4 --log-file="$LOG_FILE"
+            --config "$RCLONE_CONF" --transfers 4 --exclude ".*.tmp" --log-file="$LOG_FILE"
     fi
 
     # 3. Upload Cumulative GPS Log
@@ -168,8 +78,203 @@ if [ "$CLOUD_ENABLED" == "true" ]; then
         rclone copy "$DATA_DIR/cpu_info.csv" "$RCLONE_REMOTE:$S3_BUCKET/" \
             --config "$RCLONE_CONF" --log-file="$LOG_FILE"
     fi
-        
-    log "[Cloud] Upload complete."
+}
+
+send_at() {
+    # Check if port is busy before trying
+    if fuser "$USB_AT" >/dev/null 2>&1; then
+        sleep 1
+    fi
+    echo -e "$1\r" > "$USB_AT"
+    sleep 0.2
+}
+
+# --- START ROUTINE ---
+log "========================================"
+log "STARTING ROUTINE ($PROJECT_NAME)"
+
+# Traces of this wake cycle: every horus_app started below reads HORUS_TRACE
+if [ -n "$TRACE_DIR" ]; then
+    export HORUS_TRACE="$TRACE_DIR/"
+    find "$TRACE_DIR" -name '*.json' -mtime +"${TRACE_KEEP_DAYS:-30}" -delete 2>/dev/null
+fi
+
+# Size budget of the pictures taken below
+if [ -n "$JPEG_BUDGET_KB" ]; then CAPTURE_ARGS="$CAPTURE_ARGS --target-kb $JPEG_BUDGET_KB"; fi
+if [ -n "$ROI" ]; then CAPTURE_ARGS="$CAPTURE_ARGS --roi $ROI"; fi
+if [ -n "$SCENE_POLICY" ]; then CAPTURE_ARGS="$CAPTURE_ARGS --scene $SCENE_POLICY"; fi
+
+# 0. RESTORE TIME FROM BATTERY (RTC)
+sudo hwclock -s
+log "[Time] System clock synced from RTC Battery: $(date)"
+
+if [ "$DAILY_MODE" == "graph" ]; then
+    # 1-8 as one stage graph: picture, sensors and data work run while the modem resets,
+    # registers and searches for GNSS; the upload starts when the network is up
+    SKIP=""
+    if [ "$CLOUD_ENABLED" != "true" ] || [ "$UPLOADER" != "native" ]; then SKIP="upload"; fi
+    if [ "$BUNDLE_ENABLED" != "true" ]; then SKIP="$SKIP,bundle"; fi
+    log "[Graph] Running the daily stage graph..."
+    $APP_PATH --task daily --skip "$SKIP" $CAPTURE_ARGS --modem "$USB_AT" \
+        --rclone-conf "$RCLONE_CONF" --remote "$RCLONE_REMOTE" --bucket "$S3_BUCKET" \
+        --jobs "${UPLOAD_JOBS:-4}" >> "$LOG_FILE" 2>&1 || log "[Graph] WARNING: Some stages failed."
+
+    # The graph's upload stage is the native uploader; rclone runs once the graph is done
+    # (export_csv and bundle have run in it, and the modem is still up)
+    if [ "$CLOUD_ENABLED" == "true" ] && [ "$UPLOADER" != "native" ]; then
+        log "[Cloud] Syncing to S3 (rclone)..."
+        rclone_upload
+        log "[Cloud] Upload complete."
+    fi
+else
+    # 1. TAKE PICTURE FIRST (Captures the state before we mess with the modem)
+    log "[rpicam-jpeg Camera] Taking picture..."
+    IMG_NAME="img_$(date '+%Y-%m-%dT%H_%M_%S').jpg"
+    TODAY_DIR="$DATA_DIR/$(date +%F)"
+    mkdir -p "$TODAY_DIR"
+    # Capture Command
+    # -t 2000: Warm up for 2s (Auto Exposure/White Balance)
+    # --width 4608 --height 2592: Full Res (IMX708)
+    if rpicam-jpeg -o "$TODAY_DIR/$IMG_NAME" --nopreview -t 3000; then
+        log "[Camera] Saved: $TODAY_DIR/$IMG_NAME"
+    else
+        log "[Camera] ERROR: Capture failed."
+    fi
+
+
+    # 2. HARDWARE WAKE UP
+    log "[Modem] Triggering Hardware Reset (GPIO $PIN_RST)..."
+    pinctrl set $PIN_RST op
+    pinctrl set $PIN_RST dh
+    sleep 1
+    pinctrl set $PIN_RST dl
+    sleep 5 # Wait for boot
+
+    # 3. DRIVER INJECTION (Critical for ID 9018)
+    log "[Modem] Re-applying USB Drivers..."
+    sudo modprobe option
+    sudo modprobe usb_wwan
+    echo 1e0e 9018 | sudo tee /sys/bus/usb-serial/drivers/option1/new_id > /dev/null 2>&1
+
+    if [ "$MODEM_CONTROL" == "native" ]; then
+        # 4-5. One process per step; each returns as soon as the modem reports the event
+        # (port up, registered, position) instead of after a fixed sleep. GNSS starts with
+        # the radio, so it searches while the network registers.
+        log "[Modem] Radio on, waiting for registration..."
+        $APP_PATH --task modem_up --modem "$USB_AT" >> "$LOG_FILE" 2>&1
+        MODEM_RC=$?
+        if [ $MODEM_RC -eq 2 ]; then
+            log "[ERROR] Modem port not found or not answering. Aborting."
+            exit 1
+        elif [ $MODEM_RC -ne 0 ]; then
+            log "[Modem] WARNING: Not registered yet, carrying on."
+        fi
+
+        # Records the fix (or "No Fix") in the telemetry log and turns GNSS off
+        log "[GPS] Waiting for a fix..."
+        if $APP_PATH --task gps_fix --modem "$USB_AT" >> "$LOG_FILE" 2>&1; then
+            log "[GPS] Fix obtained."
+        else
+            log "[GPS] No Fix obtained."
+        fi
+    else
+        # Wait for Port
+        log "[Modem] Waiting for $USB_AT..."
+        for i in {1..20}; do
+            if [ -e "$USB_AT" ]; then
+                break
+            fi
+            sleep 1
+        done
+
+        if [ ! -e "$USB_AT" ]; then
+            log "[ERROR] Modem port not found. Aborting."
+            exit 1
+        fi
+
+        # 4. ENABLE RADIO & GPS
+        log "[Modem] Enabling Radio (AT+CFUN=1)..."
+        stty -F $USB_AT 115200 raw -echo -echoe -echok -crtscts > /dev/null 2>&1
+        send_at "AT+CFUN=1"
+        sleep 20 # Allow network negotiation
+
+        log "[GPS] Enabling module..."
+        send_at "AT+CGPS=1"
+        sleep 2
+
+        # 5. GET GPS FIX (Safe Mode)
+        log "[GPS] Attempting fix..."
+        GPS_FIX="No Fix"
+
+        # Prepare the command but don't execute yet
+        echo -e "AT+CGPSINFO\r" > "$USB_AT"
+
+        # Read the response safely using a temporary file descriptor capture
+        # We read for 2 seconds then kill the read process
+        RAW=$(timeout 2s cat "$USB_AT" | grep "+CGPSINFO:")
+
+        if [[ "$RAW" == *"+CGPSINFO:"* && "$RAW" != *",,,,,,"* ]]; then
+            GPS_FIX=${RAW#"+CGPSINFO: "}
+            log "[GPS] Fix Obtained: $GPS_FIX"
+        else
+            log "[GPS] No Fix obtained."
+        fi
+
+        # Log the fix (gps_history.csv is rebuilt from the telemetry log before upload)
+        $APP_PATH --task record --source gps --data "$GPS_FIX" >> "$LOG_FILE" 2>&1
+
+
+        # 5.1 TURN OFF GPS TO SAVE POWER:
+        log "[GPS] Disabling module..."
+        send_at "AT+CGPS=0"
+        sleep 2
+    fi
+
+    # 6. CONNECT INTERFACE (DHCP)
+    LTE_IFACE=$(ip -o link show | awk -F': ' '{print $2}' | grep -E 'usb|wwan|ppp' | head -n 1)
+    if [ ! -z "$LTE_IFACE" ]; then
+        sudo ip link set "$LTE_IFACE" up
+        sudo dhclient "$LTE_IFACE" -v > /dev/null 2>&1
+        log "[Network] Interface $LTE_IFACE configured."
+    fi
+
+    # 7. RUN SENSORS & CAMERA
+    log "[Sensors] Reading BME280..."
+    run_app monitor_env >> "$LOG_FILE" 2>&1
+
+    log "[Camera] Taking picture..."
+    run_app capture >> "$LOG_FILE" 2>&1
+
+    # 8. UPLOAD TO CLOUD
+    if [ "$CLOUD_ENABLED" == "true" ]; then
+        log "[Cloud] Syncing to S3..."
+
+        # The samples live in the binary telemetry log: rebuild the CSVs we upload
+        $APP_PATH --task export_csv --days 2 >> "$LOG_FILE" 2>&1
+
+        # Small files of each day in one zstd bundle; the native uploader then skips them.
+        # The first run trains the dictionary from what is on disk, later runs reuse it.
+        if [ "$BUNDLE_ENABLED" == "true" ]; then
+            TRAIN=""
+            ls "$DATA_DIR"/bundle-dict-*.zdict > /dev/null 2>&1 || TRAIN="--train-dict"
+            $APP_PATH --task bundle --days 2 $TRAIN >> "$LOG_FILE" 2>&1
+        fi
+    
+        if [ "$UPLOADER" == "native" ]; then
+            # One process: telemetry first, then previews, then full size; parts of large
+            # files in parallel; a dropped link resumes from the last stored part next time
+            if $APP_PATH --task upload --rclone-conf "$RCLONE_CONF" --remote "$RCLONE_REMOTE" \
+                    --bucket "$S3_BUCKET" --days 2 --jobs "${UPLOAD_JOBS:-4}" >> "$LOG_FILE" 2>&1; then
+                log "[Cloud] Native upload finished."
+            else
+                log "[Cloud] WARNING: Native upload incomplete, the rest resumes next run."
+            fi
+        else
+            rclone_upload
+        fi
+
+        log "[Cloud] Upload complete."
+    fi
 fi
 
 # 9. MAINTENANCE WINDOW (30 Min)
@@ -221,13 +326,17 @@ log "[Maintenance] Window CLOSED."
 # 10. SHUTDOWN & SLEEP
 log "[Modem] Entering Flight Mode (Power Save)..."
 
-# Explicitly close GPS first
-send_at "AT+CGPS=0"
-sleep 1
+if [ "$MODEM_CONTROL" == "native" ] || [ "$DAILY_MODE" == "graph" ]; then
+    $APP_PATH --task modem_down --modem "$USB_AT" >> "$LOG_FILE" 2>&1
+else
+    # Explicitly close GPS first
+    send_at "AT+CGPS=0"
+    sleep 1
 
-# Send Flight Mode command
-echo -e "AT+CFUN=0\r" > "$USB_AT"
-sleep 2
+    # Send Flight Mode command
+    echo -e "AT+CFUN=0\r" > "$USB_AT"
+    sleep 2
+fi
 
 # FIX PERMISSIONS (Crucial for 15-min logs)
 log "[Maintenance] Fixing file permissions..."
@@ -0,0 +1,51 @@
+#!/bin/bash
+# ------------------------------------------------------------------
+# HORUS DAILY STAGES
+# The hardware steps of daily_routine.sh as single commands, for the
+# stage graph of `horus_app --task daily`:  daily_stages.sh <stage>
+# Output goes to stdout (the orchestrator prefixes and logs it).
+# ------------------------------------------------------------------
+
+CONFIG_FILE="/home/horus/Horus/config/horus.conf"
+PIN_RST=6        # GPIO 6 for Hardware Reset
+[ -f "$CONFIG_FILE" ] && source "$CONFIG_FILE"
+
+rpicam_capture() {
+    # Picture before the modem draws current (same as step 1 of daily_routine.sh)
+    local dir="$DATA_DIR/$(date +%F)"
+    mkdir -p "$dir"
+    rpicam-jpeg -o "$dir/img_$(date '+%Y-%m-%dT%H_%M_%S').jpg" --nopreview -t 3000
+}
+
+modem_reset() {
+    # Reset pulse only: modem_up waits for the port itself instead of a fixed 5 s
+    pinctrl set $PIN_RST op
+    pinctrl set $PIN_RST dh
+    sleep 1
+    pinctrl set $PIN_RST dl
+}
+
+usb_drivers() {
+    # Critical for ID 9018
+    sudo modprobe option
+    sudo modprobe usb_wwan
+    echo 1e0e 9018 | sudo tee /sys/bus/usb-serial/drivers/option1/new_id > /dev/null 2>&1
+    return 0 # new_id fails harmlessly when the ID is already bound
+}
+
+lte_dhcp() {
+    local iface
+    iface=$(ip -o link show | awk -F': ' '{print $2}' | grep -E 'usb|wwan|ppp' | head -n 1)
+    if [ -z "$iface" ]; then
+        echo "No LTE interface"
+        return 1
+    fi
+    sudo ip link set "$iface" up
+    sudo dhclient "$iface" -v > /dev/null 2>&1
+    echo "Interface $iface configured."
+}
+
+case "$1" in
+    rpicam_capture|modem_reset|usb_drivers|lte_dhcp) "$1" ;;
+    *) echo "Usage: $0 rpicam_capture|modem_reset|usb_drivers|lte_dhcp"; exit 2 ;;
+esac
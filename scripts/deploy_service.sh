@@ -5,16 +5,16 @@ set -e
 PROJECT_DIR=$(pwd)
 EXEC_PATH="$PROJECT_DIR/build/horus_app"
 ROUTINE_SCRIPT="$PROJECT_DIR/daily_routine.sh"
-CPU_SCIPT="$PROJECT_DIR/monitor_cpu.sh"
 BOOT_SCRIPT="$PROJECT_DIR/boot_sleepmode.sh"
 USER_NAME=$(whoami)
+# Set USE_DAEMON=true to run horus_app resident instead of the 15-min monitor timer
+USE_DAEMON=${USE_DAEMON:-false}
 
 echo "[Horus] Starting Survival Deployment..."
 echo "  Project Dir: $PROJECT_DIR"
 echo "  Executable:  $EXEC_PATH"
 echo "  Routine:     $ROUTINE_SCRIPT"
 echo "  Boot Script: $BOOT_SCRIPT"
-echo "  CPU Monitor: $CPU_SCIPT"
 
 # Validation
 if [ ! -f "$EXEC_PATH" ]; then
@@ -26,14 +26,17 @@ if [ ! -f "$ROUTINE_SCRIPT" ]; then
     echo "Please create daily_routine.sh first!"
     exit 1
 fi
-if [ ! -f "$CPU_SCRIPT" ]; then
-    echo "ERROR: Could not find CPU script at $CPU_SCRIPT"
-    echo "Please ensure scripts/monitor_cpu.sh exists!"
-    exit 1
-fi
 
 # Ensure scripts are executable
-chmod +x "$ROUTINE_SCRIPT" "$BOOT_SCRIPT" "$CPU_SCRIPT"
+chmod +x "$ROUTINE_SCRIPT" "$BOOT_SCRIPT"
+
+# --- TELEMETRY LOG MIGRATION ---
+# Samples now go to the binary telemetry log; the first deployment carries the
+# existing CSV history over (import_csv refuses to run twice)
+if [ ! -d "/home/horus/DataCapture/telemetry" ]; then
+    echo "  -> Importing CSV history into the telemetry log..."
+    "$EXEC_PATH" --task import_csv || true
+fi
 
 # --- 0. CLEANUP OLD SERVICES ---
 # We disable the old names to prevent conflicts
@@ -102,18 +105,60 @@ Unit=horus-monitor.service
 WantedBy=timers.target
 EOF
 
+# --- 1b. RESIDENT DAEMON (Optional) ---
+# Task: daemon (keeps camera manager + BME280 open, samples every 15 min itself)
+echo "  -> Configuring Resident Daemon (USE_DAEMON=$USE_DAEMON)..."
+
+# Its capture options: the horus.conf settings daily_routine.sh gives a directly started
+# capture (tasks sent to the daemon carry only their name). Re-run after changing them.
+CONFIG_FILE="$PROJECT_DIR/config/horus.conf"
+DAEMON_ARGS="--preview 3"
+if [ -f "$CONFIG_FILE" ]; then
+    DAEMON_ARGS=$(
+        source "$CONFIG_FILE"
+        ARGS="$CAPTURE_ARGS"
+        if [ -n "$JPEG_BUDGET_KB" ]; then ARGS="$ARGS --target-kb $JPEG_BUDGET_KB"; fi
+        if [ -n "$ROI" ]; then ARGS="$ARGS --roi \"$ROI\""; fi
+        if [ -n "$SCENE_POLICY" ]; then ARGS="$ARGS --scene $SCENE_POLICY"; fi
+        echo "$ARGS"
+    )
+else
+    echo "WARNING: $CONFIG_FILE not found, the daemon captures with: $DAEMON_ARGS"
+fi
+echo "     Capture options: $DAEMON_ARGS"
+
+sudo bash -c "cat > /etc/systemd/system/horus-daemon.service" <<EOF
+[Unit]
+Description=Horus Resident Daemon (Camera + BME280 kept open)
+After=multi-user.target
+
+[Service]
+Type=simple
+ExecStart=$EXEC_PATH --task daemon --socket /tmp/horus.sock --env-interval 900 $DAEMON_ARGS
+User=$USER_NAME
+WorkingDirectory=$PROJECT_DIR
+Restart=on-failure
+RestartSec=30
+StandardOutput=journal
+StandardError=journal
+
+[Install]
+WantedBy=multi-user.target
+EOF
+
 # --- 2. CPU HEALTH MONITOR (Every 15 Minutes) ---
-# Task: monitor_cpu.sh (Temp/Volt -> CSV)
+# Task: monitor_sys (SoC temp, clock, load, memory, free space, throttling -> telemetry log)
+# Read in-process from sysfs / the firmware mailbox: no vcgencmd / date / sed forks
 echo "  -> Configuring CPU Health Monitor (15 min)..."
 
 sudo bash -c "cat > /etc/systemd/system/horus-cpu.service" <<EOF
 [Unit]
-Description=Horus CPU Health Monitor (Temp & Voltage)
+Description=Horus CPU Health Monitor (Temp, Throttling, Load, Memory, Disk)
 After=multi-user.target
 
 [Service]
 Type=oneshot
-ExecStart=$CPU_SCRIPT
+ExecStart=$EXEC_PATH --task monitor_sys
 User=$USER_NAME
 Group=$USER_NAME
 StandardOutput=journal
@@ -178,7 +223,14 @@ echo "[Horus] Enabling Boot Service..."
 sudo systemctl enable --now horus-boot.service
 
 echo "[Horus] Enabling Timers..."
-sudo systemctl enable --now horus-monitor.timer
+if [ "$USE_DAEMON" == "true" ]; then
+    # The daemon samples the BME280 itself: the timer would double the rows
+    sudo systemctl disable --now horus-monitor.timer 2>/dev/null || true
+    sudo systemctl enable --now horus-daemon.service
+else
+    sudo systemctl disable --now horus-daemon.service 2>/dev/null || true
+    sudo systemctl enable --now horus-monitor.timer
+fi
 sudo systemctl enable --now horus-cpu.timer
 sudo systemctl enable --now horus-daily.timer
 
@@ -0,0 +1,647 @@
+// Horus micro-benchmarks: timings only, the pass/fail checks live in horus_tests.
+// Everything here runs on synthetic data, so it works on any machine (no camera, no I2C:
+// the BME280 runs against the in-process register model).
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+#include <climits>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <memory>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "imaging/Frame.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "imaging/ParallelJpegEncoder.hpp"
+#include "imaging/ExposureFusion.hpp"
+#include "imaging/TemporalDenoise.hpp"
+#include "imaging/ArucoDetector.hpp"
+#include "imaging/PreviewPyramid.hpp"
+#include "imaging/JpegRateControl.hpp"
+#include "imaging/Roi.hpp"
+#include "imaging/SceneSignature.hpp"
+#include "utils/ThreadPool.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/TelemetryLog.hpp"
+#include "utils/Hash.hpp"
+#include "utils/Bundle.hpp"
+#include "utils/Trace.hpp"
+#include "sensors/BME280/bme280.hpp"
+#include "sensors/BME280/SimulatedBME280.hpp"
+#include "sensors/Modem/AtModem.hpp"
+#include "sensors/Modem/FakeModem.hpp"
+#include "sensors/Camera/MultiCapture.hpp"
+#include "sensors/Camera/FakeFrameSource.hpp"
+#include "sensors/System/SystemMonitor.hpp"
+#include "utils/MemoryBudget.hpp"
+#include "utils/TaskTimer.hpp"
+#include "utils/Args.hpp"
+#include "tests/Fixtures.hpp"
+
+// --- HELPERS ---
+
+using horus::tests::kWidth;
+using horus::tests::kHeight;
+using horus::tests::makeSyntheticBGR;
+using horus::tests::bgrView;
+using horus::tests::loadJpegBgr;
+
+template <typename F>
+static double timeMs(F&& fn, int repeats) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; ++i) fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / repeats;
+}
+
+// --- BENCHMARKS ---
+
+// Single-threaded encoder vs strip-parallel encoder on 1..N threads
+static void benchJpeg(int repeats) {
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+    horus::imaging::FrameView frame = bgrView(bgr, kWidth, kHeight);
+
+    std::vector<uint8_t> out;
+    double baseline = timeMs([&] { horus::imaging::encodeJpeg(frame, out); }, repeats);
+    std::cout << "jpeg serial      : " << baseline << " ms (" << out.size() << " bytes)" << std::endl;
+
+    unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= std::max(4u, cores); ++threads) {
+        horus::utils::ThreadPool pool(threads);
+        double ms = timeMs([&] { horus::imaging::encodeJpegParallel(frame, out, pool); }, repeats);
+        std::cout << "jpeg parallel x" << threads << " : " << ms << " ms (speedup "
+                  << baseline / ms << ", " << out.size() << " bytes)" << std::endl;
+    }
+}
+
+// Full JPEG alone vs full JPEG + 1/2, 1/4, 1/8 previews from the same pass
+static void benchPyramid(int repeats) {
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+    horus::imaging::FrameView frame = bgrView(bgr, kWidth, kHeight);
+
+    std::vector<uint8_t> full;
+    double baseline = timeMs([&] { horus::imaging::encodeJpeg(frame, full); }, repeats);
+
+    std::vector<horus::imaging::PyramidLevel> levels;
+    double combined = timeMs([&] { horus::imaging::encodePyramid(frame, 3, levels, 80, &full); }, repeats);
+    std::cout << "pyramid x3       : " << combined << " ms with the full JPEG (+"
+              << (combined - baseline) / baseline * 100.0 << "% over " << baseline << " ms)" << std::endl;
+    for (const horus::imaging::PyramidLevel& level : levels) {
+        std::cout << "  _p" << level.factor << " " << level.width << "x" << level.height << " : "
+                  << level.jpeg.size() << " bytes" << std::endl;
+    }
+}
+
+// Exposure fusion of a -2 / 0 / +2 EV bracket (synthetic: same scene scaled by 1/4, 1, 4)
+static void benchHdr(int repeats) {
+    std::vector<uint8_t> base = makeSyntheticBGR(kWidth, kHeight);
+    std::vector<std::vector<uint8_t>> bracket;
+    for (float gain : {0.25f, 1.0f, 4.0f}) {
+        std::vector<uint8_t> frame(base.size());
+        for (size_t i = 0; i < base.size(); ++i) {
+            frame[i] = static_cast<uint8_t>(std::min(255.0f, base[i] * gain));
+        }
+        bracket.push_back(std::move(frame));
+    }
+
+    std::vector<horus::imaging::FrameView> inputs;
+    for (const std::vector<uint8_t>& frame : bracket) {
+        horus::imaging::FrameView view;
+        view.width = kWidth;
+        view.height = kHeight;
+        view.planes[0] = frame.data();
+        view.strides[0] = kWidth * 3;
+        inputs.push_back(view);
+    }
+
+    horus::imaging::OwnedFrame fused;
+    double ms = timeMs([&] { horus::imaging::fuseExposures(inputs, fused); }, repeats);
+    double mpix = static_cast<double>(kWidth) * kHeight / 1e6;
+    std::cout << "hdr fusion x3    : " << ms << " ms (" << mpix * inputs.size() / (ms / 1000.0)
+              << " Mpix/s in)" << std::endl;
+}
+
+// Temporal denoise kernels: 16-bit accumulate, final average and 3-frame median
+static void benchDenoise(int repeats) {
+    const int frames = 8;
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+    horus::imaging::FrameView frame = bgrView(bgr, kWidth, kHeight);
+    const double megabytes = static_cast<double>(bgr.size()) / 1e6;
+
+    horus::imaging::FrameAccumulator accumulator;
+    double addMs = timeMs([&] {
+        accumulator.reset();
+        for (int i = 0; i < frames; ++i) accumulator.add(frame);
+    }, repeats) / frames;
+    std::cout << "denoise add      : " << addMs << " ms/frame (" << megabytes / addMs << " GB/s in)" << std::endl;
+
+    horus::imaging::OwnedFrame out;
+    double avgMs = timeMs([&] { accumulator.average(out); }, repeats);
+    std::cout << "denoise average  : " << avgMs << " ms (" << frames << " frames)" << std::endl;
+
+    std::vector<horus::imaging::FrameView> inputs(3, frame);
+    double medianMs = timeMs([&] { horus::imaging::temporalMedian(inputs, out); }, repeats);
+    std::cout << "denoise median x3: " << medianMs << " ms" << std::endl;
+}
+
+// Old stdio path (4 KB fwrite chunks) vs one atomic write
+static void benchAtomicWrite(int repeats) {
+    const std::string folder = "/tmp/horus_bench_atomic";
+    const std::string target = folder + "/img.jpg";
+    std::filesystem::create_directories(folder);
+
+    const size_t size = 4 << 20; // A typical full-res JPEG
+    std::vector<uint8_t> versions[2] = { std::vector<uint8_t>(size, 0xAA), std::vector<uint8_t>(size, 0x55) };
+
+    double stdioMs = timeMs([&] {
+        FILE* file = fopen(target.c_str(), "wb");
+        for (size_t pos = 0; pos < size; pos += 4096) fwrite(versions[0].data() + pos, 1, 4096, file);
+        fflush(file);
+        fsync(fileno(file));
+        fclose(file);
+    }, repeats);
+    std::cout << "write stdio 4K   : " << stdioMs << " ms" << std::endl;
+
+    double atomicMs = timeMs([&] {
+        horus::utils::writeFileAtomic(target, versions[0].data(), size);
+    }, repeats);
+    std::cout << "write atomic     : " << atomicMs << " ms" << std::endl;
+
+    horus::utils::removeStaleTempFiles(folder);
+}
+
+// Content hash of the file index: what writeFileAtomic() adds to every save under the
+// data root, and what a sync pays for a file the index does not know yet
+static void benchHash(int repeats) {
+    std::vector<uint8_t> frame = makeSyntheticBGR(kWidth, kHeight);
+    const size_t size = 4 << 20; // A typical full-res JPEG
+    uint64_t hash = 0;
+    double hashMs = timeMs([&] { hash ^= horus::utils::xxh64(frame.data(), size); }, repeats);
+    std::cout << "xxh64 4 MB       : " << hashMs << " ms (" << size / 1048576.0 / (hashMs / 1000.0) << " MB/s, "
+              << std::hex << hash << std::dec << ")" << std::endl;
+}
+
+// Bundle of one day, plain zstd vs zstd with a dictionary trained on the previous
+// two weeks, and the cost of reading one member back through the index. Run on the
+// CM4 for the numbers that matter; the ratios hold on any machine.
+static void benchBundle(int repeats) {
+    namespace fs = std::filesystem;
+    const std::string root = "/tmp/horus_bench_bundle";
+    fs::remove_all(root);
+
+    std::vector<std::string> samples;
+    for (int day = 0; day < 14; ++day) {
+        for (const horus::utils::BundleInput& input : horus::tests::makeBundleDay(root + "/d" + std::to_string(day), day)) {
+            samples.push_back(input.path);
+        }
+    }
+    std::vector<horus::utils::BundleInput> inputs = horus::tests::makeBundleDay(root + "/d14", 14);
+
+    std::vector<uint8_t> dict;
+    double trainMs = timeMs([&] { horus::utils::trainBundleDictionary(samples, 16 * 1024, dict); }, 1);
+    std::cout << "bundle dict      : " << dict.size() / 1024 << " KB from " << samples.size() << " files in "
+              << trainMs << " ms" << std::endl;
+
+    const std::vector<uint8_t> none;
+    const std::vector<uint8_t>* variants[] = { &none, &dict };
+    for (const std::vector<uint8_t>* d : variants) {
+        const std::string path = root + (d->empty() ? "/plain.hbn" : "/dict.hbn");
+        horus::utils::BundleStats stats;
+        double wallMs = timeMs([&] { horus::utils::writeBundle(path, inputs, *d, 19, &stats); }, repeats);
+        std::cout << (d->empty() ? "bundle plain     : " : "bundle dict      : ") << stats.files << " files, "
+                  << stats.rawBytes / 1024 << " KB -> " << stats.bundleBytes / 1024.0 << " KB (x"
+                  << static_cast<double>(stats.rawBytes) / stats.bundleBytes << "), encode " << stats.encodeMs
+                  << " ms, write " << wallMs << " ms" << std::endl;
+
+        // Random access: footer + index, then one member
+        horus::utils::BundleIndex index;
+        std::vector<uint8_t> member;
+        double readMs = timeMs([&] {
+            if (horus::utils::readBundleIndex(path, index) && !index.entries.empty()) {
+                horus::utils::readBundleMember(path, index, index.entries[index.entries.size() / 2], *d, member);
+            }
+        }, repeats);
+        std::cout << "  member read    : " << readMs << " ms (" << member.size() << " bytes)" << std::endl;
+    }
+    fs::remove_all(root);
+}
+
+// A year of telemetry (15-min env + cpu, one GPS fix a day): append, full scan,
+// one-week range query, CSV export
+static void benchTelemetry() {
+    namespace fs = std::filesystem;
+    const std::string folder = "/tmp/horus_bench_telemetry";
+    const std::string csvRoot = "/tmp/horus_bench_telemetry_csv";
+    fs::remove_all(folder);
+    fs::remove_all(csvRoot);
+
+    const int64_t start = 1767268800000LL; // 2026-01-01 12:00 UTC
+    const int64_t stepMs = 15 * 60 * 1000;
+    const int days = 365;
+
+    double appendMs = timeMs([&] {
+        horus::utils::TelemetryLog log(folder, false); // Bulk load: no fdatasync per record
+        for (int64_t t = start; t < start + days * 86400000LL; t += stepMs) {
+            horus::utils::TelemetryRecord env;
+            env.source = static_cast<uint16_t>(horus::utils::TelemetrySource::Env);
+            env.timeMs = t;
+            env.values[0] = 20.0f + (t / stepMs) % 100 * 0.1f;
+            env.values[1] = 55.5f;
+            env.values[2] = 985.25f;
+            log.append(env);
+
+            horus::utils::TelemetryRecord cpu;
+            horus::utils::parseCpuFields("52.1,0x50000", cpu);
+            cpu.timeMs = t + 1000;
+            log.append(cpu);
+
+            if ((t - start) % 86400000LL == 0) {
+                horus::utils::TelemetryRecord gps;
+                horus::utils::parseGpsFix("4503.123456,N,00740.654321,E,160126,101500.0,245.3,0.0,12.5", gps);
+                gps.timeMs = t + 2000;
+                log.append(gps);
+            }
+        }
+    }, 1);
+
+    horus::utils::TelemetryScanStats stats;
+    auto count = [](const horus::utils::TelemetryRecord&) {};
+    double scanMs = timeMs([&] {
+        horus::utils::scanTelemetry(folder, LLONG_MIN, LLONG_MAX, 0, count, &stats);
+    }, 3);
+    const size_t total = stats.records;
+    std::cout << "telemetry append : " << appendMs << " ms for " << total << " records" << std::endl;
+    std::cout << "telemetry scan   : " << scanMs << " ms (" << stats.files << " days)" << std::endl;
+
+    horus::utils::TelemetryScanStats week;
+    double weekMs = timeMs([&] {
+        horus::utils::scanTelemetry(folder, start + 100 * 86400000LL, start + 107 * 86400000LL,
+                                    static_cast<uint16_t>(horus::utils::TelemetrySource::Env), count, &week);
+    }, 3);
+    std::cout << "telemetry week   : " << weekMs << " ms (" << week.records << " env records)" << std::endl;
+
+    double exportMs = timeMs([&] { horus::utils::exportCsv(folder, csvRoot, 0); }, 1);
+    std::cout << "telemetry csv    : " << exportMs << " ms export" << std::endl;
+
+    fs::remove_all(folder);
+    fs::remove_all(csvRoot);
+}
+
+// Marker detection on the bundled field photos
+static void benchAruco(int repeats, const std::string& fixtures) {
+    const std::string names[] = { "test_1_plastic_yes_aruco", "test_2_no_plastic_yes_aruco",
+                                  "test_1_plastic_no_aruco", "test_2_no_plastic_no_aruco" };
+    const horus::imaging::MarkerDictionary dictionary = horus::imaging::builtinDictionary();
+
+    for (const std::string& name : names) {
+        horus::imaging::LumaImage luma;
+        if (!horus::imaging::loadJpegLuma(fixtures + "/" + name + ".jpg", 4, luma)) return;
+
+        std::vector<horus::imaging::MarkerDetection> markers;
+        double ms = timeMs([&] { markers = horus::imaging::detectMarkers(luma, dictionary); }, repeats);
+        std::cout << "aruco " << name << " : " << ms << " ms, " << markers.size() << " marker(s)" << std::endl;
+    }
+}
+
+// Size-budgeted encode on the fixture photos and the synthetic frame: budgets of 60 %
+// and 30 % of the q90 size, predicted vs actual size, and what the search costs next to
+// the final encode
+static void benchRateControl(const std::string& fixtures) {
+    std::vector<std::pair<std::string, horus::imaging::OwnedFrame>> images(2);
+    images[0].first = "test_1_plastic_yes_aruco";
+    images[1].first = "test_2_no_plastic_no_aruco";
+    for (auto& image : images) {
+        if (!loadJpegBgr(fixtures + "/" + image.first + ".jpg", image.second)) return;
+    }
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+
+    auto run = [&](const std::string& name, const horus::imaging::FrameView& frame) {
+        std::vector<uint8_t> out;
+        horus::imaging::encodeJpeg(frame, out);
+        const size_t reference = out.size();
+        horus::imaging::JpegOptions optimized;
+        optimized.optimizeCoding = true;
+        horus::imaging::encodeJpeg(frame, out, optimized);
+        std::cout << "rate " << name << " : q90 " << reference / 1024 << " KB, optimized Huffman "
+                  << out.size() / 1024 << " KB" << std::endl;
+
+        for (double share : { 0.6, 0.3 }) {
+            horus::imaging::RateControlOptions options;
+            options.targetBytes = static_cast<size_t>(reference * share);
+            horus::imaging::RateControlResult result;
+            horus::imaging::encodeJpegBudgeted(frame, out, options, result);
+            const double error = (static_cast<double>(result.actualBytes) / result.predictedBytes - 1.0) * 100.0;
+            std::cout << "  budget " << options.targetBytes / 1024 << " KB: q" << result.quality << ", predicted "
+                      << result.predictedBytes / 1024 << " KB, actual " << result.actualBytes / 1024 << " KB ("
+                      << error << " %), " << result.probes << " probes " << result.probeMs << " ms + encode "
+                      << result.encodeMs << " ms" << std::endl;
+        }
+    };
+    for (const auto& image : images) run(image.first, image.second.view());
+    run("synthetic", bgrView(bgr, kWidth, kHeight));
+}
+
+// Encode cost of a trunk-sized region (40% x 80% of the field) against the full frame
+static void benchRoi(int repeats) {
+    using namespace horus::imaging;
+    std::vector<Roi> rois;
+    parseRois("trunk=0.30,0.15,0.40,0.80", rois);
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+    FrameView full = bgrView(bgr, kWidth, kHeight);
+    FrameView trunk;
+    cropFrame(full, roiToPixels(rois[0], kWidth, kHeight), trunk);
+    std::vector<uint8_t> out;
+    double fullMs = timeMs([&] { encodeJpeg(full, out); }, repeats);
+    const size_t fullBytes = out.size();
+    double roiMs = timeMs([&] { encodeJpeg(trunk, out); }, repeats);
+    std::cout << "roi trunk        : " << trunk.width << "x" << trunk.height << " " << roiMs << " ms / "
+              << out.size() / 1024 << " KB vs full " << fullMs << " ms / " << fullBytes / 1024 << " KB" << std::endl;
+}
+
+// Scene signature on a bundled photo: the kernel's cost on a full-size frame (downscale
+// + histogram + DCT hash), against the encode it may save, and how far apart two days
+// of the same field are
+static void benchScene(int repeats, const std::string& fixtures) {
+    using namespace horus::imaging;
+    OwnedFrame photos[2];
+    if (!loadJpegBgr(fixtures + "/test_1_plastic_no_aruco.jpg", photos[0]) ||
+        !loadJpegBgr(fixtures + "/test_2_no_plastic_no_aruco.jpg", photos[1])) {
+        return;
+    }
+
+    SceneSignature signatures[2];
+    double signatureMs = timeMs([&] { computeSignature(photos[0].view(), signatures[0]); }, repeats);
+    std::vector<uint8_t> jpeg;
+    double encodeMs = timeMs([&] { encodeJpeg(photos[0].view(), jpeg); }, 1);
+    std::cout << "scene signature  : " << photos[0].width << "x" << photos[0].height << " " << signatureMs
+              << " ms (encode " << encodeMs << " ms)" << std::endl;
+
+    computeSignature(photos[1].view(), signatures[1]);
+    const SceneDistance days = sceneDistance(signatures[0], signatures[1]);
+    std::cout << "scene test_1 vs test_2: hash " << days.hashBits << " bits, histogram " << days.histogram
+              << ", " << sceneVerdictName(compareScenes(&signatures[0], signatures[1], SceneOptions())) << std::endl;
+}
+
+// Multi-camera capture against fake 12 MP cameras: one, two side by side (the warm-ups
+// overlap, the encodes share the pool), and two under a budget with room for one
+static void benchMultiCamera() {
+    namespace fs = std::filesystem;
+    const std::string folder = fs::temp_directory_path().string() + "/horus_bench_multicam";
+    fs::remove_all(folder);
+    fs::create_directories(folder);
+    auto pool = std::make_shared<horus::utils::ThreadPool>(0);
+    horus::CameraOptions options;
+
+    struct Run {
+        double ms;
+        size_t peak;
+    };
+    auto run = [&](int cameras, size_t budgetBytes) {
+        std::vector<std::unique_ptr<horus::FakeFrameSource>> fakes;
+        std::vector<horus::FrameSource*> sources;
+        for (int i = 0; i < cameras; ++i) {
+            horus::FakeFrameSource::Settings settings;
+            settings.name = "cam" + std::to_string(i);
+            settings.warmupMs = 800 + 100 * i;
+            fakes.push_back(std::make_unique<horus::FakeFrameSource>(settings, pool));
+            sources.push_back(fakes.back().get());
+        }
+        horus::FakeFrameSource::resetPeak();
+        horus::utils::MemoryBudget budget(budgetBytes);
+        const std::string prefix = folder + "/img_" + std::to_string(cameras) + "_" + std::to_string(budgetBytes >> 20);
+        auto start = std::chrono::steady_clock::now();
+        horus::captureAll(sources, options, prefix, ".jpg", budget);
+        return Run { std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                     horus::FakeFrameSource::peakBytes() };
+    };
+
+    const size_t perCamera = horus::FakeFrameSource(horus::FakeFrameSource::Settings()).memoryEstimate(options);
+    Run single = run(1, 1024u << 20);
+    Run pair = run(2, 1024u << 20);
+    Run tight = run(2, perCamera + perCamera / 2); // Room for one camera only
+    fs::remove_all(folder);
+
+    std::cout << "multicam         : 1 camera " << single.ms << " ms, 2 cameras " << pair.ms << " ms (peak "
+              << (pair.peak >> 20) << " MB), budget " << ((perCamera + perCamera / 2) >> 20) << " MB: "
+              << tight.ms << " ms (peak " << (tight.peak >> 20) << " MB)" << std::endl;
+}
+
+// BME280 driver against the register model, then the compensation maths on a long
+// archive of raw ADC triples: reference integer path vs batched floating-point path
+static void benchBme280(int repeats) {
+    horus::SimulatedBME280 chip;
+    horus::BME280 sensor(chip);
+    horus::BME280Data data;
+    if (!sensor.init()) return;
+    double measureMs = timeMs([&] { sensor.measure(data); }, repeats);
+    std::cout << "bme280 driver    : " << measureMs << " ms per measure (" << chip.transactions()
+              << " bus transactions)" << std::endl;
+
+    // Four years of 15-minute samples, many times over: a few million triples
+    const size_t count = 4 * 1000 * 1000;
+    std::vector<int32_t> adcT(count), adcP(count), adcH(count);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        adcT[i] = horus::SimulatedBME280::kExampleAdcT + static_cast<int32_t>(noise >> 16) % 60000 - 30000;
+        adcP[i] = horus::SimulatedBME280::kExampleAdcP + static_cast<int32_t>(noise >> 8) % 40000 - 20000;
+        adcH[i] = horus::SimulatedBME280::kExampleAdcH + static_cast<int32_t>(noise & 0xFFFF) % 8000 - 4000;
+    }
+    const horus::BME280Calibration& calib = sensor.calibration();
+
+    std::vector<float> refT(count), refP(count), refH(count);
+    double scalarMs = timeMs([&] {
+        for (size_t i = 0; i < count; ++i) {
+            int32_t tFine = 0;
+            refT[i] = horus::bme280::compensateTemp(calib, adcT[i], tFine);
+            refP[i] = horus::bme280::compensatePressure(calib, adcP[i], tFine);
+            refH[i] = horus::bme280::compensateHumidity(calib, adcH[i], tFine);
+        }
+    }, repeats);
+
+    std::vector<float> outT(count), outP(count), outH(count);
+    double batchMs = timeMs([&] {
+        horus::bme280::compensateBatch(calib, adcT.data(), adcP.data(), adcH.data(), count,
+                                       outT.data(), outP.data(), outH.data());
+    }, repeats);
+
+    float maxT = 0, maxP = 0, maxH = 0;
+    for (size_t i = 0; i < count; ++i) {
+        maxT = std::max(maxT, std::fabs(outT[i] - refT[i]));
+        maxP = std::max(maxP, std::fabs(outP[i] - refP[i]));
+        maxH = std::max(maxH, std::fabs(outH[i] - refH[i]));
+    }
+    std::cout << "bme280 scalar    : " << scalarMs << " ms for " << count << " samples" << std::endl;
+    std::cout << "bme280 batch     : " << batchMs << " ms (x" << scalarMs / batchMs << ")" << std::endl;
+    std::cout << "bme280 max diff  : " << maxT << " C, " << maxP << " hPa, " << maxH << " %" << std::endl;
+}
+
+// modem_up + gps_fix + modem_down against the pty fake. The figure that matters is the
+// radio-on time up to "registered and fixed": the script's fixed waits spend 26 s there
+// (sleep 20 after CFUN=1, sleep 2 around CGPS, a 2 s read) and miss any fix that
+// takes longer than ~4 s after AT+CGPS=1.
+static void benchModem() {
+    struct Case {
+        const char* name;
+        horus::FakeModem::Timing timing;
+        int gpsTimeoutMs;
+    };
+    const Case cases[] = {
+        { "modem urc       ", { 300, 1500, 5000, true }, 10000 },
+        { "modem polled    ", { 300, 1500, 5000, false }, 10000 },
+        { "modem no fix    ", { 300, 800, -1, true }, 2000 },
+    };
+
+    for (const Case& c : cases) {
+        horus::FakeModem fake(c.timing);
+        if (!fake.start()) return;
+        horus::AtModem modem(fake.path());
+        std::string fix;
+        bool up = modem.open(1000) && modem.sync(3000) && modem.radioOn(true, 10000);
+        bool found = up && modem.gpsFix(c.gpsTimeoutMs, fix);
+        const int64_t readyMs = fake.radioOnMs();
+        modem.radioOff();
+        std::cout << c.name << ": radio on " << readyMs << " ms to " << (found ? "fix" : "give up")
+                  << " (fix at " << c.timing.fixMs << " ms), " << fake.commands() << " commands" << std::endl;
+    }
+}
+
+// Cost of a span (off and on), what tracing adds to a full-size encode + atomic write,
+// and the summary of a parallel encode
+static void benchTrace(int repeats) {
+    namespace trace = horus::utils;
+    const int spans = 1000000;
+    trace::setTracing(false);
+    double offMs = timeMs([&] { for (int i = 0; i < spans; ++i) { HORUS_TRACE_SCOPE("bench.span"); } }, 1);
+    trace::setTracing(true);
+    double onMs = timeMs([&] { for (int i = 0; i < spans; ++i) { HORUS_TRACE_SCOPE("bench.span"); } }, 1);
+    std::cout << "trace span       : " << offMs * 1e6 / spans << " ns off, " << onMs * 1e6 / spans << " ns on" << std::endl;
+
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+    horus::imaging::FrameView frame = bgrView(bgr, kWidth, kHeight);
+    const std::string folder = "/tmp/horus_bench_trace";
+    std::filesystem::create_directories(folder);
+    auto save = [&] { horus::imaging::saveJpeg(folder + "/frame.jpg", frame); };
+
+    trace::setTracing(false);
+    double plainMs = timeMs(save, repeats);
+    trace::setTracing(true);
+    double tracedMs = timeMs(save, repeats);
+    std::cout << "trace saveJpeg   : " << plainMs << " ms off, " << tracedMs << " ms on ("
+              << (tracedMs / plainMs - 1.0) * 100.0 << " %)" << std::endl;
+
+    // Parallel strips: one ring per worker
+    trace::resetTrace();
+    {
+        horus::utils::ThreadPool pool(4);
+        std::vector<uint8_t> out;
+        horus::imaging::encodeJpegParallel(frame, out, pool);
+        horus::utils::writeFileAtomic(folder + "/parallel.jpg", out.data(), out.size());
+    }
+    trace::setTracing(false);
+    trace::printTraceSummary(6);
+    std::filesystem::remove_all(folder);
+}
+
+// CPU time of one SystemMonitor sample on a fake sysfs / procfs tree, against the forks
+// monitor_cpu.sh made for one (date, two "vcgencmd" as cat of the fake nodes, sed, echo),
+// children's CPU time included
+static void benchSystem(int repeats) {
+    namespace fs = std::filesystem;
+    const fs::path root = "/tmp/horus_bench_sysfs";
+    fs::remove_all(root);
+    horus::tests::makeFakeSysfs(root.string());
+
+    horus::SystemSources sources;
+    sources.root = root.string();
+    sources.storagePath = root.string();
+    horus::SystemSample sample;
+    const int samples = std::max(20, repeats * 20);
+    horus::utils::TaskTimer native;
+    for (int i = 0; i < samples; ++i) {
+        horus::SystemMonitor each(sources); // As the one-shot task does: zones found again
+        each.sample(sample);
+    }
+    const double nativeUs = native.cpuMs() * 1000.0 / samples;
+
+    std::ofstream(root / "monitor_cpu.sh") << (
+        "TIMESTAMP=$(date '+%Y-%m-%dT%H:%M:%S%Z')\n"
+        "TEMP_RAW=$(cat " + (root / "sys/class/thermal/thermal_zone0/temp").string() + ")\n"
+        "TEMP_CLEAN=$(echo $TEMP_RAW | sed \"s/temp=//;s/'C//\")\n"
+        "THROT_RAW=$(cat " + (root / "sys/devices/platform/soc/soc:firmware/get_throttled").string() + ")\n"
+        "THROT_CLEAN=$(echo $THROT_RAW | sed \"s/throttled=//\")\n"
+        "echo \"$TIMESTAMP,$TEMP_CLEAN,$THROT_CLEAN\" > /dev/null\n");
+    const std::string scriptPath = (root / "monitor_cpu.sh").string();
+    auto childrenCpuMs = [] {
+        struct rusage usage;
+        getrusage(RUSAGE_CHILDREN, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    };
+    const int forks = std::max(5, repeats * 2);
+    const double childrenBefore = childrenCpuMs();
+    horus::utils::TaskTimer parent;
+    bool shellOk = true;
+    for (int i = 0; i < forks; ++i) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl("/bin/sh", "sh", scriptPath.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        int status = 0;
+        shellOk = pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0 && shellOk;
+    }
+    const double scriptUs = (childrenCpuMs() - childrenBefore + parent.cpuMs()) * 1000.0 / forks;
+
+    std::cout << "sys sample cpu   : " << nativeUs << " us native vs " << scriptUs << " us forked"
+              << (shellOk ? "" : " (script failed)") << std::endl;
+    fs::remove_all(root);
+}
+
+// --- MAIN ---
+
+int main(int argc, char* argv[]) {
+    std::string which = "all";
+    std::string fixtures = ".";
+    int repeats = 3;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0 && i + 1 < argc) which = argv[++i];
+        else if (std::strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            if (!horus::utils::parseInt(argv[++i], repeats) || repeats < 1) {
+                std::cerr << "[Bench] --repeats expects an integer >= 1, got '" << argv[i] << "'" << std::endl;
+                return 1;
+            }
+        }
+        else if (std::strcmp(argv[i], "--fixtures") == 0 && i + 1 < argc) fixtures = argv[++i];
+    }
+
+    std::cout << "[Bench] Frame " << kWidth << "x" << kHeight << ", " << repeats << " repeats" << std::endl;
+
+    if (which == "all" || which == "jpeg") benchJpeg(repeats);
+    if (which == "all" || which == "pyramid") benchPyramid(repeats);
+    if (which == "all" || which == "hdr") benchHdr(repeats);
+    if (which == "all" || which == "denoise") benchDenoise(repeats);
+    if (which == "all" || which == "atomic") benchAtomicWrite(repeats);
+    if (which == "all" || which == "aruco") benchAruco(repeats, fixtures);
+    if (which == "all" || which == "telemetry") benchTelemetry();
+    if (which == "all" || which == "hash") benchHash(repeats);
+    if (which == "all" || which == "bundle") benchBundle(repeats);
+    if (which == "all" || which == "modem") benchModem();
+    if (which == "all" || which == "bme280") benchBme280(repeats);
+    if (which == "all" || which == "trace") benchTrace(repeats);
+    if (which == "all" || which == "rate") benchRateControl(fixtures);
+    if (which == "all" || which == "roi") benchRoi(repeats);
+    if (which == "all" || which == "multicam") benchMultiCamera();
+    if (which == "all" || which == "scene") benchScene(repeats, fixtures);
+    if (which == "all" || which == "sys") benchSystem(repeats);
+    return 0;
+}
@@ -0,0 +1,248 @@
+#include "FakeS3.hpp"
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <cstdlib>
+#include <strings.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "utils/Hash.hpp"
+
+namespace horus {
+namespace cloud {
+
+namespace {
+
+std::string percentDecode(const std::string& text) {
+    std::string out;
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] == '%' && i + 2 < text.size()) {
+            out += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            out += text[i];
+        }
+    }
+    return out;
+}
+
+std::string reply(int status, const std::string& reason, const std::string& body, const std::string& etag = "") {
+    std::string out = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n";
+    if (!etag.empty()) out += "ETag: " + etag + "\r\n";
+    out += "Content-Type: application/xml\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    return out + body;
+}
+
+std::string error(int status, const std::string& reason, const std::string& code) {
+    return reply(status, reason, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Error><Code>" + code +
+                                 "</Code><Message>" + code + "</Message></Error>");
+}
+
+std::string etagOf(const std::vector<uint8_t>& data) {
+    return "\"" + utils::hashToHex(utils::xxh64(data.data(), data.size())) + "\"";
+}
+
+// Appends what the socket has; false once the peer is gone (or we are stopping)
+bool receive(int fd, std::string& input, const std::atomic<bool>& stopping) {
+    while (!stopping) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        char buffer[65536];
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        input.append(buffer, static_cast<size_t>(n));
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+FakeS3::~FakeS3() {
+    stopping = true;
+    if (acceptor.joinable()) acceptor.join();
+    std::vector<std::thread> running;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running.swap(connections);
+    }
+    for (std::thread& connection : running) connection.join();
+    if (listener >= 0) close(listener);
+}
+
+bool FakeS3::start() {
+    listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    struct sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(listener, 16) != 0 || getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        std::cerr << "[FakeS3] ERROR: No loopback port: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    url = "http://127.0.0.1:" + std::to_string(ntohs(address.sin_port));
+    acceptor = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void FakeS3::failAfter(int requests) {
+    budget = requests;
+}
+
+bool FakeS3::object(const std::string& path, std::vector<uint8_t>& data) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = objects.find(path);
+    if (it == objects.end()) return false;
+    data = it->second;
+    return true;
+}
+
+int FakeS3::pendingUploads() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(uploads.size());
+}
+
+void FakeS3::acceptLoop() {
+    while (!stopping) {
+        struct pollfd pfd = { listener, POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) continue;
+        int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        std::lock_guard<std::mutex> lock(mutex);
+        connections.emplace_back([this, fd] { serve(fd); });
+    }
+}
+
+// One more answer allowed? Counts down the failAfter() budget.
+bool FakeS3::admit() {
+    int left = budget;
+    while (left != 0) {
+        if (left < 0 || budget.compare_exchange_weak(left, left - 1)) return true;
+    }
+    return false;
+}
+
+void FakeS3::serve(int fd) {
+    std::string input;
+    while (!stopping) {
+        // 1. Request line and headers
+        size_t headerEnd;
+        bool connected = true;
+        while (connected && (headerEnd = input.find("\r\n\r\n")) == std::string::npos) {
+            connected = receive(fd, input, stopping);
+        }
+        if (!connected) break;
+        std::istringstream head(input.substr(0, headerEnd));
+        std::string method, target, line;
+        head >> method >> target;
+        std::getline(head, line);
+        size_t contentLength = 0;
+        while (std::getline(head, line)) {
+            if (strncasecmp(line.c_str(), "content-length:", 15) == 0) {
+                contentLength = static_cast<size_t>(std::strtoull(line.c_str() + 15, nullptr, 10));
+            }
+        }
+
+        // 2. Body
+        const size_t bodyStart = headerEnd + 4;
+        while (connected && input.size() < bodyStart + contentLength) connected = receive(fd, input, stopping);
+        if (!connected) break;
+        std::vector<uint8_t> body(input.begin() + bodyStart, input.begin() + bodyStart + contentLength);
+        input.erase(0, bodyStart + contentLength);
+
+        // 3. Link gone: hang up without an answer
+        if (!admit()) break;
+
+        const size_t mark = target.find('?');
+        std::map<std::string, std::string> query;
+        std::istringstream pairs(mark == std::string::npos ? "" : target.substr(mark + 1));
+        std::string pair;
+        while (std::getline(pairs, pair, '&')) {
+            const size_t eq = pair.find('=');
+            query[percentDecode(pair.substr(0, eq))] = eq == std::string::npos ? "" : percentDecode(pair.substr(eq + 1));
+        }
+        const std::string path = percentDecode(target.substr(1, mark == std::string::npos ? std::string::npos : mark - 1));
+        const std::string response = handle(method, path, query, body);
+        ++answered;
+
+        size_t done = 0;
+        while (done < response.size()) {
+            ssize_t n = send(fd, response.data() + done, response.size() - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        if (done < response.size()) break;
+    }
+    close(fd);
+}
+
+std::string FakeS3::handle(const std::string& method, const std::string& path,
+                           const std::map<std::string, std::string>& query, const std::vector<uint8_t>& body) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (path.find('/') == std::string::npos) return error(400, "Bad Request", "InvalidRequest"); // No key
+
+    // PUT object
+    if (method == "PUT" && query.empty()) {
+        objects[path] = body;
+        return reply(200, "OK", "", etagOf(body));
+    }
+
+    // Multipart: create
+    if (method == "POST" && query.count("uploads")) {
+        const std::string id = "upload-" + std::to_string(nextUpload++);
+        uploads[id].path = path;
+        return reply(200, "OK", "<InitiateMultipartUploadResult><Key>" + path + "</Key><UploadId>" + id +
+                                "</UploadId></InitiateMultipartUploadResult>");
+    }
+
+    auto upload = query.count("uploadId") ? uploads.find(query.at("uploadId")) : uploads.end();
+    if (query.count("uploadId") && (upload == uploads.end() || upload->second.path != path)) {
+        return error(404, "Not Found", "NoSuchUpload");
+    }
+
+    // Multipart: part
+    if (method == "PUT" && upload != uploads.end() && query.count("partNumber")) {
+        const int part = std::atoi(query.at("partNumber").c_str());
+        if (part < 1 || part > 10000) return error(400, "Bad Request", "InvalidArgument");
+        upload->second.parts[part] = body;
+        upload->second.etags[part] = etagOf(body);
+        return reply(200, "OK", "", upload->second.etags[part]);
+    }
+
+    // Multipart: complete, from the listed parts in order
+    if (method == "POST" && upload != uploads.end()) {
+        const std::string xml(body.begin(), body.end());
+        std::vector<uint8_t> data;
+        int listed = 0;
+        for (size_t at = xml.find("<PartNumber>"); at != std::string::npos; at = xml.find("<PartNumber>", at + 1)) {
+            const int part = std::atoi(xml.c_str() + at + 12);
+            const size_t tag = xml.find("<ETag>", at);
+            const size_t end = xml.find("</ETag>", at);
+            const std::string etag = tag == std::string::npos || end == std::string::npos ? "" : xml.substr(tag + 6, end - tag - 6);
+            auto stored = upload->second.etags.find(part);
+            if (stored == upload->second.etags.end() || stored->second != etag) {
+                return error(400, "Bad Request", "InvalidPart");
+            }
+            const std::vector<uint8_t>& bytes = upload->second.parts[part];
+            data.insert(data.end(), bytes.begin(), bytes.end());
+            ++listed;
+        }
+        if (listed == 0) return error(400, "Bad Request", "MalformedXML");
+        objects[path] = data;
+        uploads.erase(upload);
+        return reply(200, "OK", "<CompleteMultipartUploadResult><Key>" + path + "</Key><ETag>" + etagOf(data) +
+                                "</ETag></CompleteMultipartUploadResult>");
+    }
+    return error(501, "Not Implemented", "NotImplemented");
+}
+
+}
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace horus {
+namespace cloud {
+
+// S3 stand-in on a loopback port, so the uploader can run off the device. It answers
+// the calls S3Client makes, path-style: PUT object, multipart create / part / complete
+// (NoSuchUpload for an unknown upload id, InvalidPart for a part it does not hold).
+// Objects stay in memory; signatures are not checked. One thread per connection,
+// connections are kept alive like a real endpoint's.
+class FakeS3 {
+public:
+    FakeS3() = default;
+    ~FakeS3();
+
+    FakeS3(const FakeS3&) = delete;
+    FakeS3& operator=(const FakeS3&) = delete;
+
+    // False if no loopback port could be bound
+    bool start();
+
+    // "http://127.0.0.1:<port>": the S3Config endpoint
+    const std::string& endpoint() const { return url; }
+
+    // Link drop: after 'requests' more answered requests every request (and every new
+    // connection) is cut without an answer, as when the LTE link goes. < 0 = never.
+    void failAfter(int requests);
+
+    // "<bucket>/<key>" -> object bytes; false if there is no such object
+    bool object(const std::string& path, std::vector<uint8_t>& data) const;
+
+    int requests() const { return answered; }   // Requests answered so far
+    int pendingUploads() const;                 // Multipart uploads not completed
+
+private:
+    struct Upload {
+        std::string path;
+        std::map<int, std::vector<uint8_t>> parts;
+        std::map<int, std::string> etags;
+    };
+
+    int listener = -1;
+    std::string url;
+    std::thread acceptor;
+    std::vector<std::thread> connections;
+    std::atomic<bool> stopping{false};
+    std::atomic<int> answered{0};
+    std::atomic<int> budget{-1};
+
+    mutable std::mutex mutex;    // Everything below, and 'connections'
+    std::map<std::string, std::vector<uint8_t>> objects;
+    std::map<std::string, Upload> uploads;
+    int nextUpload = 1;
+
+    void acceptLoop();
+    void serve(int fd);
+    bool admit();
+    std::string handle(const std::string& method, const std::string& path,
+                       const std::map<std::string, std::string>& query, const std::vector<uint8_t>& body);
+};
+
+}
+}
@@ -0,0 +1,338 @@
+#include "S3Client.hpp"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <ctime>
+#include <curl/curl.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+
+namespace horus {
+namespace cloud {
+
+namespace {
+
+    std::string trim(const std::string& text) {
+        size_t start = text.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos) return "";
+        size_t end = text.find_last_not_of(" \t\r\n");
+        return text.substr(start, end - start + 1);
+    }
+
+    std::string toHex(const unsigned char* data, size_t size) {
+        static const char digits[] = "0123456789abcdef";
+        std::string hex(size * 2, '0');
+        for (size_t i = 0; i < size; ++i) {
+            hex[2 * i] = digits[data[i] >> 4];
+            hex[2 * i + 1] = digits[data[i] & 0x0F];
+        }
+        return hex;
+    }
+
+    std::string hmac(const std::string& key, const std::string& message) {
+        unsigned char digest[EVP_MAX_MD_SIZE];
+        unsigned int length = 0;
+        HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+             reinterpret_cast<const unsigned char*>(message.data()), message.size(), digest, &length);
+        return std::string(reinterpret_cast<char*>(digest), length);
+    }
+
+    std::string amzNow() {
+        std::time_t t = std::time(nullptr);
+        char stamp[20];
+        std::strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", std::gmtime(&t));
+        return stamp;
+    }
+
+    // Value of <tag>...</tag> in a (small, flat) S3 XML answer
+    std::string xmlValue(const std::string& xml, const std::string& tag) {
+        size_t start = xml.find("<" + tag + ">");
+        if (start == std::string::npos) return "";
+        start += tag.size() + 2;
+        size_t end = xml.find("</" + tag + ">", start);
+        return end == std::string::npos ? "" : xml.substr(start, end - start);
+    }
+
+    // --- curl callbacks ---
+
+    struct Upload {
+        const uint8_t* data;
+        size_t size;
+        size_t offset;
+    };
+
+    size_t readBody(char* buffer, size_t size, size_t count, void* user) {
+        Upload* upload = static_cast<Upload*>(user);
+        size_t n = std::min(size * count, upload->size - upload->offset);
+        std::memcpy(buffer, upload->data + upload->offset, n);
+        upload->offset += n;
+        return n;
+    }
+
+    // Lets curl resend the body itself when a kept-alive connection turns out to be dead
+    int seekBody(void* user, curl_off_t offset, int origin) {
+        Upload* upload = static_cast<Upload*>(user);
+        if (origin != SEEK_SET || offset < 0 || static_cast<size_t>(offset) > upload->size) return CURL_SEEKFUNC_FAIL;
+        upload->offset = static_cast<size_t>(offset);
+        return CURL_SEEKFUNC_OK;
+    }
+
+    size_t writeBody(char* data, size_t size, size_t count, void* user) {
+        static_cast<std::string*>(user)->append(data, size * count);
+        return size * count;
+    }
+
+    size_t readHeader(char* data, size_t size, size_t count, void* user) {
+        std::string line(data, size * count);
+        if (line.size() > 5 && strncasecmp(line.c_str(), "etag:", 5) == 0) {
+            static_cast<S3Response*>(user)->etag = trim(line.substr(5));
+        }
+        return size * count;
+    }
+
+    struct CurlGlobal {
+        CurlGlobal() { curl_global_init(CURL_GLOBAL_DEFAULT); }
+        ~CurlGlobal() { curl_global_cleanup(); }
+    };
+
+}
+
+bool loadRcloneRemote(const std::string& confPath, const std::string& remote, S3Config& config) {
+    std::ifstream file(confPath);
+    if (!file) {
+        std::cerr << "[S3] ERROR: Cannot read " << confPath << std::endl;
+        return false;
+    }
+
+    // 1. Collect the key = value pairs of our section
+    bool inSection = false, found = false, envAuth = false;
+    std::string type, line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == ';') continue;
+        if (line.front() == '[') {
+            inSection = line == "[" + remote + "]";
+            found = found || inSection;
+            continue;
+        }
+        if (!inSection) continue;
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+        if (key == "type") type = value;
+        else if (key == "access_key_id") config.accessKey = value;
+        else if (key == "secret_access_key") config.secretKey = value;
+        else if (key == "region" && !value.empty()) config.region = value;
+        else if (key == "endpoint") config.endpoint = value;
+        else if (key == "env_auth") envAuth = value == "true";
+        else if (key == "force_path_style") config.forcePathStyle = value != "false";
+    }
+    if (!found || type != "s3") {
+        std::cerr << "[S3] ERROR: No s3 remote [" << remote << "] in " << confPath << std::endl;
+        return false;
+    }
+
+    // 2. Keys from the environment if the remote says so
+    if (envAuth && config.accessKey.empty()) {
+        const char* id = std::getenv("AWS_ACCESS_KEY_ID");
+        const char* secret = std::getenv("AWS_SECRET_ACCESS_KEY");
+        if (id) config.accessKey = id;
+        if (secret) config.secretKey = secret;
+    }
+    if (config.accessKey.empty() || config.secretKey.empty()) {
+        std::cerr << "[S3] ERROR: Remote [" << remote << "] has no credentials" << std::endl;
+        return false;
+    }
+
+    // 3. AWS regional endpoint unless the remote names one (MinIO, Ceph, ...)
+    if (config.endpoint.empty()) config.endpoint = "https://s3." + config.region + ".amazonaws.com";
+    if (config.endpoint.find("://") == std::string::npos) config.endpoint = "https://" + config.endpoint;
+    while (!config.endpoint.empty() && config.endpoint.back() == '/') config.endpoint.pop_back();
+    return true;
+}
+
+std::string sha256Hex(const uint8_t* data, size_t size) {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int length = 0;
+    EVP_Digest(data, size, digest, &length, EVP_sha256(), nullptr);
+    return toHex(digest, length);
+}
+
+std::string uriEncode(const std::string& text, bool encodeSlash) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(text.size() * 3);
+    for (unsigned char c : text) {
+        if ((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+            c == '-' || c == '_' || c == '.' || c == '~' || (c == '/' && !encodeSlash)) {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += digits[c >> 4];
+            out += digits[c & 0x0F];
+        }
+    }
+    return out;
+}
+
+std::string signV4(const S3Config& config, const std::string& method, const std::string& canonicalUri,
+                   const std::string& canonicalQuery, const std::string& host,
+                   const std::string& payloadHash, const std::string& amzDate) {
+    const std::string date = amzDate.substr(0, 8);
+    const std::string scope = date + "/" + config.region + "/s3/aws4_request";
+    const std::string signedHeaders = "host;x-amz-content-sha256;x-amz-date";
+
+    // 1. Canonical request
+    std::string canonical = method + "\n" + canonicalUri + "\n" + canonicalQuery + "\n" +
+                            "host:" + host + "\n" +
+                            "x-amz-content-sha256:" + payloadHash + "\n" +
+                            "x-amz-date:" + amzDate + "\n\n" +
+                            signedHeaders + "\n" + payloadHash;
+
+    // 2. String to sign
+    std::string toSign = "AWS4-HMAC-SHA256\n" + amzDate + "\n" + scope + "\n" +
+                         sha256Hex(reinterpret_cast<const uint8_t*>(canonical.data()), canonical.size());
+
+    // 3. Signing key: date -> region -> service -> request
+    std::string key = hmac("AWS4" + config.secretKey, date);
+    key = hmac(key, config.region);
+    key = hmac(key, "s3");
+    key = hmac(key, "aws4_request");
+    std::string signature = hmac(key, toSign);
+
+    return "AWS4-HMAC-SHA256 Credential=" + config.accessKey + "/" + scope +
+           ", SignedHeaders=" + signedHeaders +
+           ", Signature=" + toHex(reinterpret_cast<const unsigned char*>(signature.data()), signature.size());
+}
+
+S3Client::S3Client(const S3Config& config) : config(config) {
+    static CurlGlobal global;
+    curl = curl_easy_init();
+}
+
+S3Client::~S3Client() {
+    if (curl) curl_easy_cleanup(curl);
+}
+
+bool S3Client::request(const std::string& method, const std::string& key, const std::string& canonicalQuery,
+                       const uint8_t* body, size_t size, S3Response& response) {
+    response = S3Response();
+    if (!curl) {
+        response.error = "curl init failed";
+        return false;
+    }
+
+    // 1. Addressing
+    const size_t schemeEnd = config.endpoint.find("://") + 3;
+    std::string host = config.endpoint.substr(schemeEnd);
+    std::string path = "/" + uriEncode(key, false);
+    if (config.forcePathStyle) {
+        path = "/" + config.bucket + path;
+    } else {
+        host = config.bucket + "." + host;
+    }
+    std::string url = config.endpoint.substr(0, schemeEnd) + host + path;
+    if (!canonicalQuery.empty()) url += "?" + canonicalQuery;
+
+    // 2. Signature over the real payload hash: the server rejects a corrupted part
+    const std::string amzDate = amzNow();
+    const std::string payloadHash = sha256Hex(body, size);
+    struct curl_slist* headers = nullptr;
+    headers = curl_slist_append(headers, ("Authorization: " + signV4(config, method, path, canonicalQuery,
+                                                                      host, payloadHash, amzDate)).c_str());
+    headers = curl_slist_append(headers, ("x-amz-content-sha256: " + payloadHash).c_str());
+    headers = curl_slist_append(headers, ("x-amz-date: " + amzDate).c_str());
+    headers = curl_slist_append(headers, "Expect:"); // No 100-continue round trip before each body
+    headers = curl_slist_append(headers, "Content-Type:");
+
+    // 3. Transfer. A link that stalls below 1 KB/s for 60 s is given up on (and retried)
+    Upload upload = { body, size, 0 };
+    curl_easy_reset(curl); // Keeps the connection cache
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    if (method == "PUT" || method == "POST") {
+        curl_easy_setopt(curl, CURLOPT_UPLOAD, 1L);
+        curl_easy_setopt(curl, CURLOPT_READFUNCTION, readBody);
+        curl_easy_setopt(curl, CURLOPT_READDATA, &upload);
+        curl_easy_setopt(curl, CURLOPT_SEEKFUNCTION, seekBody);
+        curl_easy_setopt(curl, CURLOPT_SEEKDATA, &upload);
+        curl_easy_setopt(curl, CURLOPT_INFILESIZE_LARGE, static_cast<curl_off_t>(size));
+    }
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, readHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1024L);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+
+    CURLcode code = curl_easy_perform(curl);
+    curl_slist_free_all(headers);
+    sent += upload.offset; // Rewound resends are not counted twice: a lower bound
+
+    if (code != CURLE_OK) {
+        response.error = curl_easy_strerror(code);
+        return false;
+    }
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.status);
+    if (response.status < 200 || response.status >= 300) {
+        response.error = xmlValue(response.body, "Code");
+        if (response.error.empty()) response.error = "HTTP " + std::to_string(response.status);
+        return false;
+    }
+    return true;
+}
+
+bool S3Client::putObject(const std::string& key, const uint8_t* data, size_t size, S3Response& response) {
+    return request("PUT", key, "", data, size, response);
+}
+
+bool S3Client::createMultipart(const std::string& key, std::string& uploadId, S3Response& response) {
+    if (!request("POST", key, "uploads=", nullptr, 0, response)) return false;
+    uploadId = xmlValue(response.body, "UploadId");
+    if (uploadId.empty()) {
+        response.error = "no UploadId in answer";
+        return false;
+    }
+    return true;
+}
+
+bool S3Client::uploadPart(const std::string& key, const std::string& uploadId, int partNumber,
+                          const uint8_t* data, size_t size, S3Response& response) {
+    // Canonical query: parameters sorted by name
+    std::string query = "partNumber=" + std::to_string(partNumber) + "&uploadId=" + uriEncode(uploadId, true);
+    if (!request("PUT", key, query, data, size, response)) return false;
+    if (response.etag.empty()) {
+        response.error = "no ETag in answer";
+        return false;
+    }
+    return true;
+}
+
+bool S3Client::completeMultipart(const std::string& key, const std::string& uploadId,
+                                 const std::vector<std::string>& etags, S3Response& response) {
+    std::string xml = "<CompleteMultipartUpload>";
+    for (size_t i = 0; i < etags.size(); ++i) {
+        xml += "<Part><PartNumber>" + std::to_string(i + 1) + "</PartNumber><ETag>" + etags[i] + "</ETag></Part>";
+    }
+    xml += "</CompleteMultipartUpload>";
+    if (!request("POST", key, "uploadId=" + uriEncode(uploadId, true),
+                 reinterpret_cast<const uint8_t*>(xml.data()), xml.size(), response)) {
+        return false;
+    }
+    // S3 can answer 200 and still fail the completion
+    if (response.body.find("<Error>") != std::string::npos) {
+        response.error = xmlValue(response.body, "Code");
+        return false;
+    }
+    return true;
+}
+
+}
+}
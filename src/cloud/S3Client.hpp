@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+typedef void CURL;
+
+namespace horus {
+namespace cloud {
+
+    // Where and as whom we upload. Path-style addressing ("<endpoint>/<bucket>/<key>"),
+    // rclone's default, unless forcePathStyle is false.
+    struct S3Config {
+        std::string endpoint;          // "https://s3.eu-south-1.amazonaws.com", "http://127.0.0.1:9000"
+        std::string region = "us-east-1";
+        std::string bucket;
+        std::string accessKey;
+        std::string secretKey;
+        bool forcePathStyle = true;
+    };
+
+    // Reads the "[remote]" section of an rclone.conf (type = s3): access_key_id,
+    // secret_access_key (or env_auth = true -> AWS_* variables), region, endpoint,
+    // force_path_style. The bucket is not part of the remote: set it afterwards.
+    bool loadRcloneRemote(const std::string& confPath, const std::string& remote, S3Config& config);
+
+    // --- AWS Signature Version 4 ---
+
+    // Lower-case hex SHA-256
+    std::string sha256Hex(const uint8_t* data, size_t size);
+
+    // S3 URI encoding (RFC 3986 unreserved characters kept; '/' kept when encodeSlash is false)
+    std::string uriEncode(const std::string& text, bool encodeSlash);
+
+    // "Authorization" header value for one request. 'canonicalQuery' must already be
+    // sorted and encoded; the signed headers are host, x-amz-content-sha256 and x-amz-date.
+    std::string signV4(const S3Config& config, const std::string& method, const std::string& canonicalUri,
+                       const std::string& canonicalQuery, const std::string& host,
+                       const std::string& payloadHash, const std::string& amzDate);
+
+    struct S3Response {
+        long status = 0;       // HTTP status, 0 = transport error (see 'error')
+        std::string body;
+        std::string etag;
+        std::string error;
+    };
+
+    // One connection's worth of S3 calls. Keeps its curl handle, so consecutive
+    // requests reuse the TCP / TLS session: on a 600 ms RTT link a new handshake
+    // costs more than a small object. Not thread-safe: one client per thread.
+    class S3Client {
+    public:
+        explicit S3Client(const S3Config& config);
+        ~S3Client();
+
+        S3Client(const S3Client&) = delete;
+        S3Client& operator=(const S3Client&) = delete;
+
+        // Single PUT
+        bool putObject(const std::string& key, const uint8_t* data, size_t size, S3Response& response);
+
+        // Multipart: create -> parts (1-based, >= 5 MiB except the last) -> complete
+        bool createMultipart(const std::string& key, std::string& uploadId, S3Response& response);
+        bool uploadPart(const std::string& key, const std::string& uploadId, int partNumber,
+                        const uint8_t* data, size_t size, S3Response& response);
+        bool completeMultipart(const std::string& key, const std::string& uploadId,
+                               const std::vector<std::string>& etags, S3Response& response);
+
+        // Signs and runs one request. Returns true on a 2xx answer.
+        bool request(const std::string& method, const std::string& key, const std::string& canonicalQuery,
+                     const uint8_t* body, size_t size, S3Response& response);
+
+        uint64_t bytesSent() const { return sent; }
+
+    private:
+        S3Config config;
+        CURL* curl = nullptr;
+        uint64_t sent = 0; // Request bodies handed to curl, retries included
+    };
+
+}
+}
@@ -0,0 +1,382 @@
+#include "Uploader.hpp"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <deque>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utils/Hash.hpp"
+#include "utils/Bundle.hpp"
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace cloud {
+
+namespace {
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    bool readRange(const std::string& path, uint64_t offset, size_t size, std::vector<uint8_t>& buffer) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        buffer.resize(size);
+        size_t done = 0;
+        while (done < size) {
+            ssize_t n = pread(fd, buffer.data() + done, size - done, static_cast<off_t>(offset + done));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            done += static_cast<size_t>(n);
+        }
+        close(fd);
+        return done == size;
+    }
+
+    // Network trouble, throttling and server errors are worth another try; a refused
+    // signature or a missing bucket is not
+    bool isTransient(const S3Response& response) {
+        return response.status == 0 || response.status >= 500 || response.status == 408 ||
+               response.status == 429 || response.error == "RequestTimeout";
+    }
+
+    // One file of the run. Parts are 1-based; etags[n - 1] is written only by the
+    // worker that sent part n.
+    struct FileJob {
+        const UploadItem* item = nullptr;
+        int partCount = 0;                  // 0 = single PUT
+        std::string uploadId;
+        std::vector<std::string> etags;
+        std::atomic<int> remaining{0};      // Parts still to send in this run
+        std::atomic<bool> failed{false};
+    };
+
+    struct Work {
+        FileJob* job;
+        int part; // 0 = start the file
+    };
+
+    class UploadRun {
+    public:
+        UploadRun(const S3Config& config, utils::FileIndex* index, const UploadOptions& options, UploadStats& stats)
+            : config(config), index(index), options(options), stats(stats) {}
+
+        bool run(const std::vector<UploadItem>& items) {
+            for (const UploadItem& item : items) {
+                jobs.push_back(std::make_unique<FileJob>());
+                jobs.back()->item = &item;
+                queue.push_back({ jobs.back().get(), 0 });
+            }
+
+            std::vector<std::thread> workers;
+            for (unsigned i = 0; i < std::max(1u, options.jobs); ++i) workers.emplace_back([this] { workerLoop(); });
+            for (std::thread& worker : workers) worker.join();
+            return stats.failed == 0;
+        }
+
+    private:
+        const S3Config& config;
+        utils::FileIndex* index;
+        const UploadOptions& options;
+        UploadStats& stats;
+        std::atomic<bool> linkDown{false};
+
+        std::vector<std::unique_ptr<FileJob>> jobs;
+        std::deque<Work> queue;
+        std::mutex queueMutex;
+        std::condition_variable queueCv;
+        int busy = 0;
+        std::mutex statsMutex;
+
+        void workerLoop() {
+            S3Client client(config);
+            std::vector<uint8_t> buffer;
+            for (;;) {
+                Work work;
+                {
+                    std::unique_lock<std::mutex> lock(queueMutex);
+                    // Idle workers wait while someone may still queue parts
+                    queueCv.wait(lock, [this] { return !queue.empty() || busy == 0; });
+                    if (queue.empty()) break;
+                    work = queue.front();
+                    queue.pop_front();
+                    ++busy;
+                }
+                if (work.part == 0) startFile(client, *work.job, buffer);
+                else sendPart(client, *work.job, work.part, buffer);
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    --busy;
+                }
+                queueCv.notify_all();
+            }
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.wireBytes += client.bytesSent();
+        }
+
+        // Retries transient failures with back-off. Once a request has used up its retries
+        // the link is considered gone: the rest of the run fails fast instead of keeping
+        // the modem up for every remaining file (the index resumes them next time).
+        template <typename F>
+        bool withRetries(const std::string& what, S3Response& response, F&& attempt) {
+            for (int i = 0;; ++i) {
+                if (linkDown) {
+                    response.error = "link down";
+                    return false;
+                }
+                if (attempt()) return true;
+                if (!isTransient(response)) return false;
+                if (i >= options.retries) {
+                    if (!linkDown.exchange(true)) {
+                        std::cerr << "[Upload] Link looks down, stopping this run" << std::endl;
+                    }
+                    return false;
+                }
+                int waitSec = 2 << std::min(i, 4);
+                std::cerr << "[Upload] " << what << ": " << response.error << ", retry in " << waitSec << " s" << std::endl;
+                std::this_thread::sleep_for(std::chrono::seconds(waitSec));
+            }
+        }
+
+        void count(int UploadStats::* field, uint64_t bytes = 0) {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ++(stats.*field);
+            stats.bytes += bytes;
+        }
+
+        void startFile(S3Client& client, FileJob& job, std::vector<uint8_t>& buffer) {
+            const UploadItem& item = *job.item;
+
+            // 1. Small file or appended tail: one PUT
+            const uint64_t length = item.size - item.offset;
+            if (length <= options.partSize) {
+                S3Response response;
+                bool ok = readRange(item.path, item.offset, static_cast<size_t>(length), buffer) &&
+                          withRetries(item.objectKey, response, [&] {
+                              return client.putObject(item.objectKey, buffer.data(), buffer.size(), response);
+                          });
+                finishFile(job, ok, ok ? "" : response.error);
+                return;
+            }
+
+            // 2. Large file: resume the index's multipart upload, or start one
+            job.partCount = static_cast<int>((item.size + options.partSize - 1) / options.partSize);
+            job.etags.assign(job.partCount, "");
+            utils::FileState state;
+            if (index && index->find(item.key, state) && !state.uploadId.empty() &&
+                state.multipartSize == item.size && state.multipartMtimeNs == item.mtimeNs) {
+                job.uploadId = state.uploadId;
+                for (const auto& part : state.parts) {
+                    if (part.first >= 1 && part.first <= job.partCount) job.etags[part.first - 1] = part.second;
+                }
+                count(&UploadStats::resumed);
+            } else {
+                S3Response response;
+                if (!withRetries(item.key, response, [&] {
+                        return client.createMultipart(item.objectKey, job.uploadId, response);
+                    })) {
+                    finishFile(job, false, response.error);
+                    return;
+                }
+                if (index) index->startMultipart(item.key, item.size, item.mtimeNs, job.uploadId);
+            }
+
+            // 3. Missing parts go to the FRONT of the queue: every worker helps with
+            // this file before anyone starts the next one
+            std::vector<int> missing;
+            for (int part = 1; part <= job.partCount; ++part) {
+                if (job.etags[part - 1].empty()) missing.push_back(part);
+            }
+            if (missing.empty()) {
+                completeFile(client, job);
+                return;
+            }
+            job.remaining = static_cast<int>(missing.size());
+            {
+                std::lock_guard<std::mutex> lock(queueMutex);
+                for (auto it = missing.rbegin(); it != missing.rend(); ++it) queue.push_front({ &job, *it });
+            }
+            queueCv.notify_all();
+        }
+
+        void sendPart(S3Client& client, FileJob& job, int part, std::vector<uint8_t>& buffer) {
+            const UploadItem& item = *job.item;
+            if (!job.failed) {
+                const uint64_t offset = static_cast<uint64_t>(part - 1) * options.partSize;
+                const size_t size = static_cast<size_t>(std::min<uint64_t>(options.partSize, item.size - offset));
+                S3Response response;
+                const std::string what = item.key + " part " + std::to_string(part);
+                bool ok = readRange(item.path, offset, size, buffer) &&
+                          withRetries(what, response, [&] {
+                              return client.uploadPart(item.objectKey, job.uploadId, part, buffer.data(), size, response);
+                          });
+                if (ok) {
+                    job.etags[part - 1] = response.etag;
+                    if (index) index->markPart(item.key, part, response.etag);
+                } else {
+                    std::cerr << "[Upload] ERROR: " << what << ": " << response.error << std::endl;
+                    // The upload expired on the server: start over next run
+                    if (response.error == "NoSuchUpload" && index) index->abandon(item.key);
+                    job.failed = true;
+                }
+            }
+            if (--job.remaining == 0) {
+                if (job.failed) finishFile(job, false, "parts missing, will resume");
+                else completeFile(client, job);
+            }
+        }
+
+        void completeFile(S3Client& client, FileJob& job) {
+            S3Response response;
+            bool ok = withRetries(job.item->key, response, [&] {
+                return client.completeMultipart(job.item->objectKey, job.uploadId, job.etags, response);
+            });
+            // Expired upload or a part the server does not recognise: start over next run
+            const bool stale = response.error == "NoSuchUpload" || response.error == "InvalidPart";
+            if (!ok && stale && index) index->abandon(job.item->key);
+            finishFile(job, ok, response.error);
+        }
+
+        void finishFile(FileJob& job, bool ok, const std::string& error) {
+            const UploadItem& item = *job.item;
+            if (ok) {
+                if (index) index->markUploaded(item.key, item.size, item.hash, item.tails);
+                count(&UploadStats::uploaded, item.size - item.offset);
+                if (item.offset > 0) count(&UploadStats::tails);
+                std::cout << "[Upload] " << item.objectKey << " (" << (item.size - item.offset) / 1024 << " KB)" << std::endl;
+            } else {
+                count(&UploadStats::failed);
+                std::cerr << "[Upload] FAILED: " << item.key << ": " << error << std::endl;
+            }
+        }
+    };
+
+}
+
+int uploadPriority(const std::string& name) {
+    if (endsWith(name, ".csv") || endsWith(name, ".json") || endsWith(name, ".hbn")) return 0;
+    if (endsWith(name, "_p8.jpg")) return 1;
+    if (endsWith(name, "_p4.jpg")) return 2;
+    if (endsWith(name, "_p2.jpg")) return 3;
+    return 4;
+}
+
+std::vector<UploadItem> planUploads(const std::string& root, int days, utils::FileIndex& index,
+                                    const UploadOptions& options, UploadStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<UploadItem> items;
+    std::map<std::string, uint64_t> bundled; // Key -> hash, members of the folder's bundle
+
+    auto addFile = [&](const fs::path& path, const std::string& key) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) return;
+        UploadItem item;
+        item.path = path.string();
+        item.key = key;
+        item.objectKey = key;
+        item.size = static_cast<uint64_t>(st.st_size);
+        item.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        item.priority = uploadPriority(path.filename().string());
+        if (item.priority == 4 && fs::exists(fs::path(path).replace_extension(".dup.json"))) {
+            item.priority = 5; // Same scene as an earlier picture: after everything else
+        }
+
+        // 1. Content hash: from the index if the file is as it was written, else read it once
+        utils::FileState state;
+        const bool known = index.find(key, state);
+        if (known && state.known && state.size == item.size && state.mtimeNs == item.mtimeNs) {
+            item.hash = state.hash;
+        } else {
+            if (!utils::hashFile(item.path, UINT64_MAX, item.hash)) return;
+            index.recordWrite(key, item.size, item.mtimeNs, item.hash);
+            ++stats.hashed;
+        }
+
+        // 2. Already travels inside the day's bundle, with these bytes
+        auto member = bundled.find(key);
+        if (member != bundled.end() && member->second == item.hash) {
+            ++stats.bundled;
+            return;
+        }
+
+        // 3. Already in the bucket (a rewrite with the same bytes counts too)
+        if (known && state.uploaded && state.uploadedSize == item.size && state.uploadedHash == item.hash) {
+            ++stats.skipped;
+            return;
+        }
+
+        // 4. Cumulative CSV that only grew: send the new bytes
+        const bool cumulative = key.find('/') == std::string::npos && endsWith(key, ".csv");
+        uint64_t prefixHash = 0;
+        if (cumulative && known && state.uploaded && state.uploadedSize > 0 && state.uploadedSize < item.size &&
+            item.size - state.uploadedSize <= options.partSize && state.tails < options.maxTails &&
+            utils::hashFile(item.path, state.uploadedSize, prefixHash) && prefixHash == state.uploadedHash) {
+            char offset[24];
+            std::snprintf(offset, sizeof(offset), "%012llu", static_cast<unsigned long long>(state.uploadedSize));
+            item.offset = state.uploadedSize;
+            item.objectKey = key + ".tail/" + offset;
+            item.tails = state.tails + 1;
+        }
+        items.push_back(item);
+    };
+
+    auto addFolder = [&](const fs::path& folder, const std::string& prefix) {
+        std::error_code ec;
+        bundled.clear();
+        utils::BundleIndex bundle;
+        const std::string day = folder.filename().string();
+        if (!prefix.empty() && fs::exists(utils::bundlePath(root, day), ec) &&
+            utils::readBundleIndex(utils::bundlePath(root, day), bundle)) {
+            for (const utils::BundleEntry& member : bundle.entries) bundled[member.name] = member.hash;
+        }
+        for (const fs::directory_entry& entry : fs::directory_iterator(folder, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (name.empty() || name[0] == '.' || !entry.is_regular_file(ec)) continue;
+            addFile(entry.path(), prefix + name);
+        }
+    };
+
+    // 1. Cumulative files in the root, then today, yesterday, ...
+    addFolder(root, "");
+    std::time_t now = std::time(nullptr);
+    for (int d = 0; d < days; ++d) {
+        std::time_t t = now - static_cast<std::time_t>(d) * 86400;
+        char day[16];
+        std::strftime(day, sizeof(day), "%Y-%m-%d", std::localtime(&t));
+        addFolder(fs::path(root) / day, std::string(day) + "/");
+    }
+
+    // 2. Priority class, then size
+    std::sort(items.begin(), items.end(), [](const UploadItem& a, const UploadItem& b) {
+        if (a.priority != b.priority) return a.priority < b.priority;
+        if (a.size - a.offset != b.size - b.offset) return a.size - a.offset < b.size - b.offset;
+        return a.key < b.key;
+    });
+    stats.planMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return items;
+}
+
+// --- UPLOAD ---
+
+bool uploadAll(const S3Config& config, const std::vector<UploadItem>& items, utils::FileIndex* index,
+               const UploadOptions& options, UploadStats& stats) {
+    auto start = std::chrono::steady_clock::now();
+    UploadRun run(config, index, options, stats);
+    bool ok = run.run(items);
+    stats.wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+}
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "S3Client.hpp"
+#include "utils/FileIndex.hpp"
+
+namespace horus {
+namespace cloud {
+
+    struct UploadOptions {
+        unsigned jobs = 4;                    // Requests in flight (parts of one file, or files)
+        size_t partSize = 8u << 20;           // Multipart above this; S3 minimum is 5 MiB
+        int retries = 4;                      // Per request, with 2 s, 4 s, 8 s... back-off
+        int maxTails = 30;                    // Tail pieces of a cumulative CSV before a full re-upload
+    };
+
+    // One upload: a whole file, or the appended tail of a cumulative CSV
+    struct UploadItem {
+        std::string path;
+        std::string key;                      // Index key, relative to the data root
+        std::string objectKey;                // Where it goes: 'key', or "<key>.tail/<offset>"
+        uint64_t size = 0;                    // Whole file
+        int64_t mtimeNs = 0;
+        uint64_t hash = 0;                    // XXH64 of the whole file
+        uint64_t offset = 0;                  // Bytes before this are already in the bucket
+        int tails = 0;                        // Tail pieces after this upload
+        int priority = 0;                     // Lower goes first
+    };
+
+    struct UploadStats {
+        int uploaded = 0;
+        int tails = 0;                        // ...of which appended tails
+        int skipped = 0;                      // Bucket already holds this content
+        int bundled = 0;                      // Left out: the day's bundle carries this content
+        int hashed = 0;                       // Files the index did not know (read to hash them)
+        int failed = 0;
+        int resumed = 0;                      // Multipart uploads picked up where a previous run stopped
+        uint64_t bytes = 0;                   // Payload of the objects sent
+        uint64_t wireBytes = 0;               // Request bodies sent, retries included
+        double planMs = 0.0;
+        double wallMs = 0.0;
+    };
+
+    // Upload order: telemetry (CSV, JSON sidecars) -> previews, smallest level first ->
+    // everything else; smaller files first within a class. On a link that drops
+    // after a few minutes, the data we need most is already across.
+    int uploadPriority(const std::string& name);
+
+    // The exact delta, computed locally (no bucket listing, no HEAD): every file of the
+    // 'days' day folders (today, yesterday...) under 'root' and the loose files in 'root',
+    // checked against the index. Content hashes come from the index when size and mtime
+    // match (files written by writeFileAtomic); other files are hashed once and recorded.
+    // Files whose content the bucket already has are left out. A cumulative CSV in the
+    // root that only grew since its last upload becomes a tail item: just the new bytes,
+    // as "<name>.tail/<offset>" (zero-padded, 12 digits). The cloud side rebuilds the
+    // file as the base object plus the tails at offsets >= its size, in offset order.
+    // Files packed in their day's bundle (utils/Bundle.hpp) with the same content are
+    // left out too. In-flight ".*.tmp" and hidden files are left out. Sorted by priority.
+    std::vector<UploadItem> planUploads(const std::string& root, int days, utils::FileIndex& index,
+                                        const UploadOptions& options, UploadStats& stats);
+
+    // Uploads 'items' in order with options.jobs workers, each with its own S3Client
+    // (connections are kept alive across requests). Large files go multipart with
+    // their parts spread over the workers; progress goes to 'index' (may be null), so
+    // an interrupted run resumes from the last stored part. Returns true if every item made it.
+    bool uploadAll(const S3Config& config, const std::vector<UploadItem>& items, utils::FileIndex* index,
+                   const UploadOptions& options, UploadStats& stats);
+
+}
+}
@@ -0,0 +1,255 @@
+#include "Daemon.hpp"
+#include <iostream>
+#include <sstream>
+#include <csignal>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tasks/Tasks.hpp"
+#include "utils/TaskTimer.hpp"
+#include "utils/Trace.hpp"
+
+namespace horus {
+
+// Set from the signal handler, checked by the main loop
+static volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int) {
+    stopRequested = 1;
+}
+
+// Longest wait for a reply: the command may queue behind a periodic capture, and an
+// HDR capture with denoise takes well under the 120 s the daily graph allows one
+static const int kReplyTimeoutMs = 300 * 1000;
+
+Daemon::Daemon(const DaemonOptions& options) : options(options) {}
+
+Daemon::~Daemon() {
+    if (listenFd >= 0) {
+        close(listenFd);
+        unlink(options.socketPath.c_str());
+    }
+}
+
+bool Daemon::openSocket() {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (options.socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "[Daemon] Socket path too long: " << options.socketPath << std::endl;
+        return false;
+    }
+    std::strncpy(addr.sun_path, options.socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        std::cerr << "[Daemon] socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // A stale socket from a crashed run would make bind() fail
+    unlink(options.socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(listenFd, 4) < 0) {
+        std::cerr << "[Daemon] Failed to listen on " << options.socketPath << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+BME280* Daemon::envSensor() {
+    if (!bme) {
+        std::unique_ptr<BME280> sensor = std::make_unique<BME280>(0x77, 1);
+        if (!sensor->init(options.envSettings)) return nullptr;
+        bme = std::move(sensor);
+    }
+    return bme.get();
+}
+
+std::string Daemon::runTask(const std::string& task) {
+    utils::TaskTimer timer;
+    int result = 1;
+
+    if (task == "capture") {
+        result = tasks::capture(*camera, options.cameraOptions);
+    } else if (task == "capture_hdr") {
+        result = tasks::captureHdr(*camera, options.cameraOptions, options.evOffsets);
+    } else if (task == "monitor_env") {
+        BME280* sensor = envSensor();
+        result = sensor ? tasks::monitorEnv(*sensor, options.envBurstSamples) : 1;
+    } else if (task == "monitor_sys") {
+        result = tasks::monitorSys();
+    } else {
+        return "ERROR unknown task " + task;
+    }
+
+    ++tasksRun;
+    std::ostringstream reply;
+    reply << (result == 0 ? "OK " : "ERROR ") << task
+          << " wall_ms=" << timer.wallMs() << " cpu_ms=" << timer.cpuMs();
+    std::cout << "[Daemon] " << reply.str() << std::endl;
+
+    // One trace per task; the rings start over for the next one
+    if (utils::tracingEnabled() && !options.traceTarget.empty()) {
+        utils::printTraceSummary();
+        utils::writeChromeTrace(utils::traceFilePath(options.traceTarget, task), task);
+        utils::resetTrace();
+    }
+    return reply.str();
+}
+
+std::string Daemon::handleCommand(const std::string& command) {
+    if (command == "quit") {
+        running = false;
+        return "OK quit";
+    }
+    if (command == "trace on" || command == "trace off") {
+        if (options.traceTarget.empty()) return "ERROR no --trace folder";
+        utils::setTracing(command == "trace on");
+        return "OK " + command;
+    }
+    if (command == "status") {
+        std::ostringstream reply;
+        reply << "OK status tasks=" << tasksRun << " bme280=" << (bme ? "ready" : "down")
+              << " trace=" << (utils::tracingEnabled() ? "on" : "off");
+        return reply.str();
+    }
+    return runTask(command);
+}
+
+void Daemon::handleClient(int clientFd) {
+    // One command per connection, terminated by newline or EOF
+    std::string command;
+    char buffer[256];
+    while (command.find('\n') == std::string::npos && command.size() < 1024) {
+        struct pollfd pfd = { clientFd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) break;
+        ssize_t n = read(clientFd, buffer, sizeof(buffer));
+        if (n <= 0) break;
+        command.append(buffer, static_cast<size_t>(n));
+    }
+
+    // Trim whitespace / newline
+    command.erase(command.find_last_not_of(" \r\n\t") + 1);
+    command.erase(0, command.find_first_not_of(" \t"));
+
+    std::string reply = command.empty() ? "ERROR empty command" : handleCommand(command);
+    reply += "\n";
+    if (write(clientFd, reply.data(), reply.size()) < 0) {
+        std::cerr << "[Daemon] Failed to reply to client." << std::endl;
+    }
+}
+
+int Daemon::run() {
+    if (!openSocket()) return 1;
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal; // No SA_RESTART: poll() must wake up
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    // Pay the expensive start-up ONCE
+    utils::TaskTimer startup;
+    camera = std::make_unique<Camera>();
+    if (!envSensor()) {
+        std::cerr << "[Daemon] BME280 not available yet, will retry." << std::endl;
+    }
+    std::cout << "[Daemon] Ready on " << options.socketPath << " (startup wall_ms=" << startup.wallMs()
+              << " cpu_ms=" << startup.cpuMs() << ")" << std::endl;
+
+    Clock::time_point now = Clock::now();
+    nextEnv = now;
+    nextCapture = now + std::chrono::seconds(options.captureIntervalSec);
+    running = true;
+
+    while (running && !stopRequested) {
+        // 1. Run whatever is due
+        now = Clock::now();
+        if (options.envIntervalSec > 0 && now >= nextEnv) {
+            runTask("monitor_env");
+            nextEnv += std::chrono::seconds(options.envIntervalSec);
+            if (nextEnv < now) nextEnv = now + std::chrono::seconds(options.envIntervalSec);
+        }
+        if (options.captureIntervalSec > 0 && now >= nextCapture) {
+            runTask("capture");
+            nextCapture += std::chrono::seconds(options.captureIntervalSec);
+            if (nextCapture < now) nextCapture = now + std::chrono::seconds(options.captureIntervalSec);
+        }
+
+        // 2. Sleep on the socket until the next job is due
+        Clock::time_point wake = now + std::chrono::minutes(1);
+        if (options.envIntervalSec > 0) wake = std::min(wake, nextEnv);
+        if (options.captureIntervalSec > 0) wake = std::min(wake, nextCapture);
+        auto timeoutMs = std::chrono::duration_cast<std::chrono::milliseconds>(wake - Clock::now()).count();
+
+        struct pollfd pfd = { listenFd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(std::max<long long>(0, timeoutMs)));
+        if (ready > 0 && (pfd.revents & POLLIN)) {
+            int clientFd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (clientFd >= 0) {
+                handleClient(clientFd);
+                close(clientFd);
+            }
+        }
+    }
+
+    std::cout << "[Daemon] Shutting down after " << tasksRun << " tasks." << std::endl;
+    camera.reset();
+    bme.reset();
+    return 0;
+}
+
+int Daemon::sendCommand(const std::string& socketPath, const std::string& command) {
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        std::cerr << "[Daemon] Cannot reach daemon at " << socketPath << std::endl;
+        if (fd >= 0) close(fd);
+        return 1;
+    }
+
+    std::string line = command + "\n";
+    if (write(fd, line.data(), line.size()) < 0) {
+        close(fd);
+        return 1;
+    }
+
+    // Tasks like capture take a few seconds: wait for the reply, but not for a daemon
+    // that hangs (a stuck libcamera request would otherwise hold the caller forever)
+    std::string reply;
+    char buffer[256];
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(kReplyTimeoutMs);
+    for (;;) {
+        auto leftMs = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = leftMs > 0 ? poll(&pfd, 1, static_cast<int>(leftMs)) : 0;
+        if (ready < 0 && errno == EINTR) continue;
+        if (ready == 0) {
+            std::cerr << "[Daemon] No reply to '" << command << "' within " << kReplyTimeoutMs / 1000 << " s"
+                      << std::endl;
+            close(fd);
+            return 1;
+        }
+        if (ready < 0) break;
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        reply.append(buffer, static_cast<size_t>(n));
+    }
+    close(fd);
+
+    std::cout << reply;
+    return reply.rfind("OK", 0) == 0 ? 0 : 1;
+}
+
+} // namespace horus
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include "sensors/Camera/Camera.hpp"
+#include "sensors/BME280/bme280.hpp"
+
+namespace horus {
+
+struct DaemonOptions {
+    std::string socketPath = "/tmp/horus.sock";
+    int envIntervalSec = 15 * 60;  // BME280 sampling period (0 = only on command)
+    int captureIntervalSec = 0;    // Periodic capture period (0 = only on command)
+    CameraOptions cameraOptions;
+    std::vector<float> evOffsets;  // capture_hdr bracket (--ev)
+    BME280Settings envSettings;    // Oversampling / IIR of the forced-mode reads
+    int envBurstSamples = 1;       // Conversions averaged per env sample
+    std::string traceTarget;       // Folder for one Chrome trace per task (empty = "trace on" refused)
+};
+
+// Resident mode (--task daemon).
+// Keeps the CameraManager (pipeline enumeration) and the BME280 (I2C fd + calibration)
+// alive between tasks, runs the periodic jobs itself and accepts one-line commands
+// on a local Unix socket:
+//   capture | capture_hdr | monitor_env | monitor_sys | status | trace on | trace off | quit
+// Every reply is one line: "OK <task> wall_ms=<..> cpu_ms=<..>" or "ERROR <reason>".
+class Daemon {
+public:
+    explicit Daemon(const DaemonOptions& options);
+    ~Daemon();
+
+    // Blocks until "quit", SIGINT or SIGTERM. Returns the process exit code.
+    int run();
+
+    // Client side: sends 'command' to a running daemon and prints its reply.
+    static int sendCommand(const std::string& socketPath, const std::string& command);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    DaemonOptions options;
+    int listenFd = -1;
+    bool running = false;
+
+    std::unique_ptr<Camera> camera;  // CameraManager stays started
+    std::unique_ptr<BME280> bme;     // Null until the first successful init()
+
+    Clock::time_point nextEnv;
+    Clock::time_point nextCapture;
+    int tasksRun = 0;
+
+    bool openSocket();
+    void handleClient(int clientFd);
+    std::string handleCommand(const std::string& command);
+
+    // Runs one task and returns the reply line (with timing)
+    std::string runTask(const std::string& task);
+
+    // Lazily brings up the BME280 (retried on next use if it fails)
+    BME280* envSensor();
+};
+
+} // namespace horus
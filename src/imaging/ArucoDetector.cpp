@@ -0,0 +1,643 @@
+#include "ArucoDetector.hpp"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace horus {
+namespace imaging {
+
+// --- DICTIONARIES ---
+
+// AprilTag 3 bit order for 36-bit families (data area coordinates), from tag36h11.c
+static const int kTag36BitX[36] = { 0, 1, 2, 3, 4, 1, 2, 3, 2, 5, 5, 5, 5, 5, 4, 4, 4, 3,
+                                    5, 4, 3, 2, 1, 4, 3, 2, 3, 0, 0, 0, 0, 0, 1, 1, 1, 2 };
+static const int kTag36BitY[36] = { 0, 0, 0, 0, 0, 1, 1, 1, 2, 0, 1, 2, 3, 4, 1, 2, 3, 2,
+                                    5, 5, 5, 5, 5, 4, 4, 4, 3, 5, 4, 3, 2, 1, 4, 3, 2, 3 };
+
+static std::vector<std::pair<int, int>> aprilTagLayout() {
+    std::vector<std::pair<int, int>> cells;
+    for (int i = 0; i < 36; ++i) cells.emplace_back(kTag36BitX[i], kTag36BitY[i]);
+    return cells;
+}
+
+MarkerDictionary builtinDictionary() {
+    MarkerDictionary dictionary;
+    dictionary.name = "tag36h11";
+    dictionary.markerBits = 6;
+    dictionary.maxCorrection = 3; // Family distance is 11: up to 5 is still unambiguous
+    dictionary.bitCells = aprilTagLayout();
+    // IDs 0-586, the order of the printed AprilTag 3 family
+    dictionary.codes = {
+        0xd7e00984bULL, 0xdda664ca7ULL, 0xdc4a1c821ULL, 0xe17b470e9ULL, 0xef91d01b1ULL, 0xf429cdd73ULL,
+        0x05da29225ULL, 0x1106cba43ULL, 0x223bed79dULL, 0x21f51213cULL, 0x33eb19ca6ULL, 0x3f76eb0f8ULL,
+        0x469a97414ULL, 0x45dcfe0b0ULL, 0x4a6465f72ULL, 0x51801db96ULL, 0x5eb946b4eULL, 0x68a7cc2ecULL,
+        0x6f0ba2652ULL, 0x78765559dULL, 0x87b83d129ULL, 0x86cc4a5c5ULL, 0x8b64df90fULL, 0x9c577b611ULL,
+        0xa3810f2f5ULL, 0xaf4d75b83ULL, 0xb59a03fefULL, 0xbb1096f85ULL, 0xd1b92fc76ULL, 0xd0dd509d2ULL,
+        0xe2cfda160ULL, 0x2ff497c63ULL, 0x47240671bULL, 0x5047a2e55ULL, 0x635ca87c7ULL, 0x691254166ULL,
+        0x68f43d94aULL, 0x6ef24bdb6ULL, 0x8cdd8f886ULL, 0x9de96b718ULL, 0xaff6e5a8aULL, 0xbae46f029ULL,
+        0xd225b6d59ULL, 0xdf8ba8c01ULL, 0xe3744a22fULL, 0xfbb59375dULL, 0x18a916828ULL, 0x22f29c1baULL,
+        0x286887d58ULL, 0x41392322eULL, 0x75d18ecd1ULL, 0x87c302743ULL, 0x8c6317ba9ULL, 0x9e40f36d7ULL,
+        0xc0e5a806aULL, 0xcc78cb87cULL, 0x12d2f2d01ULL, 0x379f36a21ULL, 0x6973f59acULL, 0x7789ea9f4ULL,
+        0x8f1c73e84ULL, 0x8dd287a20ULL, 0x94a4eee4cULL, 0xa455379b5ULL, 0xa9e92987dULL, 0xbd25cb40bULL,
+        0xbe98d3582ULL, 0xd3d5972b2ULL, 0x14c53d7c7ULL, 0x4f1796936ULL, 0x4e71fed1aULL, 0x66d46fae0ULL,
+        0xa55abb933ULL, 0xebee1accaULL, 0x1ad4ba6a4ULL, 0x305b17571ULL, 0x553611351ULL, 0x59ca62775ULL,
+        0x7819cb6a1ULL, 0xedb7bc9ebULL, 0x5b2694212ULL, 0x72e12d185ULL, 0xed6152e2cULL, 0x5bcdadbf3ULL,
+        0x78e0aa0c6ULL, 0xc60a0b909ULL, 0xef9a34b0dULL, 0x398a6621aULL, 0xa8a27c944ULL, 0x4b564304eULL,
+        0x52902b4e2ULL, 0x857280b56ULL, 0xa91b2c84bULL, 0xe91df939bULL, 0x1fa405f28ULL, 0x23793ab86ULL,
+        0x68c17729fULL, 0x9fbf3b840ULL, 0x36922413cULL, 0x4eb5f946eULL, 0x533fe2404ULL, 0x63de7d35eULL,
+        0x925eddc72ULL, 0x99b8b3896ULL, 0xaace4c708ULL, 0xc22994af0ULL, 0x8f1eae41bULL, 0xd95fb486cULL,
+        0x13fb77857ULL, 0x4fe0983a3ULL, 0xd559bf8a9ULL, 0xe1855d78dULL, 0xfec8daaadULL, 0x71ecb6d95ULL,
+        0xdc9e50e4cULL, 0xca3a4c259ULL, 0x740d12bbfULL, 0xaeedd18e0ULL, 0xb509b9c8eULL, 0x5232fea1cULL,
+        0x19282d18bULL, 0x76c22d67bULL, 0x936beb34bULL, 0x08a5ea8ddULL, 0x679eadc28ULL, 0xa08e119c5ULL,
+        0x20a6e3e24ULL, 0x7eab9c239ULL, 0x96632c32eULL, 0x470d06e44ULL, 0x8a70212fbULL, 0x0a7e4251bULL,
+        0x9ec762cc0ULL, 0xd8a3a1f48ULL, 0xdb680f346ULL, 0x4a1e93a9dULL, 0x638ddc04fULL, 0x4c2fcc993ULL,
+        0x01ef28c95ULL, 0xbf0d9792dULL, 0x6d27557c3ULL, 0x623f977f4ULL, 0x35b43be57ULL, 0xbb0c428d5ULL,
+        0xa6f01474dULL, 0x5a70c9749ULL, 0x20ddabc3bULL, 0x2eabd78cfULL, 0x90aa18f88ULL, 0xa9ea89350ULL,
+        0x3cdb39b22ULL, 0x839a08f34ULL, 0x169bb814eULL, 0x1a575ab08ULL, 0xa04d3d5a2ULL, 0xbf7902f2bULL,
+        0x095a5e65cULL, 0x92e8fce94ULL, 0x67ef48d12ULL, 0x6400dbcacULL, 0xb12d8fb9fULL, 0x0347f45d3ULL,
+        0xb35826f56ULL, 0xc546ac6e4ULL, 0x81cc35b66ULL, 0x41d14bd57ULL, 0x0c052b168ULL, 0x7d6ce5018ULL,
+        0xab4ed5edeULL, 0x5af817119ULL, 0xd1454b182ULL, 0x2badb090bULL, 0x03fcb4c0cULL, 0x2f1c28fd8ULL,
+        0x93608c6f7ULL, 0x4c93ba2b5ULL, 0x07d950a5dULL, 0xe54b3d3fcULL, 0x15560cf9dULL, 0x189e4958aULL,
+        0x62140e9d2ULL, 0x723bc1cdbULL, 0x2063f26faULL, 0xfa08ab19fULL, 0x7955641dbULL, 0x646b01daaULL,
+        0x71cd427ccULL, 0x09a42f7d4ULL, 0x717edc643ULL, 0x15eb94367ULL, 0x8392e6bb2ULL, 0x832408542ULL,
+        0x2b9b874beULL, 0xb21f4730dULL, 0xb5d8f24c9ULL, 0x7dbaf6931ULL, 0x1b4e33629ULL, 0x13452e710ULL,
+        0xe974af612ULL, 0x1df61d29aULL, 0x99f2532adULL, 0xe50ec71b4ULL, 0x5df0a36e8ULL, 0x4934e4ceaULL,
+        0xe34a0b4bdULL, 0xb7b26b588ULL, 0x0f255118dULL, 0xd0c8fa31eULL, 0x06a50c94fULL, 0xf28aa9f06ULL,
+        0x131d194d8ULL, 0x622e3da79ULL, 0xac7478303ULL, 0xc8f2521d7ULL, 0x6c9c881f5ULL, 0x49e38b60aULL,
+        0x513d8df65ULL, 0xd7c2b0785ULL, 0x9f6f9d75aULL, 0x9f6966020ULL, 0x1e1a54e33ULL, 0xc04d63419ULL,
+        0x946e04cd7ULL, 0x1bdac5902ULL, 0x56469b830ULL, 0xffad59569ULL, 0x86970e7d8ULL, 0x8a4b41e12ULL,
+        0xad4688e3bULL, 0x85f8f5df4ULL, 0xd833a0893ULL, 0x2a36fdd7cULL, 0xd6a857cf2ULL, 0x8829bc35cULL,
+        0x5e50d79bcULL, 0xfbb8035e4ULL, 0xc1a95bebfULL, 0x036b0baf8ULL, 0xe0da964eaULL, 0xb6483689bULL,
+        0x7c8e2f4c1ULL, 0x5b856a23bULL, 0x2fc183995ULL, 0xe914b6d70ULL, 0xb31041969ULL, 0x1bb478493ULL,
+        0x063e2b456ULL, 0xf2a082b9cULL, 0x8e5e646eaULL, 0x08172f8f6ULL, 0x0dacd923eULL, 0xe5dcf0e2eULL,
+        0xbf9446baeULL, 0x4822d50d1ULL, 0x26e710bf5ULL, 0xb90ba2a24ULL, 0xf3b25aa73ULL, 0x809ad589bULL,
+        0x94cc1e254ULL, 0x5334a3adbULL, 0x592886b2fULL, 0xbf64704aaULL, 0x566dbf24cULL, 0x72203e692ULL,
+        0x64e61e809ULL, 0xd7259aad6ULL, 0x7b924aedcULL, 0x2df2184e8ULL, 0x353d1eca7ULL, 0xfce30d7ceULL,
+        0xf7b0f436eULL, 0x57e8d8f68ULL, 0x8c79e60dbULL, 0x9c8362b2bULL, 0x63a5804f2ULL, 0x9298353dcULL,
+        0x6f98a71c8ULL, 0xa5731f693ULL, 0x21ca5c870ULL, 0x1c2107fd3ULL, 0x6181f6c39ULL, 0x19e574304ULL,
+        0x329937606ULL, 0x043d5c70dULL, 0x9b18ff162ULL, 0x8e2ccfebfULL, 0x72b7b9b54ULL, 0x9b71f4f3cULL,
+        0x935d7393eULL, 0x65938881aULL, 0x6a5bd6f2dULL, 0xa19783306ULL, 0xe6472f4d7ULL, 0x81163df5aULL,
+        0xa838e1cbdULL, 0x982748477ULL, 0x050c54febULL, 0x0d82fbb58ULL, 0x2c4c72799ULL, 0x97d259ad6ULL,
+        0x22d9a43edULL, 0xfdb162a9fULL, 0x0cb4a727dULL, 0x4fae2e371ULL, 0x535b5be8bULL, 0x48795908aULL,
+        0xce7c18962ULL, 0x4ea154d80ULL, 0x50c064889ULL, 0x8d97fc75dULL, 0xc8bd9ec61ULL, 0x83ee8e8bbULL,
+        0xc8431419aULL, 0x1aa78079dULL, 0x8111aa4a5ULL, 0xdfa3a69feULL, 0x51630d83fULL, 0x2d930fb3fULL,
+        0x2133116e5ULL, 0xae5395522ULL, 0xbc07a4e8aULL, 0x57bf08ba0ULL, 0x6cb18036aULL, 0xf0e2e4b75ULL,
+        0x3eb692b6fULL, 0xd8178a3faULL, 0x238cce6a6ULL, 0xe97d5cdd7ULL, 0xfe10d8d5eULL, 0xb39584a1dULL,
+        0xca03536fdULL, 0xaa61f3998ULL, 0x72ff23ec2ULL, 0x15aa7d770ULL, 0x57a3a1282ULL, 0xd1f3902dcULL,
+        0x6554c9388ULL, 0xfd01283c7ULL, 0xe8baa42c5ULL, 0x72cee6adfULL, 0xf6614b3faULL, 0x95c3778a2ULL,
+        0x7da4cea7aULL, 0xd18a5912cULL, 0xd116426e5ULL, 0x27c17bc1cULL, 0xb95b53bc1ULL, 0xc8f937a05ULL,
+        0xed220c9bdULL, 0x0c97d72abULL, 0x8fb1217aeULL, 0x25ca8a5a1ULL, 0xb261b871bULL, 0x1bef0a056ULL,
+        0x806a51179ULL, 0xeed249145ULL, 0x3f82aecebULL, 0xcc56e9acfULL, 0x2e78d01ebULL, 0x102cee17fULL,
+        0x37caad3d5ULL, 0x16ac5b1eeULL, 0x2af164eceULL, 0xd4cd81dc9ULL, 0x12263a7e7ULL, 0x57ac7d117ULL,
+        0x9391d9740ULL, 0x7aedaa77fULL, 0x9675a3c72ULL, 0x277f25191ULL, 0xebb6e64b9ULL, 0x7ad3ef747ULL,
+        0x12759b181ULL, 0x948257d4dULL, 0xb63a850f6ULL, 0x3a52a8f75ULL, 0x4a019532cULL, 0xa021a7529ULL,
+        0xcc661876dULL, 0x4085afd05ULL, 0xe7048e089ULL, 0x3f979cdc6ULL, 0xd9da9071bULL, 0xed2fc5b68ULL,
+        0x79d64c3a1ULL, 0xfd44e2361ULL, 0x8eea46a74ULL, 0x42233b9c2ULL, 0xae4d1765dULL, 0x7303a094cULL,
+        0x2d7033abeULL, 0x3dcc2b0b4ULL, 0x0f0967d09ULL, 0x06f0cd7deULL, 0x09807aca0ULL, 0x3a295cad3ULL,
+        0x2b106b202ULL, 0x3f38a828eULL, 0x78af46596ULL, 0xbda2dc713ULL, 0x9a8c8c9d9ULL, 0x6a0f2ddceULL,
+        0xa76af6fe2ULL, 0x086f66fa4ULL, 0xd52d63f8dULL, 0x89f7a6e73ULL, 0xcc6b23362ULL, 0xb4ebf3c39ULL,
+        0x564f300faULL, 0xe8de3a706ULL, 0x79a033b61ULL, 0x765e160c5ULL, 0xa266a4f85ULL, 0xa68c38c24ULL,
+        0xdca0711fbULL, 0x85fba85baULL, 0x37a207b46ULL, 0x158fcc4d0ULL, 0x0569d79b3ULL, 0x7b1a25555ULL,
+        0xa8ae22468ULL, 0x7c592bdfdULL, 0x0c59a5f66ULL, 0xb1115daa3ULL, 0xf17c87177ULL, 0x6769d766bULL,
+        0x2b637356dULL, 0x13d8685acULL, 0xf24cb6ec0ULL, 0x0bd0b56d1ULL, 0x42ff0e26dULL, 0xb41609267ULL,
+        0x96f9518afULL, 0xc56f96636ULL, 0x4a8e10349ULL, 0x863512171ULL, 0xea455d86cULL, 0xbd0e25279ULL,
+        0xe65e3f761ULL, 0x36c84a922ULL, 0x85fd1b38fULL, 0x657c91539ULL, 0x15033fe04ULL, 0x09051c921ULL,
+        0xab27d80d8ULL, 0xf92f7d0a1ULL, 0x8eb6bb737ULL, 0x10b5b0f63ULL, 0x6c9c7ad63ULL, 0xf66fe70aeULL,
+        0xca579bd92ULL, 0x956198e4dULL, 0x29e4405e5ULL, 0xe44eb885cULL, 0x41612456cULL, 0xea45e0abfULL,
+        0xd326529bdULL, 0x7b2c33cefULL, 0x80bc9b558ULL, 0x7169b9740ULL, 0xc37f99209ULL, 0x31ff6dab9ULL,
+        0xc795190edULL, 0xa7636e95fULL, 0x9df075841ULL, 0x55a083932ULL, 0xa7cbdf630ULL, 0x409ea4ef0ULL,
+        0x92a1991b6ULL, 0x4b078dee9ULL, 0xae18ce9e4ULL, 0x5a6e1ef35ULL, 0x1a403bd59ULL, 0x31ea70a83ULL,
+        0x2bc3c4f3aULL, 0x5c921b3cbULL, 0x042da05c5ULL, 0x1f667d16bULL, 0x416a368cfULL, 0xfbc0a7a3bULL,
+        0x9419f0c7cULL, 0x81be2fa03ULL, 0x34e2c172fULL, 0x28648d8aeULL, 0xc7acbb885ULL, 0x45f31eb6aULL,
+        0xd1cfc0a7bULL, 0x42c4d260dULL, 0xcf6584097ULL, 0x94b132b14ULL, 0x3c5c5df75ULL, 0x8ae596fefULL,
+        0xaea8054ebULL, 0x0ae9cc573ULL, 0x496fb731bULL, 0xebf105662ULL, 0xaf9c83a37ULL, 0xc0d64cd6bULL,
+        0x7b608159aULL, 0xe74431642ULL, 0xd6fb9d900ULL, 0x291e99de0ULL, 0x10500ba9aULL, 0x5cd05d037ULL,
+        0xa87254fb2ULL, 0x9d7824a37ULL, 0x8b2c7b47cULL, 0x30c788145ULL, 0x2f4e5a8beULL, 0xbadb884daULL,
+        0x026e0d5c9ULL, 0x6fdbaa32eULL, 0x34758eb31ULL, 0x565cd1b4fULL, 0x2bfd90fb0ULL, 0x093052a6bULL,
+        0xd3c13c4b9ULL, 0x2daea43bfULL, 0xa279762bcULL, 0xf1bd9f22cULL, 0x4b7fec94fULL, 0x545761d5aULL,
+        0x7327df411ULL, 0x1b52a442eULL, 0x49b0ce108ULL, 0x24c764bc8ULL, 0x374563045ULL, 0xa3e8f91c6ULL,
+        0x0e6bd2241ULL, 0xe0e52ee3cULL, 0x07e8e3caaULL, 0x96c2b7372ULL, 0x33acbdfdaULL, 0xb15d91e54ULL,
+        0x464759ac1ULL, 0x6886a1998ULL, 0x57f5d3958ULL, 0x5a1f5c1f5ULL, 0x0b58158adULL, 0xe712053fbULL,
+        0x5352ddb25ULL, 0x414b98ea0ULL, 0x74f89f546ULL, 0x38a56b3c3ULL, 0x38db0dc17ULL, 0xaa016a755ULL,
+        0xdc72366f5ULL, 0x0cee93d75ULL, 0xb2fe7a56bULL, 0xa847ed390ULL, 0x8713ef88cULL, 0xa217cc861ULL,
+        0x8bca25d7bULL, 0x455526818ULL, 0xea3a7a180ULL, 0xa9536e5e0ULL, 0x9b64a1975ULL, 0x5bfc756bcULL,
+        0x046aa169bULL, 0x53a17f76fULL, 0x4d6815274ULL, 0xcca9cf3f6ULL, 0x4013fcb8bULL, 0x3d26cdfa5ULL,
+        0x5786231f7ULL, 0x7d4ab09abULL, 0x960b5ffbcULL, 0x8914df0d4ULL, 0x2fc6f2213ULL, 0xac235637eULL,
+        0x151b28ed3ULL, 0x46f79b6dbULL, 0x1382e0c9fULL, 0x53abf983aULL, 0x383c47adeULL, 0x3fcf88978ULL,
+        0xeb9079df7ULL, 0x09af0714dULL, 0xda19d1bb7ULL, 0x9a02749f8ULL, 0x1c62dab9bULL, 0x1a137e44bULL,
+        0x2867718c7ULL, 0x35815525bULL, 0x7cd35c550ULL, 0x2164f73a0ULL, 0xe8b772fe0ULL,
+    };
+    return dictionary;
+}
+
+bool loadDictionary(const std::string& path, MarkerDictionary& dictionary) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[Aruco] Could not open dictionary: " << path << std::endl;
+        return false;
+    }
+
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        MarkerDictionary loaded;
+        loaded.name = j.value("name", path);
+        loaded.markerBits = j.value("marker_bits", 6);
+        loaded.maxCorrection = j.value("max_correction", 0);
+        for (const nlohmann::json& code : j.at("codes")) {
+            loaded.codes.push_back(code.is_string() ? std::stoull(code.get<std::string>(), nullptr, 0)
+                                                    : code.get<uint64_t>());
+        }
+        if (j.value("layout", "rowmajor") == "apriltag") {
+            if (loaded.markerBits != 6) {
+                std::cerr << "[Aruco] The AprilTag layout is only known for 36-bit families." << std::endl;
+                return false;
+            }
+            loaded.bitCells = aprilTagLayout();
+        }
+        if (loaded.markerBits < 3 || loaded.markerBits > 8 || loaded.codes.empty()) {
+            std::cerr << "[Aruco] Unusable dictionary: " << path << std::endl;
+            return false;
+        }
+        dictionary = loaded;
+    } catch (const std::exception& e) {
+        std::cerr << "[Aruco] Bad dictionary " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --- ADAPTIVE THRESHOLD ---
+
+// colSum[x] += add[x] - sub[x]: the vertical half of the box filter, one row at a time
+static void slideColumns(uint16_t* colSum, const uint8_t* add, const uint8_t* sub, int n) {
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= n; x += 16) {
+        uint8x16_t a = vld1q_u8(add + x);
+        uint8x16_t s = vld1q_u8(sub + x);
+        uint16x8_t lo = vsubw_u8(vaddw_u8(vld1q_u16(colSum + x), vget_low_u8(a)), vget_low_u8(s));
+        uint16x8_t hi = vsubw_u8(vaddw_u8(vld1q_u16(colSum + x + 8), vget_high_u8(a)), vget_high_u8(s));
+        vst1q_u16(colSum + x, lo);
+        vst1q_u16(colSum + x + 8, hi);
+    }
+#endif
+    for (; x < n; ++x) colSum[x] = static_cast<uint16_t>(colSum[x] + add[x] - sub[x]);
+}
+
+// out[x] = 1 where (pixel + offset) * count < local sum, i.e. darker than the local mean
+static void thresholdRow(uint8_t* out, const uint8_t* pixels, const uint32_t* boxSum,
+                         const uint32_t* boxCount, int offset, int n) {
+    for (int x = 0; x < n; ++x) {
+        out[x] = (static_cast<uint32_t>(pixels[x] + offset) * boxCount[x] < boxSum[x]) ? 1 : 0;
+    }
+}
+
+// Box window x window (rows replicated at the top / bottom edges, columns clipped)
+static void adaptiveThreshold(const LumaImage& luma, int window, int offset, std::vector<uint8_t>& binary) {
+    const int width = luma.width;
+    const int height = luma.height;
+    const int radius = std::clamp(window, 3, 31) / 2;
+    binary.assign(static_cast<size_t>(width) * height, 0);
+
+    std::vector<uint16_t> colSum(width, 0);
+    std::vector<uint32_t> prefix(width + 1), boxSum(width), boxCount(width);
+    auto clampRow = [&](int y) { return luma.row(std::clamp(y, 0, height - 1)); };
+
+    for (int k = -radius; k <= radius; ++k) {
+        const uint8_t* row = clampRow(k);
+        for (int x = 0; x < width; ++x) colSum[x] = static_cast<uint16_t>(colSum[x] + row[x]);
+    }
+    const uint32_t rows = 2 * radius + 1;
+    for (int x = 0; x < width; ++x) {
+        boxCount[x] = rows * static_cast<uint32_t>(std::min(x + radius, width - 1) - std::max(x - radius, 0) + 1);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        if (y > 0) slideColumns(colSum.data(), clampRow(y + radius), clampRow(y - radius - 1), width);
+
+        // Horizontal half: prefix sums of the column sums
+        prefix[0] = 0;
+        for (int x = 0; x < width; ++x) prefix[x + 1] = prefix[x] + colSum[x];
+        for (int x = 0; x < width; ++x) {
+            boxSum[x] = prefix[std::min(x + radius + 1, width)] - prefix[std::max(x - radius, 0)];
+        }
+
+        thresholdRow(&binary[static_cast<size_t>(y) * width], luma.row(y), boxSum.data(), boxCount.data(),
+                     offset, width);
+    }
+}
+
+// --- CONTOURS ---
+
+struct Point {
+    float x, y;
+};
+
+// Clockwise (image y down): E, SE, S, SW, W, NW, N, NE
+static const int kDx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+static const int kDy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+// Moore-neighbour tracing of the outer border of the component holding 'start'
+// ('start' = its first pixel in raster order, so its west neighbour is background).
+// Returns the border pixels in clockwise order.
+static std::vector<Point> traceContour(const std::vector<uint8_t>& binary, int width, int height,
+                                       int startX, int startY, size_t maxLength) {
+    auto dark = [&](int x, int y) {
+        return x >= 0 && y >= 0 && x < width && y < height && binary[static_cast<size_t>(y) * width + x];
+    };
+
+    std::vector<Point> contour;
+    int x = startX, y = startY;
+    int backtrack = 4; // Came from the west
+    const int firstBacktrack = backtrack;
+
+    do {
+        contour.push_back({ x + 0.5f, y + 0.5f }); // Pixel centre
+        int d = 0;
+        for (; d < 8; ++d) {
+            int dir = (backtrack + 1 + d) & 7;
+            if (dark(x + kDx[dir], y + kDy[dir])) {
+                // New backtrack: the (background) cell checked just before, seen from the new pixel
+                int prev = (dir + 7) & 7;
+                int bx = x + kDx[prev] - (x + kDx[dir]);
+                int by = y + kDy[prev] - (y + kDy[dir]);
+                x += kDx[dir];
+                y += kDy[dir];
+                for (int k = 0; k < 8; ++k) {
+                    if (kDx[k] == bx && kDy[k] == by) backtrack = k;
+                }
+                break;
+            }
+        }
+        if (d == 8) break; // Isolated pixel
+    } while (!(x == startX && y == startY && backtrack == firstBacktrack) && contour.size() < maxLength);
+
+    return contour;
+}
+
+// Douglas-Peucker on contour[first..last] (indices modulo size), appends kept vertices
+static void simplify(const std::vector<Point>& contour, size_t first, size_t last, float epsilon,
+                     std::vector<size_t>& kept) {
+    const size_t n = contour.size();
+    const Point& a = contour[first % n];
+    const Point& b = contour[last % n];
+    const float dx = b.x - a.x, dy = b.y - a.y;
+    const float length = std::max(1e-3f, std::sqrt(dx * dx + dy * dy));
+
+    float maxDistance = 0.0f;
+    size_t farthest = first;
+    for (size_t i = first + 1; i < last; ++i) {
+        const Point& p = contour[i % n];
+        float distance = std::fabs(dy * (p.x - a.x) - dx * (p.y - a.y)) / length;
+        if (distance > maxDistance) {
+            maxDistance = distance;
+            farthest = i;
+        }
+    }
+    if (maxDistance > epsilon) {
+        simplify(contour, first, farthest, epsilon, kept);
+        kept.push_back(farthest % n);
+        simplify(contour, farthest, last, epsilon, kept);
+    }
+}
+
+// Closed-polygon approximation: split at the point farthest from contour[0]
+static std::vector<size_t> approximatePolygon(const std::vector<Point>& contour, float epsilon) {
+    size_t farthest = 0;
+    float best = 0.0f;
+    for (size_t i = 1; i < contour.size(); ++i) {
+        float dx = contour[i].x - contour[0].x, dy = contour[i].y - contour[0].y;
+        if (dx * dx + dy * dy > best) {
+            best = dx * dx + dy * dy;
+            farthest = i;
+        }
+    }
+
+    std::vector<size_t> kept = { 0 };
+    simplify(contour, 0, farthest, epsilon, kept);
+    kept.push_back(farthest);
+    simplify(contour, farthest, contour.size(), epsilon, kept);
+    return kept;
+}
+
+// Least-squares line through the middle 80% of a side, moved half a pixel outwards
+// (border pixels sit inside the true edge). Returns (a, b, c) with a x + b y = c.
+static bool fitSide(const std::vector<Point>& contour, size_t from, size_t to, const Point& centre,
+                    float line[3]) {
+    const size_t n = contour.size();
+    const size_t span = (to + n - from) % n;
+    const size_t skip = span / 10;
+    if (span < 3) return false;
+
+    float mx = 0, my = 0;
+    int count = 0;
+    for (size_t i = skip; i <= span - skip; ++i) {
+        mx += contour[(from + i) % n].x;
+        my += contour[(from + i) % n].y;
+        ++count;
+    }
+    mx /= count;
+    my /= count;
+    float sxx = 0, sxy = 0, syy = 0;
+    for (size_t i = skip; i <= span - skip; ++i) {
+        float dx = contour[(from + i) % n].x - mx, dy = contour[(from + i) % n].y - my;
+        sxx += dx * dx;
+        sxy += dx * dy;
+        syy += dy * dy;
+    }
+
+    // Normal = eigenvector of the smallest eigenvalue of the scatter matrix
+    const float angle = 0.5f * std::atan2(2.0f * sxy, sxx - syy); // Direction of the line
+    float a = -std::sin(angle), b = std::cos(angle);
+    float c = a * mx + b * my;
+    if (a * centre.x + b * centre.y > c) { // Normal must point away from the quad
+        a = -a;
+        b = -b;
+        c = -c;
+    }
+    line[0] = a;
+    line[1] = b;
+    line[2] = c + 0.5f;
+    return true;
+}
+
+static bool intersect(const float l1[3], const float l2[3], Point& p) {
+    float det = l1[0] * l2[1] - l1[1] * l2[0];
+    if (std::fabs(det) < 1e-6f) return false;
+    p.x = (l1[2] * l2[1] - l1[1] * l2[2]) / det;
+    p.y = (l1[0] * l2[2] - l1[2] * l2[0]) / det;
+    return true;
+}
+
+// --- DECODING ---
+
+// Maps grid coordinates (0..size) of the marker square onto the image quad
+struct Homography {
+    float h[9];
+
+    bool fit(const Point quad[4], float size) {
+        // 8x8 linear system, Gaussian elimination with partial pivoting
+        const float src[4][2] = { {0, 0}, {size, 0}, {size, size}, {0, size} };
+        double a[8][9];
+        for (int i = 0; i < 4; ++i) {
+            double u = src[i][0], v = src[i][1], x = quad[i].x, y = quad[i].y;
+            double r1[9] = { u, v, 1, 0, 0, 0, -u * x, -v * x, x };
+            double r2[9] = { 0, 0, 0, u, v, 1, -u * y, -v * y, y };
+            std::copy(r1, r1 + 9, a[2 * i]);
+            std::copy(r2, r2 + 9, a[2 * i + 1]);
+        }
+        for (int col = 0; col < 8; ++col) {
+            int pivot = col;
+            for (int r = col + 1; r < 8; ++r) {
+                if (std::fabs(a[r][col]) > std::fabs(a[pivot][col])) pivot = r;
+            }
+            if (std::fabs(a[pivot][col]) < 1e-9) return false;
+            std::swap(a[col], a[pivot]);
+            for (int r = 0; r < 8; ++r) {
+                if (r == col) continue;
+                double f = a[r][col] / a[col][col];
+                for (int k = col; k < 9; ++k) a[r][k] -= f * a[col][k];
+            }
+        }
+        for (int i = 0; i < 8; ++i) h[i] = static_cast<float>(a[i][8] / a[i][i]);
+        h[8] = 1.0f;
+        return true;
+    }
+
+    Point map(float u, float v) const {
+        float w = h[6] * u + h[7] * v + h[8];
+        return { (h[0] * u + h[1] * v + h[2]) / w, (h[3] * u + h[4] * v + h[5]) / w };
+    }
+};
+
+// Bilinear sample, -1 outside the image
+static float sample(const LumaImage& luma, Point p) {
+    float x = p.x - 0.5f, y = p.y - 0.5f; // Pixel centres sit at +0.5
+    if (x < 0 || y < 0 || x >= luma.width - 1 || y >= luma.height - 1) return -1.0f;
+    int x0 = static_cast<int>(x), y0 = static_cast<int>(y);
+    float fx = x - x0, fy = y - y0;
+    const uint8_t* r0 = luma.row(y0) + x0;
+    const uint8_t* r1 = luma.row(y0 + 1) + x0;
+    return (r0[0] * (1 - fx) + r0[1] * fx) * (1 - fy) + (r1[0] * (1 - fx) + r1[1] * fx) * fy;
+}
+
+// Mean of 4 samples around a cell centre (robust to blur and JPEG ringing)
+static float sampleCell(const LumaImage& luma, const Homography& H, float cx, float cy) {
+    float total = 0.0f;
+    for (int k = 0; k < 4; ++k) {
+        float v = sample(luma, H.map(cx + 0.5f + ((k & 1) ? 0.2f : -0.2f), cy + 0.5f + ((k & 2) ? 0.2f : -0.2f)));
+        if (v < 0) return -1.0f;
+        total += v;
+    }
+    return total * 0.25f;
+}
+
+static float median(std::vector<float>& values) {
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+static int popcount64(uint64_t v) {
+    int count = 0;
+    for (; v; v &= v - 1) ++count;
+    return count;
+}
+
+// Reads the cell grid of a quad and looks it up in the dictionary, in all 4 rotations.
+// On success, 'rotation' tells which quad corner is the marker's top-left.
+static bool decodeQuad(const LumaImage& luma, const Point quad[4], const MarkerDictionary& dictionary,
+                       int& id, int& hamming, int& rotation) {
+    const int cells = dictionary.markerBits + 2;
+    Homography H;
+    if (!H.fit(quad, static_cast<float>(cells))) return false;
+
+    // 1. Cell values, the black border and the white quiet zone around it
+    std::vector<float> grid(cells * cells);
+    std::vector<float> border, quiet;
+    for (int y = 0; y < cells; ++y) {
+        for (int x = 0; x < cells; ++x) {
+            float v = sampleCell(luma, H, static_cast<float>(x), static_cast<float>(y));
+            if (v < 0) return false;
+            grid[y * cells + x] = v;
+            if (x == 0 || y == 0 || x == cells - 1 || y == cells - 1) border.push_back(v);
+        }
+    }
+    for (int i = 0; i < cells; ++i) {
+        const float ring[4][2] = { {float(i), -1}, {float(i), float(cells)}, {-1, float(i)}, {float(cells), float(i)} };
+        for (const auto& cell : ring) {
+            float v = sampleCell(luma, H, cell[0], cell[1]);
+            if (v >= 0) quiet.push_back(v);
+        }
+    }
+    if (quiet.size() < static_cast<size_t>(cells)) return false;
+
+    const float black = median(border);
+    const float white = median(quiet);
+    if (white - black < 20.0f) return false; // No contrast: not a printed marker
+    const float threshold = 0.5f * (black + white);
+
+    int borderErrors = 0;
+    for (float v : border) borderErrors += v > threshold;
+    if (borderErrors > cells / 2) return false;
+
+    // 2. Bits in reading order, for each rotation: rotating the grid by 90 degrees
+    //    clockwise maps cell (u, v) of the rotated marker to (n - 1 - v, u)
+    const int n = dictionary.markerBits;
+    const int bits = n * n;
+    int bestHamming = dictionary.maxCorrection + 1;
+    for (int r = 0; r < 4; ++r) {
+        uint64_t code = 0;
+        for (int i = 0; i < bits; ++i) {
+            int u = dictionary.bitCells.empty() ? i % n : dictionary.bitCells[i].first;
+            int v = dictionary.bitCells.empty() ? i / n : dictionary.bitCells[i].second;
+            for (int k = 0; k < r; ++k) {
+                int t = u;
+                u = n - 1 - v;
+                v = t;
+            }
+            code = (code << 1) | (grid[(v + 1) * cells + (u + 1)] > threshold ? 1 : 0);
+        }
+
+        for (size_t c = 0; c < dictionary.codes.size(); ++c) {
+            int distance = popcount64(code ^ dictionary.codes[c]);
+            if (distance < bestHamming) {
+                bestHamming = distance;
+                id = static_cast<int>(c);
+                rotation = r;
+            }
+        }
+    }
+    hamming = bestHamming;
+    return bestHamming <= dictionary.maxCorrection;
+}
+
+// --- DETECTOR ---
+
+std::vector<MarkerDetection> detectMarkers(const LumaImage& luma, const MarkerDictionary& dictionary,
+                                           const DetectorOptions& options) {
+    std::vector<MarkerDetection> markers;
+    const int width = luma.width;
+    const int height = luma.height;
+    if (width < 3 || height < 3) return markers;
+
+    // 1. Dark-on-local-mean binary image
+    std::vector<uint8_t> binary;
+    adaptiveThreshold(luma, options.thresholdWindow, options.thresholdOffset, binary);
+
+    // 2. Connected components (8-connectivity), keeping only plausible marker blobs
+    std::vector<int32_t> labels(binary.size(), 0);
+    std::vector<int32_t> stack;
+    int32_t label = 0;
+    const int maxSide = std::min(width, height) * 9 / 10;
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const size_t index = static_cast<size_t>(y) * width + x;
+            if (!binary[index] || labels[index]) continue;
+
+            ++label;
+            int minX = x, maxX = x, minY = y, maxY = y;
+            size_t area = 0;
+            labels[index] = label;
+            stack.push_back(static_cast<int32_t>(index));
+            while (!stack.empty()) {
+                const int32_t p = stack.back();
+                stack.pop_back();
+                ++area;
+                const int px = p % width, py = p / width;
+                minX = std::min(minX, px); maxX = std::max(maxX, px);
+                minY = std::min(minY, py); maxY = std::max(maxY, py);
+                for (int d = 0; d < 8; ++d) {
+                    const int nx = px + kDx[d], ny = py + kDy[d];
+                    if (nx < 0 || ny < 0 || nx >= width || ny >= height) continue;
+                    const size_t q = static_cast<size_t>(ny) * width + nx;
+                    if (binary[q] && !labels[q]) {
+                        labels[q] = label;
+                        stack.push_back(static_cast<int32_t>(q));
+                    }
+                }
+            }
+
+            // Size, aspect and fill: a marker's border alone covers ~40% of its square
+            const int boxW = maxX - minX + 1, boxH = maxY - minY + 1;
+            if (boxW < options.minSide || boxH < options.minSide || boxW > maxSide || boxH > maxSide) continue;
+            if (boxW > 4 * boxH || boxH > 4 * boxW) continue;
+            if (area < static_cast<size_t>(boxW) * boxH / 8) continue;
+            if (minX == 0 || minY == 0 || maxX == width - 1 || maxY == height - 1) continue; // Cut by the frame
+
+            // 3. Outer contour -> quad
+            std::vector<Point> contour = traceContour(binary, width, height, x, y, 8 * static_cast<size_t>(boxW + boxH));
+            if (contour.size() < static_cast<size_t>(4 * options.minSide)) continue;
+            std::vector<size_t> vertices = approximatePolygon(contour, options.polygonAccuracy * contour.size() / 4.0f);
+            if (vertices.size() != 4) continue;
+
+            Point corners[4], centre = { 0, 0 };
+            for (int i = 0; i < 4; ++i) {
+                centre.x += contour[vertices[i]].x * 0.25f;
+                centre.y += contour[vertices[i]].y * 0.25f;
+            }
+            float lines[4][3];
+            bool ok = true;
+            for (int i = 0; i < 4 && ok; ++i) ok = fitSide(contour, vertices[i], vertices[(i + 1) & 3], centre, lines[i]);
+            for (int i = 0; i < 4 && ok; ++i) ok = intersect(lines[(i + 3) & 3], lines[i], corners[i]);
+            if (!ok) continue;
+
+            // Convex, and no degenerate side
+            bool convex = true;
+            for (int i = 0; i < 4; ++i) {
+                const Point &a = corners[i], &b = corners[(i + 1) & 3], &c = corners[(i + 2) & 3];
+                float cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+                float side = std::hypot(b.x - a.x, b.y - a.y);
+                if (cross <= 0.0f || side < options.minSide * 0.5f) convex = false;
+            }
+            if (!convex) continue;
+
+            // 4. Decode
+            int id = -1, hamming = 0, rotation = 0;
+            if (!decodeQuad(luma, corners, dictionary, id, hamming, rotation)) continue;
+
+            MarkerDetection marker;
+            marker.id = id;
+            marker.hamming = hamming;
+            for (int i = 0; i < 4; ++i) {
+                // Rotation r: the marker's top-left is quad corner r
+                const Point& p = corners[(i + rotation) & 3];
+                marker.corners[i][0] = p.x * luma.scale;
+                marker.corners[i][1] = p.y * luma.scale;
+            }
+            markers.push_back(marker);
+        }
+    }
+    return markers;
+}
+
+bool writeMarkersJson(const std::string& path, const std::vector<MarkerDetection>& markers,
+                      const MarkerDictionary& dictionary) {
+    nlohmann::json j;
+    j["dictionary"] = dictionary.name;
+    j["markers"] = nlohmann::json::array();
+    for (const MarkerDetection& marker : markers) {
+        nlohmann::json corners = nlohmann::json::array();
+        for (const auto& corner : marker.corners) {
+            // 0.1 px is plenty and keeps the sidecar small
+            corners.push_back({ std::round(corner[0] * 10.0) / 10.0, std::round(corner[1] * 10.0) / 10.0 });
+        }
+        j["markers"].push_back({ {"id", marker.id}, {"hamming", marker.hamming}, {"corners", corners} });
+    }
+
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[Aruco] Could not write " << path << std::endl;
+        return false;
+    }
+    file << j.dump() << "\n";
+    return file.good();
+}
+
+}
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include "imaging/Luma.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // A family of square fiducials: (markerBits x markerBits) data cells inside a
+    // one-cell black border, inside a white quiet zone.
+    struct MarkerDictionary {
+        std::string name;
+        int markerBits = 6;     // Data cells per side
+        int maxCorrection = 3;  // Bit errors still accepted when matching a code
+        std::vector<uint64_t> codes; // Index = marker ID, white cell = 1, first bit read = MSB
+        // Data cell (x, y) of each bit, in reading order (0-based, inside the border).
+        // Empty = row-major (the ArUco layout); AprilTag families use a spiral.
+        std::vector<std::pair<int, int>> bitCells;
+    };
+
+    // AprilTag tag36h11 (what our field kits carry; OpenCV calls it DICT_APRILTAG_36h11).
+    // All 587 IDs are built in; other families, or any ArUco dictionary, can be
+    // loaded with loadDictionary().
+    MarkerDictionary builtinDictionary();
+
+    // JSON: {"name": "...", "marker_bits": 6, "max_correction": 3,
+    //        "layout": "rowmajor" | "apriltag", "codes": ["0xd7e00984b", ...]}
+    bool loadDictionary(const std::string& path, MarkerDictionary& dictionary);
+
+    struct MarkerDetection {
+        int id = -1;
+        int hamming = 0;         // Corrected bit errors
+        float corners[4][2];     // Full-resolution pixels, clockwise from the marker's top-left
+    };
+
+    struct DetectorOptions {
+        int thresholdWindow = 21;      // Adaptive threshold box, pixels at working resolution (odd, <= 31)
+        int thresholdOffset = 7;       // Darker than the local mean by this much = candidate
+        int minSide = 12;              // Smallest marker side, pixels at working resolution
+        float polygonAccuracy = 0.04f; // Douglas-Peucker tolerance, fraction of the contour length
+    };
+
+    // Adaptive threshold -> connected components -> outer contours -> quads ->
+    // homography sampling of the cell grid -> dictionary lookup (4 rotations).
+    // 'luma' is usually a 1/2 or 1/4 scale plane; corners are scaled back by luma.scale.
+    std::vector<MarkerDetection> detectMarkers(const LumaImage& luma, const MarkerDictionary& dictionary,
+                                               const DetectorOptions& options = DetectorOptions());
+
+    // Compact JSON sidecar: {"dictionary": ..., "markers": [{"id", "hamming", "corners"}]}
+    bool writeMarkersJson(const std::string& path, const std::vector<MarkerDetection>& markers,
+                          const MarkerDictionary& dictionary);
+
+}
+}
@@ -0,0 +1,198 @@
+#include "ExposureFusion.hpp"
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+namespace horus {
+namespace imaging {
+
+// Pixels per tile: 3 frames x 1024 px x 3 bytes of uint16 weights stay inside L1
+static const int kTilePixels = 1024;
+
+// Luma of one pixel, 0..255 (BT.601 integer approximation for BGR)
+static inline int lumaAt(const FrameView& frame, int x, int y) {
+    if (frame.layout == PixelLayout::YUV420) {
+        return frame.planes[0][static_cast<size_t>(y) * frame.strides[0] + x];
+    }
+    const uint8_t* px = frame.planes[0] + static_cast<size_t>(y) * frame.strides[0] + x * 3;
+    return (29 * px[0] + 150 * px[1] + 77 * px[2]) >> 8;
+}
+
+// Block map of raw (un-normalised) weights for one exposure
+static void computeBlockWeights(const FrameView& frame, const FusionOptions& options,
+                                const float* wellExposed, int blocksX, int blocksY,
+                                std::vector<float>& weights) {
+    const int bs = options.blockSize;
+    weights.assign(static_cast<size_t>(blocksX) * blocksY, 0.0f);
+
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const int x0 = bx * bs, x1 = std::min(x0 + bs, frame.width);
+            const int y0 = by * bs, y1 = std::min(y0 + bs, frame.height);
+
+            // Every other pixel is plenty for block statistics
+            float exposure = 0.0f, sum = 0.0f, sumSq = 0.0f;
+            int n = 0;
+            for (int y = y0; y < y1; y += 2) {
+                for (int x = x0; x < x1; x += 2) {
+                    int l = lumaAt(frame, x, y);
+                    exposure += wellExposed[l];
+                    sum += l;
+                    sumSq += static_cast<float>(l * l);
+                    ++n;
+                }
+            }
+            float mean = sum / n;
+            float contrast = std::sqrt(std::max(0.0f, sumSq / n - mean * mean)) / 32.0f;
+            weights[by * blocksX + bx] = (exposure / n) * (1.0f + options.contrastWeight * contrast) + 1e-6f;
+        }
+    }
+}
+
+// 3x3 box blur at block resolution: hides block edges in the final blend
+static void smoothBlockWeights(std::vector<float>& weights, int blocksX, int blocksY) {
+    std::vector<float> tmp(weights.size());
+    for (int y = 0; y < blocksY; ++y) {
+        for (int x = 0; x < blocksX; ++x) {
+            float sum = 0.0f;
+            int n = 0;
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dx = -1; dx <= 1; ++dx) {
+                    int yy = y + dy, xx = x + dx;
+                    if (yy < 0 || yy >= blocksY || xx < 0 || xx >= blocksX) continue;
+                    sum += weights[yy * blocksX + xx];
+                    ++n;
+                }
+            }
+            tmp[y * blocksX + x] = sum / n;
+        }
+    }
+    weights.swap(tmp);
+}
+
+// Blends one plane. 'scale' maps plane coordinates to luma coordinates (2 for chroma).
+static void blendPlane(const std::vector<FrameView>& inputs, OwnedFrame& out, int plane,
+                       const std::vector<std::vector<float>>& maps, int blocksX, int blocksY,
+                       int blockSize, int scale) {
+    const size_t frames = inputs.size();
+    const PixelLayout layout = out.layout;
+    const int channels = layout == PixelLayout::BGR888 ? 3 : 1;
+    const int width = planeRowBytes(layout, out.width, plane) / channels;
+    const int rows = planeRows(layout, out.height, plane);
+
+    // Horizontal interpolation positions are the same for every row
+    std::vector<int> jx0(width), jx1(width);
+    std::vector<float> tx(width);
+    for (int x = 0; x < width; ++x) {
+        float fx = std::clamp((x * scale + 0.5f * scale) / blockSize - 0.5f, 0.0f, blocksX - 1.0f);
+        jx0[x] = static_cast<int>(fx);
+        jx1[x] = std::min(jx0[x] + 1, blocksX - 1);
+        tx[x] = fx - jx0[x];
+    }
+
+    std::vector<std::vector<float>> column(frames, std::vector<float>(blocksX));
+    std::vector<uint16_t> tileWeights(frames * kTilePixels * channels);
+    std::vector<uint16_t> acc(kTilePixels * channels);
+
+    for (int y = 0; y < rows; ++y) {
+        // 1. Vertical interpolation of every frame's block map, once per row
+        float fy = std::clamp((y * scale + 0.5f * scale) / blockSize - 0.5f, 0.0f, blocksY - 1.0f);
+        int r0 = static_cast<int>(fy), r1 = std::min(r0 + 1, blocksY - 1);
+        float ty = fy - r0;
+        for (size_t k = 0; k < frames; ++k) {
+            const float* m0 = &maps[k][static_cast<size_t>(r0) * blocksX];
+            const float* m1 = &maps[k][static_cast<size_t>(r1) * blocksX];
+            for (int j = 0; j < blocksX; ++j) column[k][j] = m0[j] + (m1[j] - m0[j]) * ty;
+        }
+
+        uint8_t* dst = out.plane(plane) + static_cast<size_t>(y) * out.strides[plane];
+
+        for (int xt = 0; xt < width; xt += kTilePixels) {
+            const int tileWidth = std::min(kTilePixels, width - xt);
+            const int tileBytes = tileWidth * channels;
+
+            // 2. Fixed-point weights for this tile (sum over frames == 256 for every sample)
+            for (int i = 0; i < tileWidth; ++i) {
+                const int x = xt + i;
+                int used = 0;
+                for (size_t k = 0; k < frames; ++k) {
+                    float w = column[k][jx0[x]] + (column[k][jx1[x]] - column[k][jx0[x]]) * tx[x];
+                    int q = (k + 1 == frames) ? 256 - used : std::clamp(static_cast<int>(w * 256.0f + 0.5f), 0, 256 - used);
+                    used += q;
+                    uint16_t* wk = &tileWeights[k * kTilePixels * channels + i * channels];
+                    for (int c = 0; c < channels; ++c) wk[c] = static_cast<uint16_t>(q);
+                }
+            }
+
+            // 3. The hot loop: uint8 x uint16 multiply-accumulate, fits uint16 (256 * 255).
+            //    One flat pass per frame over contiguous arrays -> vectorises cleanly.
+            uint16_t* a = acc.data();
+            std::fill(a, a + tileBytes, static_cast<uint16_t>(128)); // Rounding
+            for (size_t k = 0; k < frames; ++k) {
+                const uint8_t* src = inputs[k].planes[plane] + static_cast<size_t>(y) * inputs[k].strides[plane]
+                                     + static_cast<size_t>(xt) * channels;
+                const uint16_t* w = &tileWeights[k * kTilePixels * channels];
+                for (int i = 0; i < tileBytes; ++i) {
+                    a[i] = static_cast<uint16_t>(a[i] + w[i] * src[i]);
+                }
+            }
+            uint8_t* o = dst + static_cast<size_t>(xt) * channels;
+            for (int i = 0; i < tileBytes; ++i) {
+                o[i] = static_cast<uint8_t>(a[i] >> 8);
+            }
+        }
+    }
+}
+
+bool fuseExposures(const std::vector<FrameView>& inputs, OwnedFrame& out, const FusionOptions& options) {
+    if (inputs.empty()) return false;
+    const FrameView& first = inputs[0];
+    for (const FrameView& frame : inputs) {
+        if (frame.layout != first.layout || frame.width != first.width || frame.height != first.height) {
+            std::cerr << "[Fusion] Exposures differ in size or format." << std::endl;
+            return false;
+        }
+    }
+
+    // Only (re)allocate when needed: keeps in-place fusion into inputs[0] possible
+    if (out.layout != first.layout || out.width != first.width || out.height != first.height || out.data.empty()) {
+        out.allocate(first.layout, first.width, first.height);
+    }
+
+    // Well-exposedness lookup: gaussian around mid-grey
+    float wellExposed[256];
+    for (int l = 0; l < 256; ++l) {
+        float d = l / 255.0f - 0.5f;
+        wellExposed[l] = std::exp(-(d * d) / (2.0f * options.sigma * options.sigma));
+    }
+
+    // 1. Weight maps
+    const int blocksX = (first.width + options.blockSize - 1) / options.blockSize;
+    const int blocksY = (first.height + options.blockSize - 1) / options.blockSize;
+    std::vector<std::vector<float>> maps(inputs.size());
+    for (size_t k = 0; k < inputs.size(); ++k) {
+        computeBlockWeights(inputs[k], options, wellExposed, blocksX, blocksY, maps[k]);
+    }
+
+    // 2. Normalise across exposures, smooth, normalise again
+    auto normalise = [&]() {
+        for (size_t i = 0; i < maps[0].size(); ++i) {
+            float total = 0.0f;
+            for (const std::vector<float>& map : maps) total += map[i];
+            for (std::vector<float>& map : maps) map[i] /= total;
+        }
+    };
+    normalise();
+    for (std::vector<float>& map : maps) smoothBlockWeights(map, blocksX, blocksY);
+    normalise();
+
+    // 3. Blend every plane
+    for (int p = 0; p < planeCount(first.layout); ++p) {
+        int scale = (first.layout == PixelLayout::YUV420 && p > 0) ? 2 : 1;
+        blendPlane(inputs, out, p, maps, blocksX, blocksY, options.blockSize, scale);
+    }
+    return true;
+}
+
+}
+}
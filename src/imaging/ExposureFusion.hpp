@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    struct FusionOptions {
+        int blockSize = 16;          // Weight map resolution: one weight per block x block pixels
+        float sigma = 0.2f;          // Well-exposedness: gaussian width around mid-grey (0..1 scale)
+        float contrastWeight = 1.0f; // Extra weight for textured blocks (0 = exposure only)
+    };
+
+    // Exposure fusion (a simplified Mertens et al.) of N aligned frames of the same geometry.
+    //  1. Per block and per frame: weight = mean well-exposedness x (1 + local contrast).
+    //  2. Weights are normalised across frames and smoothed at block resolution.
+    //  3. Every output sample = sum_k w_k * in_k, with w_k bilinearly interpolated from the
+    //     block map and quantised to 8.8 fixed point (sum = 256), so the blend is a pure
+    //     uint8 x uint16 multiply-accumulate: exactly what NEON (vmlal) and the
+    //     auto-vectoriser are good at. Rows are processed in L1-sized tiles.
+    // 'out' may alias inputs[0] (same geometry): fusion then runs in place, saving a frame.
+    bool fuseExposures(const std::vector<FrameView>& inputs, OwnedFrame& out,
+                       const FusionOptions& options = FusionOptions());
+
+}
+}
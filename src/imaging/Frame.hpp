@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace horus {
+namespace imaging {
+
+// Memory layout of a frame coming out of the ISP.
+// BGR888  : one interleaved plane, 3 bytes per pixel (B, G, R).
+// YUV420  : three planes (Y full size, U and V at half width / half height).
+enum class PixelLayout {
+    BGR888,
+    YUV420
+};
+
+// Non-owning view over a mapped frame.
+// Nothing is copied: the pointers refer straight into the (DMA) buffer,
+// so the view is only valid while the buffer stays mapped.
+struct FrameView {
+    PixelLayout layout = PixelLayout::BGR888;
+    int width = 0;
+    int height = 0;
+    const uint8_t* planes[3] = {nullptr, nullptr, nullptr};
+    int strides[3] = {0, 0, 0}; // Bytes per row, per plane (Memory width != Image width)
+};
+
+// --- Plane geometry helpers ---
+
+inline int planeCount(PixelLayout layout) {
+    return layout == PixelLayout::YUV420 ? 3 : 1;
+}
+
+// Meaningful bytes per row of a plane (without stride padding)
+inline int planeRowBytes(PixelLayout layout, int width, int plane) {
+    if (layout == PixelLayout::BGR888) return width * 3;
+    return plane == 0 ? width : (width + 1) / 2;
+}
+
+inline int planeRows(PixelLayout layout, int height, int plane) {
+    if (layout == PixelLayout::BGR888 || plane == 0) return height;
+    return (height + 1) / 2;
+}
+
+// A frame that owns its pixels, tightly packed (stride == row bytes).
+// Used when a frame has to outlive the camera buffer it came from.
+struct OwnedFrame {
+    PixelLayout layout = PixelLayout::BGR888;
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> data;
+    size_t offsets[3] = {0, 0, 0};
+    int strides[3] = {0, 0, 0};
+
+    void allocate(PixelLayout newLayout, int newWidth, int newHeight) {
+        layout = newLayout;
+        width = newWidth;
+        height = newHeight;
+        size_t total = 0;
+        for (int p = 0; p < planeCount(layout); ++p) {
+            offsets[p] = total;
+            strides[p] = planeRowBytes(layout, width, p);
+            total += static_cast<size_t>(strides[p]) * planeRows(layout, height, p);
+        }
+        data.resize(total);
+    }
+
+    uint8_t* plane(int p) { return data.data() + offsets[p]; }
+
+    FrameView view() const {
+        FrameView frame;
+        frame.layout = layout;
+        frame.width = width;
+        frame.height = height;
+        for (int p = 0; p < planeCount(layout); ++p) {
+            frame.planes[p] = data.data() + offsets[p];
+            frame.strides[p] = strides[p];
+        }
+        return frame;
+    }
+};
+
+// Copies a (mapped) frame into 'dst', dropping the stride padding
+inline void copyFrame(const FrameView& src, OwnedFrame& dst) {
+    dst.allocate(src.layout, src.width, src.height);
+    for (int p = 0; p < planeCount(src.layout); ++p) {
+        const int rowBytes = planeRowBytes(src.layout, src.width, p);
+        const int rows = planeRows(src.layout, src.height, p);
+        for (int y = 0; y < rows; ++y) {
+            std::memcpy(dst.plane(p) + static_cast<size_t>(y) * dst.strides[p],
+                        src.planes[p] + static_cast<size_t>(y) * src.strides[p], rowBytes);
+        }
+    }
+}
+
+} // namespace imaging
+} // namespace horus
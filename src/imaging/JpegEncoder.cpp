@@ -0,0 +1,344 @@
+#include "JpegEncoder.hpp"
+#include <iostream>
+#include <cstdio> // jpeglib.h needs FILE / size_t declared first
+#include <vector>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <jpeglib.h>
+#include "utils/FileSystem.hpp"
+#include "utils/Trace.hpp"
+
+namespace horus {
+namespace imaging {
+
+// --- BGR PATH (Fallback) ---
+// The ISP gives us BGR, libjpeg wants RGB: swap on the fly, one band of rows at a time
+// (16 rows = one iMCU row with the default 4:2:0 sampling, so libjpeg compresses it
+// right away, and the swap and the compression show up as separate trace spans).
+// 'frame' may be a band of the image starting at row 'firstRow' (streaming encoder).
+static void writeBgrRows(jpeg_compress_struct& cinfo, const FrameView& frame, unsigned firstRow = 0) {
+    const unsigned char* src_buffer = frame.planes[0];
+    const int width = frame.width;
+    const unsigned kBandRows = 16;
+
+    // Temp buffer for one band (to hold the swapped RGB pixels)
+    std::vector<unsigned char> row_buffer(static_cast<size_t>(width) * 3 * kBandRows);
+    JSAMPROW row_pointers[kBandRows];
+
+    const unsigned endRow = std::min<unsigned>(cinfo.image_height, firstRow + frame.height);
+    while (cinfo.next_scanline < endRow) {
+        const unsigned rows = std::min(kBandRows, endRow - cinfo.next_scanline);
+        {
+            HORUS_TRACE_SCOPE("jpeg.bgr_swap");
+            for (unsigned r = 0; r < rows; ++r) {
+                // Pointer to the current row in the Source (BGR) data
+                const unsigned char* src_row =
+                    &src_buffer[static_cast<size_t>(cinfo.next_scanline + r - firstRow) * frame.strides[0]];
+                unsigned char* dst_row = &row_buffer[static_cast<size_t>(r) * width * 3];
+
+                // MANUAL SWAP LOOP: BGR -> RGB
+                // Source is BGR: [0]=B, [1]=G, [2]=R
+                // We want RGB:   [0]=R, [1]=G, [2]=B
+                for (int x = 0; x < width; ++x) {
+                    dst_row[x * 3 + 0] = src_row[x * 3 + 2]; // Dest Red   = Source Red (Byte 2)
+                    dst_row[x * 3 + 1] = src_row[x * 3 + 1]; // Dest Green = Source Green (Byte 1)
+                    dst_row[x * 3 + 2] = src_row[x * 3 + 0]; // Dest Blue  = Source Blue (Byte 0)
+                }
+                row_pointers[r] = dst_row;
+            }
+        }
+
+        // Point JPEG compressor to our corrected RGB rows
+        HORUS_TRACE_SCOPE("jpeg.write_scanlines");
+        jpeg_write_scanlines(&cinfo, row_pointers, rows);
+    }
+}
+
+// --- YUV420 PATH (Raw Data In) ---
+// libjpeg consumes one iMCU row per call: 16 luma rows + 8 rows of each chroma plane.
+// The planes already are YCbCr 4:2:0, which is exactly what the JPEG stores,
+// so we only hand over row pointers into the mapped buffer.
+// As for BGR, 'frame' may be a band starting at 'firstRow' (a multiple of 16).
+static void writeYuvRaw(jpeg_compress_struct& cinfo, const FrameView& frame, unsigned firstRow = 0) {
+    const int width = frame.width;
+    const int height = frame.height;
+    const int chromaWidth = (width + 1) / 2;
+    const int chromaHeight = (height + 1) / 2;
+
+    // libjpeg reads whole DCT blocks, i.e. rows padded to a multiple of 16 (luma) / 8 (chroma).
+    // If the stride already covers that padding we can point straight into the buffer,
+    // otherwise each row is copied into a padded scratch row (edge pixel replicated).
+    const int paddedY = (width + 15) & ~15;
+    const int paddedC = paddedY / 2;
+    const bool zeroCopy = frame.strides[0] >= paddedY &&
+                          frame.strides[1] >= paddedC &&
+                          frame.strides[2] >= paddedC;
+
+    std::vector<unsigned char> scratch(zeroCopy ? 0 : 16 * paddedY + 2 * 8 * paddedC);
+
+    JSAMPROW yRows[16];
+    JSAMPROW uRows[8];
+    JSAMPROW vRows[8];
+    JSAMPARRAY planes[3] = {yRows, uRows, vRows};
+
+    auto rowPtr = [&](int plane, int row, int srcWidth, int padded, unsigned char* dst) -> JSAMPROW {
+        const unsigned char* src = frame.planes[plane] + static_cast<size_t>(row) * frame.strides[plane];
+        if (zeroCopy) return const_cast<JSAMPROW>(src);
+        std::copy(src, src + srcWidth, dst);
+        std::fill(dst + srcWidth, dst + padded, src[srcWidth - 1]);
+        return dst;
+    };
+
+    const unsigned endRow = std::min<unsigned>(cinfo.image_height, firstRow + height);
+    while (cinfo.next_scanline < endRow) {
+        const int y0 = cinfo.next_scanline - firstRow;
+
+        // Rows past the bottom edge repeat the last row (libjpeg pads the same way)
+        for (int i = 0; i < 16; ++i) {
+            int row = std::min(y0 + i, height - 1);
+            yRows[i] = rowPtr(0, row, width, paddedY, zeroCopy ? nullptr : &scratch[i * paddedY]);
+        }
+        for (int i = 0; i < 8; ++i) {
+            int row = std::min(y0 / 2 + i, chromaHeight - 1);
+            size_t chromaOffset = 16 * paddedY + i * paddedC;
+            uRows[i] = rowPtr(1, row, chromaWidth, paddedC, zeroCopy ? nullptr : &scratch[chromaOffset]);
+            vRows[i] = rowPtr(2, row, chromaWidth, paddedC, zeroCopy ? nullptr : &scratch[chromaOffset + 8 * paddedC]);
+        }
+
+        HORUS_TRACE_SCOPE("jpeg.write_raw_data");
+        jpeg_write_raw_data(&cinfo, planes, 16);
+    }
+}
+
+// --- Memory Destination ---
+// Lets libjpeg write straight into a std::vector, growing it when full.
+struct VectorDestination {
+    jpeg_destination_mgr pub;
+    std::vector<uint8_t>* out;
+};
+
+static void initVectorDestination(j_compress_ptr cinfo) {
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    // A reused vector keeps its capacity: start with all of it, so a second
+    // frame of the same scene is encoded without any reallocation
+    dest->out->resize(std::max<size_t>(65536, dest->out->capacity()));
+    dest->pub.next_output_byte = dest->out->data();
+    dest->pub.free_in_buffer = dest->out->size();
+}
+
+static boolean emptyVectorDestination(j_compress_ptr cinfo) {
+    // Called only when the whole buffer is full: double it
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    size_t used = dest->out->size();
+    dest->out->resize(used * 2);
+    dest->pub.next_output_byte = dest->out->data() + used;
+    dest->pub.free_in_buffer = dest->out->size() - used;
+    return TRUE;
+}
+
+static void termVectorDestination(j_compress_ptr cinfo) {
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    dest->out->resize(dest->out->size() - dest->pub.free_in_buffer);
+}
+
+// --- Shared Setup ---
+static void setupCompress(jpeg_compress_struct& cinfo, const FrameView& frame, const JpegOptions& options) {
+    cinfo.image_width = frame.width;
+    cinfo.image_height = frame.height;
+    cinfo.input_components = 3;
+
+    if (frame.layout == PixelLayout::YUV420) {
+        cinfo.in_color_space = JCS_YCbCr;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_colorspace(&cinfo, JCS_YCbCr);
+
+        // Tell libjpeg the data is already downsampled 4:2:0
+        cinfo.raw_data_in = TRUE;
+#if JPEG_LIB_VERSION >= 70
+        cinfo.do_fancy_downsampling = FALSE;
+#endif
+        cinfo.comp_info[0].h_samp_factor = 2;
+        cinfo.comp_info[0].v_samp_factor = 2;
+        cinfo.comp_info[1].h_samp_factor = 1;
+        cinfo.comp_info[1].v_samp_factor = 1;
+        cinfo.comp_info[2].h_samp_factor = 1;
+        cinfo.comp_info[2].v_samp_factor = 1;
+    } else {
+        cinfo.in_color_space = JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+    }
+
+    jpeg_set_quality(&cinfo, options.quality, TRUE);
+    if (!options.quantTables.empty()) {
+        // Replaces the tables jpeg_set_quality() just installed, at the same scale
+        const size_t chromaOffset = options.quantTables.size() >= 128 ? 64 : 0;
+        unsigned int luma[64];
+        unsigned int chroma[64];
+        for (int i = 0; i < 64; ++i) {
+            luma[i] = options.quantTables[i];
+            chroma[i] = options.quantTables[chromaOffset + i];
+        }
+        const int scale = jpeg_quality_scaling(options.quality);
+        jpeg_add_quant_table(&cinfo, 0, luma, scale, TRUE);
+        jpeg_add_quant_table(&cinfo, 1, chroma, scale, TRUE);
+    }
+    cinfo.optimize_coding = options.optimizeCoding ? TRUE : FALSE;
+    cinfo.restart_in_rows = options.restartRows;
+}
+
+static void compressFrame(jpeg_compress_struct& cinfo, const FrameView& frame) {
+    jpeg_start_compress(&cinfo, TRUE);
+
+    if (frame.layout == PixelLayout::YUV420) {
+        writeYuvRaw(cinfo, frame);
+    } else {
+        writeBgrRows(cinfo, frame);
+    }
+
+    HORUS_TRACE_SCOPE("jpeg.finish");
+    jpeg_finish_compress(&cinfo);
+}
+
+bool loadQuantTables(const std::string& spec, std::vector<uint16_t>& tables) {
+    tables.clear();
+    if (spec == "flat") {
+        tables.assign(64, 16);
+        return true;
+    }
+
+    std::ifstream file(spec);
+    if (!file.is_open()) {
+        std::cerr << "[Jpeg] Cannot open quantization tables " << spec << std::endl;
+        return false;
+    }
+    std::string token;
+    while (file >> token) {
+        std::stringstream values(token);
+        std::string value;
+        while (std::getline(values, value, ',')) {
+            if (value.empty()) continue;
+            const int q = std::atoi(value.c_str());
+            if (q < 1 || q > 255) {
+                std::cerr << "[Jpeg] Quantizer out of range (1..255) in " << spec << ": " << value << std::endl;
+                tables.clear();
+                return false;
+            }
+            tables.push_back(static_cast<uint16_t>(q));
+        }
+    }
+    if (tables.size() != 64 && tables.size() != 128) {
+        std::cerr << "[Jpeg] " << spec << " has " << tables.size() << " values, expected 64 or 128" << std::endl;
+        tables.clear();
+        return false;
+    }
+    return true;
+}
+
+bool saveJpeg(const std::string& filename, const FrameView& frame, int quality) {
+    // Encode in memory (buffer reused across calls), then ONE atomic write:
+    // a power cut can never leave a truncated JPEG behind
+    static thread_local std::vector<uint8_t> buffer;
+
+    JpegOptions options;
+    options.quality = quality;
+    if (!encodeJpeg(frame, buffer, options)) return false;
+
+    utils::WriteStats stats;
+    if (!utils::writeFileAtomic(filename, buffer.data(), buffer.size(), &stats)) return false;
+
+    std::cout << "[Jpeg] Saved JPEG: " << filename << " (" << stats.bytes << " bytes, write "
+              << stats.writeMs << " ms)" << std::endl;
+    return true;
+}
+
+bool encodeJpeg(const FrameView& frame, std::vector<uint8_t>& out, const JpegOptions& options) {
+    HORUS_TRACE_SCOPE("jpeg.encode");
+    struct jpeg_compress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_compress(&cinfo);
+
+    VectorDestination dest;
+    dest.pub.init_destination = initVectorDestination;
+    dest.pub.empty_output_buffer = emptyVectorDestination;
+    dest.pub.term_destination = termVectorDestination;
+    dest.out = &out;
+    cinfo.dest = &dest.pub;
+
+    setupCompress(cinfo, frame, options);
+    compressFrame(cinfo, frame);
+
+    jpeg_destroy_compress(&cinfo);
+    HORUS_TRACE_COUNTER("jpeg.bytes", out.size());
+    return true;
+}
+
+// --- Streaming Encoder ---
+
+struct JpegStreamEncoder::State {
+    jpeg_compress_struct cinfo;
+    jpeg_error_mgr jerr;
+    VectorDestination dest;
+    PixelLayout layout = PixelLayout::BGR888;
+    bool active = false;
+};
+
+JpegStreamEncoder::JpegStreamEncoder() : state(std::make_unique<State>()) {
+    state->cinfo.err = jpeg_std_error(&state->jerr);
+    jpeg_create_compress(&state->cinfo);
+}
+
+JpegStreamEncoder::~JpegStreamEncoder() {
+    jpeg_destroy_compress(&state->cinfo);
+}
+
+bool JpegStreamEncoder::start(PixelLayout layout, int width, int height, std::vector<uint8_t>& out,
+                              const JpegOptions& options) {
+    if (state->active) jpeg_abort_compress(&state->cinfo);
+
+    state->dest.pub.init_destination = initVectorDestination;
+    state->dest.pub.empty_output_buffer = emptyVectorDestination;
+    state->dest.pub.term_destination = termVectorDestination;
+    state->dest.out = &out;
+    state->cinfo.dest = &state->dest.pub;
+
+    FrameView geometry;
+    geometry.layout = layout;
+    geometry.width = width;
+    geometry.height = height;
+    setupCompress(state->cinfo, geometry, options);
+
+    jpeg_start_compress(&state->cinfo, TRUE);
+    state->layout = layout;
+    state->active = true;
+    return true;
+}
+
+void JpegStreamEncoder::writeBand(const FrameView& band) {
+    if (!state->active) return;
+    const unsigned firstRow = state->cinfo.next_scanline;
+    if (state->layout == PixelLayout::YUV420) {
+        writeYuvRaw(state->cinfo, band, firstRow);
+    } else {
+        writeBgrRows(state->cinfo, band, firstRow);
+    }
+}
+
+bool JpegStreamEncoder::finish() {
+    if (!state->active) return false;
+    state->active = false;
+    if (state->cinfo.next_scanline < state->cinfo.image_height) {
+        std::cerr << "[Jpeg] Stream ended after " << state->cinfo.next_scanline << " of "
+                  << state->cinfo.image_height << " rows." << std::endl;
+        jpeg_abort_compress(&state->cinfo);
+        return false;
+    }
+    jpeg_finish_compress(&state->cinfo);
+    return true;
+}
+
+}
+}
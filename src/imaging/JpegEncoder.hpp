@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    struct JpegOptions {
+        int quality = 90;
+        // Emit a restart marker (RSTn) after every N MCU rows. 0 = none.
+        // The parallel encoder relies on this to stitch strips together.
+        int restartRows = 0;
+        // Two-pass Huffman: code tables fitted to this image, a few % smaller for the
+        // same pixels. Not for the strip-parallel encoder (strips share strip 0's tables).
+        bool optimizeCoding = false;
+        // Custom quantization tables in natural (row-major) order, scaled by 'quality'
+        // the way libjpeg scales its own. Empty = the standard (Annex K) tables,
+        // 64 values = one table for all components, 128 = luma then chroma.
+        std::vector<uint16_t> quantTables;
+    };
+
+    // "flat" (every coefficient quantized alike: keeps fine texture such as foliage at
+    // the cost of size), or a text file of 64 / 128 integers 1..255. False if invalid.
+    bool loadQuantTables(const std::string& spec, std::vector<uint16_t>& tables);
+
+    // Compresses a frame to a JPEG file.
+    // - BGR888 frames are swapped to RGB row by row and libjpeg does the
+    //   colour conversion + 4:2:0 downsampling itself.
+    // - YUV420 frames are handed to libjpeg as raw planes (raw_data_in),
+    //   so the CPU does no swizzle, no colour conversion and no downsampling.
+    // Returns true on success.
+    bool saveJpeg(const std::string& filename, const FrameView& frame, int quality = 90);
+
+    // Same as saveJpeg() but the compressed stream lands in 'out' (resized to fit).
+    bool encodeJpeg(const FrameView& frame, std::vector<uint8_t>& out, const JpegOptions& options = JpegOptions());
+
+    // Incremental encoder for images produced on the fly (e.g. the preview pyramid):
+    // no full frame ever exists, rows are pushed in consecutive bands.
+    // YUV420 bands must be a multiple of 16 rows (one iMCU row), except the last one.
+    class JpegStreamEncoder {
+    public:
+        JpegStreamEncoder();
+        ~JpegStreamEncoder();
+        JpegStreamEncoder(const JpegStreamEncoder&) = delete;
+        JpegStreamEncoder& operator=(const JpegStreamEncoder&) = delete;
+
+        bool start(PixelLayout layout, int width, int height, std::vector<uint8_t>& out,
+                   const JpegOptions& options = JpegOptions());
+        void writeBand(const FrameView& band);
+        bool finish(); // False if fewer rows than 'height' were written
+
+    private:
+        struct State;
+        std::unique_ptr<State> state;
+    };
+
+}
+}
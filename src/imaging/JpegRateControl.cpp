@@ -0,0 +1,179 @@
+#include "JpegRateControl.hpp"
+#include "imaging/ParallelJpegEncoder.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/Trace.hpp"
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+
+namespace horus {
+namespace imaging {
+
+// Both pixel layouts are compressed 4:2:0, so one MCU is 16x16 pixels
+static const int kMcuSize = 16;
+
+// Bytes up to the end of the SOS header: what does not grow with the image
+static size_t headerBytes(const std::vector<uint8_t>& jpeg) {
+    size_t pos = 2; // SOI
+    while (pos + 4 <= jpeg.size() && jpeg[pos] == 0xFF) {
+        const uint8_t marker = jpeg[pos + 1];
+        const size_t length = (static_cast<size_t>(jpeg[pos + 2]) << 8) | jpeg[pos + 3];
+        pos += 2 + length;
+        if (marker == 0xDA) return pos;
+    }
+    return 0;
+}
+
+double sampleMcus(const FrameView& frame, int step, OwnedFrame& mosaic) {
+    step = std::max(1, step);
+    const int mcusX = (frame.width + kMcuSize - 1) / kMcuSize;
+    const int mcusY = (frame.height + kMcuSize - 1) / kMcuSize;
+    const int cols = std::max(1, mcusX / step);
+    const int rows = std::max(1, mcusY / step);
+    mosaic.allocate(frame.layout, cols * kMcuSize, rows * kMcuSize);
+
+    const bool bgr = frame.layout == PixelLayout::BGR888;
+    for (int p = 0; p < planeCount(frame.layout); ++p) {
+        // Block of one MCU in this plane: 16x16 pixels (BGR, luma) or 8x8 (chroma)
+        const int block = bgr || p == 0 ? kMcuSize : kMcuSize / 2;
+        const int pixelBytes = bgr ? 3 : 1;
+        const int planeWidth = planeRowBytes(frame.layout, frame.width, p) / pixelBytes;
+        const int planeHeight = planeRows(frame.layout, frame.height, p);
+
+        for (int r = 0; r < rows; ++r) {
+            // Staggered columns, so a vertical structure with the period of 'step' MCUs
+            // is not sampled (or missed) on every row
+            const int mcuY = r * step;
+            const int offset = r % step;
+            for (int c = 0; c < cols; ++c) {
+                const int mcuX = std::min(c * step + offset, mcusX - 1);
+                const int x0 = mcuX * block;
+                const int inside = std::min(block, planeWidth - x0); // Edge MCUs: replicate the last pixel
+                for (int dy = 0; dy < block; ++dy) {
+                    const int y = std::min(mcuY * block + dy, planeHeight - 1);
+                    const uint8_t* src = frame.planes[p] + static_cast<size_t>(y) * frame.strides[p] +
+                                         static_cast<size_t>(x0) * pixelBytes;
+                    uint8_t* dst = mosaic.plane(p) + static_cast<size_t>(r * block + dy) * mosaic.strides[p] +
+                                   static_cast<size_t>(c) * block * pixelBytes;
+                    std::copy(src, src + inside * pixelBytes, dst);
+                    for (int x = inside; x < block; ++x) {
+                        std::copy(src + (inside - 1) * pixelBytes, src + inside * pixelBytes, dst + x * pixelBytes);
+                    }
+                }
+            }
+        }
+    }
+    return static_cast<double>(mcusX) * mcusY / (static_cast<double>(cols) * rows);
+}
+
+void chooseQuality(const FrameView& frame, const RateControlOptions& options, RateControlResult& result) {
+    HORUS_TRACE_SCOPE("jpeg.rate_probe");
+    auto start = std::chrono::steady_clock::now();
+
+    OwnedFrame mosaic;
+    const double scale = sampleMcus(frame, options.sampleStep, mosaic);
+    std::vector<uint8_t> probe;
+    std::map<int, size_t> predicted;
+    result.probes = 0;
+
+    // Headers once, entropy-coded data scaled up to the whole frame
+    auto predict = [&](int quality) {
+        auto known = predicted.find(quality);
+        if (known != predicted.end()) return known->second;
+        JpegOptions probeOptions = options.base;
+        probeOptions.quality = quality;
+        probeOptions.restartRows = 0;
+        encodeJpeg(mosaic.view(), probe, probeOptions);
+        ++result.probes;
+        const size_t header = headerBytes(probe);
+        const size_t bytes = header + static_cast<size_t>((probe.size() - header) * scale);
+        predicted[quality] = bytes;
+        return bytes;
+    };
+
+    // 1. Either end settles it
+    const size_t budget = static_cast<size_t>(options.targetBytes * (1.0 - options.headroom));
+    const double target = static_cast<double>(budget);
+    int low = std::clamp(options.minQuality, 1, 100);
+    int high = std::clamp(options.maxQuality, low, 100);
+    if (predict(high) <= budget) {
+        low = high;
+    } else if (predict(low) <= budget) {
+        // 2. 'low' fits, 'high' does not. The quantizers scale with libjpeg's quality
+        // factor, and log(size) falls about linearly with log(quantizer scale), so the
+        // guess interpolates on that line between the bracket ends, and
+        // its neighbour on the far side is tried next: with a good guess that closes the
+        // bracket. Plain halving if that takes too long (a lopsided curve).
+        auto logScale = [](int quality) {
+            return std::log(static_cast<double>(std::max(1, quality < 50 ? 5000 / quality : 200 - 2 * quality)));
+        };
+        int neighbour = 0;
+        for (int step = 0; high - low > 1; ++step) {
+            int guess = low + (high - low) / 2;
+            const double sizeLow = std::log(static_cast<double>(predicted[low]));
+            const double sizeHigh = std::log(static_cast<double>(predicted[high]));
+            if (neighbour > low && neighbour < high) {
+                guess = neighbour;
+            } else if (step < 6 && sizeHigh > sizeLow) {
+                // Log scale at the target, then the quality with the nearest log scale
+                const double x = logScale(low) + (logScale(high) - logScale(low)) * (std::log(target) - sizeLow) / (sizeHigh - sizeLow);
+                for (int q = low + 1; q < high; ++q) {
+                    if (std::fabs(logScale(q) - x) < std::fabs(logScale(guess) - x)) guess = q;
+                }
+            }
+            const bool fits = predict(guess) <= budget;
+            neighbour = guess == neighbour ? 0 : (fits ? guess + 1 : guess - 1);
+            if (fits) low = guess;
+            else high = guess;
+        }
+    }
+    // (else: not even the floor fits, 'low' is the floor)
+
+    result.quality = low;
+    result.predictedBytes = predict(low);
+    result.probeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool encodeJpegBudgeted(const FrameView& frame, std::vector<uint8_t>& out, const RateControlOptions& options,
+                        RateControlResult& result, utils::ThreadPool* pool) {
+    result = RateControlResult();
+    result.quality = options.base.quality;
+    if (options.targetBytes > 0) chooseQuality(frame, options, result);
+
+    auto start = std::chrono::steady_clock::now();
+    JpegOptions finalOptions = options.base;
+    finalOptions.quality = result.quality;
+    bool ok = pool && pool->size() > 1 && !finalOptions.optimizeCoding
+            ? encodeJpegParallel(frame, out, *pool, finalOptions)
+            : encodeJpeg(frame, out, finalOptions);
+    result.actualBytes = out.size();
+    result.encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ok;
+}
+
+bool saveJpegBudgeted(const std::string& filename, const FrameView& frame, const RateControlOptions& options,
+                      utils::ThreadPool* pool, RateControlResult* result) {
+    static thread_local std::vector<uint8_t> buffer; // Reused across calls
+    RateControlResult local;
+    RateControlResult& rate = result ? *result : local;
+    if (!encodeJpegBudgeted(frame, buffer, options, rate, pool)) return false;
+    if (!utils::writeFileAtomic(filename, buffer.data(), buffer.size())) return false;
+
+    std::cout << "[Jpeg] Saved JPEG: " << filename << " (q" << rate.quality << ", " << rate.actualBytes / 1024 << " KB";
+    if (options.targetBytes > 0) {
+        const double error = (static_cast<double>(rate.actualBytes) / rate.predictedBytes - 1.0) * 100.0;
+        std::cout << " for a " << options.targetBytes / 1024 << " KB budget, predicted " << rate.predictedBytes / 1024
+                  << " KB (" << (error >= 0 ? "+" : "") << error << " %), " << rate.probes << " probes in "
+                  << rate.probeMs << " ms";
+    }
+    std::cout << ", encode " << rate.encodeMs << " ms)" << std::endl;
+    if (options.targetBytes > 0 && rate.actualBytes > options.targetBytes && rate.quality <= options.minQuality) {
+        std::cerr << "[Jpeg] WARNING: Over budget at the minimum quality " << options.minQuality << std::endl;
+    }
+    return true;
+}
+
+}
+}
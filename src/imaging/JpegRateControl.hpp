@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "imaging/Frame.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // Size-budgeted JPEG: the highest quality whose file fits 'targetBytes'.
+    // The size at a given quality is predicted from a mosaic of every sampleStep-th
+    // MCU (16x16 pixels) across and down the frame. The blocks are copied unscaled, so
+    // their DCT coefficients are the ones the full encode will code, and the mosaic's
+    // compressed size times (frame MCUs / mosaic MCUs) is the full size. The quality is
+    // searched on the mosaic (a few encodes of 1/sampleStep^2 of the frame), then the
+    // frame is encoded once.
+    struct RateControlOptions {
+        size_t targetBytes = 0;    // Per picture; 0 = off (fixed base.quality)
+        int minQuality = 30;       // Floor: a frame that needs less is saved here, over budget
+        int maxQuality = 95;       // Ceiling: an easy frame doesn't grow to fill the budget
+        int sampleStep = 4;        // Mosaic = 1/16 of the frame
+        double headroom = 0.03;    // Aim this far under the target (predictions are within a few %)
+        JpegOptions base;          // optimizeCoding / quantTables, for the probes and the final encode
+    };
+
+    struct RateControlResult {
+        int quality = 0;
+        size_t predictedBytes = 0; // At 'quality'
+        size_t actualBytes = 0;
+        int probes = 0;            // Mosaic encodes
+        double probeMs = 0.0;
+        double encodeMs = 0.0;
+    };
+
+    // Copies every step-th MCU (staggered from one MCU row to the next) into 'mosaic',
+    // same layout as 'frame'. Returns frame MCUs / mosaic MCUs.
+    double sampleMcus(const FrameView& frame, int step, OwnedFrame& mosaic);
+
+    // Searches the quality on the mosaic: fills quality, predictedBytes, probes, probeMs
+    void chooseQuality(const FrameView& frame, const RateControlOptions& options, RateControlResult& result);
+
+    // chooseQuality() + one encode into 'out' (strip-parallel on 'pool' when given and
+    // optimizeCoding is off)
+    bool encodeJpegBudgeted(const FrameView& frame, std::vector<uint8_t>& out, const RateControlOptions& options,
+                            RateControlResult& result, utils::ThreadPool* pool = nullptr);
+
+    // Encode + one atomic write; prints the quality, predicted and actual size
+    bool saveJpegBudgeted(const std::string& filename, const FrameView& frame, const RateControlOptions& options,
+                          utils::ThreadPool* pool = nullptr, RateControlResult* result = nullptr);
+
+}
+}
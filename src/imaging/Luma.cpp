@@ -0,0 +1,88 @@
+#include "Luma.hpp"
+#include <iostream>
+#include <cstdio> // jpeglib.h needs FILE / size_t declared first
+#include <algorithm>
+#include <jpeglib.h>
+
+namespace horus {
+namespace imaging {
+
+void downscaleLuma(const FrameView& frame, int factor, LumaImage& out) {
+    factor = std::max(1, factor);
+    out.scale = factor;
+    out.width = frame.width / factor;
+    out.height = frame.height / factor;
+    out.data.resize(static_cast<size_t>(out.width) * out.height);
+
+    const uint32_t area = static_cast<uint32_t>(factor * factor);
+    std::vector<uint32_t> sums(out.width);
+
+    for (int y = 0; y < out.height; ++y) {
+        std::fill(sums.begin(), sums.end(), 0);
+
+        // 1. Sum 'factor' source rows into one row of column sums (vectorises)
+        for (int r = 0; r < factor; ++r) {
+            const uint8_t* src = frame.planes[0] + static_cast<size_t>(y * factor + r) * frame.strides[0];
+            if (frame.layout == PixelLayout::YUV420) {
+                for (int x = 0; x < out.width; ++x) {
+                    uint32_t s = 0;
+                    for (int k = 0; k < factor; ++k) s += src[x * factor + k];
+                    sums[x] += s;
+                }
+            } else {
+                for (int x = 0; x < out.width; ++x) {
+                    uint32_t s = 0;
+                    for (int k = 0; k < factor; ++k) {
+                        const uint8_t* p = src + (x * factor + k) * 3;
+                        s += (29u * p[0] + 150u * p[1] + 77u * p[2]) >> 8;
+                    }
+                    sums[x] += s;
+                }
+            }
+        }
+
+        // 2. Rounded average
+        uint8_t* dst = out.data.data() + static_cast<size_t>(y) * out.width;
+        for (int x = 0; x < out.width; ++x) {
+            dst[x] = static_cast<uint8_t>((sums[x] + area / 2) / area);
+        }
+    }
+}
+
+bool loadJpegLuma(const std::string& filename, int factor, LumaImage& out) {
+    FILE* infile = fopen(filename.c_str(), "rb");
+    if (infile == NULL) {
+        std::cerr << "[Luma] Can't open " << filename << std::endl;
+        return false;
+    }
+
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, infile);
+    jpeg_read_header(&cinfo, TRUE);
+
+    // Scaled IDCT + grey output: only the Y component is decoded
+    cinfo.out_color_space = JCS_GRAYSCALE;
+    cinfo.scale_num = 1;
+    cinfo.scale_denom = std::clamp(factor, 1, 8);
+    jpeg_start_decompress(&cinfo);
+
+    out.scale = cinfo.scale_denom;
+    out.width = cinfo.output_width;
+    out.height = cinfo.output_height;
+    out.data.resize(static_cast<size_t>(out.width) * out.height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        JSAMPROW row = out.data.data() + static_cast<size_t>(cinfo.output_scanline) * out.width;
+        jpeg_read_scanlines(&cinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(infile);
+    return true;
+}
+
+}
+}
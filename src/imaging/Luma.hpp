@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // A single 8-bit grey plane, tightly packed (stride == width).
+    // 'scale' remembers how much smaller than the source frame it is,
+    // so results can be mapped back to full-resolution coordinates.
+    struct LumaImage {
+        int width = 0;
+        int height = 0;
+        int scale = 1;
+        std::vector<uint8_t> data;
+
+        const uint8_t* row(int y) const { return data.data() + static_cast<size_t>(y) * width; }
+    };
+
+    // Box-filtered luma at 1/factor resolution.
+    // YUV420: the Y plane is averaged directly (no colour work at all).
+    // BGR888: Y = (29 B + 150 G + 77 R) >> 8, then averaged.
+    void downscaleLuma(const FrameView& frame, int factor, LumaImage& out);
+
+    // Decodes a JPEG straight to grey at 1/factor (factor 1, 2, 4 or 8): libjpeg skips
+    // the colour conversion and most of the IDCT work, so this is much cheaper than
+    // decoding full size and downscaling.
+    bool loadJpegLuma(const std::string& filename, int factor, LumaImage& out);
+
+}
+}
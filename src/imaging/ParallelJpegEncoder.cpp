@@ -0,0 +1,167 @@
+#include "ParallelJpegEncoder.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/Trace.hpp"
+#include <iostream>
+#include <algorithm>
+
+namespace horus {
+namespace imaging {
+
+// Both pixel layouts are compressed 4:2:0, so one MCU row is 16 pixel rows
+static const int kMcuHeight = 16;
+
+// JPEG marker codes we need while splicing
+static const uint8_t kMarkerSOF0 = 0xC0;
+static const uint8_t kMarkerSOF2 = 0xC2;
+static const uint8_t kMarkerSOS = 0xDA;
+static const uint8_t kMarkerRST0 = 0xD0;
+
+// Location of the pieces of a single-scan JPEG produced by libjpeg
+struct JpegLayout {
+    size_t sofHeightPos = 0;  // Offset of the 16-bit image height in the SOF segment
+    size_t scanStart = 0;     // First byte of entropy-coded data (after the SOS header)
+    size_t scanEnd = 0;       // Offset of the trailing EOI marker
+};
+
+// Walk the marker segments from SOI up to SOS
+static bool parseLayout(const std::vector<uint8_t>& jpeg, JpegLayout& layout) {
+    size_t pos = 2; // Skip SOI
+    while (pos + 4 <= jpeg.size()) {
+        if (jpeg[pos] != 0xFF) return false;
+        uint8_t marker = jpeg[pos + 1];
+        size_t length = (jpeg[pos + 2] << 8) | jpeg[pos + 3];
+
+        if (marker >= kMarkerSOF0 && marker <= kMarkerSOF2) {
+            // FF Cx | length(2) | precision(1) | height(2) | width(2) ...
+            layout.sofHeightPos = pos + 5;
+        }
+        if (marker == kMarkerSOS) {
+            layout.scanStart = pos + 2 + length;
+            layout.scanEnd = jpeg.size() - 2; // libjpeg always ends with EOI
+            return layout.sofHeightPos != 0 && layout.scanStart <= layout.scanEnd;
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+// Sub-view of 'frame' covering rows [y0, y0 + rows). y0 is a multiple of 16.
+static FrameView stripView(const FrameView& frame, int y0, int rows) {
+    FrameView strip = frame;
+    strip.height = rows;
+    strip.planes[0] = frame.planes[0] + static_cast<size_t>(y0) * frame.strides[0];
+    if (frame.layout == PixelLayout::YUV420) {
+        strip.planes[1] = frame.planes[1] + static_cast<size_t>(y0 / 2) * frame.strides[1];
+        strip.planes[2] = frame.planes[2] + static_cast<size_t>(y0 / 2) * frame.strides[2];
+    }
+    return strip;
+}
+
+bool encodeJpegParallel(const FrameView& frame, std::vector<uint8_t>& out,
+                        utils::ThreadPool& pool, int quality) {
+    JpegOptions options;
+    options.quality = quality;
+    return encodeJpegParallel(frame, out, pool, options);
+}
+
+bool encodeJpegParallel(const FrameView& frame, std::vector<uint8_t>& out,
+                        utils::ThreadPool& pool, const JpegOptions& stripOptions) {
+    HORUS_TRACE_SCOPE("jpeg.encode_parallel");
+    // 1. Cut the frame into one strip per worker, aligned on MCU rows
+    const int mcuRows = (frame.height + kMcuHeight - 1) / kMcuHeight;
+    const int strips = std::max(1, std::min<int>(pool.size(), mcuRows));
+    const int mcuRowsPerStrip = (mcuRows + strips - 1) / strips;
+
+    JpegOptions options = stripOptions;
+    options.restartRows = 1; // RST after every MCU row -> strips can be cut anywhere
+    options.optimizeCoding = false;
+
+    std::vector<std::vector<uint8_t>> encoded(strips);
+    std::vector<int> stripMcuRows(strips, 0);
+    std::vector<std::future<bool>> jobs;
+
+    for (int s = 0; s < strips; ++s) {
+        int y0 = s * mcuRowsPerStrip * kMcuHeight;
+        if (y0 >= frame.height) {
+            encoded.resize(s);
+            stripMcuRows.resize(s);
+            break;
+        }
+        int rows = std::min(mcuRowsPerStrip * kMcuHeight, frame.height - y0);
+        stripMcuRows[s] = (rows + kMcuHeight - 1) / kMcuHeight;
+
+        FrameView strip = stripView(frame, y0, rows);
+        std::vector<uint8_t>* dst = &encoded[s];
+        jobs.push_back(pool.submit([strip, dst, options] {
+            return encodeJpeg(strip, *dst, options);
+        }));
+    }
+
+    // 2. Wait for every strip
+    bool ok = true;
+    for (std::future<bool> &job : jobs) ok = job.get() && ok;
+    if (!ok) return false;
+
+    // 3. Splice: headers of strip 0, then every scan with renumbered restart markers
+    HORUS_TRACE_SCOPE("jpeg.splice");
+    std::vector<JpegLayout> layouts(encoded.size());
+    size_t total = 0;
+    for (size_t s = 0; s < encoded.size(); ++s) {
+        if (!parseLayout(encoded[s], layouts[s])) {
+            std::cerr << "[Jpeg] Malformed strip " << s << std::endl;
+            return false;
+        }
+        total += encoded[s].size();
+    }
+
+    out.clear();
+    out.reserve(total);
+    out.insert(out.end(), encoded[0].begin(), encoded[0].begin() + layouts[0].scanStart);
+    out[layouts[0].sofHeightPos] = static_cast<uint8_t>(frame.height >> 8);
+    out[layouts[0].sofHeightPos + 1] = static_cast<uint8_t>(frame.height & 0xFF);
+
+    // Markers must run RST0..RST7 continuously over the whole image.
+    // Inside a strip libjpeg restarts counting at RST0, so each one is shifted
+    // by the number of restart intervals emitted before the strip.
+    int restartIndex = 0;
+    for (size_t s = 0; s < encoded.size(); ++s) {
+        size_t scanBegin = out.size();
+        out.insert(out.end(), encoded[s].begin() + layouts[s].scanStart,
+                   encoded[s].begin() + layouts[s].scanEnd);
+
+        // Entropy data byte-stuffs 0xFF as FF 00, so FF D0..D7 can only be a marker
+        for (size_t i = scanBegin; i + 1 < out.size(); ++i) {
+            if (out[i] == 0xFF && (out[i + 1] & 0xF8) == kMarkerRST0) {
+                out[i + 1] = kMarkerRST0 + (restartIndex++ & 7);
+                ++i;
+            }
+        }
+
+        // Close this strip's last MCU row with the marker libjpeg didn't write
+        if (s + 1 < encoded.size()) {
+            out.push_back(0xFF);
+            out.push_back(kMarkerRST0 + (restartIndex++ & 7));
+        }
+    }
+
+    out.push_back(0xFF);
+    out.push_back(0xD9); // EOI
+    return true;
+}
+
+bool saveJpegParallel(const std::string& filename, const FrameView& frame,
+                      utils::ThreadPool& pool, int quality) {
+    static thread_local std::vector<uint8_t> jpeg; // Reused across calls
+    if (!encodeJpegParallel(frame, jpeg, pool, quality)) return false;
+
+    utils::WriteStats stats;
+    if (!utils::writeFileAtomic(filename, jpeg.data(), jpeg.size(), &stats)) return false;
+
+    std::cout << "[Jpeg] Saved JPEG (" << pool.size() << " threads): " << filename << " ("
+              << stats.bytes << " bytes, write " << stats.writeMs << " ms)" << std::endl;
+    return true;
+}
+
+}
+}
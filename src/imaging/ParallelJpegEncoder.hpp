@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // Strip-parallel JPEG encoder.
+    // The frame is cut into horizontal strips (multiples of one MCU row), each strip is
+    // compressed on its own worker with a restart marker after every MCU row, and the
+    // entropy-coded segments are then spliced into ONE baseline JPEG:
+    //   SOI + headers of strip 0 (height patched) + segment 0 + RSTn + segment 1 + ... + EOI
+    // Restart markers reset the DC predictors, so every strip decodes independently and
+    // the result is a standard file any decoder can read.
+    bool encodeJpegParallel(const FrameView& frame, std::vector<uint8_t>& out,
+                            utils::ThreadPool& pool, int quality = 90);
+
+    // Same with custom quantization tables; restartRows is forced to 1 and
+    // optimizeCoding ignored (every strip must use the Huffman tables of strip 0)
+    bool encodeJpegParallel(const FrameView& frame, std::vector<uint8_t>& out,
+                            utils::ThreadPool& pool, const JpegOptions& options);
+
+    // Convenience: encode on 'pool' and write the file in one go.
+    bool saveJpegParallel(const std::string& filename, const FrameView& frame,
+                          utils::ThreadPool& pool, int quality = 90);
+
+}
+}
@@ -0,0 +1,265 @@
+#include "PreviewPyramid.hpp"
+#include "JpegEncoder.hpp"
+#include "utils/FileSystem.hpp"
+#include <iostream>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+#include <regex>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace horus {
+namespace imaging {
+
+namespace {
+
+const int kBandRows = 16; // One YUV420 iMCU row
+
+// Pixels per row of a plane (chroma is half width in YUV420)
+int planeWidth(PixelLayout layout, int width, int plane) {
+    return (layout == PixelLayout::YUV420 && plane > 0) ? (width + 1) / 2 : width;
+}
+
+// --- KERNELS ---
+
+// dst[x] = rounded mean of the 2x2 block under it; the last column is
+// repeated when the source width is odd.
+void halveRows1(const uint8_t* a, const uint8_t* b, int srcWidth, uint8_t* dst) {
+    const int pairs = srcWidth / 2;
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 16 <= pairs; x += 16) {
+        uint16x8_t lo = vpadalq_u8(vpaddlq_u8(vld1q_u8(a + 2 * x)), vld1q_u8(b + 2 * x));
+        uint16x8_t hi = vpadalq_u8(vpaddlq_u8(vld1q_u8(a + 2 * x + 16)), vld1q_u8(b + 2 * x + 16));
+        vst1q_u8(dst + x, vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+#endif
+    for (; x < pairs; ++x) {
+        dst[x] = static_cast<uint8_t>((a[2 * x] + a[2 * x + 1] + b[2 * x] + b[2 * x + 1] + 2) >> 2);
+    }
+    if (srcWidth & 1) {
+        dst[pairs] = static_cast<uint8_t>((a[srcWidth - 1] + b[srcWidth - 1] + 1) >> 1);
+    }
+}
+
+// Same for interleaved 3-byte pixels (BGR)
+void halveRows3(const uint8_t* a, const uint8_t* b, int srcWidth, uint8_t* dst) {
+    const int pairs = srcWidth / 2;
+    int x = 0;
+#if defined(__ARM_NEON)
+    for (; x + 8 <= pairs; x += 8) {
+        uint8x16x3_t pa = vld3q_u8(a + 6 * x);
+        uint8x16x3_t pb = vld3q_u8(b + 6 * x);
+        uint8x8x3_t out;
+        for (int c = 0; c < 3; ++c) {
+            out.val[c] = vrshrn_n_u16(vpadalq_u8(vpaddlq_u8(pa.val[c]), pb.val[c]), 2);
+        }
+        vst3_u8(dst + 3 * x, out);
+    }
+#endif
+    for (; x < pairs; ++x) {
+        const uint8_t* pa = a + 6 * x;
+        const uint8_t* pb = b + 6 * x;
+        for (int c = 0; c < 3; ++c) {
+            dst[3 * x + c] = static_cast<uint8_t>((pa[c] + pa[c + 3] + pb[c] + pb[c + 3] + 2) >> 2);
+        }
+    }
+    if (srcWidth & 1) {
+        const int last = 3 * (srcWidth - 1);
+        for (int c = 0; c < 3; ++c) {
+            dst[3 * pairs + c] = static_cast<uint8_t>((a[last + c] + b[last + c] + 1) >> 1);
+        }
+    }
+}
+
+// --- STREAMING PYRAMID ---
+
+// Level k is fed the rows of level k-1 one at a time. An even row waits in 'pending'
+// until its odd partner arrives; the pair becomes one row of level k, written into
+// the level's band, which goes to the encoder once all its planes are full.
+// Rows of a pair always sit in the same band (16 and 8 are even), so 'pending' can
+// point straight into the band buffer of the level above (or into the mapped frame).
+class PyramidBuilder {
+public:
+    PyramidBuilder(const FrameView& frame, int levelCount, std::vector<PyramidLevel>& out, int quality)
+        : layout(frame.layout), planes(planeCount(frame.layout)),
+          channels(frame.layout == PixelLayout::BGR888 ? 3 : 1) {
+        JpegOptions options;
+        options.quality = quality;
+
+        int width = frame.width;
+        int height = frame.height;
+        out.resize(levelCount);
+        levels.resize(levelCount);
+        for (int k = 0; k < levelCount; ++k) {
+            for (int p = 0; p < planes; ++p) levels[k].srcWidth[p] = planeWidth(layout, width, p);
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+
+            out[k].factor = 2 << k;
+            out[k].width = width;
+            out[k].height = height;
+            levels[k].band.allocate(layout, width, kBandRows);
+            levels[k].encoder = std::make_unique<JpegStreamEncoder>();
+            levels[k].encoder->start(layout, width, height, out[k].jpeg, options);
+        }
+    }
+
+    // One row of the source frame, plane 'p'
+    void pushSourceRow(int p, const uint8_t* row) { push(0, p, row); }
+
+    // Pairs up the odd last rows, flushes the partial bands and closes every stream
+    bool finish() {
+        bool ok = true;
+        for (size_t k = 0; k < levels.size(); ++k) {
+            for (int p = 0; p < planes; ++p) {
+                if (levels[k].pending[p]) {
+                    const uint8_t* row = levels[k].pending[p];
+                    levels[k].pending[p] = nullptr;
+                    produce(k, p, row, row);
+                }
+            }
+            flush(k);
+            ok = levels[k].encoder->finish() && ok;
+        }
+        return ok;
+    }
+
+private:
+    struct Level {
+        int srcWidth[3] = {0, 0, 0};   // Width of the level ABOVE, per plane
+        const uint8_t* pending[3] = {nullptr, nullptr, nullptr};
+        OwnedFrame band;
+        int rows[3] = {0, 0, 0};       // Rows filled in 'band', per plane
+        std::unique_ptr<JpegStreamEncoder> encoder;
+    };
+
+    void push(size_t k, int p, const uint8_t* row) {
+        if (k >= levels.size()) return;
+        Level& level = levels[k];
+        if (!level.pending[p]) {
+            level.pending[p] = row;
+            return;
+        }
+        const uint8_t* first = level.pending[p];
+        level.pending[p] = nullptr;
+        produce(k, p, first, row);
+    }
+
+    void produce(size_t k, int p, const uint8_t* a, const uint8_t* b) {
+        Level& level = levels[k];
+        uint8_t* dst = level.band.plane(p) + static_cast<size_t>(level.rows[p]) * level.band.strides[p];
+        if (channels == 3) {
+            halveRows3(a, b, level.srcWidth[p], dst);
+        } else {
+            halveRows1(a, b, level.srcWidth[p], dst);
+        }
+        level.rows[p]++;
+
+        // The new row feeds the next level while it is still hot
+        push(k + 1, p, dst);
+
+        bool full = true;
+        for (int q = 0; q < planes; ++q) {
+            full = full && level.rows[q] == planeRows(layout, kBandRows, q);
+        }
+        if (full) flush(k);
+    }
+
+    void flush(size_t k) {
+        Level& level = levels[k];
+        if (level.rows[0] == 0) return;
+        FrameView band = level.band.view();
+        band.height = level.rows[0];
+        level.encoder->writeBand(band);
+        for (int p = 0; p < planes; ++p) level.rows[p] = 0;
+    }
+
+    PixelLayout layout;
+    int planes;
+    int channels;
+    std::vector<Level> levels;
+};
+
+} // namespace
+
+bool encodePyramid(const FrameView& frame, int levels, std::vector<PyramidLevel>& out,
+                   int quality, std::vector<uint8_t>* full, int fullQuality) {
+    levels = std::clamp(levels, 1, kMaxPyramidLevels);
+    if (frame.width < 2 || frame.height < 2) {
+        std::cerr << "[Pyramid] Frame too small: " << frame.width << "x" << frame.height << std::endl;
+        return false;
+    }
+
+    PyramidBuilder builder(frame, levels, out, quality);
+
+    JpegStreamEncoder fullEncoder;
+    if (full) {
+        JpegOptions options;
+        options.quality = fullQuality;
+        fullEncoder.start(frame.layout, frame.width, frame.height, *full, options);
+    }
+
+    // 1. Walk the frame once, one 16-row band at a time
+    const bool yuv = frame.layout == PixelLayout::YUV420;
+    for (int y0 = 0; y0 < frame.height; y0 += kBandRows) {
+        const int rows = std::min(kBandRows, frame.height - y0);
+
+        FrameView band = frame;
+        band.height = rows;
+        band.planes[0] = frame.planes[0] + static_cast<size_t>(y0) * frame.strides[0];
+        if (yuv) {
+            for (int p = 1; p < 3; ++p) band.planes[p] = frame.planes[p] + static_cast<size_t>(y0 / 2) * frame.strides[p];
+        }
+
+        // 2. Full-resolution JPEG straight from the mapped rows
+        if (full) fullEncoder.writeBand(band);
+
+        // 3. Same rows, still in cache, down the pyramid.
+        // YUV: two luma rows, then the chroma row below them (keeps every band in step).
+        for (int r = 0; r < rows; ++r) {
+            builder.pushSourceRow(0, band.planes[0] + static_cast<size_t>(r) * band.strides[0]);
+            if (yuv && ((r & 1) || r == rows - 1)) {
+                for (int p = 1; p < 3; ++p) {
+                    builder.pushSourceRow(p, band.planes[p] + static_cast<size_t>(r / 2) * band.strides[p]);
+                }
+            }
+        }
+    }
+
+    // 4. Close the streams
+    bool ok = builder.finish();
+    if (full) ok = fullEncoder.finish() && ok;
+    return ok;
+}
+
+std::string pyramidPath(const std::string& filename, int factor) {
+    std::filesystem::path path(filename);
+    std::string name = path.stem().string() + "_p" + std::to_string(factor) + ".jpg";
+    return (path.parent_path() / name).string();
+}
+
+bool writePyramid(const std::string& filename, const std::vector<PyramidLevel>& levels) {
+    bool ok = true;
+    size_t bytes = 0;
+    for (auto it = levels.rbegin(); it != levels.rend(); ++it) {
+        if (!utils::writeFileAtomic(pyramidPath(filename, it->factor), it->jpeg.data(), it->jpeg.size())) {
+            ok = false;
+            continue;
+        }
+        bytes += it->jpeg.size();
+    }
+    std::cout << "[Pyramid] Saved " << levels.size() << " preview(s) for " << filename
+              << " (" << bytes << " bytes)" << std::endl;
+    return ok;
+}
+
+bool isPyramidFile(const std::string& filename) {
+    static const std::regex pattern(".*_p[0-9]+\\.jpg");
+    return std::regex_match(std::filesystem::path(filename).filename().string(), pattern);
+}
+
+}
+}
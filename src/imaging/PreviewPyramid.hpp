@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // One preview level: 1/factor of the full frame (ceil when odd), as a JPEG.
+    struct PyramidLevel {
+        int factor = 2;
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> jpeg;
+    };
+
+    static const int kMaxPyramidLevels = 4; // Down to 1/16
+
+    // Builds 'levels' previews (1/2, 1/4, 1/8 ...) in ONE pass over the frame.
+    // Source rows are read in 16-row bands; each level is a 2x2 box average of the level
+    // above, kept as a 16-row band that is handed to its own streaming JPEG encoder as soon
+    // as it is full. No level is ever held in full: memory is a few KB per level plus
+    // the compressed output.
+    // If 'full' is set, the full-resolution JPEG is encoded in the same pass, so every
+    // band of the (mapped) frame is pulled into cache once for all outputs.
+    bool encodePyramid(const FrameView& frame, int levels, std::vector<PyramidLevel>& out,
+                       int quality = 80, std::vector<uint8_t>* full = nullptr, int fullQuality = 90);
+
+    // "<dir>/<stem>_p<factor>.jpg", next to the full picture
+    std::string pyramidPath(const std::string& filename, int factor);
+
+    // Writes every level next to 'filename', smallest first (atomic writes)
+    bool writePyramid(const std::string& filename, const std::vector<PyramidLevel>& levels);
+
+    // True for "<stem>_p<N>.jpg" preview files
+    bool isPyramidFile(const std::string& filename);
+
+}
+}
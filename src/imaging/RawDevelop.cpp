@@ -0,0 +1,401 @@
+#include "RawDevelop.hpp"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <nlohmann/json.hpp>
+#include "imaging/Frame.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "utils/FileSystem.hpp"
+
+namespace horus {
+namespace imaging {
+
+// --- FORMAT / SIDECAR ---
+
+bool parseRawFormat(const std::string& format, RawInfo& info) {
+    // "S" + Bayer order + bit depth [+ "_CSI2P"], e.g. SBGGR12_CSI2P, SRGGB16
+    info.format = format;
+    if (format.size() < 7 || format[0] != 'S') return false;
+
+    info.bayerOrder = format.substr(1, 4);
+    if (info.bayerOrder != "RGGB" && info.bayerOrder != "GRBG" &&
+        info.bayerOrder != "GBRG" && info.bayerOrder != "BGGR") {
+        return false;
+    }
+
+    size_t suffix = format.find('_');
+    std::string digits = format.substr(5, suffix == std::string::npos ? std::string::npos : suffix - 5);
+    if (digits.empty() || !std::all_of(digits.begin(), digits.end(), ::isdigit)) return false;
+    info.bitDepth = std::stoi(digits);
+
+    if (suffix == std::string::npos) {
+        info.packing = RawPacking::None;
+        return info.bitDepth <= 16;
+    }
+    if (format.substr(suffix) == "_CSI2P") {
+        info.packing = RawPacking::Csi2;
+        return info.bitDepth == 10 || info.bitDepth == 12;
+    }
+    return false;
+}
+
+bool writeRawInfo(const std::string& path, const RawInfo& info) {
+    nlohmann::json j;
+    j["format"] = info.format;
+    j["model"] = info.model;
+    j["width"] = info.width;
+    j["height"] = info.height;
+    j["stride"] = info.stride;
+    j["bit_depth"] = info.bitDepth;
+    j["packing"] = info.packing == RawPacking::Csi2 ? "csi2" : "none";
+    j["bayer_order"] = info.bayerOrder;
+    j["black_level"] = info.blackLevel;
+    j["exposure_time_us"] = info.exposureTime;
+    j["analogue_gain"] = info.analogueGain;
+    j["colour_gains"] = { info.colourGains[0], info.colourGains[1] };
+    j["ccm"] = std::vector<float>(info.ccm, info.ccm + 9);
+    j["lux"] = info.lux;
+    j["timestamp_ns"] = info.timestampNs;
+
+    const std::string text = j.dump(2) + "\n";
+    if (!utils::writeFileAtomic(path, reinterpret_cast<const uint8_t*>(text.data()), text.size())) {
+        std::cerr << "[Raw] Could not write sidecar: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readRawInfo(const std::string& path, RawInfo& info) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[Raw] Missing sidecar: " << path << std::endl;
+        return false;
+    }
+
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        if (!parseRawFormat(j.at("format").get<std::string>(), info)) {
+            std::cerr << "[Raw] Unsupported RAW format: " << info.format << std::endl;
+            return false;
+        }
+        info.model = j.value("model", "");
+        info.width = j.at("width").get<int>();
+        info.height = j.at("height").get<int>();
+        info.stride = j.at("stride").get<int>();
+        info.blackLevel = j.value("black_level", info.blackLevel);
+        info.exposureTime = j.value("exposure_time_us", 0.0f);
+        info.analogueGain = j.value("analogue_gain", 0.0f);
+        if (j.contains("colour_gains") && j["colour_gains"].size() == 2) {
+            info.colourGains[0] = j["colour_gains"][0].get<float>();
+            info.colourGains[1] = j["colour_gains"][1].get<float>();
+        }
+        if (j.contains("ccm") && j["ccm"].size() == 9) {
+            for (int i = 0; i < 9; ++i) info.ccm[i] = j["ccm"][i].get<float>();
+        }
+        info.lux = j.value("lux", 0.0f);
+        info.timestampNs = j.value("timestamp_ns", int64_t(0));
+    } catch (const nlohmann::json::exception& e) {
+        std::cerr << "[Raw] Bad sidecar " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return info.width > 0 && info.height > 0 && info.stride > 0;
+}
+
+// --- UNPACKING ---
+
+void unpackRawRow(const uint8_t* src, uint16_t* dst, const RawInfo& info) {
+    const int width = info.width;
+    if (info.packing == RawPacking::None) {
+        // Already 16 bits per sample; left-align if the sensor depth is lower
+        const int shift = 16 - info.bitDepth;
+        for (int x = 0; x < width; ++x) {
+            uint16_t v = static_cast<uint16_t>(src[2 * x] | (src[2 * x + 1] << 8));
+            dst[x] = static_cast<uint16_t>(v << shift);
+        }
+    } else if (info.bitDepth == 10) {
+        // 4 MSB bytes, then one byte holding the 2 LSBs of each sample
+        int x = 0;
+        for (; x + 4 <= width; x += 4, src += 5) {
+            for (int i = 0; i < 4; ++i) {
+                dst[x + i] = static_cast<uint16_t>(((src[i] << 2) | ((src[4] >> (2 * i)) & 3)) << 6);
+            }
+        }
+        for (int i = 0; x < width; ++x, ++i) dst[x] = static_cast<uint16_t>(src[i] << 8);
+    } else {
+        // 12-bit: 2 MSB bytes, then one byte holding both 4-bit LSBs
+        int x = 0;
+        for (; x + 2 <= width; x += 2, src += 3) {
+            dst[x] = static_cast<uint16_t>(((src[0] << 4) | (src[2] & 0xF)) << 4);
+            dst[x + 1] = static_cast<uint16_t>(((src[1] << 4) | (src[2] >> 4)) << 4);
+        }
+        if (x < width) dst[x] = static_cast<uint16_t>(src[0] << 8);
+    }
+}
+
+static bool readRawFile(const std::string& rawPath, const RawInfo& info, std::vector<uint8_t>& data) {
+    std::ifstream file(rawPath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "[Raw] Could not open " << rawPath << std::endl;
+        return false;
+    }
+    data.resize(static_cast<size_t>(info.stride) * info.height);
+    file.read(reinterpret_cast<char*>(data.data()), data.size());
+    if (file.gcount() != static_cast<std::streamsize>(data.size())) {
+        std::cerr << "[Raw] Truncated RAW file: " << rawPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static int whiteLevel(const RawInfo& info) {
+    return ((1 << info.bitDepth) - 1) << (16 - info.bitDepth);
+}
+
+// --- JPEG (half resolution) ---
+
+bool developJpeg(const std::string& rawPath, const RawInfo& info, const std::string& jpegPath, int quality) {
+    std::vector<uint8_t> data;
+    if (!readRawFile(rawPath, info, data)) return false;
+
+    // Where each colour sits in the 2x2 quad (index = row * 2 + col)
+    int red = 0, blue = 0, green[2], greens = 0;
+    for (int i = 0; i < 4; ++i) {
+        if (info.bayerOrder[i] == 'R') red = i;
+        else if (info.bayerOrder[i] == 'B') blue = i;
+        else green[greens++] = i;
+    }
+
+    // Linear [0, 1] -> sRGB 8-bit
+    const int kLutSize = 4096;
+    std::vector<uint8_t> gamma(kLutSize);
+    for (int i = 0; i < kLutSize; ++i) {
+        float v = static_cast<float>(i) / (kLutSize - 1);
+        v = v <= 0.0031308f ? 12.92f * v : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+        gamma[i] = static_cast<uint8_t>(std::lround(v * 255.0f));
+    }
+
+    const float black = static_cast<float>(info.blackLevel);
+    const float scale = 1.0f / std::max(1.0f, whiteLevel(info) - black);
+    const float gainR = info.colourGains[0] * scale;
+    const float gainB = info.colourGains[1] * scale;
+    const float* m = info.ccm;
+
+    OwnedFrame out;
+    out.allocate(PixelLayout::BGR888, info.width / 2, info.height / 2);
+    std::vector<uint16_t> rows[2] = { std::vector<uint16_t>(info.width), std::vector<uint16_t>(info.width) };
+
+    for (int y = 0; y < out.height; ++y) {
+        for (int r = 0; r < 2; ++r) {
+            unpackRawRow(&data[static_cast<size_t>(2 * y + r) * info.stride], rows[r].data(), info);
+        }
+
+        uint8_t* dst = out.plane(0) + static_cast<size_t>(y) * out.strides[0];
+        for (int x = 0; x < out.width; ++x) {
+            auto sample = [&](int i) {
+                return std::max(0.0f, rows[i >> 1][2 * x + (i & 1)] - black);
+            };
+            const float cr = sample(red) * gainR;
+            const float cg = 0.5f * (sample(green[0]) + sample(green[1])) * scale;
+            const float cb = sample(blue) * gainB;
+
+            const float rgb[3] = {
+                m[0] * cr + m[1] * cg + m[2] * cb,
+                m[3] * cr + m[4] * cg + m[5] * cb,
+                m[6] * cr + m[7] * cg + m[8] * cb,
+            };
+            for (int c = 0; c < 3; ++c) {
+                int index = static_cast<int>(std::clamp(rgb[c], 0.0f, 1.0f) * (kLutSize - 1));
+                dst[x * 3 + (2 - c)] = gamma[index]; // BGR888
+            }
+        }
+    }
+
+    return saveJpeg(jpegPath, out.view(), quality);
+}
+
+// --- DNG ---
+
+// Minimal little-endian TIFF/DNG writer: one IFD, one strip
+class TiffWriter {
+public:
+    enum Type { BYTE = 1, ASCII = 2, SHORT = 3, LONG = 4, RATIONAL = 5, SRATIONAL = 10 };
+
+    void add(uint16_t tag, Type type, uint32_t count, const void* values) {
+        Entry entry{tag, type, count, {}};
+        const uint8_t* bytes = static_cast<const uint8_t*>(values);
+        entry.data.assign(bytes, bytes + count * typeSize(type));
+        entries.push_back(entry);
+    }
+    void addShort(uint16_t tag, uint16_t value) { add(tag, SHORT, 1, &value); }
+    void addLong(uint16_t tag, uint32_t value) { add(tag, LONG, 1, &value); }
+    void addAscii(uint16_t tag, const std::string& text) { add(tag, ASCII, text.size() + 1, text.c_str()); }
+    void addRationals(uint16_t tag, Type type, const std::vector<float>& values) {
+        std::vector<int32_t> pairs;
+        for (float v : values) {
+            pairs.push_back(static_cast<int32_t>(std::lround(v * 10000.0f)));
+            pairs.push_back(10000);
+        }
+        add(tag, type, values.size(), pairs.data());
+    }
+
+    // Appends header + IFD + out-of-line values to 'out'; the image strip goes right after
+    // (its offset is patched into StripOffsets / StripByteCounts here).
+    void writeHeader(std::vector<uint8_t>& out, uint32_t imageBytes) {
+        std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.tag < b.tag; });
+
+        const uint32_t ifdSize = 2 + 12 * static_cast<uint32_t>(entries.size()) + 4;
+        uint32_t dataOffset = 8 + ifdSize;
+        uint32_t imageOffset = dataOffset;
+        for (const Entry& entry : entries) {
+            if (entry.data.size() > 4) imageOffset += (entry.data.size() + 1) & ~1u;
+        }
+        for (Entry& entry : entries) {
+            if (entry.tag == kStripOffsets) std::memcpy(entry.data.data(), &imageOffset, 4);
+            if (entry.tag == kStripByteCounts) std::memcpy(entry.data.data(), &imageBytes, 4);
+        }
+
+        out.insert(out.end(), { 'I', 'I', 42, 0, 8, 0, 0, 0 });
+        std::vector<uint8_t> extra;
+        put16(out, static_cast<uint16_t>(entries.size()));
+        for (const Entry& entry : entries) {
+            put16(out, entry.tag);
+            put16(out, static_cast<uint16_t>(entry.type));
+            put32(out, entry.count);
+            if (entry.data.size() <= 4) {
+                std::vector<uint8_t> inlined = entry.data;
+                inlined.resize(4, 0);
+                out.insert(out.end(), inlined.begin(), inlined.end());
+            } else {
+                put32(out, dataOffset + static_cast<uint32_t>(extra.size()));
+                extra.insert(extra.end(), entry.data.begin(), entry.data.end());
+                if (extra.size() & 1) extra.push_back(0); // Word alignment
+            }
+        }
+        put32(out, 0); // No next IFD
+        out.insert(out.end(), extra.begin(), extra.end());
+    }
+
+    static const uint16_t kStripOffsets = 273;
+    static const uint16_t kStripByteCounts = 279;
+
+private:
+    struct Entry {
+        uint16_t tag;
+        Type type;
+        uint32_t count;
+        std::vector<uint8_t> data;
+    };
+    std::vector<Entry> entries;
+
+    static uint32_t typeSize(Type type) {
+        switch (type) {
+            case SHORT: return 2;
+            case LONG: return 4;
+            case RATIONAL: case SRATIONAL: return 8;
+            default: return 1;
+        }
+    }
+    static void put16(std::vector<uint8_t>& v, uint16_t x) { v.push_back(x & 0xFF); v.push_back(x >> 8); }
+    static void put32(std::vector<uint8_t>& v, uint32_t x) { put16(v, x & 0xFFFF); put16(v, x >> 16); }
+};
+
+// 3x3 inverse (row-major), false if singular
+static bool invert3x3(const float* a, float* inv) {
+    const float det = a[0] * (a[4] * a[8] - a[5] * a[7]) - a[1] * (a[3] * a[8] - a[5] * a[6]) +
+                      a[2] * (a[3] * a[7] - a[4] * a[6]);
+    if (std::fabs(det) < 1e-9f) return false;
+    inv[0] = (a[4] * a[8] - a[5] * a[7]) / det;
+    inv[1] = (a[2] * a[7] - a[1] * a[8]) / det;
+    inv[2] = (a[1] * a[5] - a[2] * a[4]) / det;
+    inv[3] = (a[5] * a[6] - a[3] * a[8]) / det;
+    inv[4] = (a[0] * a[8] - a[2] * a[6]) / det;
+    inv[5] = (a[2] * a[3] - a[0] * a[5]) / det;
+    inv[6] = (a[3] * a[7] - a[4] * a[6]) / det;
+    inv[7] = (a[1] * a[6] - a[0] * a[7]) / det;
+    inv[8] = (a[0] * a[4] - a[1] * a[3]) / det;
+    return true;
+}
+
+bool developDng(const std::string& rawPath, const RawInfo& info, const std::string& dngPath) {
+    std::vector<uint8_t> data;
+    if (!readRawFile(rawPath, info, data)) return false;
+
+    // ColorMatrix1 maps XYZ (D65) to camera RGB:
+    // camera = diag(1 / wb) * inverse(sRGB->XYZ * ccm)
+    static const float srgbToXyz[9] = { 0.4124f, 0.3576f, 0.1805f,
+                                        0.2126f, 0.7152f, 0.0722f,
+                                        0.0193f, 0.1192f, 0.9505f };
+    float cameraToXyz[9], xyzToCamera[9];
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            cameraToXyz[r * 3 + c] = 0.0f;
+            for (int k = 0; k < 3; ++k) cameraToXyz[r * 3 + c] += srgbToXyz[r * 3 + k] * info.ccm[k * 3 + c];
+        }
+    }
+    if (!invert3x3(cameraToXyz, xyzToCamera)) {
+        std::cerr << "[Raw] Singular colour matrix, using sRGB." << std::endl;
+        invert3x3(srgbToXyz, xyzToCamera);
+    }
+    const float wb[3] = { info.colourGains[0], 1.0f, info.colourGains[1] };
+    std::vector<float> colorMatrix(9);
+    for (int i = 0; i < 9; ++i) colorMatrix[i] = xyzToCamera[i] / std::max(0.01f, wb[i / 3]);
+
+    // CFAPattern: 0 = R, 1 = G, 2 = B
+    uint8_t cfa[4];
+    for (int i = 0; i < 4; ++i) cfa[i] = info.bayerOrder[i] == 'R' ? 0 : info.bayerOrder[i] == 'G' ? 1 : 2;
+    const uint16_t cfaDim[2] = { 2, 2 };
+    const uint8_t dngVersion[4] = { 1, 4, 0, 0 };
+    const uint8_t dngBackward[4] = { 1, 1, 0, 0 };
+    const std::string model = info.model.empty() ? "Horus" : info.model;
+    const uint32_t imageBytes = static_cast<uint32_t>(info.width) * info.height * 2;
+
+    TiffWriter tiff;
+    tiff.addLong(254, 0);                       // NewSubFileType: main image
+    tiff.addLong(256, info.width);
+    tiff.addLong(257, info.height);
+    tiff.addShort(258, 16);                     // BitsPerSample
+    tiff.addShort(259, 1);                      // Compression: none
+    tiff.addShort(262, 32803);                  // Photometric: CFA
+    tiff.addAscii(271, "Raspberry Pi");
+    tiff.addAscii(272, model);
+    tiff.addLong(TiffWriter::kStripOffsets, 0); // Patched by writeHeader()
+    tiff.addShort(274, 1);                      // Orientation
+    tiff.addShort(277, 1);                      // SamplesPerPixel
+    tiff.addLong(278, info.height);             // RowsPerStrip: one strip
+    tiff.addLong(TiffWriter::kStripByteCounts, 0);
+    tiff.addShort(284, 1);                      // PlanarConfiguration
+    tiff.add(33421, TiffWriter::SHORT, 2, cfaDim);
+    tiff.add(33422, TiffWriter::BYTE, 4, cfa);
+    tiff.add(50706, TiffWriter::BYTE, 4, dngVersion);
+    tiff.add(50707, TiffWriter::BYTE, 4, dngBackward);
+    tiff.addAscii(50708, info.model.empty() ? model : "Horus " + model); // UniqueCameraModel
+    tiff.addLong(50714, static_cast<uint32_t>(info.blackLevel));
+    tiff.addLong(50717, static_cast<uint32_t>(whiteLevel(info)));
+    tiff.addRationals(50721, TiffWriter::SRATIONAL, colorMatrix);
+    tiff.addRationals(50728, TiffWriter::RATIONAL, { 1.0f / wb[0], 1.0f, 1.0f / wb[2] }); // AsShotNeutral
+    tiff.addShort(50778, 21);                   // CalibrationIlluminant1: D65
+
+    // Built in memory and committed with writeFileAtomic(): a DNG cut short by a power
+    // loss would otherwise count as developed, and the RAW is never developed again
+    std::vector<uint8_t> dng;
+    tiff.writeHeader(dng, imageBytes);
+    size_t offset = dng.size();
+    dng.resize(offset + imageBytes);
+    std::vector<uint16_t> row(info.width);
+    for (int y = 0; y < info.height; ++y) {
+        unpackRawRow(&data[static_cast<size_t>(y) * info.stride], row.data(), info);
+        std::memcpy(&dng[offset], row.data(), row.size() * 2); // Host is little-endian
+        offset += row.size() * 2;
+    }
+    if (!utils::writeFileAtomic(dngPath, dng.data(), dng.size())) {
+        std::cerr << "[Raw] Could not write " << dngPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+}
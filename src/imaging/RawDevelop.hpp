@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace horus {
+namespace imaging {
+
+    // How the sensor samples are laid out in a RAW buffer
+    enum class RawPacking {
+        None,  // One uint16 per sample, left-aligned to 16 bits
+        Csi2   // MIPI CSI-2 packed: 10-bit = 4 samples / 5 bytes, 12-bit = 2 samples / 3 bytes
+    };
+
+    // Everything needed to make sense of a RAW dump later (stored as a JSON sidecar).
+    // Levels are on a 16-bit scale, like libcamera's SensorBlackLevels.
+    struct RawInfo {
+        std::string format;        // libcamera name, e.g. "SRGGB10_CSI2P"
+        std::string model;         // Sensor model, e.g. "imx708"
+        int width = 0;
+        int height = 0;
+        int stride = 0;            // Bytes per row in the file (includes padding)
+        int bitDepth = 0;
+        RawPacking packing = RawPacking::None;
+        std::string bayerOrder;    // "RGGB", "GRBG", "GBRG" or "BGGR"
+        int blackLevel = 4096;     // 16-bit scale (64 at 10 bits)
+        float exposureTime = 0.0f; // us
+        float analogueGain = 0.0f;
+        float colourGains[2] = {1.0f, 1.0f}; // AWB R, B
+        float ccm[9] = {1, 0, 0, 0, 1, 0, 0, 0, 1}; // White-balanced camera RGB -> linear sRGB
+        float lux = 0.0f;
+        int64_t timestampNs = 0;   // Sensor timestamp
+    };
+
+    // Fills format / bitDepth / packing / bayerOrder from a libcamera format name.
+    // Returns false for formats develop cannot read (e.g. the Pi 5 compressed ones).
+    bool parseRawFormat(const std::string& format, RawInfo& info);
+
+    bool writeRawInfo(const std::string& path, const RawInfo& info);
+    bool readRawInfo(const std::string& path, RawInfo& info);
+
+    // Unpacks one row of samples to 16-bit scale
+    void unpackRawRow(const uint8_t* src, uint16_t* dst, const RawInfo& info);
+
+    // Deferred "develop" of a RAW dump (+ its sidecar):
+    // JPEG : half-resolution demosaic (one RGB pixel per 2x2 Bayer quad), white balance,
+    //        colour matrix and sRGB gamma, then the regular encoder.
+    // DNG  : lossless, full resolution, uncompressed 16-bit CFA with the white balance
+    //        and colour matrix as metadata, for the CO2 estimation pipeline.
+    bool developJpeg(const std::string& rawPath, const RawInfo& info, const std::string& jpegPath, int quality = 90);
+    bool developDng(const std::string& rawPath, const RawInfo& info, const std::string& dngPath);
+
+}
+}
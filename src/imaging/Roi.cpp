@@ -0,0 +1,157 @@
+#include "Roi.hpp"
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <filesystem>
+#include "utils/Args.hpp"
+
+namespace horus {
+namespace imaging {
+
+// Clips to the field [0, 1]; a region outside it keeps zero width / height
+static Roi clipToField(Roi roi) {
+    const double left = std::clamp(roi.x, 0.0, 1.0);
+    const double top = std::clamp(roi.y, 0.0, 1.0);
+    const double right = std::clamp(roi.x + roi.width, 0.0, 1.0);
+    const double bottom = std::clamp(roi.y + roi.height, 0.0, 1.0);
+    roi.x = left;
+    roi.y = top;
+    roi.width = std::max(0.0, right - left);
+    roi.height = std::max(0.0, bottom - top);
+    return roi;
+}
+
+bool parseRois(const std::string& spec, std::vector<Roi>& rois) {
+    std::vector<Roi> parsed;
+    std::stringstream regions(spec);
+    std::string region;
+    while (std::getline(regions, region, ';')) {
+        if (region.find_first_not_of(" \t") == std::string::npos) continue;
+
+        // 1. Optional "name="
+        Roi roi;
+        std::string values = region;
+        const size_t equals = region.find('=');
+        if (equals != std::string::npos) {
+            roi.name = region.substr(0, equals);
+            values = region.substr(equals + 1);
+        }
+        roi.name.erase(std::remove_if(roi.name.begin(), roi.name.end(), ::isspace), roi.name.end());
+        if (roi.name.empty()) roi.name = "roi" + std::to_string(parsed.size() + 1);
+        // "p2", "p4" ... would land on the preview files (<stem>_p<factor>.jpg)
+        const bool previewName = roi.name.size() > 1 && roi.name[0] == 'p' &&
+                                 roi.name.find_first_not_of("0123456789", 1) == std::string::npos;
+        if (roi.name.find_first_of("/\\.") != std::string::npos || previewName) {
+            std::cerr << "[Roi] Invalid name: " << roi.name << std::endl;
+            return false;
+        }
+
+        // 2. x,y,width,height
+        std::vector<double> numbers;
+        std::stringstream fields(values);
+        std::string field;
+        bool numeric = true;
+        while (numeric && std::getline(fields, field, ',')) {
+            field.erase(std::remove_if(field.begin(), field.end(), ::isspace), field.end());
+            double number = 0.0;
+            numeric = utils::parseDouble(field, number);
+            numbers.push_back(number);
+        }
+        if (!numeric || numbers.size() != 4 || numbers[2] <= 0.0 || numbers[3] <= 0.0) {
+            std::cerr << "[Roi] " << roi.name << ": expected x,y,width,height (fractions of the field), got "
+                      << values << std::endl;
+            return false;
+        }
+        roi.x = numbers[0];
+        roi.y = numbers[1];
+        roi.width = numbers[2];
+        roi.height = numbers[3];
+
+        roi = clipToField(roi);
+        if (roi.width <= 0.0 || roi.height <= 0.0) {
+            std::cerr << "[Roi] Outside the field: " << region << std::endl;
+            return false;
+        }
+        parsed.push_back(roi);
+    }
+    rois = parsed;
+    return true;
+}
+
+Roi roiBounds(const std::vector<Roi>& rois) {
+    Roi bounds;
+    if (rois.empty()) return bounds;
+
+    double right = 0.0;
+    double bottom = 0.0;
+    bounds.x = bounds.y = 1.0;
+    for (const Roi& roi : rois) {
+        bounds.x = std::min(bounds.x, roi.x);
+        bounds.y = std::min(bounds.y, roi.y);
+        right = std::max(right, roi.x + roi.width);
+        bottom = std::max(bottom, roi.y + roi.height);
+    }
+    bounds.width = right - bounds.x;
+    bounds.height = bottom - bounds.y;
+    return clipToField(bounds);
+}
+
+Roi roiWithin(const Roi& roi, const Roi& field) {
+    Roi relative = roi;
+    if (field.width <= 0.0 || field.height <= 0.0) {
+        relative.width = relative.height = 0.0;
+        return relative;
+    }
+    relative.x = (roi.x - field.x) / field.width;
+    relative.y = (roi.y - field.y) / field.height;
+    relative.width = roi.width / field.width;
+    relative.height = roi.height / field.height;
+    return clipToField(relative);
+}
+
+PixelRect roiToPixels(const Roi& roi, int width, int height) {
+    // Outward to even coordinates: the region never loses a pixel row or column
+    auto evenFloor = [](double v) { return static_cast<int>(std::floor(v / 2.0)) * 2; };
+    auto evenCeil = [](double v) { return static_cast<int>(std::ceil(v / 2.0 - 1e-9)) * 2; };
+
+    const int left = std::clamp(evenFloor(roi.x * width), 0, width);
+    const int top = std::clamp(evenFloor(roi.y * height), 0, height);
+    const int right = std::clamp(evenCeil((roi.x + roi.width) * width), left, width);
+    const int bottom = std::clamp(evenCeil((roi.y + roi.height) * height), top, height);
+    return { left, top, right - left, bottom - top };
+}
+
+bool cropFrame(const FrameView& frame, const PixelRect& rect, FrameView& out) {
+    if (rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+        rect.x + rect.width > frame.width || rect.y + rect.height > frame.height) {
+        std::cerr << "[Roi] Crop outside the frame." << std::endl;
+        return false;
+    }
+    const bool yuv = frame.layout == PixelLayout::YUV420;
+    if (yuv && (rect.x % 2 != 0 || rect.y % 2 != 0)) {
+        std::cerr << "[Roi] YUV420 crops start on even coordinates." << std::endl;
+        return false;
+    }
+
+    out = frame;
+    out.width = rect.width;
+    out.height = rect.height;
+    for (int p = 0; p < planeCount(frame.layout); ++p) {
+        // Luma / BGR at full resolution, chroma at half
+        const int shift = yuv && p > 0 ? 1 : 0;
+        const int pixelBytes = yuv ? 1 : 3;
+        out.planes[p] = frame.planes[p] + static_cast<size_t>(rect.y >> shift) * frame.strides[p] +
+                        static_cast<size_t>(rect.x >> shift) * pixelBytes;
+    }
+    return true;
+}
+
+std::string roiPath(const std::string& filename, const std::string& name) {
+    std::filesystem::path path(filename);
+    return (path.parent_path() / (path.stem().string() + "_" + name + ".jpg")).string();
+}
+
+}
+}
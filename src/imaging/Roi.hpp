@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // Region of interest as fractions (0..1) of the sensor's field of view, so one
+    // configuration holds at any stream size and in both pixel layouts.
+    struct Roi {
+        std::string name;
+        double x = 0.0;
+        double y = 0.0;
+        double width = 1.0;
+        double height = 1.0;
+    };
+
+    // Pixel rectangle inside a frame
+    struct PixelRect {
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+
+    // "trunk=0.30,0.15,0.40,0.80;crown=0.10,0,0.80,0.35": name=x,y,width,height per
+    // region, ';' between regions. The name is optional ("roi1", "roi2" ...) and may not
+    // be a preview suffix ("p2", "p4" ...) or hold '/', '\' or '.'.
+    // Regions are clipped to the field; false (and 'rois' untouched) on a malformed spec.
+    bool parseRois(const std::string& spec, std::vector<Roi>& rois);
+
+    // Smallest region holding all of 'rois' (the whole field if there are none)
+    Roi roiBounds(const std::vector<Roi>& rois);
+
+    // 'roi' in the coordinates of 'field' (a region of the same sensor), clipped to it.
+    // Zero width or height if they don't overlap.
+    Roi roiWithin(const Roi& roi, const Roi& field);
+
+    // 'roi' in pixels of a width x height frame. Edges are widened to even coordinates
+    // (the chroma planes of a 4:2:0 frame are half size), then clamped inside the frame.
+    PixelRect roiToPixels(const Roi& roi, int width, int height);
+
+    // Zero-copy crop: the plane pointers move to the rectangle's corner, the strides stay
+    // those of 'frame'. 'rect' must be inside the frame, with even x and y for YUV420.
+    bool cropFrame(const FrameView& frame, const PixelRect& rect, FrameView& out);
+
+    // "<dir>/<stem>_<name>.jpg", next to the context picture
+    std::string roiPath(const std::string& filename, const std::string& name);
+
+}
+}
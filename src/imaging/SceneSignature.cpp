@@ -0,0 +1,223 @@
+#include "SceneSignature.hpp"
+#include "utils/FileSystem.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <filesystem>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+namespace horus {
+namespace imaging {
+
+namespace {
+
+const int kHashSize = 32; // Luma is area-averaged to 32x32 before the DCT
+const int kLowFreq = 8;   // 8x8 lowest frequencies = 64 hash bits
+const int kSignatureWidth = 256;
+
+// Rows 0..7 of the 32-point DCT-II basis
+struct DctBasis {
+    float c[kLowFreq][kHashSize];
+    DctBasis() {
+        const double pi = std::acos(-1.0);
+        for (int u = 0; u < kLowFreq; ++u) {
+            for (int x = 0; x < kHashSize; ++x) {
+                c[u][x] = static_cast<float>(std::cos((2 * x + 1) * u * pi / (2.0 * kHashSize)));
+            }
+        }
+    }
+};
+
+const DctBasis& dctBasis() {
+    static const DctBasis basis;
+    return basis;
+}
+
+} // namespace
+
+void computeSignature(const FrameView& frame, SceneSignature& out) {
+    LumaImage luma;
+    downscaleLuma(frame, std::max(1, frame.width / kSignatureWidth), luma);
+    computeSignature(luma, out);
+}
+
+void computeSignature(const LumaImage& luma, SceneSignature& out) {
+    out = SceneSignature();
+    if (luma.width < kHashSize || luma.height < kHashSize) return;
+
+    // 1. Histogram and mean. Four partial histograms, so consecutive pixels in the same
+    // bin don't wait on each other's increment
+    uint32_t counts[4][32] = {};
+    uint64_t total = 0;
+    const size_t pixels = luma.data.size();
+    const uint8_t* p = luma.data.data();
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4) {
+        ++counts[0][p[i] >> 3];
+        ++counts[1][p[i + 1] >> 3];
+        ++counts[2][p[i + 2] >> 3];
+        ++counts[3][p[i + 3] >> 3];
+    }
+    for (; i < pixels; ++i) ++counts[0][p[i] >> 3];
+    for (size_t k = 0; k < pixels; ++k) total += p[k]; // Vectorises
+    for (int b = 0; b < 32; ++b) {
+        out.histogram[b] = static_cast<float>(counts[0][b] + counts[1][b] + counts[2][b] + counts[3][b]) / pixels;
+    }
+    out.meanLuma = static_cast<float>(static_cast<double>(total) / pixels);
+
+    // 2. Area average down to 32x32: rows of each band summed into column sums, then
+    // the columns of each cell
+    float cells[kHashSize][kHashSize];
+    std::vector<uint32_t> columns(luma.width);
+    for (int cy = 0; cy < kHashSize; ++cy) {
+        const int y0 = cy * luma.height / kHashSize;
+        const int y1 = (cy + 1) * luma.height / kHashSize;
+        std::fill(columns.begin(), columns.end(), 0);
+        for (int y = y0; y < y1; ++y) {
+            const uint8_t* row = luma.row(y);
+            for (int x = 0; x < luma.width; ++x) columns[x] += row[x];
+        }
+        for (int cx = 0; cx < kHashSize; ++cx) {
+            const int x0 = cx * luma.width / kHashSize;
+            const int x1 = (cx + 1) * luma.width / kHashSize;
+            uint32_t sum = 0;
+            for (int x = x0; x < x1; ++x) sum += columns[x];
+            cells[cy][cx] = static_cast<float>(sum) / ((y1 - y0) * (x1 - x0));
+        }
+    }
+
+    // 3. Low 8x8 of the 2D DCT: basis x cells (8x32), then x basis^T (8x8)
+    const DctBasis& basis = dctBasis();
+    float rows[kLowFreq][kHashSize] = {};
+    for (int u = 0; u < kLowFreq; ++u) {
+        for (int y = 0; y < kHashSize; ++y) {
+            const float c = basis.c[u][y];
+            for (int x = 0; x < kHashSize; ++x) rows[u][x] += c * cells[y][x];
+        }
+    }
+    float coefficients[kLowFreq * kLowFreq];
+    for (int u = 0; u < kLowFreq; ++u) {
+        for (int v = 0; v < kLowFreq; ++v) {
+            float sum = 0.0f;
+            for (int x = 0; x < kHashSize; ++x) sum += rows[u][x] * basis.c[v][x];
+            coefficients[u * kLowFreq + v] = sum;
+        }
+    }
+
+    // 4. One bit per coefficient: above the median of the AC terms (the DC term is
+    // just the brightness, which the histogram already covers)
+    float ac[kLowFreq * kLowFreq - 1];
+    std::copy(coefficients + 1, coefficients + kLowFreq * kLowFreq, ac);
+    std::nth_element(ac, ac + 31, ac + 63);
+    const float median = ac[31];
+    for (int k = 1; k < kLowFreq * kLowFreq; ++k) {
+        if (coefficients[k] > median) out.hash |= uint64_t(1) << k;
+    }
+}
+
+SceneDistance sceneDistance(const SceneSignature& a, const SceneSignature& b) {
+    SceneDistance distance;
+    distance.hashBits = __builtin_popcountll(a.hash ^ b.hash);
+
+    // 1D earth mover's distance: area between the cumulative histograms, so a small
+    // exposure shift moves it a little instead of emptying whole bins
+    double cumulativeA = 0.0;
+    double cumulativeB = 0.0;
+    double area = 0.0;
+    for (size_t bin = 0; bin + 1 < a.histogram.size(); ++bin) {
+        cumulativeA += a.histogram[bin];
+        cumulativeB += b.histogram[bin];
+        area += std::fabs(cumulativeA - cumulativeB);
+    }
+    distance.histogram = area / (a.histogram.size() - 1);
+    return distance;
+}
+
+SceneVerdict compareScenes(const SceneSignature* previous, const SceneSignature& current,
+                           const SceneOptions& options, SceneDistance* distance) {
+    SceneDistance d;
+    if (previous) d = sceneDistance(*previous, current);
+    if (distance) *distance = d;
+
+    if (current.meanLuma < options.darkLuma) return SceneVerdict::Dark;
+    if (previous && d.hashBits <= options.maxHashDistance && d.histogram <= options.maxHistogramDistance) {
+        return SceneVerdict::Duplicate;
+    }
+    return SceneVerdict::New;
+}
+
+bool saveSignature(const std::string& path, const SceneSignature& signature, const std::string& image) {
+    std::ostringstream hash;
+    hash << std::hex << signature.hash;
+    nlohmann::json j = {
+        {"hash", hash.str()},
+        {"mean", std::round(signature.meanLuma * 100.0f) / 100.0f},
+        {"histogram", signature.histogram},
+        {"image", image}
+    };
+    const std::string text = j.dump() + "\n";
+    return utils::writeFileAtomic(path, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+bool loadSignature(const std::string& path, SceneSignature& signature, std::string* image) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false; // First capture: no reference yet
+    try {
+        nlohmann::json j = nlohmann::json::parse(file);
+        signature.hash = std::stoull(j.at("hash").get<std::string>(), nullptr, 16);
+        signature.meanLuma = j.at("mean").get<float>();
+        signature.histogram = j.at("histogram").get<std::array<float, 32>>();
+        if (image) *image = j.value("image", "");
+    } catch (const std::exception& e) {
+        std::cerr << "[Scene] Ignoring " << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::string duplicateFlagPath(const std::string& filename) {
+    return std::filesystem::path(filename).replace_extension(".dup.json").string();
+}
+
+bool writeDuplicateFlag(const std::string& filename, SceneVerdict verdict, const SceneDistance& distance,
+                        const std::string& reference) {
+    nlohmann::json j = {
+        {"verdict", sceneVerdictName(verdict)},
+        {"hashBits", distance.hashBits},
+        {"histogram", std::round(distance.histogram * 1e4) / 1e4},
+        {"reference", std::filesystem::path(reference).filename().string()}
+    };
+    const std::string text = j.dump() + "\n";
+    return utils::writeFileAtomic(duplicateFlagPath(filename), reinterpret_cast<const uint8_t*>(text.data()), text.size());
+}
+
+bool parseScenePolicy(const std::string& name, ScenePolicy& policy) {
+    if (name == "off") policy = ScenePolicy::Off;
+    else if (name == "flag") policy = ScenePolicy::Flag;
+    else if (name == "thumbnail") policy = ScenePolicy::Thumbnail;
+    else if (name == "skip") policy = ScenePolicy::Skip;
+    else return false;
+    return true;
+}
+
+const char* scenePolicyName(ScenePolicy policy) {
+    switch (policy) {
+        case ScenePolicy::Flag: return "flag";
+        case ScenePolicy::Thumbnail: return "thumbnail";
+        case ScenePolicy::Skip: return "skip";
+        default: return "off";
+    }
+}
+
+const char* sceneVerdictName(SceneVerdict verdict) {
+    switch (verdict) {
+        case SceneVerdict::Duplicate: return "duplicate";
+        case SceneVerdict::Dark: return "dark";
+        default: return "new";
+    }
+}
+
+}
+}
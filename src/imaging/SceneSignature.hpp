@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <array>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+#include "imaging/Luma.hpp"
+
+namespace horus {
+namespace imaging {
+
+    // What a capture that looks like the previous one (or is black) turns into
+    enum class ScenePolicy {
+        Off,        // No signature, every frame is saved
+        Flag,       // Saved as usual, plus a "<image>.dup.json" the uploader sends last
+        Thumbnail,  // Only the 1/8 preview "<image>_p8.jpg" is saved
+        Skip        // Nothing is encoded or saved
+    };
+
+    struct SceneOptions {
+        ScenePolicy policy = ScenePolicy::Off;
+        int maxHashDistance = 3;            // Perceptual hash bits (of 64) still "the same scene"
+        double maxHistogramDistance = 0.05; // Luma histogram distance (0..1) still "the same scene"
+        double darkLuma = 12.0;             // Mean luma under this = black frame (night, broken schedule)
+    };
+
+    // Cheap fingerprint of a frame, from a luma plane ~256 pixels wide
+    struct SceneSignature {
+        uint64_t hash = 0;                 // DCT perceptual hash: low 8x8 frequencies vs their median
+        std::array<float, 32> histogram{}; // Luma in 32 bins, fractions of the pixels
+        float meanLuma = 0.0f;
+    };
+
+    enum class SceneVerdict { New, Duplicate, Dark };
+
+    struct SceneDistance {
+        int hashBits = 64;
+        double histogram = 1.0; // Earth mover's distance between the histograms, 1 = black vs white
+    };
+
+    // Downscales 'frame' (Y plane only for YUV420) and fingerprints it
+    void computeSignature(const FrameView& frame, SceneSignature& out);
+
+    // Same, from an already downscaled luma plane (any size of at least 32x32)
+    void computeSignature(const LumaImage& luma, SceneSignature& out);
+
+    SceneDistance sceneDistance(const SceneSignature& a, const SceneSignature& b);
+
+    // Dark first (needs no reference), then Duplicate if both distances are within the
+    // options against 'previous' (null = no reference yet: New)
+    SceneVerdict compareScenes(const SceneSignature* previous, const SceneSignature& current,
+                               const SceneOptions& options, SceneDistance* distance = nullptr);
+
+    // Reference signature kept between runs (JSON, atomic write), with the image it came from
+    bool saveSignature(const std::string& path, const SceneSignature& signature, const std::string& image);
+    bool loadSignature(const std::string& path, SceneSignature& signature, std::string* image = nullptr);
+
+    // "<dir>/<stem>.dup.json": the uploader sends images that have one after everything else
+    std::string duplicateFlagPath(const std::string& filename);
+
+    // Writes that flag for 'filename': the verdict, the distances and the reference image
+    bool writeDuplicateFlag(const std::string& filename, SceneVerdict verdict, const SceneDistance& distance,
+                            const std::string& reference);
+
+    // "skip" / "thumbnail" / "flag" / "off"; false for anything else
+    bool parseScenePolicy(const std::string& name, ScenePolicy& policy);
+    const char* scenePolicyName(ScenePolicy policy);
+    const char* sceneVerdictName(SceneVerdict verdict);
+
+}
+}
@@ -0,0 +1,174 @@
+#include "TemporalDenoise.hpp"
+#include <iostream>
+#include <algorithm>
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace horus {
+namespace imaging {
+
+// --- KERNELS ---
+
+// sum[i] += src[i]
+static void accumulateRow(uint16_t* sum, const uint8_t* src, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t pixels = vld1q_u8(src + i);
+        vst1q_u16(sum + i, vaddw_u8(vld1q_u16(sum + i), vget_low_u8(pixels)));
+        vst1q_u16(sum + i + 8, vaddw_u8(vld1q_u16(sum + i + 8), vget_high_u8(pixels)));
+    }
+#endif
+    for (; i < n; ++i) sum[i] = static_cast<uint16_t>(sum[i] + src[i]);
+}
+
+// sum[i] = src[i] (first frame: saves clearing the accumulator)
+static void storeRow(uint16_t* sum, const uint8_t* src, int n) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t pixels = vld1q_u8(src + i);
+        vst1q_u16(sum + i, vmovl_u8(vget_low_u8(pixels)));
+        vst1q_u16(sum + i + 8, vmovl_u8(vget_high_u8(pixels)));
+    }
+#endif
+    for (; i < n; ++i) sum[i] = src[i];
+}
+
+// dst[i] = round(sum[i] / frames), division replaced by a 16.16 reciprocal multiply
+static void averageRow(uint8_t* dst, const uint16_t* sum, int n, int frames) {
+    const uint32_t reciprocal = (65536u + frames - 1) / frames;
+    const uint32_t half = static_cast<uint32_t>(frames / 2);
+    int i = 0;
+#if defined(__ARM_NEON)
+    const uint32x4_t vrecip = vdupq_n_u32(reciprocal);
+    const uint16x8_t vhalf = vdupq_n_u16(static_cast<uint16_t>(half));
+    for (; i + 8 <= n; i += 8) {
+        uint16x8_t s = vaddq_u16(vld1q_u16(sum + i), vhalf);
+        uint32x4_t lo = vshrq_n_u32(vmulq_u32(vmovl_u16(vget_low_u16(s)), vrecip), 16);
+        uint32x4_t hi = vshrq_n_u32(vmulq_u32(vmovl_u16(vget_high_u16(s)), vrecip), 16);
+        vst1_u8(dst + i, vqmovn_u16(vcombine_u16(vqmovn_u32(lo), vqmovn_u32(hi))));
+    }
+#endif
+    for (; i < n; ++i) {
+        uint32_t v = ((sum[i] + half) * reciprocal) >> 16;
+        dst[i] = static_cast<uint8_t>(std::min<uint32_t>(v, 255));
+    }
+}
+
+// --- ACCUMULATOR ---
+
+bool FrameAccumulator::add(const FrameView& frame) {
+    if (frames == 0) {
+        layout = frame.layout;
+        width = frame.width;
+        height = frame.height;
+        size_t total = 0;
+        for (int p = 0; p < planeCount(layout); ++p) {
+            offsets[p] = total;
+            total += static_cast<size_t>(planeRowBytes(layout, width, p)) * planeRows(layout, height, p);
+        }
+        sum.resize(total);
+    } else if (frame.layout != layout || frame.width != width || frame.height != height) {
+        std::cerr << "[Denoise] Frame geometry changed, skipping frame." << std::endl;
+        return false;
+    } else if (frames >= kMaxFrames) {
+        return false;
+    }
+
+    for (int p = 0; p < planeCount(layout); ++p) {
+        const int rowBytes = planeRowBytes(layout, width, p);
+        const int rows = planeRows(layout, height, p);
+        for (int y = 0; y < rows; ++y) {
+            uint16_t* dst = &sum[offsets[p] + static_cast<size_t>(y) * rowBytes];
+            const uint8_t* src = frame.planes[p] + static_cast<size_t>(y) * frame.strides[p];
+            if (frames == 0) {
+                storeRow(dst, src, rowBytes);
+            } else {
+                accumulateRow(dst, src, rowBytes);
+            }
+        }
+    }
+    ++frames;
+    return true;
+}
+
+bool FrameAccumulator::average(OwnedFrame& out) const {
+    if (frames == 0) return false;
+    out.allocate(layout, width, height);
+
+    for (int p = 0; p < planeCount(layout); ++p) {
+        const int rowBytes = planeRowBytes(layout, width, p);
+        const int rows = planeRows(layout, height, p);
+        for (int y = 0; y < rows; ++y) {
+            averageRow(out.plane(p) + static_cast<size_t>(y) * out.strides[p],
+                       &sum[offsets[p] + static_cast<size_t>(y) * rowBytes], rowBytes, frames);
+        }
+    }
+    return true;
+}
+
+// --- MEDIAN ---
+
+static inline void sort2(uint8_t& a, uint8_t& b) {
+    uint8_t lo = std::min(a, b);
+    b = std::max(a, b);
+    a = lo;
+}
+
+bool temporalMedian(const std::vector<FrameView>& frames, OwnedFrame& out) {
+    if (frames.empty()) return false;
+    const FrameView& first = frames[0];
+    for (const FrameView& frame : frames) {
+        if (frame.layout != first.layout || frame.width != first.width || frame.height != first.height) {
+            std::cerr << "[Denoise] Frames differ in size or format." << std::endl;
+            return false;
+        }
+    }
+
+    out.allocate(first.layout, first.width, first.height);
+    const size_t n = frames.size();
+    std::vector<uint8_t> samples(n);
+
+    for (int p = 0; p < planeCount(first.layout); ++p) {
+        const int rowBytes = planeRowBytes(first.layout, first.width, p);
+        const int rows = planeRows(first.layout, first.height, p);
+        for (int y = 0; y < rows; ++y) {
+            uint8_t* dst = out.plane(p) + static_cast<size_t>(y) * out.strides[p];
+            const size_t rowOffset = static_cast<size_t>(y);
+
+            if (n == 3) {
+                // Branch-free min/max network: vectorises to vmin/vmax
+                const uint8_t* a = frames[0].planes[p] + rowOffset * frames[0].strides[p];
+                const uint8_t* b = frames[1].planes[p] + rowOffset * frames[1].strides[p];
+                const uint8_t* c = frames[2].planes[p] + rowOffset * frames[2].strides[p];
+                for (int i = 0; i < rowBytes; ++i) {
+                    uint8_t lo = std::min(a[i], b[i]);
+                    uint8_t hi = std::max(a[i], b[i]);
+                    dst[i] = std::max(lo, std::min(hi, c[i]));
+                }
+            } else if (n == 5) {
+                // 7-exchange median-of-5 network
+                for (int i = 0; i < rowBytes; ++i) {
+                    uint8_t v[5];
+                    for (int k = 0; k < 5; ++k) v[k] = frames[k].planes[p][rowOffset * frames[k].strides[p] + i];
+                    sort2(v[0], v[1]); sort2(v[3], v[4]); sort2(v[0], v[3]);
+                    sort2(v[1], v[4]); sort2(v[1], v[2]); sort2(v[2], v[3]);
+                    sort2(v[1], v[2]);
+                    dst[i] = v[2];
+                }
+            } else {
+                for (int i = 0; i < rowBytes; ++i) {
+                    for (size_t k = 0; k < n; ++k) samples[k] = frames[k].planes[p][rowOffset * frames[k].strides[p] + i];
+                    std::nth_element(samples.begin(), samples.begin() + n / 2, samples.end());
+                    dst[i] = samples[n / 2];
+                }
+            }
+        }
+    }
+    return true;
+}
+
+}
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+
+namespace horus {
+namespace imaging {
+
+    enum class DenoiseMode {
+        Average, // 16-bit running sum, divided at the end (any N up to 256)
+        Median   // Per-sample temporal median, robust to moving leaves (keeps N copies)
+    };
+
+    // Running 16-bit sum of frames of the same geometry.
+    // 255 x 256 frames still fits in uint16, so up to kMaxFrames frames can be added.
+    class FrameAccumulator {
+    public:
+        static const int kMaxFrames = 256;
+
+        void reset() { frames = 0; }
+
+        // Adds one frame. The first frame after reset() fixes the geometry.
+        // Returns false on geometry mismatch or when full.
+        bool add(const FrameView& frame);
+
+        int count() const { return frames; }
+
+        // Rounded average of everything added so far
+        bool average(OwnedFrame& out) const;
+
+    private:
+        PixelLayout layout = PixelLayout::BGR888;
+        int width = 0;
+        int height = 0;
+        std::vector<uint16_t> sum;
+        size_t offsets[3] = {0, 0, 0};
+        int frames = 0;
+    };
+
+    // Per-sample median of 3..N frames of the same geometry
+    bool temporalMedian(const std::vector<FrameView>& frames, OwnedFrame& out);
+
+}
+}
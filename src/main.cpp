@@ -1,57 +1,315 @@
 #include <iostream>
 #include <string>
 #include <cstring>
-#include <chrono>
-#include <iomanip>
 #include <sstream>
+#include <vector>
+#include <cstdlib>
 
 // Include our modules
 #include "sensors/Camera/Camera.hpp"
 #include "utils/FileSystem.hpp"
+#include "utils/TaskTimer.hpp"
+#include "utils/Trace.hpp"
+#include "utils/Args.hpp"
 #include "sensors/BME280/bme280.hpp"
+#include "tasks/Tasks.hpp"
+#include "daemon/Daemon.hpp"
 
 // --- HELPERS ---
 
-// Returns ISO 8601 string: "2026-02-03T12:00:00"
-// or specific format for images
-std::string getTimestamped(const std::string& extension) {
-    auto now = std::chrono::system_clock::now();
-    auto in_time_t = std::chrono::system_clock::to_time_t(now);
-    std::stringstream ss;
-    if(extension == ".csv"){
-        ss << std::put_time(std::localtime(&in_time_t), "%FT%H:%M:%S%Z");
-    } else {
-        ss << std::put_time(std::localtime(&in_time_t), "img_%FT%H:%M:%S%Z");
-        ss << extension;
-    }
-    return ss.str();
-}
+// Exit code of a bad command line (no task, unknown task, malformed option value)
+const int kUsageError = 1;
 
 void printUsage() {
     std::cout << "Horus Edge System v1.0 (Torino Release)" << std::endl;
     std::cout << "Usage: ./horus_app --task <task_name>" << std::endl;
     std::cout << "Tasks:" << std::endl;
     std::cout << "  capture      : Capture image from CSI camera" << std::endl;
-    std::cout << "  monitor_env  : Read BME280 & Save to CSV" << std::endl;
+    std::cout << "  capture_hdr  : Exposure bracket fused on-device into one JPEG" << std::endl;
+    std::cout << "  capture_multi: All cameras (or --cameras) at once, one img_<time>_cam<N>.jpg each" << std::endl;
+    std::cout << "  develop      : Turn RAW dumps (--input, default today) into --develop-format jpeg|dng" << std::endl;
+    std::cout << "  detect_aruco : Find markers in JPEGs (--input, default today), write .aruco.json sidecars" << std::endl;
+    std::cout << "  monitor_env  : Read BME280 & Save to the telemetry log" << std::endl;
+    std::cout << "  monitor_sys  : SoC temperature, clock, load, memory, free space & throttling -> telemetry log" << std::endl;
+    std::cout << "  record       : Log --source cpu|gps --data <fields> to the telemetry log" << std::endl;
+    std::cout << "  modem_up     : Radio (and GNSS) on, returns once registered on the network" << std::endl;
+    std::cout << "  gps_fix      : Wait for a GNSS position, GNSS off, log it to the telemetry log" << std::endl;
+    std::cout << "  modem_down   : GNSS off, modem in flight mode" << std::endl;
+    std::cout << "  export_csv   : Rebuild the CSVs from the telemetry log (--days, default 2, 0 = all)" << std::endl;
+    std::cout << "  import_csv   : One-off: load existing CSVs into an empty telemetry log" << std::endl;
+    std::cout << "  bundle       : Pack the small files of the last --days day folders into <day>.hbn (zstd)" << std::endl;
+    std::cout << "  daily        : The wake cycle as a stage graph (camera and data work overlap modem bring-up)" << std::endl;
+    std::cout << "  upload       : Send the CSVs and the last --days day folders to --remote/--bucket (S3)" << std::endl;
+    std::cout << "  daemon       : Stay resident, schedule tasks, listen on --socket" << std::endl;
+    std::cout << "  ctl          : Send --cmd <task> to a running daemon" << std::endl;
+    std::cout << "Options:" << std::endl;
+    std::cout << "  --format <bgr|yuv420> : Capture pixel format (default: bgr)" << std::endl;
+    std::cout << "  --raw                 : capture writes the sensor's Bayer data, no compression" << std::endl;
+    std::cout << "  --aruco               : capture also writes the visible markers to a .aruco.json sidecar" << std::endl;
+    std::cout << "  --aruco-scale <n>     : Marker detection at 1/n resolution (default: 4)" << std::endl;
+    std::cout << "  --preview <n>         : capture also saves n smaller copies (_p2, _p4, _p8.jpg) (default: 0)" << std::endl;
+    std::cout << "  --dictionary <file>   : Marker dictionary JSON (default: built-in tag36h11)" << std::endl;
+    std::cout << "  --threads <n>         : JPEG encoder threads, 0 = all cores (default: 0)" << std::endl;
+    std::cout << "  --ae-tolerance <f>    : Relative AE/AWB change still considered stable (default: 0.02)" << std::endl;
+    std::cout << "  --max-warmup <n>      : Upper bound on warm-up frames (default: 60)" << std::endl;
+    std::cout << "  --denoise <n>         : Combine the last n converged warm-up frames (default: off)" << std::endl;
+    std::cout << "  --denoise-mode <m>    : avg | median (default: avg)" << std::endl;
+    std::cout << "  --ev <list>           : HDR bracket in EV, comma separated (default: -2,0,2)" << std::endl;
+    std::cout << "  --target-kb <n>       : JPEG size budget: highest quality whose file fits n KB (default: q90)" << std::endl;
+    std::cout << "  --min-quality <n>     : Lowest quality --target-kb may pick (default: 30)" << std::endl;
+    std::cout << "  --jpeg-tables <t>     : Quantization tables: flat, or a file of 64/128 values (default: standard)" << std::endl;
+    std::cout << "  --optimize-huffman    : Two-pass Huffman tables fitted to each picture (single-threaded encode)" << std::endl;
+    std::cout << "  --roi <list>          : Regions saved at full detail as <image>_<name>.jpg, the image becomes" << std::endl;
+    std::cout << "                          a context frame: name=x,y,w,h;... in fractions of the field" << std::endl;
+    std::cout << "  --roi-software        : Crop the ROIs from the full frame instead of on the sensor (ScalerCrop)" << std::endl;
+    std::cout << "  --context-scale <n>   : Context frame at 1/n with --roi: 2|4|8|16 (default: 8)" << std::endl;
+    std::cout << "  --scene <policy>      : Same scene as the last picture, or black: skip | thumbnail | flag" << std::endl;
+    std::cout << "                          (flag = saved, uploaded last) (default: off)" << std::endl;
+    std::cout << "  --scene-bits <n>      : Perceptual hash bits (of 64) that may differ in the same scene (default: 3)" << std::endl;
+    std::cout << "  --cameras <list>      : capture_multi camera indices, comma separated (default: all)" << std::endl;
+    std::cout << "  --memory-mb <n>       : capture_multi cap on the frames held at once; cameras that" << std::endl;
+    std::cout << "                          don't fit wait for one to finish (default: 512)" << std::endl;
+    std::cout << "  --bme-os <n>          : BME280 oversampling 1|2|4|8|16 (default: 1)" << std::endl;
+    std::cout << "  --bme-iir <n>         : BME280 IIR filter 0|2|4|8|16 (default: 0)" << std::endl;
+    std::cout << "  --bme-burst <n>       : monitor_env logs the mean of n conversions (default: 1)" << std::endl;
+    std::cout << "  --sys-root <dir>      : monitor_sys reads <dir>/sys, <dir>/proc instead (a fake tree)" << std::endl;
+    std::cout << "  --rclone-conf <file>  : Credentials for upload (default: ~horus/.config/rclone/rclone.conf)" << std::endl;
+    std::cout << "  --remote <name>       : rclone remote (type s3) to upload to" << std::endl;
+    std::cout << "  --bucket <name>       : Target bucket" << std::endl;
+    std::cout << "  --endpoint <url>      : Override the remote's endpoint (e.g. a local S3 stand-in)" << std::endl;
+    std::cout << "  --jobs <n>            : Upload requests in flight (default: 4)" << std::endl;
+    std::cout << "  --part-mb <n>         : Multipart part size in MiB, min 5 (default: 8)" << std::endl;
+    std::cout << "  --train-dict          : bundle trains a new compression dictionary first" << std::endl;
+    std::cout << "  --level <n>           : bundle zstd level (default: 19)" << std::endl;
+    std::cout << "  --modem <tty>         : Modem AT port (default: /dev/ttyUSB2)" << std::endl;
+    std::cout << "  --register-timeout <s>: modem_up deadline for network registration (default: 90)" << std::endl;
+    std::cout << "  --gps-timeout <s>     : gps_fix deadline for a position (default: 60)" << std::endl;
+    std::cout << "  --no-gps              : modem_up leaves GNSS off" << std::endl;
+    std::cout << "  --dry-run             : daily prints the schedule with simulated stage durations, runs nothing" << std::endl;
+    std::cout << "  --skip <list>         : daily leaves these stages out, comma separated (e.g. upload,bundle)" << std::endl;
+    std::cout << "  --simulate <list>     : daily dry-run durations, e.g. modem_up=45000,gps_fix=30000" << std::endl;
+    std::cout << "  --stages-script <f>   : daily hardware helper (default: ../scripts/daily_stages.sh from the binary)" << std::endl;
+    std::cout << "  --trace <file|dir/>   : Chrome trace JSON of the run (a folder gets one file per run;" << std::endl;
+    std::cout << "                          env HORUS_TRACE does the same, daily passes it to every stage)" << std::endl;
+    std::cout << "  --socket <path>       : Daemon socket (default: /tmp/horus.sock)" << std::endl;
+    std::cout << "  --env-interval <s>    : Daemon BME280 period, 0 = on command only (default: 900)" << std::endl;
+    std::cout << "  --capture-interval <s>: Daemon capture period, 0 = on command only (default: 0)" << std::endl;
+}
+
+// Finds "--name value" or "--name=value". True if the option is there, even without a value.
+bool findArg(int argc, char* argv[], const std::string& name, std::string& value) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == name) {
+            value = i + 1 < argc ? argv[i+1] : "";
+            return true;
+        } else if (arg.rfind(name + "=", 0) == 0) {
+            value = arg.substr(name.size() + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns the value of "--name value" or "--name=value", empty if absent
+std::string getArgValue(int argc, char* argv[], const std::string& name) {
+    std::string value;
+    findArg(argc, argv, name, value);
+    return value;
+}
+
+// Says which option has a bad value; always false, for "return badValue(...)"
+bool badValue(const std::string& name, const std::string& text, const char* expected) {
+    std::cerr << "[Main] " << name << " expects " << expected << ", got '" << text << "'" << std::endl;
+    return false;
+}
+
+// Numeric options: absent leaves 'value' at its default, a value that is not a whole
+// number (or none at all) is a usage error
+bool getIntArg(int argc, char* argv[], const std::string& name, int& value) {
+    std::string text;
+    if (!findArg(argc, argv, name, text) || horus::utils::parseInt(text, value)) return true;
+    return badValue(name, text, "an integer");
 }
 
-// Helper to init and read BME280
-bool getBME280Data(horus::BME280Data& data) {
-    horus::BME280 sensor(0x77, 1); // Address 0x76, Bus 1
-    if (sensor.init()){
-        data = sensor.readAll();
-        return true;
+bool getFloatArg(int argc, char* argv[], const std::string& name, float& value) {
+    std::string text;
+    if (!findArg(argc, argv, name, text) || horus::utils::parseFloat(text, value)) return true;
+    return badValue(name, text, "a number");
+}
+
+// Same for a count that must be at least 'min' (--jobs, --threads...)
+bool getCountArg(int argc, char* argv[], const std::string& name, int min, int& value) {
+    std::string text;
+    if (!findArg(argc, argv, name, text)) return true;
+    if (horus::utils::parseInt(text, value) && value >= min) return true;
+    return badValue(name, text, ("an integer >= " + std::to_string(min)).c_str());
+}
+
+// True if the bare "--name" switch is present
+bool hasFlag(int argc, char* argv[], const char* name) {
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], name) == 0) return true;
     }
     return false;
 }
 
+// Camera settings shared by the capture task and the daemon. False on a malformed value.
+bool getCameraOptions(int argc, char* argv[], horus::CameraOptions& options) {
+    options = horus::CameraOptions();
+    if (getArgValue(argc, argv, "--format") == "yuv420") {
+        options.pixelLayout = horus::imaging::PixelLayout::YUV420;
+    }
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--raw") == 0) options.captureRaw = true;
+        if (std::strcmp(argv[i], "--aruco") == 0) options.detectMarkers = true;
+    }
+    options.markerDictionary = getArgValue(argc, argv, "--dictionary");
+    int threads = static_cast<int>(options.encoderThreads);
+    int targetKb = 0;
+    if (!getCountArg(argc, argv, "--aruco-scale", 1, options.markerScale) ||
+        !getCountArg(argc, argv, "--preview", 0, options.previewLevels) ||
+        !getCountArg(argc, argv, "--threads", 0, threads) ||
+        !getFloatArg(argc, argv, "--ae-tolerance", options.convergence.tolerance) ||
+        !getCountArg(argc, argv, "--max-warmup", 1, options.convergence.maxFrames) ||
+        !getCountArg(argc, argv, "--denoise", 0, options.denoiseFrames) ||
+        !getCountArg(argc, argv, "--target-kb", 0, targetKb) ||
+        !getIntArg(argc, argv, "--min-quality", options.rateControl.minQuality) ||
+        !getCountArg(argc, argv, "--scene-bits", 0, options.scene.maxHashDistance) ||
+        !getCountArg(argc, argv, "--context-scale", 1, options.contextScale)) {
+        return false;
+    }
+    options.encoderThreads = static_cast<unsigned>(threads);
+    if (getArgValue(argc, argv, "--denoise-mode") == "median") {
+        options.denoiseMode = horus::imaging::DenoiseMode::Median;
+    }
+    if (targetKb > 0) {
+        options.rateControl.targetBytes = static_cast<size_t>(targetKb) * 1024;
+    }
+    std::string tables = getArgValue(argc, argv, "--jpeg-tables");
+    if (!tables.empty() && !horus::imaging::loadQuantTables(tables, options.rateControl.base.quantTables)) {
+        std::cerr << "[Main] Using the standard quantization tables." << std::endl;
+    }
+    options.rateControl.base.optimizeCoding = hasFlag(argc, argv, "--optimize-huffman");
+    std::string rois = getArgValue(argc, argv, "--roi");
+    if (!rois.empty() && !horus::imaging::parseRois(rois, options.rois)) {
+        std::cerr << "[Main] Ignoring --roi, capturing the full field." << std::endl;
+    }
+    options.roiSensorCrop = !hasFlag(argc, argv, "--roi-software");
+    std::string scene = getArgValue(argc, argv, "--scene");
+    if (!scene.empty() && !horus::imaging::parseScenePolicy(scene, options.scene.policy)) {
+        std::cerr << "[Main] Unknown --scene " << scene << ", saving every frame." << std::endl;
+    }
+    return true;
+}
+
+// BME280 acquisition settings shared by monitor_env and the daemon. False on a malformed value.
+bool getEnvSettings(int argc, char* argv[], horus::BME280Settings& settings) {
+    settings = horus::BME280Settings();
+    int factor = 0;
+    int coefficient = -1;
+    if (!getCountArg(argc, argv, "--bme-os", 1, factor) || !getCountArg(argc, argv, "--bme-iir", 0, coefficient)) {
+        return false;
+    }
+    if (factor > 0) {
+        // 1, 2, 4, 8, 16 -> register code 1..5, same for all three channels
+        factor = std::min(factor, 16);
+        int code = 1;
+        while ((1 << code) <= factor && code < 5) ++code;
+        settings.temperature = settings.pressure = settings.humidity = static_cast<horus::BME280Oversampling>(code);
+    }
+    if (coefficient >= 0) {
+        // 0 = off, 2, 4, 8, 16 -> register code 0..4
+        coefficient = std::min(coefficient, 16);
+        int code = 0;
+        while ((2 << code) <= coefficient && code < 4) ++code;
+        settings.filter = static_cast<horus::BME280Filter>(code);
+    }
+    return true;
+}
+
+bool getEnvBurst(int argc, char* argv[], int& burst) {
+    burst = 1;
+    return getCountArg(argc, argv, "--bme-burst", 1, burst);
+}
+
+// Parses "-2,0,2" into EV offsets
+bool getEvOffsets(int argc, char* argv[], std::vector<float>& evOffsets) {
+    std::string list = getArgValue(argc, argv, "--ev");
+    if (list.empty()) list = "-2,0,2";
+
+    evOffsets.clear();
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item.empty()) continue;
+        float ev = 0.0f;
+        if (!horus::utils::parseFloat(item, ev)) return badValue("--ev", item, "a list of EV numbers");
+        evOffsets.push_back(ev);
+    }
+    return true;
+}
+
+// --trace, or HORUS_TRACE from the scripts (inherited by the stages of --task daily)
+std::string getTraceTarget(int argc, char* argv[]) {
+    std::string target = getArgValue(argc, argv, "--trace");
+    if (target.empty()) {
+        const char* env = std::getenv("HORUS_TRACE");
+        if (env) target = env;
+    }
+    return target;
+}
+
+// --task daily: its own options; the rest is sorted out per stage (tasks::daily). False on a malformed value.
+bool getDailyOptions(int argc, char* argv[], horus::tasks::DailyOptions& options) {
+    options = horus::tasks::DailyOptions();
+    options.dryRun = hasFlag(argc, argv, "--dry-run");
+    options.stagesScript = getArgValue(argc, argv, "--stages-script");
+    std::string socket = getArgValue(argc, argv, "--socket");
+    if (!socket.empty()) options.daemonSocket = socket;
+
+    std::stringstream skip(getArgValue(argc, argv, "--skip"));
+    std::string item;
+    while (std::getline(skip, item, ',')) {
+        if (!item.empty()) options.skip.push_back(item);
+    }
+    std::stringstream simulate(getArgValue(argc, argv, "--simulate"));
+    while (std::getline(simulate, item, ',')) {
+        size_t eq = item.find('=');
+        int ms = 0;
+        if (eq == std::string::npos || !horus::utils::parseInt(item.substr(eq + 1), ms) || ms < 0) {
+            return badValue("--simulate", item, "stage=milliseconds");
+        }
+        options.simulatedMs.emplace_back(item.substr(0, eq), ms);
+    }
+
+    const char* own[] = { "--task", "--skip", "--simulate", "--stages-script", "--socket" };
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dry-run") continue;
+        bool skipped = false;
+        for (const char* name : own) {
+            if (arg == name) {
+                ++i; // ...and its value
+                skipped = true;
+            } else if (arg.rfind(std::string(name) + "=", 0) == 0) {
+                skipped = true;
+            }
+        }
+        if (!skipped) options.forwardArgs.push_back(arg);
+    }
+    return true;
+}
+
 // --- MAIN ---
 
 int main(int argc, char* argv[]) {
+    horus::utils::TaskTimer taskTimer;
+
     // 1. Parse Arguments
     if (argc < 2) {
         printUsage();
-        return 1;
+        return kUsageError;
     }
 
     std::string task = "";
@@ -68,72 +326,214 @@ int main(int argc, char* argv[]) {
 
     if (task.empty()) {
         std::cerr << "[Main] Error: No task specified." << std::endl;
-        return 1;
+        return kUsageError;
     }
 
     std::cout << "[Main] Starting Task: " << task << std::endl;
 
+    // Spans are compiled in, recorded only when asked for
+    const std::string traceTarget = getTraceTarget(argc, argv);
+    horus::utils::setTraceThreadName("main");
+    if (!traceTarget.empty() && task != "ctl") horus::utils::setTracing(true);
+
     // 2. Task Router
+    int result = 0;
 
     if(task == "capture"){
         // --- TASK: IMAGE CAPTURE ---
-        std::string folderPath = horus::utils::getTodaysFolder();
-        std::string fullPath = folderPath + "/" + getTimestamped(".jpg");
-        std::cout << "[Main] Target File: " << fullPath << std::endl;
-
+        horus::CameraOptions options;
+        if (!getCameraOptions(argc, argv, options)) return kUsageError;
         horus::Camera cam;
-        if (!cam.start()) {
-            std::cerr << "[Main] Critical: Camera init failed." << std::endl;
-            return 2;
-        }
-
-        if (cam.capture(fullPath)) {
-            std::cout << "[Main] Capture Success." << std::endl;
-        } else {
-            std::cerr << "[Main] Capture Failed." << std::endl;
-            return 3;
-        }
-        cam.stop();
+        result = horus::tasks::capture(cam, options);
     } 
     
+    else if(task == "capture_hdr"){
+        // --- TASK: HDR IMAGE CAPTURE ---
+        horus::CameraOptions options;
+        std::vector<float> evOffsets;
+        if (!getCameraOptions(argc, argv, options) || !getEvOffsets(argc, argv, evOffsets)) return kUsageError;
+        horus::Camera cam;
+        result = horus::tasks::captureHdr(cam, options, evOffsets);
+    }
+
+    else if(task == "capture_multi"){
+        // --- TASK: EVERY CAMERA AT ONCE ---
+        horus::CameraOptions options;
+        std::vector<int> indices;
+        std::stringstream list(getArgValue(argc, argv, "--cameras"));
+        std::string index;
+        while (std::getline(list, index, ',')) {
+            int camera = 0;
+            if (index.empty()) continue;
+            if (!horus::utils::parseInt(index, camera) || camera < 0) {
+                badValue("--cameras", index, "camera indices");
+                return kUsageError;
+            }
+            indices.push_back(camera);
+        }
+        int memoryMb = 512;
+        if (!getCountArg(argc, argv, "--memory-mb", 1, memoryMb) || !getCameraOptions(argc, argv, options)) {
+            return kUsageError;
+        }
+        result = horus::tasks::captureMulti(options, indices, static_cast<size_t>(memoryMb) * 1024 * 1024);
+    }
+
+    else if(task == "develop"){
+        // --- TASK: DEFERRED RAW DEVELOPMENT ---
+        std::string format = getArgValue(argc, argv, "--develop-format");
+        result = horus::tasks::develop(getArgValue(argc, argv, "--input"), format.empty() ? "jpeg" : format);
+    }
+
+    else if(task == "detect_aruco"){
+        // --- TASK: MARKER CHECK ON SAVED IMAGES ---
+        int scale = 4;
+        if (!getCountArg(argc, argv, "--aruco-scale", 1, scale)) return kUsageError;
+        result = horus::tasks::detectAruco(getArgValue(argc, argv, "--input"), scale,
+                                           getArgValue(argc, argv, "--dictionary"));
+    }
+
     else if(task == "monitor_env"){
         // --- TASK: ENVIRONMENTAL LOGGING ---
-        // Used to be monitor_external, now consolidated for BME280
-        
-        horus::BME280Data data;
-        if(getBME280Data(data)){
-            // 1. Print to Console (for debugging/journalctl)
-            std::cout << "Temp: " << data.temperature << " C | ";
-            std::cout << "Hum: "  << data.humidity << " % | ";
-            std::cout << "Pres: " << data.pressure << " hPa" << std::endl;
-
-            // 2. CSV Formatting
-            // Format: Timestamp, Temp, Humidity, Pressure
-            std::string timestamp = getTimestamped(".csv");
-            std::stringstream csvRow;
-            csvRow << data.temperature << "," << data.humidity << "," << data.pressure;
-
-            // 3. Save to File
-            // Note: csv header should be: Timestamp,Temperature,Humidity,Pressure
-            // Path:
-            std::string folderPath = horus::utils::getTodaysFolder();
-            std::string fullPathCSV = folderPath + "/environmental_data.csv";
-            std::cout << "[Main] .csv Target File: " << fullPathCSV << std::endl;
-
-            horus::utils::appendToCSV(fullPathCSV, timestamp, csvRow.str());
-            std::cout << "[Main] Data appended to: " << fullPathCSV << std::endl;
-
+        horus::BME280Settings settings;
+        int burst = 1;
+        if (!getEnvSettings(argc, argv, settings) || !getEnvBurst(argc, argv, burst)) return kUsageError;
+        horus::BME280 sensor(0x77, 1); // Address 0x77, Bus 1
+        if (sensor.init(settings)) {
+            result = horus::tasks::monitorEnv(sensor, burst);
         } else {
             std::cerr << "[Main] Failed to read BME280 sensor." << std::endl;
             return 1;
         }
     } 
+
+    else if(task == "monitor_sys"){
+        // --- TASK: SYSTEM HEALTH LOGGING ---
+        horus::SystemSources sources;
+        sources.root = getArgValue(argc, argv, "--sys-root");
+        result = horus::tasks::monitorSys(sources);
+    }
+
+    else if(task == "record"){
+        // --- TASK: SAMPLE FROM THE SHELL SCRIPTS -> TELEMETRY LOG ---
+        result = horus::tasks::recordTelemetry(getArgValue(argc, argv, "--source"), getArgValue(argc, argv, "--data"));
+    }
+
+    else if(task == "modem_up" || task == "gps_fix" || task == "modem_down"){
+        // --- TASK: MODEM / GNSS ---
+        horus::ModemOptions options;
+        std::string device = getArgValue(argc, argv, "--modem");
+        if (!device.empty()) options.device = device;
+        if (!getCountArg(argc, argv, "--register-timeout", 0, options.registerTimeoutSec) ||
+            !getCountArg(argc, argv, "--gps-timeout", 0, options.gpsTimeoutSec)) {
+            return kUsageError;
+        }
+        options.gps = !hasFlag(argc, argv, "--no-gps");
+
+        if (task == "modem_up") result = horus::tasks::modemUp(options);
+        else if (task == "gps_fix") result = horus::tasks::gpsFix(options);
+        else result = horus::tasks::modemDown(options);
+    }
+
+    else if(task == "export_csv"){
+        // --- TASK: TELEMETRY LOG -> CSV FILES ---
+        int days = 2;
+        if (!getCountArg(argc, argv, "--days", 0, days)) return kUsageError;
+        result = horus::tasks::exportCsv(days);
+    }
+
+    else if(task == "import_csv"){
+        // --- TASK: ONE-OFF CSV MIGRATION ---
+        result = horus::tasks::importCsv();
+    }
+
+    else if(task == "bundle"){
+        // --- TASK: DAILY COMPRESSED BUNDLE ---
+        int days = 2;
+        int level = 19;
+        if (!getCountArg(argc, argv, "--days", 0, days) || !getIntArg(argc, argv, "--level", level)) return kUsageError;
+        result = horus::tasks::bundle(days, hasFlag(argc, argv, "--train-dict"), level);
+    }
+
+    else if(task == "daily"){
+        // --- TASK: WAKE CYCLE AS A STAGE GRAPH ---
+        horus::tasks::DailyOptions options;
+        if (!getDailyOptions(argc, argv, options)) return kUsageError;
+        result = horus::tasks::daily(options);
+    }
+
+    else if(task == "upload"){
+        // --- TASK: NATIVE S3 UPLOAD ---
+        horus::cloud::UploadOptions options;
+        int jobs = static_cast<int>(options.jobs);
+        int partMb = static_cast<int>(options.partSize >> 20);
+        int days = 2;
+        if (!getCountArg(argc, argv, "--jobs", 1, jobs) || !getCountArg(argc, argv, "--part-mb", 5, partMb) ||
+            !getCountArg(argc, argv, "--days", 0, days)) {
+            return kUsageError;
+        }
+        options.jobs = static_cast<unsigned>(jobs);
+        options.partSize = static_cast<size_t>(partMb) << 20;
+
+        std::string conf = getArgValue(argc, argv, "--rclone-conf");
+        horus::cloud::S3Config config;
+        if (!horus::cloud::loadRcloneRemote(conf.empty() ? "/home/horus/.config/rclone/rclone.conf" : conf,
+                                            getArgValue(argc, argv, "--remote"), config)) {
+            return 1;
+        }
+        config.bucket = getArgValue(argc, argv, "--bucket");
+        if (config.bucket.empty()) {
+            std::cerr << "[Main] upload needs --bucket <name>" << std::endl;
+            return 1;
+        }
+        std::string endpoint = getArgValue(argc, argv, "--endpoint");
+        if (!endpoint.empty()) config.endpoint = endpoint;
+
+        result = horus::tasks::upload(config, days, options);
+    }
+
+    else if(task == "daemon"){
+        // --- TASK: RESIDENT MODE ---
+        horus::DaemonOptions options;
+        if (!getCameraOptions(argc, argv, options.cameraOptions) || !getEvOffsets(argc, argv, options.evOffsets) ||
+            !getEnvSettings(argc, argv, options.envSettings) ||
+            !getEnvBurst(argc, argv, options.envBurstSamples) ||
+            !getCountArg(argc, argv, "--env-interval", 0, options.envIntervalSec) ||
+            !getCountArg(argc, argv, "--capture-interval", 0, options.captureIntervalSec)) {
+            return kUsageError;
+        }
+        std::string socketPath = getArgValue(argc, argv, "--socket");
+        if (!socketPath.empty()) options.socketPath = socketPath;
+        options.traceTarget = traceTarget;
+
+        horus::Daemon daemon(options);
+        return daemon.run();
+    }
+
+    else if(task == "ctl"){
+        // --- TASK: TALK TO THE DAEMON ---
+        std::string socketPath = getArgValue(argc, argv, "--socket");
+        std::string command = getArgValue(argc, argv, "--cmd");
+        if (command.empty()) {
+            std::cerr << "[Main] ctl needs --cmd <task>" << std::endl;
+            return 1;
+        }
+        return horus::Daemon::sendCommand(socketPath.empty() ? horus::DaemonOptions().socketPath : socketPath, command);
+    }
     
     else {
         std::cerr << "[Main] Unknown task: " << task << std::endl;
         printUsage();
-        return 1;
+        return kUsageError;
     }
 
-    return 0;
-}
\ No newline at end of file
+    if (horus::utils::tracingEnabled()) {
+        horus::utils::printTraceSummary();
+        horus::utils::writeChromeTrace(horus::utils::traceFilePath(traceTarget, task), task);
+    }
+
+    // Whole-process cost (compare with the daemon's per-task wall_ms / cpu_ms)
+    std::cout << "[Main] Task " << task << " wall_ms=" << taskTimer.wallMs()
+              << " cpu_ms=" << horus::utils::TaskTimer::processCpuMs() << std::endl;
+
+    return result;
+}
@@ -0,0 +1,127 @@
+#include "BME280Compensation.hpp"
+#include <algorithm>
+
+namespace horus {
+namespace bme280 {
+
+BME280Calibration parseCalibration(const uint8_t* blob) {
+    BME280Calibration calib;
+
+    // Temp/Pressure calib (0x88 - 0xA1)
+    const uint8_t* buf = blob;
+    calib.dig_T1 = (buf[1] << 8) | buf[0];
+    calib.dig_T2 = (int16_t)((buf[3] << 8) | buf[2]);
+    calib.dig_T3 = (int16_t)((buf[5] << 8) | buf[4]);
+    calib.dig_P1 = (buf[7] << 8) | buf[6];
+    calib.dig_P2 = (int16_t)((buf[9] << 8) | buf[8]);
+    calib.dig_P3 = (int16_t)((buf[11] << 8) | buf[10]);
+    calib.dig_P4 = (int16_t)((buf[13] << 8) | buf[12]);
+    calib.dig_P5 = (int16_t)((buf[15] << 8) | buf[14]);
+    calib.dig_P6 = (int16_t)((buf[17] << 8) | buf[16]);
+    calib.dig_P7 = (int16_t)((buf[19] << 8) | buf[18]);
+    calib.dig_P8 = (int16_t)((buf[21] << 8) | buf[20]);
+    calib.dig_P9 = (int16_t)((buf[23] << 8) | buf[22]);
+
+    // Humidity calib (0xA1, then 0xE1 - 0xE7)
+    calib.dig_H1 = buf[25];
+    const uint8_t* bufH = blob + 26;
+    calib.dig_H2 = (int16_t)((bufH[1] << 8) | bufH[0]);
+    calib.dig_H3 = bufH[2];
+    calib.dig_H4 = (int16_t)((bufH[3] << 4) | (bufH[4] & 0x0F));
+    calib.dig_H5 = (int16_t)((bufH[5] << 4) | (bufH[4] >> 4));
+    calib.dig_H6 = (int8_t)bufH[6];
+    return calib;
+}
+
+float compensateTemp(const BME280Calibration& calib, int32_t adc_T, int32_t& t_fine) {
+    int32_t var1, var2;
+    var1 = ((((adc_T >> 3) - ((int32_t)calib.dig_T1 << 1))) * ((int32_t)calib.dig_T2)) >> 11;
+    var2 = (((((adc_T >> 4) - ((int32_t)calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)calib.dig_T1))) >> 12) * ((int32_t)calib.dig_T3)) >> 14;
+    t_fine = var1 + var2;
+    // We convert to float:
+    return ((t_fine * 5 + 128) >> 8) / 100.0f;
+}
+
+float compensatePressure(const BME280Calibration& calib, int32_t adc_P, int32_t t_fine) {
+    int64_t var1, var2, p;
+    var1 = ((int64_t)t_fine) - 128000;
+    var2 = var1 * var1 * (int64_t)calib.dig_P6;
+    var2 = var2 + ((var1 * (int64_t)calib.dig_P5) << 17);
+    var2 = var2 + (((int64_t)calib.dig_P4) << 35);
+    var1 = ((var1 * var1 * (int64_t)calib.dig_P3) >> 8) + ((var1 * (int64_t)calib.dig_P2) << 12);
+    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib.dig_P1) >> 33;
+    if (var1 == 0) return 0;
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (((int64_t)calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (((int64_t)calib.dig_P8) * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (((int64_t)calib.dig_P7) << 4);
+    return (float)p / 256.0f / 100.0f; // hPa
+}
+
+float compensateHumidity(const BME280Calibration& calib, int32_t adc_H, int32_t t_fine) {
+    int32_t v_x1_u32r;
+    v_x1_u32r = (t_fine - ((int32_t)76800));
+    v_x1_u32r = (((((adc_H << 14) - (((int32_t)calib.dig_H4) << 20) - (((int32_t)calib.dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15) * (((((((v_x1_u32r * ((int32_t)calib.dig_H6)) >> 10) * (((v_x1_u32r * ((int32_t)calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) + ((int32_t)2097152)) * ((int32_t)calib.dig_H2) + 8192) >> 14));
+    v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)calib.dig_H1)) >> 4));
+    v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
+    v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
+    return (float)(v_x1_u32r >> 12) / 1024.0f;
+}
+
+void compensateBatch(const BME280Calibration& calib, const int32_t* adcT, const int32_t* adcP,
+                     const int32_t* adcH, size_t count,
+                     float* temperature, float* pressure, float* humidity) {
+    // Trims as doubles, hoisted out of the loops
+    const double t1 = calib.dig_T1, t2 = calib.dig_T2, t3 = calib.dig_T3;
+    const double p1 = calib.dig_P1, p2 = calib.dig_P2, p3 = calib.dig_P3, p4 = calib.dig_P4, p5 = calib.dig_P5;
+    const double p6 = calib.dig_P6, p7 = calib.dig_P7, p8 = calib.dig_P8, p9 = calib.dig_P9;
+    const double h1 = calib.dig_H1, h2 = calib.dig_H2, h3 = calib.dig_H3, h4 = calib.dig_H4;
+    const double h5 = calib.dig_H5, h6 = calib.dig_H6;
+
+    // Blocks keep t_fine in a small stack buffer (L1) between the three passes
+    const size_t kBlock = 256;
+    double tFine[kBlock];
+
+    for (size_t base = 0; base < count; base += kBlock) {
+        const size_t n = std::min(kBlock, count - base);
+        const int32_t* aT = adcT + base;
+        const int32_t* aP = adcP + base;
+        const int32_t* aH = adcH + base;
+
+        // 1. Temperature
+        for (size_t i = 0; i < n; ++i) {
+            const double x = aT[i] / 131072.0 - t1 / 8192.0;
+            const double fine = (aT[i] / 16384.0 - t1 / 1024.0) * t2 + x * x * t3;
+            tFine[i] = fine;
+            temperature[base + i] = static_cast<float>(fine / 5120.0);
+        }
+
+        // 2. Pressure (var1 == 0 only with a blank calibration: select instead of branch)
+        for (size_t i = 0; i < n; ++i) {
+            double var1 = tFine[i] / 2.0 - 64000.0;
+            double var2 = var1 * var1 * p6 / 32768.0;
+            var2 = var2 + var1 * p5 * 2.0;
+            var2 = var2 / 4.0 + p4 * 65536.0;
+            var1 = (p3 * var1 * var1 / 524288.0 + p2 * var1) / 524288.0;
+            var1 = (1.0 + var1 / 32768.0) * p1;
+            const double safe = var1 != 0.0 ? var1 : 1.0;
+            double p = 1048576.0 - aP[i];
+            p = (p - var2 / 4096.0) * 6250.0 / safe;
+            const double pa = p + (p9 * p * p / 2147483648.0 + p * p8 / 32768.0 + p7) / 16.0;
+            pressure[base + i] = var1 != 0.0 ? static_cast<float>(pa / 100.0) : 0.0f;
+        }
+
+        // 3. Humidity, clamped to 0..100 like the integer path
+        for (size_t i = 0; i < n; ++i) {
+            const double v = tFine[i] - 76800.0;
+            double h = (aH[i] - (h4 * 64.0 + h5 / 16384.0 * v)) *
+                       (h2 / 65536.0 * (1.0 + h6 / 67108864.0 * v * (1.0 + h3 / 67108864.0 * v)));
+            h = h * (1.0 - h1 * h / 524288.0);
+            humidity[base + i] = static_cast<float>(std::min(100.0, std::max(0.0, h)));
+        }
+    }
+}
+
+} // namespace bme280
+} // namespace horus
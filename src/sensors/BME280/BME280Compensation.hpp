@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace horus {
+
+// Calibration data (Trim parameters from datasheet)
+// The sensor stores these internally to correct its own raw data.
+struct BME280Calibration {
+    uint16_t dig_T1;
+    int16_t  dig_T2, dig_T3;
+    uint8_t  dig_H1, dig_H3;
+    int16_t  dig_H2, dig_H4, dig_H5;
+    int8_t   dig_H6;
+    uint16_t dig_P1;
+    int16_t  dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+};
+
+namespace bme280 {
+
+    // Raw trim registers: 0x88..0xA1 (26 bytes) then 0xE1..0xE7 (7 bytes)
+    static const int kCalibSize = 33;
+    BME280Calibration parseCalibration(const uint8_t* blob);
+
+    // --- Compensation Formulas (From Bosch Datasheet) ---
+    // Reference integer path (datasheet 4.2.3 / 8.2), one sample at a time.
+    // Temperature MUST come first: it produces 't_fine', used by pressure and humidity.
+    float compensateTemp(const BME280Calibration& calib, int32_t adc_T, int32_t& t_fine);
+    float compensatePressure(const BME280Calibration& calib, int32_t adc_P, int32_t t_fine); // hPa
+    float compensateHumidity(const BME280Calibration& calib, int32_t adc_H, int32_t t_fine); // %
+
+    // Batched path for re-processing logged ADC samples (datasheet 8.1 floating-point
+    // formulas): plain loops over arrays, no 64-bit integer division and no branches,
+    // so the compiler can vectorise them (2 doubles per NEON register on aarch64).
+    // Matches the integer path to within ~0.01 C / 0.01 hPa / 0.01 %.
+    void compensateBatch(const BME280Calibration& calib, const int32_t* adcT, const int32_t* adcP,
+                         const int32_t* adcH, size_t count,
+                         float* temperature, float* pressure, float* humidity);
+
+} // namespace bme280
+} // namespace horus
@@ -0,0 +1,126 @@
+#include "SimulatedBME280.hpp"
+#include <cstring>
+
+namespace horus {
+
+namespace {
+
+// Datasheet section 8 example trims. Humidity is not part of that example:
+// typical values of a production part.
+const uint16_t kT1 = 27504;
+const int16_t kT2 = 26435, kT3 = -1000;
+const uint16_t kP1 = 36477;
+const int16_t kP2 = -10685, kP3 = 3024, kP4 = 2855, kP5 = 140, kP6 = -7, kP7 = 15500, kP8 = -14600, kP9 = 6000;
+const uint8_t kH1 = 75, kH3 = 0;
+const int16_t kH2 = 362, kH4 = 313, kH5 = 50;
+const int8_t kH6 = 30;
+
+void put16(uint8_t* regs, int reg, int value) {
+    regs[reg] = static_cast<uint8_t>(value & 0xFF);
+    regs[reg + 1] = static_cast<uint8_t>((value >> 8) & 0xFF);
+}
+
+} // namespace
+
+SimulatedBME280::SimulatedBME280(uint8_t address) : deviceAddress(address) {
+    reset();
+}
+
+void SimulatedBME280::reset() {
+    std::memset(regs, 0, sizeof(regs));
+    regs[0xD0] = 0x60; // Chip ID
+
+    // Temperature / pressure trims, little-endian from 0x88
+    const int tp[12] = { kT1, kT2, kT3, kP1, kP2, kP3, kP4, kP5, kP6, kP7, kP8, kP9 };
+    for (int i = 0; i < 12; ++i) put16(regs, 0x88 + 2 * i, tp[i]);
+
+    // Humidity trims: H1 at 0xA1, the rest packed at 0xE1..0xE7 (H4 / H5 share 0xE5)
+    regs[0xA1] = kH1;
+    put16(regs, 0xE1, kH2);
+    regs[0xE3] = kH3;
+    regs[0xE4] = static_cast<uint8_t>(kH4 >> 4);
+    regs[0xE5] = static_cast<uint8_t>((kH4 & 0x0F) | ((kH5 & 0x0F) << 4));
+    regs[0xE6] = static_cast<uint8_t>(kH5 >> 4);
+    regs[0xE7] = static_cast<uint8_t>(kH6);
+
+    // Data registers read 0x80000 / 0x8000 until the first conversion
+    regs[0xF7] = 0x80;
+    regs[0xFA] = 0x80;
+    regs[0xFD] = 0x80;
+}
+
+void SimulatedBME280::setAdc(int32_t newT, int32_t newP, int32_t newH) {
+    adcT = newT;
+    adcP = newP;
+    adcH = newH;
+}
+
+void SimulatedBME280::calibrationBlob(uint8_t* blob) const {
+    std::memcpy(blob, regs + 0x88, 26);
+    std::memcpy(blob + 26, regs + 0xE1, 7);
+}
+
+int32_t SimulatedBME280::jitter() {
+    if (noise == 0) return 0;
+    seed = seed * 1664525u + 1013904223u;
+    return static_cast<int32_t>((seed >> 8) % (2 * noise + 1)) - noise;
+}
+
+void SimulatedBME280::convert() {
+    const int32_t t = adcT + jitter();
+    const int32_t p = adcP + jitter();
+    const int32_t h = adcH + jitter();
+
+    // 20-bit pressure / temperature (msb, lsb, xlsb[7:4]), 16-bit humidity
+    regs[0xF7] = static_cast<uint8_t>(p >> 12);
+    regs[0xF8] = static_cast<uint8_t>(p >> 4);
+    regs[0xF9] = static_cast<uint8_t>((p & 0x0F) << 4);
+    regs[0xFA] = static_cast<uint8_t>(t >> 12);
+    regs[0xFB] = static_cast<uint8_t>(t >> 4);
+    regs[0xFC] = static_cast<uint8_t>((t & 0x0F) << 4);
+    regs[0xFD] = static_cast<uint8_t>(h >> 8);
+    regs[0xFE] = static_cast<uint8_t>(h);
+
+    // Conversion done at once: back to sleep, 'measuring' clear
+    regs[0xF4] &= ~0x03;
+    regs[0xF3] = 0;
+    ++conversionCount;
+}
+
+bool SimulatedBME280::read(uint8_t address, const I2CRead* reads, int count) {
+    if (address != deviceAddress) return false; // NACK
+    ++transactionCount;
+    for (int i = 0; i < count; ++i) {
+        for (int k = 0; k < reads[i].length; ++k) {
+            reads[i].buffer[k] = regs[(reads[i].reg + k) & 0xFF];
+        }
+    }
+    return true;
+}
+
+bool SimulatedBME280::write(uint8_t address, const uint8_t* data, int length) {
+    if (address != deviceAddress || length <= 0) return false;
+    ++transactionCount;
+
+    // A lone byte only sets the register pointer
+    if (length == 1) {
+        pointer = data[0];
+        return true;
+    }
+
+    // Otherwise (reg, value) pairs
+    for (int i = 0; i + 1 < length; i += 2) {
+        const uint8_t reg = data[i];
+        const uint8_t value = data[i + 1];
+        if (reg == 0xE0) {
+            if (value == 0xB6) reset(); // Soft reset
+            continue;
+        }
+        if (reg < 0xF2) continue; // Trims and ID are read-only
+        regs[reg] = value;
+        if (reg == 0xF4 && (value & 0x03) != 0) convert(); // 01 / 10 = forced
+    }
+    return true;
+}
+
+} // namespace horus
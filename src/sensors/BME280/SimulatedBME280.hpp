@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include "sensors/I2C/I2CBus.hpp"
+
+namespace horus {
+
+// In-process BME280 register model behind the I2CBus interface, so the driver can be
+// exercised and profiled off the device. It answers at one address with chip ID 0x60,
+// holds the calibration example of the Bosch datasheet (section 8) and runs a forced
+// conversion instantly when ctrl_meas asks for one. With the default ADC values
+// the driver must read 25.08 C and 1006.53 hPa.
+class SimulatedBME280 : public I2CBus {
+public:
+    // Datasheet example raw readings
+    static const int32_t kExampleAdcT = 519888;
+    static const int32_t kExampleAdcP = 415148;
+    static const int32_t kExampleAdcH = 26000;
+
+    explicit SimulatedBME280(uint8_t address = 0x76);
+
+    // Raw values the next conversions will produce
+    void setAdc(int32_t adcT, int32_t adcP, int32_t adcH);
+
+    // +/- 'lsb' of pseudo-random noise on every conversion (0 = exact)
+    void setNoise(int lsb) { noise = lsb; }
+
+    // The 33-byte trim blob as the chip stores it (0x88..0xA1, 0xE1..0xE7)
+    void calibrationBlob(uint8_t* blob) const;
+
+    int conversions() const { return conversionCount; }
+    int transactions() const { return transactionCount; }
+
+    bool read(uint8_t address, const I2CRead* reads, int count) override;
+    bool write(uint8_t address, const uint8_t* data, int length) override;
+    std::string name() const override { return ""; } // Nothing to cache
+
+private:
+    uint8_t deviceAddress;
+    uint8_t regs[256];
+    uint8_t pointer = 0; // Register address latched by a 1-byte write
+    int32_t adcT = kExampleAdcT;
+    int32_t adcP = kExampleAdcP;
+    int32_t adcH = kExampleAdcH;
+    int noise = 0;
+    uint32_t seed = 12345;
+    int conversionCount = 0;
+    int transactionCount = 0;
+
+    void reset();
+    void convert();
+    int32_t jitter();
+};
+
+} // namespace horus
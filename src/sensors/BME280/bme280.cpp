@@ -1,11 +1,13 @@
 #include "bme280.hpp"
 #include <iostream>
-#include <fcntl.h>
-#include <unistd.h>
-#include <sys/ioctl.h>
-#include <linux/i2c-dev.h>
+#include <fstream>
 #include <cstring>
 #include <cmath>
+#include <thread>
+#include <chrono>
+#include "sensors/I2C/LinuxI2CBus.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/Trace.hpp"
 
 // BME280 Registers (From Datasheet)
 #define REG_ID 0xD0
@@ -15,156 +17,215 @@
 #define REG_CTRL_MEAS 0xF4
 #define REG_CONFIG 0xF5
 #define REG_DATA 0xF7
+#define REG_CALIB_TP 0x88 // 26 bytes, ends with dig_H1 at 0xA1
+#define REG_CALIB_H 0xE1  // 7 bytes
 
 namespace horus {
 
+// On-disk calibration cache: the trim registers never change for a given chip
+struct CalibCache {
+    char magic[4];      // "BMEC"
+    uint8_t chipId;
+    uint8_t address;
+    uint8_t size;
+    uint8_t reserved;
+    uint8_t blob[33];
+};
+
+static int oversamplingFactor(BME280Oversampling os) {
+    return os == BME280Oversampling::Skip ? 0 : 1 << (static_cast<int>(os) - 1);
+}
+
 BME280::BME280(uint8_t i2cAddress, int busId) 
-    : i2c_fd(-1), busId(busId), deviceAddress(i2cAddress), t_fine(0) {}
+    : busId(busId), deviceAddress(i2cAddress) {}
 
-BME280::~BME280() {
-    if (i2c_fd >= 0) close(i2c_fd);
-}
+BME280::BME280(I2CBus& bus, uint8_t i2cAddress)
+    : bus(&bus), busId(-1), deviceAddress(i2cAddress) {}
 
-bool BME280::init() {
-    // 1. Open I2C Bus
-    std::string filename = "/dev/i2c-" + std::to_string(busId);
-    if ((i2c_fd = open(filename.c_str(), O_RDWR)) < 0) {
-        std::cerr << "[BME280] Failed to open I2C bus: " << filename << std::endl;
-        return false;
-    }
+BME280::~BME280() = default;
 
-    // 2. Select Device
-    if (ioctl(i2c_fd, I2C_SLAVE, deviceAddress) < 0) {
-        std::cerr << "[BME280] Failed to acquire bus access." << std::endl;
-        return false;
-    }
+std::string BME280::calibrationCachePath(const std::string& busName, uint8_t address) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "/var/tmp/horus-bme280-%s-%02x.cal", busName.c_str(), address);
+    return name;
+}
 
-    // 3. Check ID (Should be 0x60 for BME280)
-    uint8_t id;
-    readRegs(REG_ID, &id, 1);
-    if (id != 0x60) {
-        std::cerr << "[BME280] ID mismatch. Expected 0x60, got " << std::hex << (int)id << std::endl;
-        return false;
+bool BME280::init(const BME280Settings& newSettings) {
+    // 1. Open I2C Bus (unless one was handed to us)
+    if (!bus) {
+        auto linuxBus = std::make_unique<LinuxI2CBus>(busId);
+        if (!linuxBus->open()) return false;
+        ownedBus = std::move(linuxBus);
+        bus = ownedBus.get();
     }
 
-    // 4. Load Calibration Data
-    if (!readCalibrationData()) return false;
+    // 2. Check ID + load Calibration Data (cached across runs)
+    if (!loadCalibration()) return false;
 
-    // 5. Configure Sensor
-    // humidity oversampling x1
-    writeReg(REG_CTRL_HUM, 0x01); 
-    
-    // temp oversampling x1, press oversampling x1, Normal Mode
-    writeReg(REG_CTRL_MEAS, 0x27); 
-    
-    // standby 1000ms, filter off
-    writeReg(REG_CONFIG, 0xA0);   
+    // 3. Configure Sensor, left in sleep mode
+    return configure(newSettings);
+}
 
+bool BME280::configure(const BME280Settings& newSettings) {
+    settings = newSettings;
+    // ctrl_hum only takes effect on the next ctrl_meas write, config is only
+    // guaranteed to stick in sleep mode: sleep first, then both, in one transaction
+    const uint8_t ctrlMeas = static_cast<uint8_t>((static_cast<int>(settings.temperature) << 5) |
+                                                  (static_cast<int>(settings.pressure) << 2));
+    const uint8_t pairs[6] = {
+        REG_CTRL_MEAS, ctrlMeas, // mode 00 = sleep
+        REG_CTRL_HUM, static_cast<uint8_t>(settings.humidity),
+        REG_CONFIG, static_cast<uint8_t>(static_cast<int>(settings.filter) << 2) // t_sb unused in forced mode
+    };
+    if (!writeRegs(pairs, sizeof(pairs))) {
+        std::cerr << "[BME280] Failed to configure the sensor." << std::endl;
+        return false;
+    }
     return true;
 }
 
-BME280Data BME280::readAll() {
-    BME280Data data = {0, 0, 0};
-    
+// Datasheet 9.1, maximum measurement time
+int BME280::measurementTimeUs() const {
+    const int t = oversamplingFactor(settings.temperature);
+    const int p = oversamplingFactor(settings.pressure);
+    const int h = oversamplingFactor(settings.humidity);
+    return 1250 + 2300 * t + (p ? 2300 * p + 575 : 0) + (h ? 2300 * h + 575 : 0);
+}
+
+bool BME280::measure(BME280Data& data) {
+    HORUS_TRACE_SCOPE("bme280.measure");
+    data = {0, 0, 0};
+
+    // 1. Trigger one conversion (mode 01 = forced)
+    const uint8_t ctrlMeas = static_cast<uint8_t>((static_cast<int>(settings.temperature) << 5) |
+                                                  (static_cast<int>(settings.pressure) << 2) | 0x01);
+    const uint8_t trigger[2] = {REG_CTRL_MEAS, ctrlMeas};
+    if (!writeRegs(trigger, 2)) return false;
+
+    // 2. Sleep through the conversion, then status + ctrl_meas + data in one read:
+    // done when 'measuring' is clear and the mode bits went back to sleep
+    {
+        HORUS_TRACE_SCOPE("bme280.conversion");
+        std::this_thread::sleep_for(std::chrono::microseconds(measurementTimeUs()));
+    }
+    uint8_t buffer[12]; // 0xF3 status .. 0xFE hum_lsb
+    bool done = false;
+    int attempt = 0;
+    for (; attempt < 10 && !done; ++attempt) {
+        if (attempt > 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!bus->readRegs(deviceAddress, REG_STATUS, buffer, sizeof(buffer))) return false;
+        done = !(buffer[0] & 0x08) && (buffer[1] & 0x03) == 0;
+    }
+    HORUS_TRACE_COUNTER("bme280.status_polls", attempt);
+    if (!done) {
+        std::cerr << "[BME280] Conversion did not finish." << std::endl;
+        return false;
+    }
+
     // BME280 data is burst read from 0xF7 to 0xFE (8 bytes)
     // press_msb, press_lsb, press_xlsb, temp_msb, temp_lsb, temp_xlsb, hum_msb, hum_lsb
-    uint8_t buffer[8];
-    readRegs(REG_DATA, buffer, 8);
+    const uint8_t* raw = buffer + (REG_DATA - REG_STATUS);
 
     // Combine bytes into raw ADC integers (20-bit and 16-bit)
-    int32_t adc_P = (buffer[0] << 12) | (buffer[1] << 4) | (buffer[2] >> 4);
-    int32_t adc_T = (buffer[3] << 12) | (buffer[4] << 4) | (buffer[5] >> 4);
-    int32_t adc_H = (buffer[6] << 8) | buffer[7];
+    int32_t adc_P = (raw[0] << 12) | (raw[1] << 4) | (raw[2] >> 4);
+    int32_t adc_T = (raw[3] << 12) | (raw[4] << 4) | (raw[5] >> 4);
+    int32_t adc_H = (raw[6] << 8) | raw[7];
 
     // Calculate Compensated Values
     // Note: MUST calculate Temp first because it updates 't_fine'
-    data.temperature = compensateTemp(adc_T);
-    data.pressure = compensatePressure(adc_P);
-    data.humidity = compensateHumidity(adc_H);
+    int32_t t_fine = 0;
+    data.temperature = bme280::compensateTemp(calib, adc_T, t_fine);
+    if (settings.pressure != BME280Oversampling::Skip) data.pressure = bme280::compensatePressure(calib, adc_P, t_fine);
+    if (settings.humidity != BME280Oversampling::Skip) data.humidity = bme280::compensateHumidity(calib, adc_H, t_fine);
+    return true;
+}
 
+BME280Data BME280::readAll() {
+    BME280Data data;
+    measure(data);
     return data;
 }
 
-// --- Low Level I2C ---
-
-void BME280::writeReg(uint8_t reg, uint8_t value) {
-    uint8_t buf[2] = {reg, value};
-    write(i2c_fd, buf, 2);
-}
+bool BME280::readBurst(int samples, BME280Burst& burst) {
+    burst = BME280Burst();
+    // Welford: numerically stable single pass
+    double mean[3] = {0, 0, 0};
+    double m2[3] = {0, 0, 0};
+    for (int i = 0; i < samples; ++i) {
+        BME280Data data;
+        if (!measure(data)) return false;
+        const double values[3] = {data.temperature, data.humidity, data.pressure};
+        burst.samples++;
+        for (int c = 0; c < 3; ++c) {
+            const double delta = values[c] - mean[c];
+            mean[c] += delta / burst.samples;
+            m2[c] += delta * (values[c] - mean[c]);
+        }
+    }
+    if (burst.samples == 0) return false;
 
-void BME280::readRegs(uint8_t reg, uint8_t* buffer, int length) {
-    write(i2c_fd, &reg, 1); // Ask for register
-    read(i2c_fd, buffer, length); // Read response
+    const double n = burst.samples > 1 ? burst.samples - 1 : 1;
+    burst.mean = {static_cast<float>(mean[0]), static_cast<float>(mean[1]), static_cast<float>(mean[2])};
+    burst.variance = {static_cast<float>(m2[0] / n), static_cast<float>(m2[1] / n), static_cast<float>(m2[2] / n)};
+    return true;
 }
 
-// --- Calibration Loading ---
-bool BME280::readCalibrationData() {
-    uint8_t buf[26];
-    uint8_t bufH[7];
-
-    // Read Temp/Pressure calib (0x88 - 0xA1)
-    readRegs(0x88, buf, 26);
-    calib.dig_T1 = (buf[1] << 8) | buf[0];
-    calib.dig_T2 = (int16_t)((buf[3] << 8) | buf[2]);
-    calib.dig_T3 = (int16_t)((buf[5] << 8) | buf[4]);
-    calib.dig_P1 = (buf[7] << 8) | buf[6];
-    calib.dig_P2 = (int16_t)((buf[9] << 8) | buf[8]);
-    calib.dig_P3 = (int16_t)((buf[11] << 8) | buf[10]);
-    calib.dig_P4 = (int16_t)((buf[13] << 8) | buf[12]);
-    calib.dig_P5 = (int16_t)((buf[15] << 8) | buf[14]);
-    calib.dig_P6 = (int16_t)((buf[17] << 8) | buf[16]);
-    calib.dig_P7 = (int16_t)((buf[19] << 8) | buf[18]);
-    calib.dig_P8 = (int16_t)((buf[21] << 8) | buf[20]);
-    calib.dig_P9 = (int16_t)((buf[23] << 8) | buf[22]);
-
-    // Read Humidity calib
-    readRegs(0xA1, &calib.dig_H1, 1);
-    readRegs(0xE1, bufH, 7);
-    calib.dig_H2 = (int16_t)((bufH[1] << 8) | bufH[0]);
-    calib.dig_H3 = bufH[2];
-    calib.dig_H4 = (int16_t)((bufH[3] << 4) | (bufH[4] & 0x0F));
-    calib.dig_H5 = (int16_t)((bufH[5] << 4) | (bufH[4] >> 4));
-    calib.dig_H6 = (int8_t)bufH[6];
+// --- Low Level I2C ---
 
-    return true;
+bool BME280::writeRegs(const uint8_t* pairs, int length) {
+    // Multiple (reg, value) pairs in one write transaction (datasheet 6.2.1)
+    return bus->write(deviceAddress, pairs, length);
 }
 
-// --- Compensation Formulas (From Bosch Datasheet) ---
+// --- Calibration Loading ---
+// Cold start: chip ID + the first 6 trim bytes (T1..T3) in one transaction, compared
+// with the cached blob. A match means the same chip: no need to read the other 27 bytes.
+bool BME280::loadCalibration() {
+    HORUS_TRACE_SCOPE("bme280.calibration");
+    uint8_t id = 0;
+    uint8_t fingerprint[6];
+    const I2CRead probe[2] = { { REG_ID, &id, 1 }, { REG_CALIB_TP, fingerprint, sizeof(fingerprint) } };
+    if (!bus->read(deviceAddress, probe, 2)) {
+        std::cerr << "[BME280] No answer at 0x" << std::hex << (int)deviceAddress << std::dec << std::endl;
+        return false;
+    }
 
-float BME280::compensateTemp(int32_t adc_T) {
-    int32_t var1, var2;
-    var1 = ((((adc_T >> 3) - ((int32_t)calib.dig_T1 << 1))) * ((int32_t)calib.dig_T2)) >> 11;
-    var2 = (((((adc_T >> 4) - ((int32_t)calib.dig_T1)) * ((adc_T >> 4) - ((int32_t)calib.dig_T1))) >> 12) * ((int32_t)calib.dig_T3)) >> 14;
-    t_fine = var1 + var2;
-    // We convert to float:
-    return ((t_fine * 5 + 128) >> 8) / 100.0f;
-}
+    // Check ID (Should be 0x60 for BME280)
+    if (id != 0x60) {
+        std::cerr << "[BME280] ID mismatch. Expected 0x60, got " << std::hex << (int)id << std::dec << std::endl;
+        return false;
+    }
 
-float BME280::compensatePressure(int32_t adc_P) {
-    int64_t var1, var2, p;
-    var1 = ((int64_t)t_fine) - 128000;
-    var2 = var1 * var1 * (int64_t)calib.dig_P6;
-    var2 = var2 + ((var1 * (int64_t)calib.dig_P5) << 17);
-    var2 = var2 + (((int64_t)calib.dig_P4) << 35);
-    var1 = ((var1 * var1 * (int64_t)calib.dig_P3) >> 8) + ((var1 * (int64_t)calib.dig_P2) << 12);
-    var1 = (((((int64_t)1) << 47) + var1)) * ((int64_t)calib.dig_P1) >> 33;
-    if (var1 == 0) return 0;
-    p = 1048576 - adc_P;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (((int64_t)calib.dig_P9) * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (((int64_t)calib.dig_P8) * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (((int64_t)calib.dig_P7) << 4);
-    return (float)p / 256.0f / 100.0f; // hPa
-}
+    // 1. Cached blob of this very chip?
+    const std::string busName = bus->name();
+    const std::string cachePath = busName.empty() ? "" : calibrationCachePath(busName, deviceAddress);
+    CalibCache cache;
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!cachePath.empty() && file.read(reinterpret_cast<char*>(&cache), sizeof(cache)) &&
+        std::memcmp(cache.magic, "BMEC", 4) == 0 && cache.chipId == id && cache.address == deviceAddress &&
+        cache.size == bme280::kCalibSize && std::memcmp(cache.blob, fingerprint, sizeof(fingerprint)) == 0) {
+        calib = bme280::parseCalibration(cache.blob);
+        return true;
+    }
 
-float BME280::compensateHumidity(int32_t adc_H) {
-    int32_t v_x1_u32r;
-    v_x1_u32r = (t_fine - ((int32_t)76800));
-    v_x1_u32r = (((((adc_H << 14) - (((int32_t)calib.dig_H4) << 20) - (((int32_t)calib.dig_H5) * v_x1_u32r)) + ((int32_t)16384)) >> 15) * (((((((v_x1_u32r * ((int32_t)calib.dig_H6)) >> 10) * (((v_x1_u32r * ((int32_t)calib.dig_H3)) >> 11) + ((int32_t)32768))) >> 10) + ((int32_t)2097152)) * ((int32_t)calib.dig_H2) + 8192) >> 14));
-    v_x1_u32r = (v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * ((int32_t)calib.dig_H1)) >> 4));
-    v_x1_u32r = (v_x1_u32r < 0 ? 0 : v_x1_u32r);
-    v_x1_u32r = (v_x1_u32r > 419430400 ? 419430400 : v_x1_u32r);
-    return (float)(v_x1_u32r >> 12) / 1024.0f;
+    // 2. Full read: both trim blocks in one transaction
+    uint8_t blob[bme280::kCalibSize];
+    const I2CRead trims[2] = { { REG_CALIB_TP, blob, 26 }, { REG_CALIB_H, blob + 26, 7 } };
+    if (!bus->read(deviceAddress, trims, 2)) {
+        std::cerr << "[BME280] Failed to read calibration data." << std::endl;
+        return false;
+    }
+    calib = bme280::parseCalibration(blob);
+    if (cachePath.empty()) return true;
+
+    std::memcpy(cache.magic, "BMEC", 4);
+    cache.chipId = id;
+    cache.address = deviceAddress;
+    cache.size = bme280::kCalibSize;
+    cache.reserved = 0;
+    std::memcpy(cache.blob, blob, bme280::kCalibSize);
+    utils::writeFileAtomic(cachePath, reinterpret_cast<const uint8_t*>(&cache), sizeof(cache));
+    return true;
 }
 
-} // namespace horus
\ No newline at end of file
+} // namespace horus
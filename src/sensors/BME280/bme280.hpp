@@ -1,7 +1,10 @@
 #pragma once
 
 #include <string>
+#include <memory>
 #include <cstdint>
+#include "BME280Compensation.hpp"
+#include "sensors/I2C/I2CBus.hpp"
 
 namespace horus {
 
@@ -11,44 +14,68 @@ struct BME280Data {
     float pressure;    // hPa
 };
 
+// Register encodings (datasheet 5.4.3 - 5.4.6)
+enum class BME280Oversampling : uint8_t { Skip = 0, X1 = 1, X2 = 2, X4 = 3, X8 = 4, X16 = 5 };
+enum class BME280Filter : uint8_t { Off = 0, X2 = 1, X4 = 2, X8 = 3, X16 = 4 };
+
+// Acquisition settings. The defaults are the datasheet's "weather monitoring" case
+// (forced mode, x1 everywhere, no IIR): the lowest power, one sample per request.
+// Higher oversampling / IIR trade conversion time for noise.
+struct BME280Settings {
+    BME280Oversampling temperature = BME280Oversampling::X1;
+    BME280Oversampling pressure = BME280Oversampling::X1;
+    BME280Oversampling humidity = BME280Oversampling::X1;
+    BME280Filter filter = BME280Filter::Off;
+};
+
+// Mean and sample variance of a burst of forced conversions
+struct BME280Burst {
+    BME280Data mean = {0, 0, 0};
+    BME280Data variance = {0, 0, 0};
+    int samples = 0;
+};
+
 class BME280 {
 public:
+    // Owns a LinuxI2CBus on /dev/i2c-<busId>, opened by init()
     BME280(uint8_t i2cAddress = 0x76, int busId = 1);
+    // Talks through 'bus' (not owned), e.g. a SimulatedBME280
+    BME280(I2CBus& bus, uint8_t i2cAddress = 0x76);
     ~BME280();
 
-    // Initialize sensor (soft reset, read calibration data, set config)
-    bool init();
+    // Initialize sensor (check ID, load calibration, configure, then sleep).
+    // The sensor stays in sleep mode between measurements (forced mode).
+    bool init(const BME280Settings& settings = BME280Settings());
+
+    // Changes oversampling / filter (sensor must be idle)
+    bool configure(const BME280Settings& settings);
 
-    // Read the current values
+    // Forced mode: one conversion on demand, then the sensor goes back to sleep
+    bool measure(BME280Data& data);
+
+    // Read the current values (one forced conversion, zeros on failure)
     BME280Data readAll();
 
+    // 'samples' back-to-back forced conversions -> mean and variance
+    bool readBurst(int samples, BME280Burst& burst);
+
+    const BME280Calibration& calibration() const { return calib; }
+
+    // Where the calibration blob of the chip at bus/address is cached
+    static std::string calibrationCachePath(const std::string& busName, uint8_t address);
+
 private:
-    int i2c_fd;
+    std::unique_ptr<I2CBus> ownedBus;
+    I2CBus* bus = nullptr;
     int busId;
     uint8_t deviceAddress;
-
-    // Calibration data (Trim parameters from datasheet)
-    // The sensor stores these internally to correct its own raw data.
-    struct CalibData {
-        uint16_t dig_T1;
-        int16_t  dig_T2, dig_T3;
-        uint8_t  dig_H1, dig_H3;
-        int16_t  dig_H2, dig_H4, dig_H5;
-        int8_t   dig_H6;
-        uint16_t dig_P1;
-        int16_t  dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
-    } calib;
+    BME280Settings settings;
+    BME280Calibration calib;
 
     // Internal helper methods
-    bool readCalibrationData();
-    void writeReg(uint8_t reg, uint8_t value);
-    void readRegs(uint8_t reg, uint8_t* buffer, int length);
-    
-    // The Bosch compensation logic
-    int32_t t_fine; // Intermediate temperature value used for pressure/humidity
-    float compensateTemp(int32_t adc_T);
-    float compensatePressure(int32_t adc_P);
-    float compensateHumidity(int32_t adc_H);
+    bool loadCalibration();
+    bool writeRegs(const uint8_t* pairs, int length); // (reg, value) pairs, one transaction
+    int measurementTimeUs() const;
 };
 
-} // namespace horus
\ No newline at end of file
+} // namespace horus
@@ -0,0 +1,47 @@
+#include "AeConvergence.hpp"
+#include <cmath>
+#include <algorithm>
+
+namespace horus {
+
+ConvergenceDetector::ConvergenceDetector(const ConvergenceOptions& options)
+    : options(options) {}
+
+void ConvergenceDetector::reset() {
+    anchor = AeMetadata();
+    frameCount = 0;
+    stableCount = 0;
+}
+
+bool ConvergenceDetector::withinTolerance(float current, float previous, float tolerance) {
+    float reference = std::max(std::fabs(previous), 1e-6f);
+    return std::fabs(current - previous) <= tolerance * reference;
+}
+
+bool ConvergenceDetector::push(const AeMetadata& metadata) {
+    ++frameCount;
+
+    // Every frame of a stable run is compared with the frame that started the run
+    // (not just its neighbour), so a slow steady drift - typical at dawn - adds up
+    // and breaks the run instead of sneaking through as "small changes".
+    // When AE reports its state, its own "searching" wins: the first frames after start
+    // repeat the initial exposure unchanged while the algorithm is still measuring.
+    bool stable = frameCount > 1 && metadata.status != AeStatus::Searching &&
+                  withinTolerance(metadata.exposureTime, anchor.exposureTime, options.tolerance) &&
+                  withinTolerance(metadata.analogueGain, anchor.analogueGain, options.tolerance) &&
+                  withinTolerance(metadata.colourGainR, anchor.colourGainR, options.tolerance) &&
+                  withinTolerance(metadata.colourGainB, anchor.colourGainB, options.tolerance) &&
+                  withinTolerance(metadata.lux, anchor.lux, options.luxTolerance);
+
+    if (stable) {
+        ++stableCount;
+    } else {
+        // Any jump restarts the count: we want N quiet frames in a row
+        anchor = metadata;
+        stableCount = 0;
+    }
+
+    return converged() || frameCount >= options.maxFrames;
+}
+
+} // namespace horus
@@ -0,0 +1,56 @@
+#pragma once
+
+namespace horus {
+
+// What the AE algorithm says about itself (libcamera AeState, or AeLocked on older releases)
+enum class AeStatus {
+    Unknown,   // Not reported, or AE off: only the values decide
+    Searching, // Still adjusting: the frame never counts as stable
+    Converged
+};
+
+// The values the AE/AWB algorithms report back for every frame (request metadata).
+// A field left at 0 means "not reported" and never blocks convergence.
+struct AeMetadata {
+    float exposureTime = 0.0f; // us
+    float analogueGain = 0.0f;
+    float colourGainR = 0.0f;  // AWB red gain
+    float colourGainB = 0.0f;  // AWB blue gain
+    float lux = 0.0f;
+    AeStatus status = AeStatus::Unknown;
+};
+
+struct ConvergenceOptions {
+    float tolerance = 0.02f;    // Max relative change of exposure / gains over a stable run
+    float luxTolerance = 0.05f; // Lux is noisier, so it gets its own (looser) bound
+    int stableFrames = 3;       // Consecutive frames within tolerance = converged
+    int minFrames = 4;          // Never stop before the algorithms had a chance to react
+    int maxFrames = 60;         // Hard upper bound (slow dawn scenes)
+};
+
+// Decides when AE/AWB have settled, from the metadata of consecutive frames.
+// No libcamera dependency: it can be fed recorded metadata sequences.
+class ConvergenceDetector {
+public:
+    explicit ConvergenceDetector(const ConvergenceOptions& options = ConvergenceOptions());
+
+    void reset();
+
+    // Feeds one frame. Returns true when warm-up can stop:
+    // either the values are stable, or maxFrames was reached.
+    bool push(const AeMetadata& metadata);
+
+    bool converged() const { return stableCount >= options.stableFrames && frameCount >= options.minFrames; }
+    int frames() const { return frameCount; }
+    int stableRun() const { return stableCount; }
+
+private:
+    ConvergenceOptions options;
+    AeMetadata anchor; // First frame of the current stable run
+    int frameCount = 0;
+    int stableCount = 0;
+
+    static bool withinTolerance(float current, float previous, float tolerance);
+};
+
+} // namespace horus
@@ -1,41 +1,129 @@
 #include "Camera.hpp"
+#include <libcamera/version.h>
 #include <iostream>
 #include <sys/mman.h> // Essential for memory mapping
 #include <unistd.h>
 #include <fcntl.h>
 #include <fstream>
-#include <jpeglib.h>
 #include <vector>
+#include <map>
+#include <algorithm>
+#include <chrono>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <future>
+#include "imaging/JpegEncoder.hpp"
+#include "imaging/ParallelJpegEncoder.hpp"
+#include "imaging/PreviewPyramid.hpp"
+#include "imaging/ExposureFusion.hpp"
+#include "imaging/RawDevelop.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/Trace.hpp"
 
 namespace horus {
 
-Camera::Camera() {
-    cm = std::make_unique<CameraManager>();
-    cm->start(); // Load the camera manager
+std::shared_ptr<CameraManager> startCameraManager() {
+    std::shared_ptr<CameraManager> manager(new CameraManager(), [](CameraManager *cm) {
+        cm->stop();
+        delete cm;
+    });
+    manager->start(); // Load the camera manager
+    return manager;
 }
 
+Camera::Camera() : Camera(startCameraManager(), 0) {}
+
+Camera::Camera(std::shared_ptr<CameraManager> manager, size_t index, std::shared_ptr<utils::ThreadPool> encoderPool)
+    : cm(std::move(manager)), cameraIndex(index), sharedPool(encoderPool != nullptr),
+      encoderPool(std::move(encoderPool)) {}
+
 Camera::~Camera() {
     stop();
-    cm->stop();
 }
 
-bool Camera::start() {
-    if (cm->cameras().empty()) {
-        std::cerr << "[Camera] No cameras found." << std::endl;
+std::string Camera::name() const {
+    return "cam" + std::to_string(cameraIndex);
+}
+
+size_t Camera::memoryEstimate(const CameraOptions& options) const {
+    if (cameraIndex >= cm->cameras().size()) return 0;
+    const std::shared_ptr<libcamera::Camera> &sensor = cm->cameras()[cameraIndex];
+    auto size = sensor->properties().get(properties::PixelArraySize);
+    if (!size) return captureMemoryBytes(options, 4608, 2592); // IMX708, the largest we use
+    return captureMemoryBytes(options, static_cast<int>(size->width), static_cast<int>(size->height));
+}
+
+bool Camera::start(const CameraOptions& options) {
+    HORUS_TRACE_SCOPE("camera.start");
+    if (cameraIndex >= cm->cameras().size()) {
+        std::cerr << "[Camera] No camera " << cameraIndex << " (" << cm->cameras().size() << " found)." << std::endl;
         return false;
     }
 
-    // 1. Acquire Camera (Grab the first one found)
-    camera = cm->cameras()[0];
+    // 1. Acquire Camera (the first one found, unless another was asked for)
+    camera = cm->cameras()[cameraIndex];
     if (camera->acquire()) {
         std::cerr << "[Camera] Failed to acquire lock." << std::endl;
         return false;
     }
 
-    // 2. Configure: We want a Still Capture (High Res)
-    config = camera->generateConfiguration({ StreamRole::StillCapture });
-    
-    config->at(0).pixelFormat = formats::BGR888;    
+    // 2. Configure: We want a Still Capture (High Res), plus the sensor's Bayer data in RAW mode
+    rawStream = nullptr;
+    if (options.captureRaw) {
+        config = camera->generateConfiguration({ StreamRole::StillCapture, StreamRole::Raw });
+    } else {
+        config = camera->generateConfiguration({ StreamRole::StillCapture });
+    }
+    if (!config || (options.captureRaw && config->size() < 2)) {
+        std::cerr << "[Camera] Could not generate a configuration." << std::endl;
+        return false;
+    }
+
+    pixelLayout = options.pixelLayout;
+    convergence = options.convergence;
+    denoiseFrames = options.denoiseFrames;
+    denoiseMode = options.denoiseMode;
+    detectMarkers = options.detectMarkers;
+    markerScale = std::max(1, options.markerScale);
+    previewLevels = std::clamp(options.previewLevels, 0, imaging::kMaxPyramidLevels);
+    rateControl = options.rateControl;
+    rois = options.rois;
+    scene = options.scene;
+    contextLevels = 1;
+    while ((2 << contextLevels) <= options.contextScale && contextLevels < imaging::kMaxPyramidLevels) ++contextLevels;
+    markerDictionary = imaging::builtinDictionary();
+    if (detectMarkers && !options.markerDictionary.empty() &&
+        !imaging::loadDictionary(options.markerDictionary, markerDictionary)) {
+        std::cerr << "[Camera] Using the built-in " << markerDictionary.name << " dictionary." << std::endl;
+    }
+    // ROIs: only their bounding box goes through the ISP
+    capturedField = imaging::Roi();
+    sensorCrop = Rectangle();
+    if (!rois.empty() && options.roiSensorCrop && !options.captureRaw) {
+        configureSensorCrop();
+    }
+
+    if (pixelLayout == imaging::PixelLayout::YUV420) {
+        // Planar 4:2:0 in full-range BT.601 (sYCC) is exactly what a JPEG stores
+        config->at(0).pixelFormat = formats::YUV420;
+        config->at(0).colorSpace = ColorSpace::Sycc;
+
+        if (config->validate() == CameraConfiguration::Invalid ||
+            config->at(0).pixelFormat != formats::YUV420 ||
+            config->at(0).colorSpace != ColorSpace::Sycc) {
+            std::cerr << "[Camera] YUV420 not supported, falling back to BGR888." << std::endl;
+            pixelLayout = imaging::PixelLayout::BGR888;
+        }
+    }
+
+    if (pixelLayout == imaging::PixelLayout::BGR888) {
+        config->at(0).pixelFormat = formats::BGR888;
+    }
+
+    for (size_t i = 0; i < config->size(); ++i) {
+        config->at(i).bufferCount = std::max(1u, options.bufferCount);
+    }
 
     if (config->validate() == CameraConfiguration::Invalid) {
         std::cerr << "[Camera] Invalid configuration." << std::endl;
@@ -47,192 +135,704 @@ bool Camera::start() {
         return false;
     }
 
+    // Encoder workers are spun up now so capture() doesn't pay for it
+    if (!sharedPool) {
+        encoderPool.reset();
+        if (options.encoderThreads != 1) {
+            encoderPool = std::make_shared<utils::ThreadPool>(options.encoderThreads);
+        }
+    }
+
     // 3. Allocate Buffers (Reserve RAM for the images)
     allocator = std::make_unique<FrameBufferAllocator>(camera);
     Stream *stream = config->at(0).stream();
-    
-    if (allocator->allocate(stream) < 0) {
-        std::cerr << "[Camera] Buffer allocation failed." << std::endl;
-        return false;
-    }
-
-    // 4. Create the Request object
-    request = camera->createRequest();
-    if (!request) {
-        std::cerr << "[Camera] Failed to create request." << std::endl;
-        return false;
+    if (options.captureRaw) rawStream = config->at(1).stream();
+
+    // 4. Map every buffer ONCE: capture() and the encoders read straight from here
+    unmapBuffers();
+    for (size_t i = 0; i < config->size(); ++i) {
+        if (allocator->allocate(config->at(i).stream()) < 0) {
+            std::cerr << "[Camera] Buffer allocation failed." << std::endl;
+            return false;
+        }
+        if (!mapBuffers(config->at(i).stream())) {
+            return false;
+        }
     }
 
-    // Assign the allocated buffer to the request
+    // 5. Create one Request per buffer, so several frames can be in flight
+    requests.clear();
     const std::vector<std::unique_ptr<FrameBuffer>> &buffers = allocator->buffers(stream);
-    if (request->addBuffer(stream, buffers[0].get()) < 0) {
-        std::cerr << "[Camera] Failed to attach buffer." << std::endl;
-        return false;
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        std::unique_ptr<Request> request = camera->createRequest();
+        if (!request) {
+            std::cerr << "[Camera] Failed to create request." << std::endl;
+            return false;
+        }
+
+        // Assign the allocated buffer(s) to the request
+        if (request->addBuffer(stream, buffers[i].get()) < 0 ||
+            (rawStream && (i >= allocator->buffers(rawStream).size() ||
+                           request->addBuffer(rawStream, allocator->buffers(rawStream)[i].get()) < 0))) {
+            std::cerr << "[Camera] Failed to attach buffer." << std::endl;
+            return false;
+        }
+        requests.push_back(std::move(request));
     }
 
-    // 5. Connect the Signal (The "Callback")
+    // 6. Connect the Signal (The "Callback")
     // When camera finishes, it calls 'requestCompleteHandler'
     camera->requestCompleted.connect(this, &Camera::requestCompleteHandler);
 
+    std::cout << "[Camera] " << name() << " ready: " << requests.size() << " buffers mapped"
+              << (rawStream ? " (+ RAW " + config->at(1).pixelFormat.toString() + ")." : ".") << std::endl;
+    if (!rois.empty() && !rawStream) {
+        std::cout << "[Camera] " << rois.size() << " ROI(s), "
+                  << (sensorCrop.width > 0 ? "sensor crop " + std::to_string(sensorCrop.width) + "x" +
+                                             std::to_string(sensorCrop.height) + " -> stream " +
+                                             std::to_string(config->at(0).size.width) + "x" +
+                                             std::to_string(config->at(0).size.height)
+                                           : std::string("cropped from the full frame"))
+                  << ", context 1/" << (1 << contextLevels) << "." << std::endl;
+    }
     return true;
 }
 
+// ScalerCrop takes one rectangle in sensor pixels (inside ScalerCropMaximum): the
+// bounding box of the regions. The stream is sized to the crop at full resolution, so
+// the ISP neither scales the regions down nor processes what lies outside them.
+// Note: on a small crop the pipeline may pick a binned sensor mode for the smaller
+// stream; roiSensorCrop = false keeps the full-resolution field.
+void Camera::configureSensorCrop() {
+    auto maximum = camera->properties().get(properties::ScalerCropMaximum);
+    if (!maximum || maximum->width == 0 || maximum->height == 0) {
+        std::cerr << "[Camera] No ScalerCrop on this camera, cropping the ROIs from the full frame." << std::endl;
+        return;
+    }
+    cropMaximum = *maximum;
+
+    const imaging::Roi bounds = imaging::roiBounds(rois);
+    sensorCrop = Rectangle(cropMaximum.x + static_cast<int>(bounds.x * cropMaximum.width),
+                           cropMaximum.y + static_cast<int>(bounds.y * cropMaximum.height),
+                           static_cast<unsigned>(std::ceil(bounds.width * cropMaximum.width)),
+                           static_cast<unsigned>(std::ceil(bounds.height * cropMaximum.height)));
+
+    // The default StillCapture size is the full sensor resolution: keep its scale
+    StreamConfiguration &streamConfig = config->at(0);
+    const unsigned width = static_cast<unsigned>(streamConfig.size.width * bounds.width) & ~1u;
+    const unsigned height = static_cast<unsigned>(streamConfig.size.height * bounds.height) & ~1u;
+    streamConfig.size = Size(std::max(16u, width), std::max(16u, height));
+    capturedField = bounds;
+}
+
+// The pipeline aligns and clips the requested crop; the frame covers what it reports
+void Camera::updateCapturedField(const Request *request) {
+    if (sensorCrop.width == 0) return;
+    auto crop = request->metadata().get(controls::ScalerCrop);
+    if (!crop || crop->width == 0 || crop->height == 0) return;
+    capturedField.x = static_cast<double>(crop->x - cropMaximum.x) / cropMaximum.width;
+    capturedField.y = static_cast<double>(crop->y - cropMaximum.y) / cropMaximum.height;
+    capturedField.width = static_cast<double>(crop->width) / cropMaximum.width;
+    capturedField.height = static_cast<double>(crop->height) / cropMaximum.height;
+}
+
 void Camera::stop() {
     if (camera) {
         camera->stop();
+        camera->requestCompleted.disconnect(this, &Camera::requestCompleteHandler);
+
+        // Buffers must go before the camera is released
+        requests.clear();
+        unmapBuffers();
+        allocator.reset();
+        rawStream = nullptr;
+
         camera->release();
         camera.reset();
     }
 }
 
-// The "Main Event": This blocks until the photo is taken
-bool Camera::capture(const std::string& filepath) {
-    if (!camera) return false;
+// Resets the completion queue, starts the sensor and queues ALL the requests:
+// the sensor keeps streaming while we look at a frame
+bool Camera::startStreaming() {
+    HORUS_TRACE_SCOPE("camera.stream_on");
+    if (!camera || requests.empty()) return false;
 
-    // Start hardware processing
-    camera->start();
-    
-    // --- WARM UP LOOP ---
-    // We capture multiple frames to let Auto-Exposure (AE) & AWB settle.
-    // 30 frames is roughly 1 second, which is usually enough.
-    const int warmupFrames = 30;
+    {
+        std::lock_guard<std::mutex> lock(cameraMutex);
+        completedRequests.clear();
+    }
+    if (camera->start() < 0) {
+        std::cerr << "[Camera] Failed to start streaming." << std::endl;
+        return false;
+    }
+
+    for (size_t i = 0; i < requests.size(); ++i) {
+        requests[i]->reuse(Request::ReuseBuffers);
+        if (i == 0) {
+            // A previous bracket may have left AE/AWB in manual mode
+            requests[i]->controls().set(controls::AeEnable, true);
+            requests[i]->controls().set(controls::AwbEnable, true);
+        }
+        if (sensorCrop.width > 0) requests[i]->controls().set(controls::ScalerCrop, sensorCrop);
+        camera->queueRequest(requests[i].get());
+    }
+    return true;
+}
+
+// Hands a buffer straight back to the sensor
+void Camera::requeue(Request *request) {
+    request->reuse(Request::ReuseBuffers);
+    camera->queueRequest(request);
+}
+
+// --- WARM UP LOOP ---
+// We capture frames until Auto-Exposure (AE) & AWB settle, judged from each
+// frame's metadata: a bright scene settles in a handful of frames, dawn may need 60.
+// With minRunFrames, streaming goes on after convergence until the stable run is
+// that long; 'sink' sees every frame before its buffer goes back to the sensor.
+// Returns the frame that ended the warm-up (NOT re-queued), nullptr on failure.
+Request* Camera::warmUp(int minRunFrames, const WarmUpSink& sink) {
+    HORUS_TRACE_SCOPE("camera.warmup");
+    ConvergenceDetector detector(convergence);
 
     std::cout << "[Camera] Warming up (AE/AWB convergence)..." << std::endl;
 
-    for (int i = 0; i < warmupFrames; ++i) {
-        // 1. Reset the flag so we can wait again
-        {
-            std::lock_guard<std::mutex> lock(cameraMutex);
-            requestComplete = false;
+    Request *last = nullptr;
+    while (!last) {
+        // 1. Wait for the next finished frame
+        Request *request = waitForRequest();
+        if (!request) {
+            std::cerr << "[Camera] Timed out waiting for a frame." << std::endl;
+            camera->stop();
+            return nullptr;
         }
 
-        // 2. Reuse the request (Essential!)
-        // For the very first frame (i=0), the request is fresh.
-        // For subsequent frames, we must tell libcamera we are reusing the buffers.
-        if (i > 0) {
-            request->reuse(Request::ReuseBuffers);
+        // 2. Keep the frame that ends the warm-up, hand every other buffer straight back to the sensor
+        bool done = detector.push(readAeMetadata(request));
+        if (sink) sink(request, detector.stableRun());
+        if (done && detector.converged() && detector.stableRun() + 1 < minRunFrames &&
+            detector.frames() < convergence.maxFrames + minRunFrames) {
+            done = false; // Converged, but the run is still too short for the denoiser
         }
 
-        // 3. Queue the request
-        camera->queueRequest(request.get());
+        if (done) {
+            last = request;
+        } else {
+            requeue(request);
+        }
 
-        // 4. Wait for the hardware to finish this frame
-        std::unique_lock<std::mutex> lock(cameraMutex);
-        cameraCv.wait(lock, [this] { return requestComplete; });
-        
         // (Optional) Print dots to show progress
-        if (i % 5 == 0) std::cout << "." << std::flush;
+        if (detector.frames() % 5 == 0) std::cout << "." << std::flush;
     }
     std::cout << std::endl;
+    HORUS_TRACE_COUNTER("camera.warmup_frames", detector.frames());
+
+    if (detector.converged()) {
+        std::cout << "[Camera] AE/AWB converged after " << detector.frames() << " frames." << std::endl;
+    } else {
+        std::cerr << "[Camera] AE/AWB NOT converged after " << detector.frames()
+                  << " frames, using the last one." << std::endl;
+    }
+    return last;
+}
+
+// The "Main Event": This blocks until the photo is taken
+bool Camera::capture(const std::string& filepath) {
+    HORUS_TRACE_SCOPE("camera.capture");
+    if (rawStream) return captureRawFrame(filepath);
+    if (denoiseFrames > 1) return captureDenoised(filepath);
+
+    // Start hardware processing
+    if (!startStreaming()) return false;
+
+    Request *last = warmUp();
+    if (!last) return false;
+    updateCapturedField(last);
 
     std::cout << "[Camera] Capture finished." << std::endl;
 
-    // Stop camera to save power
-    camera->stop();
+    // Stop camera to save power (in-flight requests come back cancelled)
+    {
+        HORUS_TRACE_SCOPE("camera.stop");
+        camera->stop();
+    }
 
     // Now save the data from the LAST buffer (the fully exposed one)
     Stream *stream = config->at(0).stream();
-    FrameBuffer *buffer = request->buffers().at(stream);
-    
-    saveBufferToFile(filepath, buffer);
+    FrameBuffer *buffer = last->buffers().at(stream);
     
-    return true;
+    return saveBufferToFile(filepath, buffer);
+}
+
+// Temporal denoise: the frames of the converged warm-up run are the same scene at
+// the same exposure, so they are combined instead of thrown away. No extra
+// frames are shot unless the run is shorter than denoiseFrames.
+bool Camera::captureDenoised(const std::string& filepath) {
+    HORUS_TRACE_SCOPE("camera.capture_denoised");
+    if (!startStreaming()) return false;
+
+    Stream *stream = config->at(0).stream();
+    imaging::FrameAccumulator accumulator;
+    std::deque<imaging::OwnedFrame> recent; // Median only: copies of the last N frames
+    const bool median = denoiseMode == imaging::DenoiseMode::Median;
+    const int wanted = median ? std::min(denoiseFrames, kMaxMedianFrames) : denoiseFrames;
+
+    // 1. Gather the current stable run while AE/AWB settle
+    WarmUpSink sink = [&](const Request *request, int stableRun) {
+        const imaging::FrameView frame = frameView(request->buffers().at(stream));
+        if (median) {
+            if (stableRun == 0) recent.clear();
+            if (static_cast<int>(recent.size()) == wanted) recent.pop_front();
+            recent.emplace_back();
+            imaging::copyFrame(frame, recent.back());
+        } else {
+            if (stableRun == 0) accumulator.reset();
+            accumulator.add(frame);
+        }
+    };
+
+    Request *last = warmUp(wanted, sink);
+    if (!last) return false;
+    updateCapturedField(last);
+
+    // 2. Everything is on the CPU side now (accumulator or copies): stop the sensor
+    camera->stop();
+
+    imaging::OwnedFrame denoised;
+    int used = 0;
+    if (median) {
+        std::vector<imaging::FrameView> inputs;
+        for (const imaging::OwnedFrame &frame : recent) inputs.push_back(frame.view());
+        used = static_cast<int>(inputs.size());
+        if (!imaging::temporalMedian(inputs, denoised)) return false;
+    } else {
+        used = accumulator.count();
+        if (!accumulator.average(denoised)) return false;
+    }
+
+    std::cout << "[Camera] Denoised " << used << " frames ("
+              << (median ? "median" : "average") << ")." << std::endl;
+    return saveFrame(filepath, denoised.view());
+}
+
+// RAW mode: the converged Bayer frame goes to disk untouched, compression comes later
+bool Camera::captureRawFrame(const std::string& filepath) {
+    if (!startStreaming()) return false;
+
+    Request *last = warmUp();
+    if (!last) return false;
+
+    // Nothing else to do with the sensor: the buffer stays valid until the next start
+    camera->stop();
+    return saveRawBuffer(filepath, last);
+}
+
+// Exposure bracket + on-device fusion
+bool Camera::captureHdr(const std::string& filepath, const std::vector<float>& evOffsets) {
+    HORUS_TRACE_SCOPE("camera.capture_hdr");
+    if (evOffsets.empty()) return false;
+    if (!startStreaming()) return false;
+
+    // 1. Let AE/AWB settle: the converged values are the 0 EV reference
+    Request *base = warmUp();
+    if (!base) return false;
+
+    updateCapturedField(base);
+    const AeMetadata reference = readAeMetadata(base);
+    const float baseGain = std::max(1.0f, reference.analogueGain);
+    const float totalExposure = reference.exposureTime * baseGain; // us x gain
+    std::array<float, 2> colourGains = { reference.colourGainR, reference.colourGainB };
+    requeue(base);
+
+    // 2. One frame per bracket step, all with AWB frozen at the reference gains
+    std::vector<imaging::OwnedFrame> frames(evOffsets.size());
+    Stream *stream = config->at(0).stream();
+
+    for (size_t i = 0; i < evOffsets.size(); ++i) {
+        // Prefer longer shutter over gain (less noise), within what a still can afford
+        const float target = totalExposure * std::pow(2.0f, evOffsets[i]);
+        const float exposure = std::max(100.0f, std::min(target / baseGain, kMaxBracketExposureUs));
+        const float gain = std::clamp(target / exposure, 1.0f, kMaxBracketGain);
+
+        // The controls ride on the next request we hand back; the sensor applies
+        // them a few frames later, so wait until the metadata says they took effect.
+        bool controlsSent = false;
+        bool matched = false;
+        for (int attempt = 0; attempt < kMaxBracketFrames && !matched; ++attempt) {
+            Request *request = waitForRequest();
+            if (!request) {
+                std::cerr << "[Camera] Timed out waiting for a bracket frame." << std::endl;
+                camera->stop();
+                return false;
+            }
+
+            AeMetadata ae = readAeMetadata(request);
+            matched = controlsSent &&
+                      std::fabs(ae.exposureTime - exposure) <= 0.05f * exposure &&
+                      std::fabs(ae.analogueGain - gain) <= 0.05f * gain;
+
+            // Copy out: the buffer goes straight back to the sensor
+            if (matched || attempt == kMaxBracketFrames - 1) {
+                imaging::copyFrame(frameView(request->buffers().at(stream)), frames[i]);
+            }
+
+            request->reuse(Request::ReuseBuffers);
+            if (!controlsSent) {
+                request->controls().set(controls::AeEnable, false);
+                request->controls().set(controls::AwbEnable, false);
+                request->controls().set(controls::ExposureTime, static_cast<int32_t>(exposure));
+                request->controls().set(controls::AnalogueGain, gain);
+                if (colourGains[0] > 0.0f && colourGains[1] > 0.0f) {
+                    request->controls().set(controls::ColourGains, Span<const float, 2>(colourGains));
+                }
+                controlsSent = true;
+            }
+            camera->queueRequest(request);
+        }
+
+        std::cout << "[Camera] Bracket " << evOffsets[i] << " EV: " << exposure << " us x" << gain
+                  << (matched ? "" : " (not confirmed by metadata)") << std::endl;
+    }
+
+    // Stop camera to save power: the rest is CPU work on the copies
+    camera->stop();
+
+    // 3. Fuse in place into the first frame (saves one full-res buffer)
+    std::vector<imaging::FrameView> inputs;
+    for (const imaging::OwnedFrame &frame : frames) inputs.push_back(frame.view());
+    if (!imaging::fuseExposures(inputs, frames[0])) return false;
+
+    std::cout << "[Camera] Fused " << frames.size() << " exposures." << std::endl;
+    return saveFrame(filepath, frames[0].view());
 }
 
 // This runs in a separate thread managed by libcamera!
 void Camera::requestCompleteHandler(Request *req) {
-    if (req->status() == Request::RequestComplete) {
+    // Cancelled requests (from camera->stop()) carry no image
+    if (req->status() == Request::RequestCancelled) return;
+
+    {
         std::lock_guard<std::mutex> lock(cameraMutex);
-        requestComplete = true;
+        completedRequests.push_back(req);
     }
     // Notify the main thread to wake up
     cameraCv.notify_one();
 }
 
-// Helper function to compress BGR data to JPEG (Swapping to RGB on the fly)
-void saveJpeg(const std::string& filename, void* data, int width, int height, int stride) {
-    struct jpeg_compress_struct cinfo;
-    struct jpeg_error_mgr jerr;
-    FILE * outfile;
-    JSAMPROW row_pointer[1];
+Request* Camera::waitForRequest() {
+    HORUS_TRACE_SCOPE("camera.wait_frame");
+    std::unique_lock<std::mutex> lock(cameraMutex);
+    if (!cameraCv.wait_for(lock, std::chrono::seconds(5), [this] { return !completedRequests.empty(); })) {
+        return nullptr;
+    }
+    Request *req = completedRequests.front();
+    completedRequests.pop_front();
+    return req;
+}
 
-    cinfo.err = jpeg_std_error(&jerr);
-    jpeg_create_compress(&cinfo);
+AeMetadata Camera::readAeMetadata(const Request *request) {
+    const ControlList &metadata = request->metadata();
+    AeMetadata ae;
 
-    if ((outfile = fopen(filename.c_str(), "wb")) == NULL) {
-        std::cerr << "[Camera] Can't open " << filename << std::endl;
-        return;
+    if (auto exposure = metadata.get(controls::ExposureTime)) ae.exposureTime = static_cast<float>(*exposure);
+    if (auto gain = metadata.get(controls::AnalogueGain)) ae.analogueGain = *gain;
+    if (auto gains = metadata.get(controls::ColourGains)) {
+        ae.colourGainR = (*gains)[0];
+        ae.colourGainB = (*gains)[1];
     }
-    jpeg_stdio_dest(&cinfo, outfile);
-
-    cinfo.image_width = width;
-    cinfo.image_height = height;
-    cinfo.input_components = 3;
-    cinfo.in_color_space = JCS_RGB;
+    if (auto lux = metadata.get(controls::Lux)) ae.lux = *lux;
 
-    jpeg_set_defaults(&cinfo);
-    jpeg_set_quality(&cinfo, 90, TRUE);
-    jpeg_start_compress(&cinfo, TRUE);
+    // AeState replaced AeLocked in libcamera 0.4; Idle means AE is off (manual exposure)
+#if LIBCAMERA_VERSION_MAJOR > 0 || LIBCAMERA_VERSION_MINOR >= 4
+    if (auto state = metadata.get(controls::AeState)) {
+        if (*state == controls::AeStateConverged) ae.status = AeStatus::Converged;
+        else if (*state != controls::AeStateIdle) ae.status = AeStatus::Searching;
+    }
+#else
+    if (auto locked = metadata.get(controls::AeLocked)) {
+        ae.status = *locked ? AeStatus::Converged : AeStatus::Searching;
+    }
+#endif
 
-    unsigned char* src_buffer = static_cast<unsigned char*>(data);
+    return ae;
+}
 
-    // Temp buffer for one row (to hold the swapped RGB pixels)
-    std::vector<unsigned char> row_buffer(width * 3);
+// Memory Mapping
+// We have to map the Kernel's memory (DMA) into our User Space to read it.
+// Multi-planar formats (YUV420) usually share one dmabuf fd with per-plane offsets,
+// so each distinct fd is mapped once, large enough to cover all its planes.
+// Mappings accumulate across streams (RAW mode maps two); unmapBuffers() drops them all.
+bool Camera::mapBuffers(Stream *stream) {
+    HORUS_TRACE_SCOPE("camera.mmap");
+    for (const std::unique_ptr<FrameBuffer> &buffer : allocator->buffers(stream)) {
+        std::map<int, size_t> mapLengths;
+        for (const FrameBuffer::Plane &plane : buffer->planes()) {
+            size_t end = plane.offset + plane.length;
+            mapLengths[plane.fd.get()] = std::max(mapLengths[plane.fd.get()], end);
+        }
 
-    while (cinfo.next_scanline < cinfo.image_height) {
-        // Pointer to the current row in the Source (BGR) data
-        const unsigned char* src_row = &src_buffer[cinfo.next_scanline * stride];
+        std::map<int, uint8_t*> fdData;
+        for (const auto &[fd, length] : mapLengths) {
+            void *data = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                std::cerr << "[Camera] mmap failed!" << std::endl;
+                unmapBuffers();
+                return false;
+            }
+            mappings.push_back({ static_cast<uint8_t*>(data), length });
+            fdData[fd] = static_cast<uint8_t*>(data);
+        }
 
-        // MANUAL SWAP LOOP: BGR -> RGB
-        // We copy pixel by pixel to the temporary row buffer
-        for (int x = 0; x < width; ++x) {
-            // Source is BGR (Blue=0, Green=1, Red=2)
-            // Dest is RGB (Red=0, Green=1, Blue=2)
-            
-            row_buffer[x * 3 + 0] = src_row[x * 3 + 2];
-            // Source is BGR: [0]=B, [1]=G, [2]=R
-            // We want RGB:        [0]=R, [1]=G, [2]=B
-            
-            row_buffer[x * 3 + 0] = src_row[x * 3 + 2]; // Dest Red   = Source Red (Byte 2)
-            row_buffer[x * 3 + 1] = src_row[x * 3 + 1]; // Dest Green = Source Green (Byte 1)
-            row_buffer[x * 3 + 2] = src_row[x * 3 + 0]; // Dest Blue  = Source Blue (Byte 0)
+        std::vector<uint8_t*> &planes = planeData[buffer.get()];
+        for (const FrameBuffer::Plane &plane : buffer->planes()) {
+            planes.push_back(fdData[plane.fd.get()] + plane.offset);
         }
+    }
+    return true;
+}
 
-        // Point JPEG compressor to our corrected RGB row
-        row_pointer[0] = row_buffer.data();
-        jpeg_write_scanlines(&cinfo, row_pointer, 1);
+void Camera::unmapBuffers() {
+    for (const Mapping &mapping : mappings) {
+        munmap(mapping.data, mapping.length);
     }
+    mappings.clear();
+    planeData.clear();
+}
 
-    jpeg_finish_compress(&cinfo);
-    fclose(outfile);
-    jpeg_destroy_compress(&cinfo);
-    
-    std::cout << "[Camera] Saved JPEG: " << filename << std::endl;
+// Describes a mapped buffer using the geometry of the active configuration
+imaging::FrameView Camera::frameView(const FrameBuffer *buffer) {
+    const std::vector<uint8_t*> &planes = planeData.at(buffer);
+
+    StreamConfiguration &streamConfig = config->at(0);
+    imaging::FrameView frame;
+    frame.layout = pixelLayout;
+    frame.width = streamConfig.size.width;
+    frame.height = streamConfig.size.height;
+    frame.planes[0] = planes[0];
+    frame.strides[0] = streamConfig.stride; // Crucial! Memory width != Image width
+
+    if (pixelLayout == imaging::PixelLayout::YUV420) {
+        // Chroma planes are half width: stride / 2
+        frame.strides[1] = frame.strides[2] = streamConfig.stride / 2;
+        if (planes.size() >= 3) {
+            frame.planes[1] = planes[1];
+            frame.planes[2] = planes[2];
+        } else {
+            // Single-plane buffer: U follows Y, V follows U
+            frame.planes[1] = frame.planes[0] + static_cast<size_t>(frame.strides[0]) * frame.height;
+            frame.planes[2] = frame.planes[1] + static_cast<size_t>(frame.strides[1]) * ((frame.height + 1) / 2);
+        }
+    }
+    return frame;
 }
 
-// Memory Mapping
-// We have to map the Kernel's memory (DMA) into our User Space to read it.
-void Camera::saveBufferToFile(const std::string& filepath, FrameBuffer *buffer) {
-    const FrameBuffer::Plane &plane = buffer->planes()[0];
-    int fd = plane.fd.get();
-    size_t length = plane.length;
-    
-    void *data = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
-    if (data == MAP_FAILED) {
-        std::cerr << "[Camera] mmap failed!" << std::endl;
-        return;
+// Writes the mapped Bayer buffer to disk in one atomic write() straight from the
+// DMA mapping (no unpacking, no copy in user space), then writes the sidecar.
+// Rows keep their stride padding: the sidecar records the stride.
+bool Camera::saveRawBuffer(const std::string& filepath, const Request *request) {
+    const StreamConfiguration &rawConfig = config->at(1);
+    const FrameBuffer *buffer = request->buffers().at(rawStream);
+    const uint8_t *data = planeData.at(buffer)[0];
+    const size_t length = static_cast<size_t>(rawConfig.stride) * rawConfig.size.height;
+
+    utils::WriteStats stats;
+    if (!utils::writeFileAtomic(filepath, data, length, &stats)) return false;
+
+    // Sidecar: what develop needs to read the dump back
+    imaging::RawInfo info;
+    imaging::parseRawFormat(rawConfig.pixelFormat.toString(), info);
+    info.width = static_cast<int>(rawConfig.size.width);
+    info.height = static_cast<int>(rawConfig.size.height);
+    info.stride = static_cast<int>(rawConfig.stride);
+    if (auto model = camera->properties().get(properties::Model)) info.model = *model;
+
+    const AeMetadata ae = readAeMetadata(request);
+    info.exposureTime = ae.exposureTime;
+    info.analogueGain = ae.analogueGain;
+    if (ae.colourGainR > 0.0f && ae.colourGainB > 0.0f) {
+        info.colourGains[0] = ae.colourGainR;
+        info.colourGains[1] = ae.colourGainB;
     }
+    info.lux = ae.lux;
 
-    // Get dimensions from the active configuration
-    StreamConfiguration &streamConfig = config->at(0);
-    int width = streamConfig.size.width;
-    int height = streamConfig.size.height;
-    int stride = streamConfig.stride; // Crucial! Memory width != Image width
+    const ControlList &metadata = request->metadata();
+    if (auto levels = metadata.get(controls::SensorBlackLevels)) info.blackLevel = (*levels)[0];
+    if (auto ccm = metadata.get(controls::ColourCorrectionMatrix)) {
+        for (int i = 0; i < 9; ++i) info.ccm[i] = (*ccm)[i];
+    }
+    if (auto timestamp = metadata.get(controls::SensorTimestamp)) info.timestampNs = *timestamp;
+
+    std::string sidecar = std::filesystem::path(filepath).replace_extension(".json").string();
+    if (!imaging::writeRawInfo(sidecar, info)) return false;
+
+    std::cout << "[Camera] RAW " << info.format << " " << info.width << "x" << info.height
+              << " saved (" << stats.bytes << " bytes, write " << stats.writeMs << " ms)." << std::endl;
+    return true;
+}
+
+bool Camera::saveBufferToFile(const std::string& filepath, FrameBuffer *buffer) {
+    return saveFrame(filepath, frameView(buffer));
+}
+
+bool Camera::saveFrame(const std::string& filepath, const imaging::FrameView& frame) {
+    HORUS_TRACE_SCOPE("camera.save");
+
+    // Scene check: against the last frame saved in full, before any encode
+    imaging::SceneVerdict verdict = imaging::SceneVerdict::New;
+    imaging::SceneSignature signature;
+    imaging::SceneDistance distance;
+    std::string reference;
+    const std::string signaturePath = utils::getDataRoot() + "/.scene_" + name() + ".json";
+    if (scene.policy != imaging::ScenePolicy::Off) {
+        HORUS_TRACE_SCOPE("camera.scene");
+        imaging::computeSignature(frame, signature);
+        imaging::SceneSignature previous;
+        const bool known = imaging::loadSignature(signaturePath, previous, &reference);
+        verdict = imaging::compareScenes(known ? &previous : nullptr, signature, scene, &distance);
+        if (verdict != imaging::SceneVerdict::New) {
+            std::cout << "[Camera] Scene " << imaging::sceneVerdictName(verdict) << " (hash " << distance.hashBits
+                      << " bits, histogram " << distance.histogram << ", mean " << signature.meanLuma << "): "
+                      << imaging::scenePolicyName(scene.policy) << "." << std::endl;
+        }
+        if (verdict != imaging::SceneVerdict::New && scene.policy == imaging::ScenePolicy::Skip) return true;
+        if (verdict != imaging::SceneVerdict::New && scene.policy == imaging::ScenePolicy::Thumbnail) {
+            return saveThumbnail(filepath, frame);
+        }
+    }
 
     // Compress!
-    saveJpeg(filepath, data, width, height, stride);
+    bool saved = false;
+    if (!rois.empty()) {
+        saved = saveRois(filepath, frame);
+    } else if (previewLevels > 0) {
+        saved = saveWithPreviews(filepath, frame);
+    } else {
+        saved = saveJpegFile(filepath, frame);
+    }
 
-    munmap(data, length);
+    if (saved && detectMarkers) writeMarkerSidecar(filepath, frame);
+
+    // Flagged duplicates keep the old reference, so a slow drift still ends up "new"
+    if (saved && scene.policy != imaging::ScenePolicy::Off) {
+        if (verdict == imaging::SceneVerdict::New) {
+            imaging::saveSignature(signaturePath, signature, filepath);
+        } else {
+            imaging::writeDuplicateFlag(filepath, verdict, distance, reference);
+        }
+    }
+    return saved;
+}
+
+// Only the smallest preview, "<image>_p8.jpg", for a frame not worth a full picture
+bool Camera::saveThumbnail(const std::string& filepath, const imaging::FrameView& frame) {
+    std::vector<imaging::PyramidLevel> levels;
+    if (!imaging::encodePyramid(frame, 3, levels) || levels.empty()) return false;
+    levels.erase(levels.begin(), levels.end() - 1);
+    return imaging::writePyramid(filepath, levels);
+}
+
+// One full-detail JPEG: size-budgeted, strip-parallel or single-threaded
+bool Camera::saveJpegFile(const std::string& filepath, const imaging::FrameView& frame) {
+    if (budgetedJpeg()) return imaging::saveJpegBudgeted(filepath, frame, rateControl, encoderPool.get());
+    if (encoderPool && encoderPool->size() > 1) return imaging::saveJpegParallel(filepath, frame, *encoderPool);
+    return imaging::saveJpeg(filepath, frame);
+}
+
+// Every region at full detail, cut out of the mapped frame without a copy, then the
+// whole capture at 1/2^contextLevels under 'filepath' to show where they were taken.
+// With a pool the context (the last level of a preview pyramid) takes one worker
+// while the regions' strips share the rest.
+bool Camera::saveRois(const std::string& filepath, const imaging::FrameView& frame) {
+    HORUS_TRACE_SCOPE("camera.roi");
+    auto start = std::chrono::steady_clock::now();
+    std::vector<imaging::PyramidLevel> levels;
+    std::future<bool> pyramid;
+    const bool pooled = encoderPool && encoderPool->size() > 1;
+    if (pooled) pyramid = encoderPool->submit([&] { return imaging::encodePyramid(frame, contextLevels, levels); });
+
+    // 1. Regions, placed in the part of the field the frame covers
+    bool ok = true;
+    size_t pixels = 0;
+    for (const imaging::Roi &roi : rois) {
+        const imaging::PixelRect rect =
+            imaging::roiToPixels(imaging::roiWithin(roi, capturedField), frame.width, frame.height);
+        imaging::FrameView crop;
+        if (rect.width == 0 || rect.height == 0 || !imaging::cropFrame(frame, rect, crop)) {
+            std::cerr << "[Camera] ROI " << roi.name << " is outside the captured field." << std::endl;
+            ok = false;
+            continue;
+        }
+        ok = saveJpegFile(imaging::roiPath(filepath, roi.name), crop) && ok;
+        pixels += static_cast<size_t>(rect.width) * rect.height;
+    }
+
+    // 2. Context frame ('frame' must stay mapped until the job is done)
+    const bool context = pooled ? pyramid.get() : imaging::encodePyramid(frame, contextLevels, levels);
+    if (!context || levels.empty()) return false;
+    const imaging::PyramidLevel &smallest = levels.back();
+    ok = utils::writeFileAtomic(filepath, smallest.jpeg.data(), smallest.jpeg.size()) && ok;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Camera] " << rois.size() << " ROI(s) = "
+              << pixels * 100 / (static_cast<size_t>(frame.width) * frame.height) << " % of the "
+              << frame.width << "x" << frame.height << " frame, + " << smallest.width << "x" << smallest.height
+              << " context in " << ms << " ms." << std::endl;
+    return ok;
+}
+
+// Full JPEG + preview pyramid. Single-threaded, both come out of the same pass over
+// the frame; with a pool, the pyramid takes one worker while the strips share the rest.
+bool Camera::saveWithPreviews(const std::string& filepath, const imaging::FrameView& frame) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<imaging::PyramidLevel> levels;
+    bool saved = false;
+    bool previews = false;
+
+    if (encoderPool && encoderPool->size() > 1) {
+        // Queued before the strips, so it starts first and finishes with them
+        auto pyramid = encoderPool->submit([&] { return imaging::encodePyramid(frame, previewLevels, levels); });
+        saved = budgetedJpeg() ? imaging::saveJpegBudgeted(filepath, frame, rateControl, encoderPool.get())
+                               : imaging::saveJpegParallel(filepath, frame, *encoderPool);
+        previews = pyramid.get(); // 'frame' must stay mapped until the job is done
+    } else if (budgetedJpeg()) {
+        // The quality is only known after the probes: no shared pass with the previews
+        previews = imaging::encodePyramid(frame, previewLevels, levels);
+        saved = previews && imaging::saveJpegBudgeted(filepath, frame, rateControl);
+    } else {
+        static thread_local std::vector<uint8_t> buffer;
+        previews = imaging::encodePyramid(frame, previewLevels, levels, 80, &buffer);
+        saved = previews && utils::writeFileAtomic(filepath, buffer.data(), buffer.size());
+    }
+
+    // Previews only exist next to a full picture
+    if (saved && previews) imaging::writePyramid(filepath, levels);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Camera] JPEG + " << levels.size() << " preview(s) in " << ms << " ms." << std::endl;
+    return saved;
+}
+
+// Markers are looked for on the frame still in memory: a missing or occluded one is
+// reported now, not when someone opens the picture in the cloud days later
+void Camera::writeMarkerSidecar(const std::string& filepath, const imaging::FrameView& frame) {
+    HORUS_TRACE_SCOPE("camera.markers");
+    auto start = std::chrono::steady_clock::now();
+
+    imaging::LumaImage luma;
+    imaging::downscaleLuma(frame, markerScale, luma);
+    std::vector<imaging::MarkerDetection> markers = imaging::detectMarkers(luma, markerDictionary);
+
+    std::string sidecar = std::filesystem::path(filepath).replace_extension(".aruco.json").string();
+    imaging::writeMarkersJson(sidecar, markers, markerDictionary);
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (markers.empty()) {
+        std::cerr << "[Camera] WARNING: No marker visible (" << ms << " ms)." << std::endl;
+    } else {
+        std::cout << "[Camera] " << markers.size() << " marker(s), first id " << markers[0].id
+                  << " (" << ms << " ms)." << std::endl;
+    }
 }
 
-} // namespace horus
\ No newline at end of file
+} // namespace horus
@@ -5,45 +5,149 @@
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <deque>
+#include <map>
 #include <string>
+#include <functional>
+#include "imaging/Frame.hpp"
+#include "imaging/TemporalDenoise.hpp"
+#include "imaging/ArucoDetector.hpp"
+#include "imaging/JpegRateControl.hpp"
+#include "imaging/Roi.hpp"
+#include "utils/ThreadPool.hpp"
+#include "AeConvergence.hpp"
+#include "CameraOptions.hpp"
+#include "FrameSource.hpp"
 
 namespace horus {
 
 using namespace libcamera;
 
-class Camera {
+// libcamera allows one CameraManager per process: every Camera of a multi-camera
+// capture shares this one (started, stopped once the last Camera lets go of it)
+std::shared_ptr<CameraManager> startCameraManager();
+
+class Camera : public FrameSource {
 public:
+    // The first camera found, with its own CameraManager
     Camera();
+    // Camera 'index' of a shared manager. With an 'encoderPool' the JPEGs go to that pool
+    // (shared with other cameras) and CameraOptions::encoderThreads is ignored.
+    Camera(std::shared_ptr<CameraManager> manager, size_t index,
+           std::shared_ptr<utils::ThreadPool> encoderPool = nullptr);
     ~Camera();
 
+    // "cam<index>"
+    std::string name() const override;
+
+    // Frame buffers + CPU copies at the sensor's full resolution
+    size_t memoryEstimate(const CameraOptions& options) const override;
+
     // Setup the camera hardware
-    bool start();
+    bool start(const CameraOptions& options = CameraOptions()) override;
     
     // The main blocking call: Takes a photo and saves raw data
+    // (in RAW mode 'filepath' gets the Bayer dump, the sidecar goes next to it as .json)
     // Returns true on success
-    bool capture(const std::string& filepath);
+    bool capture(const std::string& filepath) override;
+
+    // HDR: after warm-up, shoots one frame per EV offset (e.g. -2, 0, +2) with manual
+    // ExposureTime / AnalogueGain, fuses them on the CPU and writes a single JPEG.
+    bool captureHdr(const std::string& filepath, const std::vector<float>& evOffsets);
 
     // Shutdown
-    void stop();
+    void stop() override;
 
 private:
-    std::unique_ptr<CameraManager> cm;
+    std::shared_ptr<CameraManager> cm;
+    size_t cameraIndex = 0;
+    bool sharedPool = false; // encoderPool given by the owner, kept across start()
     std::shared_ptr<libcamera::Camera> camera;
     std::unique_ptr<CameraConfiguration> config;
     std::unique_ptr<FrameBufferAllocator> allocator;
-    std::vector<std::unique_ptr<Request>> requests;
-    std::unique_ptr<Request> request;
+    Stream *rawStream = nullptr; // Set in RAW mode only
+    std::vector<std::unique_ptr<Request>> requests; // One per buffer, all queued while streaming
+    imaging::PixelLayout pixelLayout = imaging::PixelLayout::BGR888;
+    std::shared_ptr<utils::ThreadPool> encoderPool; // Null when encoding single-threaded
+    ConvergenceOptions convergence;
+    int denoiseFrames = 0;
+    imaging::DenoiseMode denoiseMode = imaging::DenoiseMode::Average;
+    bool detectMarkers = false;
+    int markerScale = 4;
+    imaging::MarkerDictionary markerDictionary;
+    int previewLevels = 0;
+    imaging::RateControlOptions rateControl;
+    std::vector<imaging::Roi> rois;
+    imaging::SceneOptions scene;
+    int contextLevels = 3;           // Pyramid depth of the context frame (1/8)
+    imaging::Roi capturedField;      // Part of the sensor field the stream covers
+    Rectangle sensorCrop;            // ScalerCrop sent with the requests (width 0 = none)
+    Rectangle cropMaximum;           // ScalerCropMaximum: the sensor field in ScalerCrop units
+
+    // Persistent CPU mappings of the DMA buffers: made once in start(), dropped in stop()
+    struct Mapping {
+        uint8_t* data;
+        size_t length;
+    };
+    std::vector<Mapping> mappings;
+    std::map<const FrameBuffer*, std::vector<uint8_t*>> planeData; // Per buffer, per plane
 
     // Concurrency tools to wait for the hardware
     std::mutex cameraMutex;
     std::condition_variable cameraCv;
-    bool requestComplete = false;
+    std::deque<Request*> completedRequests; // Filled by libcamera's thread, drained by capture()
 
     // The callback function called by libcamera when image is ready
     void requestCompleteHandler(Request *request);
-    
+
+    // Bracket limits: long shutters blur leaves in the wind, high gain is noisy
+    static constexpr float kMaxBracketExposureUs = 100000.0f;
+    static constexpr float kMaxBracketGain = 8.0f;
+    static constexpr int kMaxBracketFrames = 12; // Frames to wait for new controls to apply
+    static constexpr int kMaxMedianFrames = 5;   // Each one is a full-res copy
+
+    // Called by warmUp() for every frame with the length of the current stable run
+    // (0 = this frame starts a new run, anything gathered so far is stale)
+    using WarmUpSink = std::function<void(const Request *request, int stableRun)>;
+
+    // capture() when denoiseFrames > 1
+    bool captureDenoised(const std::string& filepath);
+
+    // capture() in RAW mode
+    bool captureRawFrame(const std::string& filepath);
+    bool saveRawBuffer(const std::string& filepath, const Request *request);
+
+    // Streaming helpers shared by capture() and captureHdr()
+    bool startStreaming();
+    Request* warmUp(int minRunFrames = 0, const WarmUpSink& sink = WarmUpSink());
+    void requeue(Request *request);
+
+    // Blocks until the next completed request (nullptr on timeout)
+    Request* waitForRequest();
+
+    // Pulls the AE/AWB results out of a completed request
+    static AeMetadata readAeMetadata(const Request *request);
+
+    // ROIs: sensor-side crop to their bounding box (start()), then the crop actually
+    // applied, from a frame's metadata
+    void configureSensorCrop();
+    void updateCapturedField(const Request *request);
+
     // Helper to map hardware memory to CPU memory
-    void saveBufferToFile(const std::string& filepath, FrameBuffer *buffer);
+    bool mapBuffers(Stream *stream);
+    void unmapBuffers();
+    imaging::FrameView frameView(const FrameBuffer *buffer);
+    bool saveBufferToFile(const std::string& filepath, FrameBuffer *buffer);
+    bool saveFrame(const std::string& filepath, const imaging::FrameView& frame);
+    bool saveWithPreviews(const std::string& filepath, const imaging::FrameView& frame);
+    bool saveRois(const std::string& filepath, const imaging::FrameView& frame);
+    bool saveJpegFile(const std::string& filepath, const imaging::FrameView& frame);
+    bool saveThumbnail(const std::string& filepath, const imaging::FrameView& frame);
+    // Size budget, custom tables or optimized Huffman: the full JPEG goes through saveJpegBudgeted()
+    bool budgetedJpeg() const {
+        return rateControl.targetBytes > 0 || rateControl.base.optimizeCoding || !rateControl.base.quantTables.empty();
+    }
+    void writeMarkerSidecar(const std::string& filepath, const imaging::FrameView& frame);
 };
 
 } // namespace horus
\ No newline at end of file
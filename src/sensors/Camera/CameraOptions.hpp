@@ -0,0 +1,77 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include "imaging/Frame.hpp"
+#include "imaging/TemporalDenoise.hpp"
+#include "imaging/JpegRateControl.hpp"
+#include "imaging/Roi.hpp"
+#include "imaging/SceneSignature.hpp"
+#include "AeConvergence.hpp"
+
+namespace horus {
+
+// Options chosen by the caller before start()
+struct CameraOptions {
+    // BGR888 : legacy path, CPU swaps to RGB and libjpeg converts + downsamples.
+    // YUV420 : the ISP outputs planar YCbCr 4:2:0 which goes straight into libjpeg.
+    //          Falls back to BGR888 if the pipeline refuses the format.
+    imaging::PixelLayout pixelLayout = imaging::PixelLayout::BGR888;
+
+    // JPEG encoder workers. 0 = one per core (strip-parallel), 1 = single-threaded.
+    unsigned encoderThreads = 0;
+
+    // Frame buffers (and requests) kept in flight while streaming.
+    // More buffers = the sensor never waits for us, at the cost of CMA memory
+    // (a full-res BGR888 frame is ~36 MB, YUV420 ~18 MB).
+    unsigned bufferCount = 3;
+
+    // Warm-up stops as soon as AE/AWB metadata is stable (bounded by maxFrames)
+    ConvergenceOptions convergence;
+
+    // Temporal denoise: capture() combines the last N frames of the converged
+    // warm-up run instead of saving a single one. 0 or 1 = off.
+    // Average needs one 16-bit accumulator and no frame copies, so the averaged
+    // run may be longer than N (at least stableFrames + 1 frames);
+    // Median keeps copies of exactly the last N frames (capped at kMaxMedianFrames).
+    int denoiseFrames = 0;
+    imaging::DenoiseMode denoiseMode = imaging::DenoiseMode::Average;
+
+    // RAW mode: a Raw stream is configured next to the still, and capture() writes the
+    // Bayer buffer straight from its mapping to disk (+ a JSON sidecar) with no CPU
+    // processing. `--task develop` turns the dumps into JPEG / DNG later.
+    bool captureRaw = false;
+
+    // ArUco / AprilTag check on every saved JPEG: a 1/markerScale luma plane is built
+    // from the frame and the markers go to a "<stem>.aruco.json" sidecar (img.jpg -> img.aruco.json).
+    // Empty dictionary path = built-in tag36h11.
+    bool detectMarkers = false;
+    int markerScale = 4;
+    std::string markerDictionary;
+
+    // Preview pyramid: N levels (1/2, 1/4, 1/8 ...) saved next to every JPEG as
+    // "<image>_p2.jpg" etc., built in the same pass over the frame as the full encode,
+    // so uploads can send the small files first. 0 = off.
+    int previewLevels = 0;
+
+    // JPEG size budget (rateControl.targetBytes, 0 = fixed quality 90), custom
+    // quantization tables and optimized Huffman coding (rateControl.base)
+    imaging::RateControlOptions rateControl;
+
+    // Regions of interest: each one is saved at full detail as "<image>_<name>.jpg",
+    // and the image itself becomes a 1/contextScale context frame of the whole capture
+    // (2, 4, 8 or 16; previews are not made). With roiSensorCrop the ISP only
+    // delivers the regions' bounding box (ScalerCrop + a stream of that size);
+    // without it, or if the camera has no ScalerCrop, the full field is captured and
+    // the regions are cut out of the mapped buffer without a copy. RAW mode ignores them.
+    std::vector<imaging::Roi> rois;
+    bool roiSensorCrop = true;
+    int contextScale = 8;
+
+    // Scene check before the encode: a frame that looks like the last one saved in full
+    // (perceptual hash + luma histogram, kept in "<DataCapture>/.scene_<camera>.json"),
+    // or that is black, is skipped, saved as a thumbnail only, or flagged for the uploader
+    imaging::SceneOptions scene;
+};
+
+} // namespace horus
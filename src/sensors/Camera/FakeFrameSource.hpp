@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include "FrameSource.hpp"
+#include "imaging/Frame.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace horus {
+
+// Camera stand-in for the multi-camera capture off the device. start() allocates and
+// fills the frame buffers a stream of that size would hold, capture() "warms up" for
+// warmupMs (sleeping, like the real warm-up waits on the sensor) and saves a synthetic
+// frame through the encoder pool it was given. The bytes all fakes hold are counted,
+// so a test can check the real peak against the memory budget.
+class FakeFrameSource : public FrameSource {
+public:
+    struct Settings {
+        std::string name = "cam0";
+        int width = 4056;   // 12 MP, like the HQ camera
+        int height = 3040;
+        int warmupMs = 800; // AE/AWB convergence of a bright scene
+    };
+
+    explicit FakeFrameSource(const Settings& settings, std::shared_ptr<utils::ThreadPool> encoderPool = nullptr);
+
+    std::string name() const override { return settings.name; }
+    size_t memoryEstimate(const CameraOptions& options) const override;
+    bool start(const CameraOptions& options) override;
+    bool capture(const std::string& filepath) override;
+    void stop() override;
+
+    // Bytes held by all fakes right now, and the most ever held at once
+    static size_t liveBytes();
+    static size_t peakBytes();
+    static void resetPeak();
+
+private:
+    Settings settings;
+    std::shared_ptr<utils::ThreadPool> encoderPool;
+    std::vector<imaging::OwnedFrame> buffers;
+    size_t heldBytes = 0;
+
+    void hold(size_t bytes);
+};
+
+} // namespace horus
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <algorithm>
+#include "CameraOptions.hpp"
+
+namespace horus {
+
+// What the multi-camera capture drives: the libcamera Camera on the device,
+// FakeFrameSource anywhere else (same start / capture / stop cycle as the capture task)
+class FrameSource {
+public:
+    virtual ~FrameSource() = default;
+
+    // Short name, the suffix of its files ("cam0")
+    virtual std::string name() const = 0;
+
+    // Upper bound of the memory a start() + capture() with 'options' holds at once
+    virtual size_t memoryEstimate(const CameraOptions& options) const = 0;
+
+    virtual bool start(const CameraOptions& options) = 0;
+    virtual bool capture(const std::string& filepath) = 0;
+    virtual void stop() = 0;
+};
+
+// Memory of one capture of a width x height sensor: the stream's frame buffers (plus the
+// Bayer ones in RAW mode), the CPU copies of the denoiser and the compressed output
+inline size_t captureMemoryBytes(const CameraOptions& options, int width, int height) {
+    const size_t pixels = static_cast<size_t>(width) * height;
+    const size_t frame = options.pixelLayout == imaging::PixelLayout::BGR888 ? pixels * 3 : pixels * 3 / 2;
+    size_t bytes = std::max(1u, options.bufferCount) * frame;
+    if (options.captureRaw) return bytes + std::max(1u, options.bufferCount) * pixels * 2;
+
+    if (options.denoiseFrames > 1) {
+        // Median: the last N frames (at most 5) + the result; average: a 16-bit accumulator + the result
+        bytes += options.denoiseMode == imaging::DenoiseMode::Median
+               ? (static_cast<size_t>(std::min(options.denoiseFrames, 5)) + 1) * frame
+               : 3 * frame;
+    }
+    return bytes + frame / 4; // JPEG output, previews and ROIs included
+}
+
+} // namespace horus
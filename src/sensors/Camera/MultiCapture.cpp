@@ -0,0 +1,58 @@
+#include "MultiCapture.hpp"
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include "utils/Trace.hpp"
+
+namespace horus {
+
+std::vector<SourceCapture> captureAll(const std::vector<FrameSource*>& sources, const CameraOptions& options,
+                                      const std::string& prefix, const std::string& extension,
+                                      utils::MemoryBudget& budget) {
+    std::vector<SourceCapture> results(sources.size());
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        threads.emplace_back([&, i] {
+            FrameSource &source = *sources[i];
+            SourceCapture &result = results[i];
+            result.name = source.name();
+            result.path = prefix + "_" + result.name + extension;
+            utils::setTraceThreadName(result.name);
+
+            // 1. Wait until its frames fit next to the others'
+            auto queued = std::chrono::steady_clock::now();
+            {
+                HORUS_TRACE_SCOPE("multicam.wait_memory");
+                result.reservedBytes = budget.acquire(source.memoryEstimate(options));
+            }
+            auto started = std::chrono::steady_clock::now();
+            result.waitMs = std::chrono::duration<double, std::milli>(started - queued).count();
+
+            // 2. The same cycle as the capture task
+            {
+                HORUS_TRACE_SCOPE("multicam.capture");
+                if (!source.start(options)) {
+                    std::cerr << "[MultiCam] " << result.name << ": init failed." << std::endl;
+                } else {
+                    result.ok = source.capture(result.path);
+                }
+                source.stop();
+            }
+            budget.release(result.reservedBytes);
+            result.captureMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+
+    for (const SourceCapture &result : results) {
+        std::cout << "[MultiCam] " << result.name << ": " << (result.ok ? "OK" : "FAILED") << " in "
+                  << result.captureMs << " ms (waited " << result.waitMs << " ms for "
+                  << result.reservedBytes / (1024 * 1024) << " MB) -> " << result.path << std::endl;
+    }
+    std::cout << "[MultiCam] Peak reserved " << budget.peak() / (1024 * 1024) << " of "
+              << budget.capacity() / (1024 * 1024) << " MB." << std::endl;
+    return results;
+}
+
+} // namespace horus
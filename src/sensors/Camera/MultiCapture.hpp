@@ -0,0 +1,29 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include "FrameSource.hpp"
+#include "utils/MemoryBudget.hpp"
+
+namespace horus {
+
+struct SourceCapture {
+    std::string name;
+    std::string path;
+    bool ok = false;
+    size_t reservedBytes = 0;
+    double waitMs = 0.0;    // Queued for memory
+    double captureMs = 0.0; // start() + capture() + stop()
+};
+
+// Every source on its own thread: the warm-ups run side by side and the frames go to
+// the encoder pool the sources share. Before start() a source reserves its
+// memoryEstimate() from 'budget', and gives it back after stop(), so what the sources
+// hold together stays within the budget: one that doesn't fit waits for another to finish.
+// Files: "<prefix>_<name><extension>" ("img_<time>_cam0.jpg").
+std::vector<SourceCapture> captureAll(const std::vector<FrameSource*>& sources, const CameraOptions& options,
+                                      const std::string& prefix, const std::string& extension,
+                                      utils::MemoryBudget& budget);
+
+} // namespace horus
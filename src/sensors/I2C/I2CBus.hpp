@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace horus {
+
+// One register block to read: 'length' bytes from 'reg' on (auto-increment)
+struct I2CRead {
+    uint8_t reg;
+    uint8_t* buffer;
+    int length;
+};
+
+// What a register-based I2C device driver needs from a bus.
+// Backends: LinuxI2CBus (/dev/i2c-N) on the device, SimulatedBME280 off it.
+class I2CBus {
+public:
+    virtual ~I2CBus() = default;
+
+    // Register reads, all in ONE combined transaction when the backend can
+    // (address write + read with a repeated start for each block)
+    virtual bool read(uint8_t address, const I2CRead* reads, int count) = 0;
+
+    // Raw write transaction (register address followed by data, or reg/value pairs)
+    virtual bool write(uint8_t address, const uint8_t* data, int length) = 0;
+
+    // Stable name for per-bus state such as calibration caches ("i2c-1").
+    // Empty = nothing worth caching (simulated buses).
+    virtual std::string name() const = 0;
+
+    // Convenience: a single register block
+    bool readRegs(uint8_t address, uint8_t reg, uint8_t* buffer, int length) {
+        I2CRead block = { reg, buffer, length };
+        return read(address, &block, 1);
+    }
+};
+
+} // namespace horus
@@ -0,0 +1,78 @@
+#include "LinuxI2CBus.hpp"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "utils/Trace.hpp"
+
+namespace horus {
+
+LinuxI2CBus::LinuxI2CBus(int busId) : busId(busId) {}
+
+LinuxI2CBus::~LinuxI2CBus() {
+    if (fd >= 0) close(fd);
+}
+
+std::string LinuxI2CBus::name() const {
+    return "i2c-" + std::to_string(busId);
+}
+
+bool LinuxI2CBus::open() {
+    std::string filename = "/dev/i2c-" + std::to_string(busId);
+    if ((fd = ::open(filename.c_str(), O_RDWR | O_CLOEXEC)) < 0) {
+        std::cerr << "[I2C] Failed to open I2C bus: " << filename << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    // Combined write+read transactions need a plain-I2C adapter (the Pi's is)
+    unsigned long funcs = 0;
+    combinedTransfers = ioctl(fd, I2C_FUNCS, &funcs) == 0 && (funcs & I2C_FUNC_I2C);
+    return true;
+}
+
+bool LinuxI2CBus::select(uint8_t address) {
+    if (selectedAddress == address) return true;
+    if (ioctl(fd, I2C_SLAVE, address) < 0) {
+        std::cerr << "[I2C] Failed to acquire bus access (0x" << std::hex << (int)address << std::dec << ")." << std::endl;
+        return false;
+    }
+    selectedAddress = address;
+    return true;
+}
+
+bool LinuxI2CBus::read(uint8_t address, const I2CRead* reads, int count) {
+    HORUS_TRACE_SCOPE("i2c.read");
+    if (fd < 0 || count <= 0) return false;
+
+    if (combinedTransfers && count <= kMaxReads) {
+        // Register address + read with a repeated start per block: one ioctl, one transaction
+        struct i2c_msg msgs[2 * kMaxReads];
+        uint8_t regs[kMaxReads];
+        for (int i = 0; i < count; ++i) {
+            regs[i] = reads[i].reg;
+            msgs[2 * i] = { address, 0, 1, &regs[i] };
+            msgs[2 * i + 1] = { address, I2C_M_RD, static_cast<uint16_t>(reads[i].length), reads[i].buffer };
+        }
+        struct i2c_rdwr_ioctl_data transfer = { msgs, static_cast<uint32_t>(2 * count) };
+        return ioctl(fd, I2C_RDWR, &transfer) == 2 * count;
+    }
+
+    if (!select(address)) return false;
+    for (int i = 0; i < count; ++i) {
+        if (::write(fd, &reads[i].reg, 1) != 1) return false;                           // Ask for register
+        if (::read(fd, reads[i].buffer, reads[i].length) != reads[i].length) return false; // Read response
+    }
+    return true;
+}
+
+bool LinuxI2CBus::write(uint8_t address, const uint8_t* data, int length) {
+    HORUS_TRACE_SCOPE("i2c.write");
+    if (fd < 0 || !select(address)) return false;
+    return ::write(fd, data, length) == length;
+}
+
+} // namespace horus
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "I2CBus.hpp"
+
+namespace horus {
+
+// i2c-dev backend. Uses I2C_RDWR (one ioctl, repeated starts) when the adapter
+// supports plain I2C transfers, otherwise I2C_SLAVE + write()/read() per block.
+class LinuxI2CBus : public I2CBus {
+public:
+    explicit LinuxI2CBus(int busId = 1);
+    ~LinuxI2CBus() override;
+
+    LinuxI2CBus(const LinuxI2CBus&) = delete;
+    LinuxI2CBus& operator=(const LinuxI2CBus&) = delete;
+
+    // Opens /dev/i2c-<busId>
+    bool open();
+
+    bool read(uint8_t address, const I2CRead* reads, int count) override;
+    bool write(uint8_t address, const uint8_t* data, int length) override;
+    std::string name() const override;
+
+private:
+    static const int kMaxReads = 8; // Blocks per combined transaction
+
+    int busId;
+    int fd = -1;
+    bool combinedTransfers = false;
+    int selectedAddress = -1; // Last I2C_SLAVE address
+
+    bool select(uint8_t address);
+};
+
+} // namespace horus
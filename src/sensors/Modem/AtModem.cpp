@@ -0,0 +1,312 @@
+#include "AtModem.hpp"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+namespace horus {
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool startsWith(const std::string& text, const char* prefix) {
+    return text.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+// "+CEREG" for "AT+CEREG?" and "AT+CGPSINFO" (read / action commands answer with
+// their own name); empty for set commands and basic ones ("AT+CFUN=1", "ATE0")
+std::string queryName(const std::string& cmd) {
+    if (!startsWith(cmd, "AT+") || cmd.find('=') != std::string::npos) return "";
+    std::string name = cmd.substr(2);
+    if (!name.empty() && name.back() == '?') name.pop_back();
+    return name;
+}
+
+std::vector<std::string> splitFields(const std::string& text) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    for (;;) {
+        size_t comma = text.find(',', start);
+        fields.push_back(text.substr(start, comma - start));
+        if (comma == std::string::npos) return fields;
+        start = comma + 1;
+    }
+}
+
+// Without a URC, the state is asked for again after this long (firmware that does
+// not report, or a report lost while the port was closed)
+const int kRequeryMs = 2000;
+
+bool registered(AtRegistration stat) {
+    return stat == AtRegistration::Home || stat == AtRegistration::Roaming;
+}
+
+} // namespace
+
+AtModem::AtModem(const std::string& device) : device(device) {}
+
+AtModem::~AtModem() {
+    close();
+}
+
+bool AtModem::open(int waitMs) {
+    close();
+    const int64_t deadline = nowMs() + std::max(waitMs, 0);
+
+    // 1. The node shows up once USB re-enumerates after a reset; then it must be ours
+    // alone (a second writer would interleave commands)
+    for (;;) {
+        struct stat st;
+        if (stat(device.c_str(), &st) == 0) {
+            fd = ::open(device.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+            if (fd >= 0 && flock(fd, LOCK_EX | LOCK_NB) == 0) break;
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+        if (nowMs() >= deadline) {
+            std::cerr << "[Modem] ERROR: Could not open " << device << ": "
+                      << (errno == EWOULDBLOCK ? "in use" : std::strerror(errno)) << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // 2. 115200 8N1, raw, no flow control, reads never block (poll() does the waiting)
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, B115200);
+        cfsetospeed(&tio, B115200);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~CRTSCTS;
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    tcflush(fd, TCIOFLUSH); // Stale answers of a previous session
+    pending.clear();
+    return true;
+}
+
+void AtModem::close() {
+    if (fd >= 0) ::close(fd); // Drops the flock
+    fd = -1;
+}
+
+bool AtModem::readLine(std::string& line, int64_t deadlineMs) {
+    for (;;) {
+        // 1. A complete line already buffered (CR, LF or both end it)
+        size_t end = pending.find_first_of("\r\n");
+        while (end != std::string::npos) {
+            line = pending.substr(0, end);
+            pending.erase(0, end + 1);
+            if (!line.empty()) return true;
+            end = pending.find_first_of("\r\n");
+        }
+
+        // 2. Wait for more
+        const int64_t left = deadlineMs - nowMs();
+        if (left <= 0 || fd < 0) return false;
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int ready = poll(&pfd, 1, static_cast<int>(std::min<int64_t>(left, 60000)));
+        if (ready < 0 && errno != EINTR) return false;
+        if (ready <= 0) continue;
+        if (pfd.revents & (POLLERR | POLLNVAL)) return false;
+        char buffer[256];
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n > 0) {
+            pending.append(buffer, static_cast<size_t>(n));
+        } else if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+            // Hang-up (modem reset, USB gone): nothing more will come before the deadline
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<int64_t>(left, 50)));
+        }
+    }
+}
+
+bool AtModem::handleLine(const std::string& line, const std::string& query) {
+    const size_t colon = line.find(": ");
+    if (colon == std::string::npos || line[0] != '+') return false;
+    const std::string name = line.substr(0, colon);
+    const bool solicited = name == query;
+
+    // 1. Registration: URC "+CEREG: <stat>[,...]", read answer "+CEREG: <n>,<stat>[,...]"
+    if (name == "+CREG" || name == "+CGREG" || name == "+CEREG") {
+        std::vector<std::string> fields = splitFields(line.substr(colon + 2));
+        const size_t at = solicited ? 1 : 0;
+        if (at < fields.size() && !fields[at].empty() && std::isdigit(static_cast<unsigned char>(fields[at][0]))) {
+            AtRegistration stat = static_cast<AtRegistration>(std::stoi(fields[at]));
+            if (name == "+CREG") creg = stat;
+            else if (name == "+CGREG") cgreg = stat;
+            else cereg = stat;
+        }
+        return !solicited;
+    }
+
+    // 2. GNSS: "+CGPSINFO: <lat>,<N/S>,<lon>,<E/W>,<date>,<utc>,<alt>,<speed>,<course>",
+    // all fields empty until the receiver has a position
+    if (name == "+CGPSINFO") {
+        const std::string fields = line.substr(colon + 2);
+        if (!fields.empty() && fields[0] != ',') {
+            gpsFields = fields;
+            gpsFresh = true;
+        }
+        return !solicited;
+    }
+    return false;
+}
+
+AtResult AtModem::command(const std::string& cmd, int timeoutMs, std::vector<std::string>* response) {
+    if (fd < 0) return AtResult::Error;
+    const int64_t deadline = nowMs() + timeoutMs;
+    const std::string query = queryName(cmd);
+
+    // 1. Send
+    const std::string out = cmd + "\r";
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(fd, out.data() + done, out.size() - done);
+        if (n > 0) {
+            done += static_cast<size_t>(n);
+        } else if (n < 0 && (errno == EAGAIN || errno == EINTR) && nowMs() < deadline) {
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+        } else {
+            return AtResult::Error;
+        }
+    }
+
+    // 2. Read up to the final result; URCs update the state on the way
+    std::string line;
+    while (readLine(line, deadline)) {
+        if (line == cmd) continue; // Echo (until ATE0)
+        if (line == "OK") return AtResult::Ok;
+        if (line == "ERROR" || startsWith(line, "+CME ERROR") || startsWith(line, "+CMS ERROR")) {
+            if (response) response->push_back(line);
+            return AtResult::Error;
+        }
+        if (!handleLine(line, query) && response) response->push_back(line);
+    }
+    return AtResult::Timeout;
+}
+
+template <typename F>
+bool AtModem::waitUntil(int64_t deadlineMs, F&& done) {
+    std::string line;
+    while (!done()) {
+        if (!readLine(line, deadlineMs)) return done();
+        handleLine(line, "");
+    }
+    return true;
+}
+
+bool AtModem::sync(int timeoutMs) {
+    const int64_t deadline = nowMs() + timeoutMs;
+    while (command("AT", 300) != AtResult::Ok) {
+        if (nowMs() >= deadline) {
+            std::cerr << "[Modem] ERROR: No answer on " << device << std::endl;
+            return false;
+        }
+    }
+    command("ATE0", 1000);
+    return true;
+}
+
+// --- SEQUENCES ---
+
+bool AtModem::radioOn(bool startGps, int registerTimeoutMs) {
+    const int64_t deadline = nowMs() + registerTimeoutMs;
+
+    // 1. Radio on (the answer can take a few seconds), GNSS searching in parallel
+    if (command("AT+CFUN=1", 10000) != AtResult::Ok) {
+        std::cerr << "[Modem] ERROR: AT+CFUN=1 refused" << std::endl;
+        return false;
+    }
+    if (startGps) command("AT+CGPS=1", 2000); // ERROR = already running
+
+    // 2. A URC for every registration change, then the state right now
+    command("AT+CREG=1", 1000);
+    command("AT+CGREG=1", 1000);
+    command("AT+CEREG=1", 1000);
+    while (!isRegistered()) {
+        command("AT+CEREG?", 1000);
+        command("AT+CREG?", 1000);
+        if (isRegistered() || nowMs() >= deadline) break;
+
+        // Sleep on the port until a URC says so
+        waitUntil(std::min(deadline, nowMs() + kRequeryMs), [this] { return isRegistered(); });
+    }
+    if (isRegistered()) {
+        command("AT+CEREG?", 1000); // +CREG may have come first: settle the technology
+    } else {
+        std::cerr << "[Modem] WARNING: Not registered after " << registerTimeoutMs / 1000 << " s" << std::endl;
+    }
+    return isRegistered();
+}
+
+bool AtModem::gpsFix(int timeoutMs, std::string& fix) {
+    const int64_t deadline = nowMs() + timeoutMs;
+    command("AT+CGPS=1", 2000); // ERROR = already running (radioOn started it)
+
+    // 1. Maybe it already has a position
+    gpsFresh = false;
+    command("AT+CGPSINFO", 2000);
+
+    // 2. Otherwise a report every second, as URCs; firmware without auto-report is
+    // asked directly when nothing arrives
+    if (!gpsFresh) {
+        command("AT+CGPSINFO=1", 2000);
+        while (!gpsFresh && nowMs() < deadline) {
+            if (!waitUntil(std::min(deadline, nowMs() + kRequeryMs), [this] { return gpsFresh; })) {
+                command("AT+CGPSINFO", 2000);
+            }
+        }
+        command("AT+CGPSINFO=0", 2000);
+    }
+
+    // 3. GNSS off: it draws more than the idle radio
+    command("AT+CGPS=0", 2000);
+    const bool found = gpsFresh;
+    fix = found ? gpsFields : "No Fix";
+    gpsFresh = false;
+    return found;
+}
+
+bool AtModem::radioOff() {
+    command("AT+CGPS=0", 2000);
+    return command("AT+CFUN=0", 10000) == AtResult::Ok;
+}
+
+// --- STATE ---
+
+AtRegistration AtModem::registration() const {
+    if (registered(cereg)) return cereg;
+    if (registered(cgreg)) return cgreg;
+    if (registered(creg)) return creg;
+    return cereg != AtRegistration::Unknown ? cereg : creg;
+}
+
+bool AtModem::isRegistered() const {
+    return registered(cereg) || registered(cgreg) || registered(creg);
+}
+
+std::string AtModem::technology() const {
+    if (registered(cereg)) return "LTE";
+    if (registered(cgreg)) return "GPRS";
+    if (registered(creg)) return "GSM";
+    return "";
+}
+
+} // namespace horus
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace horus {
+
+enum class AtResult { Ok, Error, Timeout };
+
+// Network registration as +CREG / +CGREG / +CEREG report it (3GPP 27.007 <stat>)
+enum class AtRegistration : int {
+    Unknown = -1, NotSearching = 0, Home = 1, Searching = 2, Denied = 3, Roaming = 5
+};
+
+// Settings of the modem tasks (modem_up, gps_fix, modem_down)
+struct ModemOptions {
+    std::string device = "/dev/ttyUSB2";
+    int portWaitSec = 20;        // For the node to appear after a reset
+    int registerTimeoutSec = 90;
+    int gpsTimeoutSec = 60;
+    bool gps = true;             // modem_up starts GNSS too, so it searches while we register
+};
+
+// AT command engine for the SIM7600 on its USB AT port (/dev/ttyUSB2), or any
+// tty that speaks the same commands (a pty, for the FakeModem).
+// One poll() loop reads lines with a deadline. Final results (OK / ERROR / +CME ERROR)
+// end a command; URCs are picked up whenever they arrive, during a command or while
+// waiting, so registration and GPS fixes are waited for as events instead of
+// fixed sleeps.
+class AtModem {
+public:
+    explicit AtModem(const std::string& device = "/dev/ttyUSB2");
+    ~AtModem();
+
+    AtModem(const AtModem&) = delete;
+    AtModem& operator=(const AtModem&) = delete;
+
+    // Opens the port at 115200 8N1 raw, exclusively (flock). Waits up to 'waitMs' for
+    // the device node to appear, as it does a few seconds after a modem reset.
+    bool open(int waitMs = 0);
+    void close();
+
+    // Sends "cmd\r" and reads up to the final result. Information lines (URCs excluded)
+    // go to 'response' when given.
+    AtResult command(const std::string& cmd, int timeoutMs, std::vector<std::string>* response = nullptr);
+
+    // "AT" until the modem answers (it ignores commands while booting), then echo off
+    bool sync(int timeoutMs);
+
+    // --- Sequences (each returns as soon as its event arrives) ---
+
+    // AT+CFUN=1, optionally AT+CGPS=1 right away so GNSS acquisition overlaps network
+    // search, then waits for home or roaming registration
+    bool radioOn(bool startGps, int registerTimeoutMs);
+
+    // GNSS on (if not already), waits for a +CGPSINFO with a position, GNSS off.
+    // 'fix' = the CGPSINFO fields ("4503.123456,N,00740.654321,E,..."), or "No Fix".
+    bool gpsFix(int timeoutMs, std::string& fix);
+
+    // GNSS off, then flight mode (AT+CFUN=0)
+    bool radioOff();
+
+    // --- State from responses and URCs ---
+    AtRegistration registration() const;
+    bool isRegistered() const;
+    std::string technology() const; // "LTE", "GPRS", "GSM" or "" (whichever registered)
+
+private:
+    std::string device;
+    int fd = -1;
+    std::string pending;          // Bytes read past the last complete line
+
+    AtRegistration creg = AtRegistration::Unknown;
+    AtRegistration cgreg = AtRegistration::Unknown;
+    AtRegistration cereg = AtRegistration::Unknown;
+    std::string gpsFields;        // Last +CGPSINFO with a position
+    bool gpsFresh = false;        // ...not consumed by gpsFix() yet
+
+    // One non-empty line, or false at the deadline (steady clock, ms)
+    bool readLine(std::string& line, int64_t deadlineMs);
+
+    // Updates the state; true if the line was a URC (not part of a command's answer).
+    // 'query' = "+CEREG" while AT+CEREG? is pending: its answer has an extra <n> field.
+    bool handleLine(const std::string& line, const std::string& query);
+
+    // Reads and handles lines until 'done' holds or the deadline passes
+    template <typename F> bool waitUntil(int64_t deadlineMs, F&& done);
+};
+
+} // namespace horus
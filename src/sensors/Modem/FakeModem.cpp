@@ -0,0 +1,181 @@
+#include "FakeModem.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <termios.h>
+
+namespace horus {
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// "AT+CEREG=2" -> 2
+int setValue(const std::string& cmd) {
+    size_t eq = cmd.find('=');
+    return eq == std::string::npos ? 0 : std::atoi(cmd.c_str() + eq + 1);
+}
+
+} // namespace
+
+const char* FakeModem::kExampleFix = "4503.123456,N,00740.654321,E,160126,101500.0,245.3,0.0,12.5";
+
+FakeModem::FakeModem(const Timing& timing) : timing(timing) {}
+
+FakeModem::~FakeModem() {
+    stopping = true;
+    if (worker.joinable()) worker.join();
+    if (slave >= 0) close(slave);
+    if (master >= 0) close(master);
+}
+
+bool FakeModem::start() {
+    // 1. pty pair; the slave end is what clients open
+    master = posix_openpt(O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0 || ptsname(master) == nullptr) {
+        std::cerr << "[FakeModem] ERROR: No pseudo-terminal: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    slavePath = ptsname(master);
+    slave = open(slavePath.c_str(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+    struct termios tio;
+    if (slave >= 0 && tcgetattr(slave, &tio) == 0) {
+        cfmakeraw(&tio); // No CR/LF translation or echo by the line discipline
+        tcsetattr(slave, TCSANOW, &tio);
+    }
+
+    // 2. The modem itself
+    startMs = nowMs();
+    worker = std::thread([this] { run(); });
+    return true;
+}
+
+int64_t FakeModem::radioOnMs() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return radioTotalMs + (radio ? nowMs() - radioSinceMs : 0);
+}
+
+void FakeModem::send(const std::string& text) {
+    const std::string out = "\r\n" + text + "\r\n";
+    if (write(master, out.data(), out.size()) != static_cast<ssize_t>(out.size())) {
+        std::cerr << "[FakeModem] WARNING: Short write" << std::endl;
+    }
+}
+
+void FakeModem::run() {
+    std::string input;
+    while (!stopping) {
+        struct pollfd pfd = { master, POLLIN, 0 };
+        if (poll(&pfd, 1, 20) > 0 && (pfd.revents & POLLIN)) {
+            char buffer[256];
+            ssize_t n = read(master, buffer, sizeof(buffer));
+            if (n > 0) input.append(buffer, static_cast<size_t>(n));
+        }
+
+        // Commands end with CR
+        size_t end;
+        while ((end = input.find('\r')) != std::string::npos) {
+            std::string cmd = input.substr(0, end);
+            input.erase(0, end + 1);
+            cmd.erase(0, cmd.find_first_not_of('\n'));
+            if (cmd.empty() || nowMs() - startMs < timing.bootMs) continue; // Booting: deaf
+            std::lock_guard<std::mutex> lock(mutex);
+            ++commandCount;
+            if (echo) {
+                const std::string out = cmd + "\r";
+                if (write(master, out.data(), out.size()) < 0) break;
+            }
+            answer(cmd);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        tick(nowMs());
+    }
+}
+
+std::string FakeModem::gpsInfo(int64_t now) const {
+    return gps && fixAtMs >= 0 && now >= fixAtMs ? kExampleFix : ",,,,,,,,";
+}
+
+void FakeModem::answer(const std::string& cmd) {
+    const int64_t now = nowMs();
+    const int stat = registeredLte ? 1 : radio ? 2 : 0;
+
+    if (cmd == "AT") {
+    } else if (cmd == "ATE0" || cmd == "ATE1") {
+        echo = cmd == "ATE1";
+    } else if (cmd == "AT+CFUN=1") {
+        if (!radio) {
+            radio = true;
+            radioSinceMs = now;
+            registerAtMs = timing.registerMs >= 0 ? now + timing.registerMs : -1;
+        }
+    } else if (cmd == "AT+CFUN=0") {
+        if (radio) radioTotalMs += now - radioSinceMs;
+        radio = false;
+        registeredLte = false;
+        registerAtMs = -1;
+        gps = false;
+        reportEverySec = 0;
+    } else if (cmd == "AT+CFUN?") {
+        send(radio ? "+CFUN: 1" : "+CFUN: 0");
+    } else if (cmd.compare(0, 8, "AT+CREG=") == 0) {
+        cregMode = setValue(cmd);
+    } else if (cmd.compare(0, 9, "AT+CEREG=") == 0) {
+        ceregMode = setValue(cmd);
+    } else if (cmd.compare(0, 9, "AT+CGREG=") == 0) {
+    } else if (cmd == "AT+CREG?") {
+        send("+CREG: " + std::to_string(cregMode) + "," + std::to_string(stat));
+    } else if (cmd == "AT+CGREG?") {
+        send("+CGREG: 0," + std::to_string(stat));
+    } else if (cmd == "AT+CEREG?") {
+        send("+CEREG: " + std::to_string(ceregMode) + "," + std::to_string(stat));
+    } else if (cmd == "AT+CGPS=1") {
+        if (gps) {
+            send("ERROR"); // As the SIM7600 does when GNSS is already on
+            return;
+        }
+        gps = true;
+        fixAtMs = timing.fixMs >= 0 ? now + timing.fixMs : -1;
+    } else if (cmd == "AT+CGPS=0") {
+        if (!gps) {
+            send("ERROR");
+            return;
+        }
+        gps = false;
+        reportEverySec = 0;
+    } else if (cmd == "AT+CGPSINFO") {
+        send("+CGPSINFO: " + gpsInfo(now));
+    } else if (cmd.compare(0, 12, "AT+CGPSINFO=") == 0 && timing.urcs) {
+        reportEverySec = setValue(cmd);
+        nextReportMs = now + reportEverySec * 1000;
+    } else {
+        send("ERROR");
+        return;
+    }
+    send("OK");
+}
+
+void FakeModem::tick(int64_t now) {
+    // 1. Network found
+    if (radio && registerAtMs >= 0 && now >= registerAtMs) {
+        registeredLte = true;
+        registerAtMs = -1;
+        if (timing.urcs && cregMode > 0) send("+CREG: 1");
+        if (timing.urcs && ceregMode > 0) send("+CEREG: 1");
+    }
+
+    // 2. Periodic GNSS reports
+    if (gps && reportEverySec > 0 && now >= nextReportMs) {
+        send("+CGPSINFO: " + gpsInfo(now));
+        nextReportMs += reportEverySec * 1000;
+    }
+}
+
+} // namespace horus
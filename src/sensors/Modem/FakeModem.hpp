@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace horus {
+
+// SIM7600 stand-in on a pseudo-terminal, so AtModem (and the modem tasks, with
+// --modem <path>) can run off the device. A thread answers on the pty master with the
+// commands the modem sequences use, registers 'registerMs' after AT+CFUN=1 (+CREG /
+// +CEREG URCs when enabled) and gets a position 'fixMs' after AT+CGPS=1 (auto-reports
+// with AT+CGPSINFO=<s>). It keeps count of the time the radio was on.
+class FakeModem {
+public:
+    struct Timing {
+        int bootMs = 0;          // No answer to anything before this (modem still booting)
+        int registerMs = 1000;   // AT+CFUN=1 -> registered on LTE; < 0 = never
+        int fixMs = 2000;        // AT+CGPS=1 -> position; < 0 = never
+        bool urcs = true;        // Registration URCs and CGPSINFO auto-reports
+    };
+
+    static const char* kExampleFix; // The position it reports
+
+    explicit FakeModem(const Timing& timing);
+    ~FakeModem();
+
+    FakeModem(const FakeModem&) = delete;
+    FakeModem& operator=(const FakeModem&) = delete;
+
+    // False if no pty could be opened
+    bool start();
+
+    // "/dev/pts/N": open it like /dev/ttyUSB2
+    const std::string& path() const { return slavePath; }
+
+    // Time spent with AT+CFUN=1 so far (ms), and the commands answered
+    int64_t radioOnMs() const;
+    int commands() const { return commandCount; }
+
+private:
+    Timing timing;
+    int master = -1;
+    int slave = -1;              // Held open so the pty survives clients closing it
+    std::string slavePath;
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+    std::atomic<int> commandCount{0};
+
+    mutable std::mutex mutex;    // State below (radioOnMs() reads it from other threads)
+    int64_t startMs = 0;
+    bool echo = true;
+    bool radio = false;
+    int64_t radioSinceMs = 0;
+    int64_t radioTotalMs = 0;
+    int64_t registerAtMs = -1;   // Pending registration
+    bool registeredLte = false;
+    int cregMode = 0;            // <n> of AT+CREG / AT+CEREG
+    int ceregMode = 0;
+    bool gps = false;
+    int64_t fixAtMs = -1;
+    int reportEverySec = 0;      // AT+CGPSINFO=<s>
+    int64_t nextReportMs = 0;
+
+    void run();
+    void answer(const std::string& cmd);
+    void tick(int64_t now);
+    void send(const std::string& text);
+    std::string gpsInfo(int64_t now) const;
+};
+
+} // namespace horus
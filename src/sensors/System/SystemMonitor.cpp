@@ -0,0 +1,145 @@
+#include "SystemMonitor.hpp"
+#include <iostream>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/statvfs.h>
+#include "utils/FileSystem.hpp"
+
+namespace fs = std::filesystem;
+namespace horus {
+
+namespace {
+
+// VideoCore property interface (raspberrypi/userland vcmailbox), as vcgencmd uses it
+const unsigned long kMailboxProperty = _IOWR(100, 0, char*);
+const uint32_t kMailboxResponseOk = 0x80000000u;
+const uint32_t kTagGetThrottled = 0x00030046u;
+
+// Whole file (small sysfs / procfs text) into 'buffer', NUL-terminated. -1 on error.
+ssize_t readSmall(const std::string& path, char* buffer, size_t size) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return -1;
+    size_t length = 0;
+    while (length + 1 < size) {
+        ssize_t n = ::read(fd, buffer + length, size - 1 - length);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        length += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    buffer[length] = '\0';
+    return static_cast<ssize_t>(length);
+}
+
+// First number of a one-value file ("48312\n", "50005\n")
+bool readNumber(const std::string& path, int base, uint64_t& value) {
+    char text[64];
+    if (readSmall(path, text, sizeof(text)) <= 0) return false;
+    char* end = nullptr;
+    value = std::strtoull(text, &end, base);
+    return end != text;
+}
+
+// "MemAvailable:    1234567 kB" -> 1234567
+bool meminfoField(const char* text, const char* key, uint64_t& kb) {
+    const char* at = std::strstr(text, key);
+    if (!at) return false;
+    char* end = nullptr;
+    kb = std::strtoull(at + std::strlen(key), &end, 10);
+    return end != at + std::strlen(key);
+}
+
+} // namespace
+
+SystemMonitor::SystemMonitor(const SystemSources& sources) : sources(sources) {
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(sources.root + "/sys/class/thermal", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("thermal_zone", 0) == 0 && fs::exists(entry.path() / "temp", ec)) {
+            zones.push_back((entry.path() / "temp").string());
+        }
+    }
+    std::sort(zones.begin(), zones.end());
+}
+
+bool SystemMonitor::sample(SystemSample& out) {
+    out = SystemSample();
+    const std::string& root = sources.root;
+    uint64_t value = 0;
+
+    // 1. Thermal zones (millidegrees), the hottest one
+    for (const std::string& zone : zones) {
+        if (!readNumber(zone, 10, value)) continue;
+        const double celsius = static_cast<int64_t>(value) / 1000.0;
+        out.cpuTempC = out.thermalZones == 0 ? celsius : std::max(out.cpuTempC, celsius);
+        ++out.thermalZones;
+    }
+
+    // 2. cpufreq (kHz)
+    if (readNumber(root + "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", 10, value)) {
+        out.cpuMHz = value / 1000.0;
+    }
+
+    // 3. Load and memory
+    char text[4096];
+    if (readSmall(root + "/proc/loadavg", text, sizeof(text)) > 0) {
+        char* end = nullptr;
+        out.load1 = std::strtod(text, &end);
+        out.loadKnown = end != text;
+    }
+    if (readSmall(root + "/proc/meminfo", text, sizeof(text)) > 0) {
+        out.memoryKnown = meminfoField(text, "MemTotal:", out.memTotalKb) &&
+                          meminfoField(text, "MemAvailable:", out.memAvailableKb);
+    }
+
+    // 4. Free space where the pictures go
+    const std::string storage = sources.storagePath.empty() ? utils::getDataRoot() : sources.storagePath;
+    struct statvfs vfs;
+    if (statvfs(storage.c_str(), &vfs) == 0) {
+        out.storageFreeBytes = static_cast<uint64_t>(vfs.f_bavail) * vfs.f_frsize;
+        out.storageTotalBytes = static_cast<uint64_t>(vfs.f_blocks) * vfs.f_frsize;
+        out.storageKnown = true;
+    }
+
+    // 5. Firmware throttling flags
+    out.throttledKnown = readThrottled(out.throttled);
+
+    return out.thermalZones > 0 || out.cpuMHz > 0 || out.loadKnown || out.memoryKnown || out.storageKnown ||
+           out.throttledKnown;
+}
+
+bool SystemMonitor::readThrottled(uint32_t& bits) {
+    // 1. The firmware driver's sysfs node (Raspberry Pi kernels), hex text
+    uint64_t value = 0;
+    if (readNumber(sources.root + "/sys/devices/platform/soc/soc:firmware/get_throttled", 16, value)) {
+        bits = static_cast<uint32_t>(value);
+        return true;
+    }
+
+    // 2. The mailbox property call, as vcgencmd get_throttled makes it
+    if (sources.mailbox.empty()) return false;
+    int fd = ::open((sources.root + sources.mailbox).c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return false;
+    uint32_t message[7] = {
+        sizeof(message), 0,    // Buffer size, request
+        kTagGetThrottled, 4, 0, // Tag, value buffer size, request length
+        0,                      // Value
+        0                       // End tag
+    };
+    const bool ok = ioctl(fd, kMailboxProperty, message) == 0 && message[1] == kMailboxResponseOk;
+    ::close(fd);
+    if (!ok) {
+        std::cerr << "[SysMon] Mailbox get_throttled failed." << std::endl;
+        return false;
+    }
+    bits = message[5];
+    return true;
+}
+
+}
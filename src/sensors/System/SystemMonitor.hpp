@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace horus {
+
+// Where the readings come from. Every path is under 'root', so a test can point the
+// monitor at a fake tree ("<root>/sys/class/thermal/...", "<root>/proc/loadavg", ...).
+struct SystemSources {
+    std::string root;            // Empty = the real filesystem
+    std::string mailbox = "/dev/vcio"; // VideoCore property mailbox, under 'root' too (empty = never)
+    std::string storagePath;     // Filesystem whose free space is logged (empty = the data root)
+};
+
+// One reading. Fields that could not be read keep their "unknown" value and the
+// matching flag stays false.
+struct SystemSample {
+    double cpuTempC = 0.0;       // Hottest thermal zone
+    int thermalZones = 0;        // Zones that answered (0 = cpuTempC unknown)
+    double cpuMHz = 0.0;         // cpu0 current frequency (0 = no cpufreq)
+    double load1 = 0.0;          // /proc/loadavg, 1 minute
+    uint64_t memTotalKb = 0;
+    uint64_t memAvailableKb = 0;
+    uint64_t storageFreeBytes = 0;  // Available to the (non-root) user
+    uint64_t storageTotalBytes = 0;
+    uint32_t throttled = 0;      // get_throttled bits: 0 under-voltage, 1 freq capped, 2 throttled,
+                                 // 3 soft temp limit, 16-19 the same "has occurred since boot"
+    bool throttledKnown = false;
+    bool loadKnown = false;
+    bool memoryKnown = false;
+    bool storageKnown = false;
+};
+
+// SoC health without a subprocess: sysfs / procfs reads into a stack buffer, statvfs
+// and, when the firmware's sysfs node is missing, one ioctl on the VideoCore mailbox
+// (the call vcgencmd makes). The thermal zones are found once, at construction, so the
+// daemon can keep one monitor and a sample is then ~10 small reads.
+class SystemMonitor {
+public:
+    explicit SystemMonitor(const SystemSources& sources = SystemSources());
+
+    // False only if nothing at all could be read
+    bool sample(SystemSample& out);
+
+    const std::vector<std::string>& thermalZones() const { return zones; }
+
+private:
+    bool readThrottled(uint32_t& bits);
+
+    SystemSources sources;
+    std::vector<std::string> zones; // ".../thermal_zoneN/temp"
+};
+
+}
@@ -0,0 +1,356 @@
+#include "TaskGraph.hpp"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <set>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/wait.h>
+
+namespace horus {
+namespace tasks {
+
+namespace {
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+const int kKillGraceMs = 5000;
+
+// "12.3": run clock in seconds, formatted apart so std::cout keeps its own flags
+std::string seconds(int64_t ms) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1) << ms / 1000.0;
+    return text.str();
+}
+
+// A started stage
+struct Child {
+    int index;
+    pid_t pid = -1;
+    int outFd = -1;
+    std::string partial;     // Output past the last newline
+    int64_t deadlineAt = 0;  // Run clock, 0 = none
+    int64_t killAt = 0;      // SIGKILL after the SIGTERM, 0 = not terminated yet
+};
+
+bool isDone(StageStatus status) {
+    return status != StageStatus::Pending && status != StageStatus::Running;
+}
+
+// Prints the complete lines of 'partial' with the stage prefix ('flush' = the rest too)
+void printLines(const std::string& name, std::string& partial, bool flush) {
+    size_t end;
+    while ((end = partial.find('\n')) != std::string::npos) {
+        std::cout << "[" << name << "] " << partial.substr(0, end) << std::endl;
+        partial.erase(0, end + 1);
+    }
+    if (flush && !partial.empty()) {
+        std::cout << "[" << name << "] " << partial << std::endl;
+        partial.clear();
+    }
+}
+
+// fork + exec with stdout/stderr on a pipe, in its own process group (helper scripts
+// start children of their own: a deadline must reach them too)
+bool spawn(const std::vector<std::string>& command, Child& child) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        std::vector<char*> argv;
+        for (const std::string& arg : command) argv.push_back(const_cast<char*>(arg.c_str()));
+        argv.push_back(nullptr);
+        execvp(argv[0], argv.data());
+        const char* message = "exec failed\n";
+        ssize_t ignored = write(STDERR_FILENO, message, std::strlen(message));
+        (void)ignored;
+        _exit(127);
+    }
+    setpgid(pid, pid); // Also from here: no race with the kill below
+    close(fds[1]);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    child.pid = pid;
+    child.outFd = fds[0];
+    return true;
+}
+
+// At end of file the pipe is closed and 'outFd' set to -1, which poll() skips: a stage
+// that closes its output but keeps running must not wake the loop on every pass
+void drain(const std::string& name, Child& child, bool flush) {
+    if (child.outFd >= 0) {
+        char buffer[4096];
+        ssize_t n;
+        while ((n = read(child.outFd, buffer, sizeof(buffer))) > 0) child.partial.append(buffer, static_cast<size_t>(n));
+        if (n == 0) {
+            close(child.outFd);
+            child.outFd = -1;
+        }
+    }
+    printLines(name, child.partial, flush);
+}
+
+} // namespace
+
+const char* stageStatusName(StageStatus status) {
+    switch (status) {
+        case StageStatus::Pending: return "pending";
+        case StageStatus::Running: return "running";
+        case StageStatus::Ok: return "ok";
+        case StageStatus::Failed: return "failed";
+        case StageStatus::TimedOut: return "timeout";
+        case StageStatus::Skipped: return "skipped";
+    }
+    return "?";
+}
+
+void TaskGraph::add(const Stage& stage) {
+    stages.push_back(stage);
+}
+
+int TaskGraph::indexOf(const std::string& name) const {
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (stages[i].name == name) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+bool TaskGraph::validate(std::string& error) const {
+    // 1. Names
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (indexOf(stages[i].name) != static_cast<int>(i)) {
+            error = "duplicate stage " + stages[i].name;
+            return false;
+        }
+        for (const std::vector<std::string>* list : { &stages[i].after, &stages[i].needs }) {
+            for (const std::string& name : *list) {
+                if (indexOf(name) < 0) {
+                    error = stages[i].name + " depends on unknown stage " + name;
+                    return false;
+                }
+            }
+        }
+    }
+
+    // 2. Cycles: peel off stages whose predecessors are all gone (Kahn)
+    std::vector<bool> placed(stages.size(), false);
+    for (size_t round = 0; round < stages.size(); ++round) {
+        bool progress = false;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            if (placed[i]) continue;
+            bool ready = true;
+            for (const std::vector<std::string>* list : { &stages[i].after, &stages[i].needs }) {
+                for (const std::string& name : *list) ready = ready && placed[indexOf(name)];
+            }
+            if (ready) placed[i] = progress = true;
+        }
+        if (!progress) break;
+    }
+    for (size_t i = 0; i < stages.size(); ++i) {
+        if (!placed[i]) {
+            error = "dependency cycle through " + stages[i].name;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<StageResult> TaskGraph::run(bool dryRun) {
+    std::vector<StageResult> results(stages.size());
+    for (size_t i = 0; i < stages.size(); ++i) results[i].name = stages[i].name;
+
+    const int64_t start = nowMs();
+    int64_t virtualNow = 0;
+    auto clock = [&] { return dryRun ? virtualNow : nowMs() - start; };
+    std::set<std::string> busy;
+    std::vector<Child> running;
+
+    auto finish = [&](size_t slot, StageStatus status, int exitCode) {
+        Child& child = running[slot];
+        StageResult& result = results[child.index];
+        const Stage& stage = stages[child.index];
+        drain(stage.name, child, true);
+        if (child.outFd >= 0) close(child.outFd);
+        result.status = status;
+        result.exitCode = exitCode;
+        result.endMs = clock();
+        if (!stage.resource.empty()) busy.erase(stage.resource);
+        std::cout << "[Graph] +" << seconds(result.endMs) << " s " << stage.name << " " << stageStatusName(status);
+        if (status == StageStatus::Failed) std::cout << " (exit " << exitCode << ")";
+        std::cout << std::endl;
+        running.erase(running.begin() + static_cast<long>(slot));
+    };
+
+    for (;;) {
+        // 1. Start (or skip) everything that can go now
+        for (bool progress = true; progress;) {
+            progress = false;
+            for (size_t i = 0; i < stages.size(); ++i) {
+                const Stage& stage = stages[i];
+                StageResult& result = results[i];
+                if (result.status != StageStatus::Pending) continue;
+
+                bool ready = true;
+                std::string missing;
+                for (const std::string& name : stage.after) ready = ready && isDone(results[indexOf(name)].status);
+                for (const std::string& name : stage.needs) {
+                    StageStatus status = results[indexOf(name)].status;
+                    ready = ready && isDone(status);
+                    if (isDone(status) && status != StageStatus::Ok && missing.empty()) missing = name;
+                }
+                if (!ready) continue;
+                if (!missing.empty()) {
+                    result.status = StageStatus::Skipped;
+                    result.startMs = result.endMs = clock();
+                    std::cout << "[Graph] " << stage.name << " skipped (" << missing << " did not succeed)" << std::endl;
+                    progress = true;
+                    continue;
+                }
+                if (!stage.resource.empty() && busy.count(stage.resource)) continue;
+
+                Child child;
+                child.index = static_cast<int>(i);
+                result.startMs = clock();
+                if (stage.deadlineSec > 0) child.deadlineAt = result.startMs + stage.deadlineSec * 1000LL;
+                if (!dryRun && !stage.command.empty() && !spawn(stage.command, child)) {
+                    std::cerr << "[Graph] ERROR: Could not start " << stage.name << ": " << std::strerror(errno) << std::endl;
+                    result.status = StageStatus::Failed;
+                    result.endMs = result.startMs;
+                    progress = true;
+                    continue;
+                }
+                result.status = StageStatus::Running;
+                if (!stage.resource.empty()) busy.insert(stage.resource);
+                std::cout << "[Graph] +" << seconds(result.startMs) << " s " << stage.name << " started" << std::endl;
+                running.push_back(child);
+                progress = true;
+            }
+        }
+        if (running.empty()) break;
+
+        // 2a. Dry run: jump to the next simulated end
+        if (dryRun) {
+            size_t next = 0;
+            int64_t nextEnd = INT64_MAX;
+            bool timedOut = false;
+            for (size_t slot = 0; slot < running.size(); ++slot) {
+                const Stage& stage = stages[running[slot].index];
+                const int64_t work = stage.command.empty() ? 0 : stage.simulatedMs;
+                int64_t end = results[running[slot].index].startMs + work;
+                bool late = running[slot].deadlineAt > 0 && end > running[slot].deadlineAt;
+                if (late) end = running[slot].deadlineAt;
+                if (end < nextEnd) {
+                    next = slot;
+                    nextEnd = end;
+                    timedOut = late;
+                }
+            }
+            virtualNow = nextEnd;
+            finish(next, timedOut ? StageStatus::TimedOut : StageStatus::Ok, timedOut ? -1 : 0);
+            continue;
+        }
+
+        // 2b. Join points end at once
+        for (size_t slot = 0; slot < running.size();) {
+            if (running[slot].pid < 0) finish(slot, StageStatus::Ok, 0);
+            else ++slot;
+        }
+        if (running.empty()) continue;
+
+        // 2c. Output, for up to 100 ms
+        std::vector<struct pollfd> fds;
+        for (const Child& child : running) fds.push_back({ child.outFd, POLLIN, 0 });
+        if (poll(fds.data(), fds.size(), 100) > 0) {
+            for (Child& child : running) drain(stages[child.index].name, child, false);
+        }
+
+        // 2d. Ended children, then deadlines
+        const int64_t now = clock();
+        for (size_t slot = 0; slot < running.size();) {
+            Child& child = running[slot];
+            int status = 0;
+            if (waitpid(child.pid, &status, WNOHANG) == child.pid) {
+                const int code = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                const StageStatus outcome = child.killAt > 0 ? StageStatus::TimedOut
+                                          : code == 0 ? StageStatus::Ok : StageStatus::Failed;
+                finish(slot, outcome, code);
+                continue;
+            }
+            if (child.deadlineAt > 0 && now >= child.deadlineAt && child.killAt == 0) {
+                std::cerr << "[Graph] " << stages[child.index].name << " over its " << stages[child.index].deadlineSec
+                          << " s deadline, terminating" << std::endl;
+                kill(-child.pid, SIGTERM);
+                child.killAt = now + kKillGraceMs;
+            } else if (child.killAt > 0 && now >= child.killAt) {
+                kill(-child.pid, SIGKILL);
+            }
+            ++slot;
+        }
+    }
+    return results;
+}
+
+void printSchedule(const std::vector<StageResult>& results, bool dryRun) {
+    int64_t total = 0;
+    int64_t serial = 0;
+    std::cout << "[Graph] " << (dryRun ? "Simulated schedule" : "Schedule") << ":" << std::endl;
+    for (const StageResult& result : results) {
+        total = std::max(total, result.endMs);
+        serial += result.endMs - result.startMs;
+        std::ostringstream line;
+        line << "  " << std::left << std::setw(14) << result.name << std::right << std::setw(7)
+             << seconds(result.startMs) << " s -> " << std::setw(7) << seconds(result.endMs) << " s  "
+             << stageStatusName(result.status);
+        std::cout << line.str() << std::endl;
+    }
+    std::cout << "[Graph] Wake time " << seconds(total) << " s (one stage at a time: " << seconds(serial) << " s)"
+              << std::endl;
+}
+
+
+std::vector<std::string> selectOptions(const std::vector<std::string>& args,
+                                       const std::vector<StageOption>& accepted,
+                                       std::vector<std::string>* rest) {
+    std::vector<std::string> selected;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& arg = args[i];
+        const size_t eq = arg.find('=');
+        const std::string name = arg.substr(0, eq);
+        auto match = std::find_if(accepted.begin(), accepted.end(),
+                                  [&](const StageOption& option) { return name == option.name; });
+        // The value is the next argument unless it is inline or the next one is an option
+        const bool inlineValue = eq != std::string::npos;
+        const bool nextIsValue = i + 1 < args.size() && args[i + 1].rfind("--", 0) != 0;
+        if (match != accepted.end()) {
+            selected.push_back(arg);
+            if (match->takesValue && !inlineValue && i + 1 < args.size()) selected.push_back(args[++i]);
+        } else {
+            // Not ours: whether it takes a value is a guess, so a value goes along with it
+            if (rest) rest->push_back(arg);
+            if (arg.rfind("--", 0) == 0 && !inlineValue && nextIsValue) {
+                ++i;
+                if (rest) rest->push_back(args[i]);
+            }
+        }
+    }
+    return selected;
+}
+
+}
+}
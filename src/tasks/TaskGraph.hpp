@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace horus {
+namespace tasks {
+
+    // One step of a wake cycle, run as a child process ("horus_app --task ...", or a
+    // helper script), so a stage that hangs can be killed at its deadline without
+    // taking the orchestrator (or the camera stack) with it.
+    struct Stage {
+        std::string name;
+        std::vector<std::string> command;  // argv; empty = nothing to run (a join point)
+        std::vector<std::string> after;    // Start only once these have ended, whatever the outcome
+        std::vector<std::string> needs;    // ...and these must have succeeded, else this is skipped
+        std::string resource;              // Stages naming the same resource never overlap ("camera", "modem")
+        int deadlineSec = 0;               // SIGTERM when exceeded (SIGKILL 5 s later); 0 = none
+        int simulatedMs = 0;               // Duration in a dry run
+    };
+
+    enum class StageStatus { Pending, Running, Ok, Failed, TimedOut, Skipped };
+
+    struct StageResult {
+        std::string name;
+        StageStatus status = StageStatus::Pending;
+        int exitCode = -1;
+        int64_t startMs = 0;               // From the start of the run
+        int64_t endMs = 0;
+    };
+
+    const char* stageStatusName(StageStatus status);
+
+    // A dependency graph of stages. Every stage whose predecessors are done and whose
+    // resource is free starts right away, so independent work (encoding, bundling)
+    // overlaps the waits of the others (modem registration, GNSS).
+    class TaskGraph {
+    public:
+        void add(const Stage& stage);
+
+        // Unknown names in after/needs, duplicates, cycles
+        bool validate(std::string& error) const;
+
+        // Runs the graph; output lines of each stage are prefixed with "[<name>] ".
+        // dryRun = nothing is started: each stage "takes" its simulatedMs on a virtual
+        // clock (capped by its deadline), which gives the schedule and its length.
+        std::vector<StageResult> run(bool dryRun);
+
+    private:
+        std::vector<Stage> stages;
+
+        int indexOf(const std::string& name) const;
+    };
+
+    // Stage timeline (start, end, status) and the total against running them one by one
+    void printSchedule(const std::vector<StageResult>& results, bool dryRun);
+
+    // An option a stage takes from the command line of the run: "--name value" /
+    // "--name=value", or a bare switch ("--raw")
+    struct StageOption {
+        const char* name;
+        bool takesValue;
+    };
+
+    // The options of 'args' named in 'accepted', in order, each with its value. The
+    // others (and anything that is not an option) go to 'rest' when given.
+    std::vector<std::string> selectOptions(const std::vector<std::string>& args,
+                                           const std::vector<StageOption>& accepted,
+                                           std::vector<std::string>* rest = nullptr);
+
+}
+}
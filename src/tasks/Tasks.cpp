@@ -0,0 +1,557 @@
+#include "Tasks.hpp"
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <ctime>
+#include <cstdint>
+#include "utils/FileSystem.hpp"
+#include "utils/TelemetryLog.hpp"
+#include "utils/FileIndex.hpp"
+#include "utils/Bundle.hpp"
+#include "TaskGraph.hpp"
+#include "imaging/RawDevelop.hpp"
+#include "imaging/ArucoDetector.hpp"
+#include "imaging/PreviewPyramid.hpp"
+#include "sensors/Camera/MultiCapture.hpp"
+#include "utils/MemoryBudget.hpp"
+#include "utils/TaskTimer.hpp"
+
+namespace horus {
+namespace tasks {
+
+std::string getTimestamped(const std::string& extension) {
+    auto now = std::chrono::system_clock::now();
+    auto in_time_t = std::chrono::system_clock::to_time_t(now);
+    std::stringstream ss;
+    if(extension == ".csv"){
+        ss << std::put_time(std::localtime(&in_time_t), "%FT%H:%M:%S%Z");
+    } else {
+        ss << std::put_time(std::localtime(&in_time_t), "img_%FT%H:%M:%S%Z");
+        ss << extension;
+    }
+    return ss.str();
+}
+
+int capture(Camera& cam, const CameraOptions& options) {
+    std::string folderPath = horus::utils::getTodaysFolder();
+    horus::utils::removeStaleTempFiles(folderPath); // Leftovers of a power cut mid-write
+    std::string fullPath = folderPath + "/" + getTimestamped(options.captureRaw ? ".raw" : ".jpg");
+    std::cout << "[Main] Target File: " << fullPath << std::endl;
+
+    if (!cam.start(options)) {
+        std::cerr << "[Main] Critical: Camera init failed." << std::endl;
+        cam.stop();
+        return 2;
+    }
+
+    if (cam.capture(fullPath)) {
+        std::cout << "[Main] Capture Success." << std::endl;
+    } else {
+        std::cerr << "[Main] Capture Failed." << std::endl;
+        cam.stop();
+        return 3;
+    }
+    cam.stop();
+    return 0;
+}
+
+int captureHdr(Camera& cam, const CameraOptions& options, const std::vector<float>& evOffsets) {
+    std::string folderPath = horus::utils::getTodaysFolder();
+    horus::utils::removeStaleTempFiles(folderPath);
+    std::string fullPath = folderPath + "/" + getTimestamped("_hdr.jpg");
+    std::cout << "[Main] Target File: " << fullPath << std::endl;
+
+    if (!cam.start(options)) {
+        std::cerr << "[Main] Critical: Camera init failed." << std::endl;
+        cam.stop();
+        return 2;
+    }
+
+    if (cam.captureHdr(fullPath, evOffsets)) {
+        std::cout << "[Main] HDR Capture Success." << std::endl;
+    } else {
+        std::cerr << "[Main] HDR Capture Failed." << std::endl;
+        cam.stop();
+        return 3;
+    }
+    cam.stop();
+    return 0;
+}
+
+int captureMulti(const CameraOptions& options, const std::vector<int>& indices, size_t memoryBudgetBytes) {
+    std::shared_ptr<CameraManager> manager = startCameraManager();
+    const size_t found = manager->cameras().size();
+    std::vector<size_t> selected;
+    for (int index : indices) {
+        if (index < 0 || static_cast<size_t>(index) >= found) {
+            std::cerr << "[Main] No camera " << index << " (" << found << " found)." << std::endl;
+        } else if (std::find(selected.begin(), selected.end(), static_cast<size_t>(index)) == selected.end()) {
+            selected.push_back(static_cast<size_t>(index));
+        }
+    }
+    if (indices.empty()) {
+        for (size_t i = 0; i < found; ++i) selected.push_back(i);
+    }
+    if (selected.empty()) {
+        std::cerr << "[Main] Critical: No camera to capture from." << std::endl;
+        return 2;
+    }
+
+    // One pool for every camera: the cores are shared out, not oversubscribed
+    std::shared_ptr<utils::ThreadPool> pool;
+    if (options.encoderThreads != 1) pool = std::make_shared<utils::ThreadPool>(options.encoderThreads);
+    std::vector<std::unique_ptr<Camera>> cameras;
+    std::vector<FrameSource*> sources;
+    for (size_t index : selected) {
+        cameras.push_back(std::make_unique<Camera>(manager, index, pool));
+        sources.push_back(cameras.back().get());
+    }
+
+    std::string folderPath = horus::utils::getTodaysFolder();
+    horus::utils::removeStaleTempFiles(folderPath);
+    const std::string prefix = folderPath + "/" + getTimestamped("");
+    std::cout << "[Main] " << sources.size() << " camera(s), memory budget " << memoryBudgetBytes / (1024 * 1024)
+              << " MB, target " << prefix << "_cam<N>" << std::endl;
+
+    utils::MemoryBudget budget(memoryBudgetBytes);
+    std::vector<SourceCapture> results = captureAll(sources, options, prefix, options.captureRaw ? ".raw" : ".jpg", budget);
+    const bool ok = std::all_of(results.begin(), results.end(), [](const SourceCapture &r) { return r.ok; });
+    std::cout << (ok ? "[Main] Capture Success." : "[Main] Capture Failed.") << std::endl;
+    return ok ? 0 : 3;
+}
+
+int develop(const std::string& input, const std::string& format) {
+    namespace fs = std::filesystem;
+    const bool dng = format == "dng";
+    const std::string extension = dng ? ".dng" : ".jpg";
+
+    // 1. Collect the dumps: one file, or every .raw of a folder (default: today's)
+    std::vector<fs::path> rawFiles;
+    fs::path target = input.empty() ? fs::path(horus::utils::getTodaysFolder()) : fs::path(input);
+    std::error_code ec;
+    if (fs::is_directory(target, ec)) {
+        for (const fs::directory_entry &entry : fs::directory_iterator(target, ec)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".raw") rawFiles.push_back(entry.path());
+        }
+        std::sort(rawFiles.begin(), rawFiles.end());
+    } else if (fs::exists(target, ec)) {
+        rawFiles.push_back(target);
+    } else {
+        std::cerr << "[Main] Nothing to develop at " << target << std::endl;
+        return 1;
+    }
+
+    // 2. Develop whatever has no output yet (so the task can be re-run after a crash)
+    int developed = 0, failed = 0;
+    for (const fs::path &rawPath : rawFiles) {
+        fs::path outPath = fs::path(rawPath).replace_extension(extension);
+        if (fs::exists(outPath, ec)) continue;
+
+        imaging::RawInfo info;
+        bool ok = imaging::readRawInfo(fs::path(rawPath).replace_extension(".json").string(), info);
+        if (ok) {
+            ok = dng ? imaging::developDng(rawPath.string(), info, outPath.string())
+                     : imaging::developJpeg(rawPath.string(), info, outPath.string());
+        }
+        if (ok) {
+            std::cout << "[Main] Developed " << outPath.filename().string() << std::endl;
+            ++developed;
+        } else {
+            std::cerr << "[Main] Could not develop " << rawPath.filename().string() << std::endl;
+            fs::remove(outPath, ec); // No half-written outputs
+            ++failed;
+        }
+    }
+
+    std::cout << "[Main] Developed " << developed << " RAW file(s), " << failed << " failed." << std::endl;
+    return failed == 0 ? 0 : 3;
+}
+
+int detectAruco(const std::string& input, int scale, const std::string& dictionaryPath) {
+    namespace fs = std::filesystem;
+
+    imaging::MarkerDictionary dictionary = imaging::builtinDictionary();
+    if (!dictionaryPath.empty() && !imaging::loadDictionary(dictionaryPath, dictionary)) return 1;
+
+    // 1. One JPEG, or every JPEG of a folder (default: today's)
+    std::vector<fs::path> images;
+    fs::path target = input.empty() ? fs::path(horus::utils::getTodaysFolder()) : fs::path(input);
+    std::error_code ec;
+    if (fs::is_directory(target, ec)) {
+        for (const fs::directory_entry &entry : fs::directory_iterator(target, ec)) {
+            // Previews are the same scene again, smaller
+            if (entry.is_regular_file() && entry.path().extension() == ".jpg" &&
+                !imaging::isPyramidFile(entry.path().string())) {
+                images.push_back(entry.path());
+            }
+        }
+        std::sort(images.begin(), images.end());
+    } else if (fs::exists(target, ec)) {
+        images.push_back(target);
+    } else {
+        std::cerr << "[Main] No image at " << target << std::endl;
+        return 1;
+    }
+
+    // 2. Scaled grey decode -> detection -> sidecar next to the image
+    int withMarkers = 0;
+    for (const fs::path &image : images) {
+        imaging::LumaImage luma;
+        if (!imaging::loadJpegLuma(image.string(), scale, luma)) continue;
+
+        std::vector<imaging::MarkerDetection> markers = imaging::detectMarkers(luma, dictionary);
+        imaging::writeMarkersJson(fs::path(image).replace_extension(".aruco.json").string(), markers, dictionary);
+
+        std::cout << "[Main] " << image.filename().string() << ": " << markers.size() << " marker(s)";
+        for (const imaging::MarkerDetection &marker : markers) std::cout << " id=" << marker.id;
+        std::cout << std::endl;
+        if (!markers.empty()) ++withMarkers;
+    }
+
+    std::cout << "[Main] Markers found in " << withMarkers << "/" << images.size() << " image(s)." << std::endl;
+    return 0;
+}
+
+int monitorEnv(BME280& sensor, int burstSamples) {
+    // Used to be monitor_external, now consolidated for BME280
+    // Forced-mode conversions, averaged over the burst
+    horus::BME280Burst burst;
+    if (!sensor.readBurst(std::max(1, burstSamples), burst)) {
+        std::cerr << "[Main] BME280 measurement failed." << std::endl;
+        return 1;
+    }
+    const horus::BME280Data& data = burst.mean;
+
+    // 1. Print to Console (for debugging/journalctl)
+    std::cout << "Temp: " << data.temperature << " C | ";
+    std::cout << "Hum: "  << data.humidity << " % | ";
+    std::cout << "Pres: " << data.pressure << " hPa" << std::endl;
+
+    // 2. One 64-byte record into today's telemetry file
+    // (environmental_data.csv is rebuilt from the log by --task export_csv)
+    utils::TelemetryRecord record;
+    record.source = static_cast<uint16_t>(utils::TelemetrySource::Env);
+    record.values[0] = data.temperature;
+    record.values[1] = data.humidity;
+    record.values[2] = data.pressure;
+    record.values[3] = burst.samples;
+    if (burst.samples > 1) {
+        const float variance[3] = { burst.variance.temperature, burst.variance.humidity, burst.variance.pressure };
+        std::memcpy(record.aux, variance, sizeof(variance));
+        std::cout << "[Main] Burst of " << burst.samples << ", std dev: " << std::sqrt(variance[0]) << " C, "
+                  << std::sqrt(variance[1]) << " %, " << std::sqrt(variance[2]) << " hPa" << std::endl;
+    }
+
+    utils::TelemetryLog log;
+    if (!log.append(record)) return 1;
+    std::cout << "[Main] Sample logged to " << utils::getTelemetryFolder() << std::endl;
+    return 0;
+}
+
+int monitorSys(const SystemSources& sources) {
+    utils::TaskTimer timer;
+    SystemMonitor monitor(sources);
+    SystemSample sample;
+    if (!monitor.sample(sample)) {
+        std::cerr << "[Main] No system reading available." << std::endl;
+        return 1;
+    }
+    if (sample.thermalZones == 0) std::cerr << "[Main] WARNING: no thermal zone, temperature logged as 0." << std::endl;
+    if (!sample.throttledKnown) std::cerr << "[Main] WARNING: throttled state unavailable, logged as 0x0." << std::endl;
+
+    // 1. Print to Console (for debugging/journalctl)
+    std::cout << "CPU: " << sample.cpuTempC << " C | " << sample.cpuMHz << " MHz | "
+              << "Load: " << sample.load1 << " | "
+              << "Mem: " << sample.memAvailableKb / 1024 << "/" << sample.memTotalKb / 1024 << " MB | "
+              << "Disk: " << (sample.storageFreeBytes >> 20) << "/" << (sample.storageTotalBytes >> 20) << " MB | "
+              << "Throttled: 0x" << std::hex << sample.throttled << std::dec << std::endl;
+
+    // 2. One Cpu record, the monitor_cpu.sh fields plus the rest
+    utils::TelemetryRecord record;
+    record.source = static_cast<uint16_t>(utils::TelemetrySource::Cpu);
+    record.flags = utils::kFlagCpuSystem;
+    record.values[0] = sample.cpuTempC;
+    record.values[1] = sample.cpuMHz;
+    record.values[2] = sample.load1;
+    record.values[3] = static_cast<double>(sample.memAvailableKb / 1024);
+    record.aux[0] = sample.throttled;
+    record.aux[1] = static_cast<uint32_t>(std::min<uint64_t>(sample.storageFreeBytes >> 20, UINT32_MAX));
+
+    utils::TelemetryLog log;
+    if (!log.append(record)) return 1;
+    std::cout << "[Main] Sample logged to " << utils::getTelemetryFolder() << " (cpu " << timer.cpuMs()
+              << " ms)" << std::endl;
+    return 0;
+}
+
+int recordTelemetry(const std::string& source, const std::string& data) {
+    utils::TelemetryRecord record;
+    bool parsed = false;
+    if (source == "cpu") {
+        parsed = utils::parseCpuFields(data, record);
+    } else if (source == "gps") {
+        parsed = utils::parseGpsFix(data, record);
+    } else {
+        std::cerr << "[Main] Unknown telemetry source: " << source << std::endl;
+        return 1;
+    }
+    if (!parsed) {
+        std::cerr << "[Main] Could not parse " << source << " data: " << data << std::endl;
+        return 1;
+    }
+
+    utils::TelemetryLog log;
+    return log.append(record) ? 0 : 1;
+}
+
+int modemUp(const ModemOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    AtModem modem(options.device);
+    if (!modem.open(options.portWaitSec * 1000) || !modem.sync(10000)) return 2;
+
+    bool ok = modem.radioOn(options.gps, options.registerTimeoutSec * 1000);
+    long ms = static_cast<long>(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    if (!ok) return 3;
+    std::cout << "[Modem] Registered on " << modem.technology() << " in " << ms << " ms" << std::endl;
+    return 0;
+}
+
+int gpsFix(const ModemOptions& options) {
+    auto start = std::chrono::steady_clock::now();
+    AtModem modem(options.device);
+    if (!modem.open(options.portWaitSec * 1000) || !modem.sync(10000)) return 2;
+
+    std::string fix;
+    bool found = modem.gpsFix(options.gpsTimeoutSec * 1000, fix);
+    long ms = static_cast<long>(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    if (found) std::cout << "[GPS] Fix in " << ms << " ms: " << fix << std::endl;
+    else std::cout << "[GPS] No fix after " << ms << " ms" << std::endl;
+
+    // The history keeps the misses too
+    if (recordTelemetry("gps", fix) != 0) return 1;
+    return found ? 0 : 4;
+}
+
+int modemDown(const ModemOptions& options) {
+    AtModem modem(options.device);
+    if (!modem.open(2000) || !modem.sync(5000)) return 2;
+    if (!modem.radioOff()) {
+        std::cerr << "[Modem] ERROR: AT+CFUN=0 refused" << std::endl;
+        return 2;
+    }
+    std::cout << "[Modem] Flight mode" << std::endl;
+    return 0;
+}
+
+int exportCsv(int days) {
+    return utils::exportCsv(utils::getTelemetryFolder(), utils::getDataRoot(), days) ? 0 : 1;
+}
+
+int importCsv() {
+    return utils::importCsv(utils::getTelemetryFolder(), utils::getDataRoot()) >= 0 ? 0 : 1;
+}
+
+int bundle(int days, bool trainDict, int level) {
+    namespace fs = std::filesystem;
+    const std::string root = utils::getDataRoot();
+
+    // 1. Members per day folder (today, yesterday, ...)
+    std::vector<std::pair<std::string, std::vector<utils::BundleInput>>> folders;
+    std::vector<std::string> samples;
+    std::time_t now = std::time(nullptr);
+    for (int d = 0; d < days; ++d) {
+        std::time_t t = now - static_cast<std::time_t>(d) * 86400;
+        char day[16];
+        std::strftime(day, sizeof(day), "%Y-%m-%d", std::localtime(&t));
+        std::vector<utils::BundleInput> inputs;
+        std::error_code ec;
+        for (const fs::directory_entry& entry : fs::directory_iterator(fs::path(root) / day, ec)) {
+            const std::string name = entry.path().filename().string();
+            if (!utils::isBundleMember(name) || !entry.is_regular_file(ec)) continue;
+            inputs.push_back({ entry.path().string(), std::string(day) + "/" + name });
+            samples.push_back(entry.path().string());
+        }
+        std::sort(inputs.begin(), inputs.end(), [](const utils::BundleInput& a, const utils::BundleInput& b) {
+            return a.name < b.name;
+        });
+        if (!inputs.empty()) folders.emplace_back(day, inputs);
+    }
+
+    // 2. Dictionary: a fresh one, or the newest we have (none = plain zstd)
+    std::vector<uint8_t> dict;
+    if (trainDict) {
+        if (utils::trainBundleDictionary(samples, 16 * 1024, dict)) {
+            char name[48];
+            std::snprintf(name, sizeof(name), "bundle-dict-%08x.zdict", utils::bundleDictionaryId(dict));
+            if (!utils::writeFileAtomic(root + "/" + name, dict.data(), dict.size())) return 1;
+            std::cout << "[Bundle] Trained " << name << " (" << dict.size() / 1024 << " KB) on "
+                      << samples.size() << " files" << std::endl;
+        }
+    } else {
+        std::string dictPath = utils::findBundleDictionary(root);
+        if (!dictPath.empty() && !utils::loadBundleDictionary(dictPath, dict)) return 1;
+    }
+
+    // 3. One bundle per day
+    bool ok = true;
+    for (const auto& folder : folders) {
+        utils::BundleStats stats;
+        if (!utils::writeBundle(utils::bundlePath(root, folder.first), folder.second, dict, level, &stats)) {
+            ok = false;
+            continue;
+        }
+        // Formatted apart: std::cout keeps its own flags and precision
+        std::ostringstream line;
+        line << "[Bundle] " << folder.first << ": " << stats.files << " files, " << stats.rawBytes / 1024
+             << " KB -> " << stats.bundleBytes / 1024 << " KB (x" << std::fixed << std::setprecision(1)
+             << static_cast<double>(stats.rawBytes) / std::max<uint64_t>(1, stats.bundleBytes)
+             << ") in " << std::setprecision(0) << stats.encodeMs << " ms, dict " << std::hex << stats.dictId;
+        std::cout << line.str() << std::endl;
+    }
+    return ok ? 0 : 1;
+}
+
+namespace {
+
+// What each horus_app task of the graph reads from the run's command line (see main.cpp).
+// The stages' own arguments ("--days 2") are not here: a second copy would be ambiguous.
+std::vector<StageOption> stageOptions(const std::string& task) {
+    std::vector<StageOption> options = { { "--trace", true } };
+    std::vector<StageOption> more;
+    if (task == "capture") {
+        more = { { "--format", true }, { "--raw", false }, { "--aruco", false }, { "--aruco-scale", true },
+                 { "--dictionary", true }, { "--preview", true }, { "--threads", true }, { "--ae-tolerance", true },
+                 { "--max-warmup", true }, { "--denoise", true }, { "--denoise-mode", true },
+                 { "--target-kb", true }, { "--min-quality", true }, { "--jpeg-tables", true },
+                 { "--optimize-huffman", false }, { "--roi", true }, { "--roi-software", false },
+                 { "--scene", true }, { "--scene-bits", true }, { "--context-scale", true } };
+    } else if (task == "monitor_env") {
+        more = { { "--bme-os", true }, { "--bme-iir", true }, { "--bme-burst", true } };
+    } else if (task == "modem_up" || task == "gps_fix" || task == "modem_down") {
+        more = { { "--modem", true }, { "--register-timeout", true }, { "--gps-timeout", true }, { "--no-gps", false } };
+    } else if (task == "upload") {
+        more = { { "--rclone-conf", true }, { "--remote", true }, { "--bucket", true }, { "--endpoint", true },
+                 { "--jobs", true }, { "--part-mb", true } };
+    } else if (task == "bundle") {
+        more = { { "--level", true } };
+    }
+    options.insert(options.end(), more.begin(), more.end());
+    return options;
+}
+
+}
+
+int daily(const DailyOptions& options) {
+    namespace fs = std::filesystem;
+
+    // 1. Commands: this binary for the tasks, the helper script for the hardware steps
+    std::error_code ec;
+    const fs::path exe = fs::read_symlink("/proc/self/exe", ec);
+    const std::string script = !options.stagesScript.empty() ? options.stagesScript
+                             : (exe.parent_path().parent_path() / "scripts" / "daily_stages.sh").string();
+    const bool daemonUp = fs::is_socket(options.daemonSocket, ec);
+    // Each task gets only the forwarded options it reads; the daemon has its own
+    auto app = [&](std::vector<std::string> args) {
+        std::vector<std::string> forwarded = selectOptions(options.forwardArgs, stageOptions(args[1]));
+        args.insert(args.begin(), exe.string());
+        args.insert(args.end(), forwarded.begin(), forwarded.end());
+        return args;
+    };
+    auto sensorTask = [&](const std::string& task) {
+        if (!daemonUp) return app({ "--task", task });
+        // The daemon runs the task with the options of its own command line
+        for (const std::string& arg : selectOptions(options.forwardArgs, stageOptions(task))) {
+            if (arg.rfind("--", 0) == 0) {
+                std::cerr << "[Graph] WARNING: " << task << " runs in the daemon, " << arg
+                          << " ignored (set it on the daemon's ExecStart)" << std::endl;
+            }
+        }
+        return std::vector<std::string>{ exe.string(), "--task", "ctl", "--socket", options.daemonSocket, "--cmd", task };
+    };
+    std::vector<StageOption> known;
+    for (const char* task : { "capture", "monitor_env", "modem_up", "upload", "bundle" }) {
+        std::vector<StageOption> taskOptions = stageOptions(task);
+        known.insert(known.end(), taskOptions.begin(), taskOptions.end());
+    }
+    std::vector<std::string> unused;
+    selectOptions(options.forwardArgs, known, &unused);
+    for (const std::string& arg : unused) {
+        if (arg.rfind("--", 0) == 0) std::cerr << "[Graph] Ignoring " << arg << ": no stage takes it" << std::endl;
+    }
+    auto helper = [&](const std::string& stage) { return std::vector<std::string>{ "/bin/bash", script, stage }; };
+    std::vector<std::string> bundleArgs = { "--task", "bundle", "--days", "2" };
+    if (utils::findBundleDictionary(utils::getDataRoot()).empty()) bundleArgs.push_back("--train-dict");
+
+    // 2. The graph: name, command, after, needs, resource, deadline (s), dry-run duration (ms).
+    // Durations are typical CM4 + SIM7600 figures from the daily log; gps_fix is short
+    // because GNSS has been searching since modem_up.
+    std::vector<Stage> stages = {
+        { "rpicam",      helper("rpicam_capture"),         {},                        {},          "camera", 30,   4000 },
+        { "modem_reset", helper("modem_reset"),            {},                        {},          "modem",  20,   1100 },
+        { "usb_drivers", helper("usb_drivers"),            { "modem_reset" },         {},          "modem",  30,   1500 },
+        { "modem_up",    app({ "--task", "modem_up" }),    { "usb_drivers" },         {},          "modem",  150,  18000 },
+        { "gps_fix",     app({ "--task", "gps_fix" }),     { "modem_up" },            {},          "modem",  90,   3000 },
+        { "network",     helper("lte_dhcp"),               {},                        { "modem_up" }, "",    60,   4000 },
+        { "monitor_env", sensorTask("monitor_env"),        {},                        {},          "i2c",    30,   400 },
+        { "capture",     sensorTask("capture"),            { "rpicam" },              {},          "camera", 120,  7000 },
+        { "export_csv",  app({ "--task", "export_csv", "--days", "2" }), { "monitor_env", "gps_fix" }, {}, "", 60, 800 },
+        { "bundle",      app(bundleArgs),                  { "export_csv" },          {},          "",       120,  1500 },
+        { "upload",      app({ "--task", "upload", "--days", "2" }), { "bundle", "capture" }, { "network" }, "", 1800, 60000 },
+    };
+
+    // 3. Overrides, then run
+    TaskGraph graph;
+    for (Stage& stage : stages) {
+        if (std::find(options.skip.begin(), options.skip.end(), stage.name) != options.skip.end()) {
+            stage.command.clear(); // No-op: keeps the ordering of the rest
+        }
+        for (const auto& simulated : options.simulatedMs) {
+            if (simulated.first == stage.name) stage.simulatedMs = simulated.second;
+        }
+        graph.add(stage);
+    }
+    std::string error;
+    if (!graph.validate(error)) {
+        std::cerr << "[Graph] ERROR: " << error << std::endl;
+        return 1;
+    }
+    std::vector<StageResult> results = graph.run(options.dryRun);
+    printSchedule(results, options.dryRun);
+
+    bool ok = true;
+    for (const StageResult& result : results) {
+        ok = ok && (result.status == StageStatus::Ok || result.name == "gps_fix"); // No fix is no failure
+    }
+    return ok ? 0 : 1;
+}
+
+int upload(const cloud::S3Config& config, int days, const cloud::UploadOptions& options) {
+    const std::string root = utils::getDataRoot();
+
+    // 1. The index is the whole picture: what was written, what the bucket already has
+    utils::FileIndex index;
+    if (!index.claimUploader() || !index.load(root, true)) return 1;
+
+    cloud::UploadStats stats;
+    std::vector<cloud::UploadItem> items = cloud::planUploads(root, days, index, options, stats);
+    std::cout << "[Upload] " << items.size() << " to send, " << stats.skipped << " up to date, "
+              << stats.bundled << " bundled, "
+              << stats.hashed << " hashed (plan " << static_cast<long>(stats.planMs) << " ms), "
+              << options.jobs << " in flight to " << config.endpoint << "/" << config.bucket << std::endl;
+
+    // 2. Send the delta
+    bool ok = cloud::uploadAll(config, items, &index, options, stats);
+    std::cout << "[Upload] uploaded=" << stats.uploaded << " tails=" << stats.tails << " skipped=" << stats.skipped
+              << " resumed=" << stats.resumed << " failed=" << stats.failed
+              << " payload_kb=" << stats.bytes / 1024 << " wire_kb=" << stats.wireBytes / 1024
+              << " wall_ms=" << static_cast<long>(stats.wallMs) << std::endl;
+    return ok ? 0 : 1;
+}
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "sensors/Camera/Camera.hpp"
+#include "sensors/BME280/bme280.hpp"
+#include "sensors/Modem/AtModem.hpp"
+#include "sensors/System/SystemMonitor.hpp"
+#include "cloud/Uploader.hpp"
+
+namespace horus {
+namespace tasks {
+
+    // Returns ISO 8601 string: "2026-02-03T12:00:00"
+    // or specific format for images
+    std::string getTimestamped(const std::string& extension);
+
+    // The task bodies, shared by the one-shot CLI and the daemon.
+    // They take already-constructed sensors so the daemon can keep them alive.
+    // Return values are process exit codes (0 = success).
+
+    // TASK: IMAGE CAPTURE (2 = camera init failed, 3 = capture failed)
+    int capture(Camera& cam, const CameraOptions& options);
+
+    // TASK: HDR CAPTURE, one fused JPEG from an exposure bracket (same exit codes as capture)
+    int captureHdr(Camera& cam, const CameraOptions& options, const std::vector<float>& evOffsets);
+
+    // TASK: MULTI-CAMERA CAPTURE: cameras 'indices' (empty = every camera found) warm up
+    // and capture side by side into "img_<time>_cam<N>.jpg", their JPEGs sharing one
+    // encoder pool; what they hold together stays within 'memoryBudgetBytes'
+    // (same exit codes as capture: 2 = no camera, 3 = a capture failed)
+    int captureMulti(const CameraOptions& options, const std::vector<int>& indices, size_t memoryBudgetBytes);
+
+    // TASK: DEVELOP RAW dumps ('input' = file or folder, empty = today's folder)
+    // into "jpeg" (half resolution) or "dng" (lossless). Already developed files are skipped.
+    int develop(const std::string& input, const std::string& format);
+
+    // TASK: ARUCO CHECK on existing JPEGs ('input' = file or folder, empty = today's folder),
+    // decoded at 1/scale. Writes a "<stem>.aruco.json" sidecar next to each image
+    // (img.jpg -> img.aruco.json).
+    int detectAruco(const std::string& input, int scale, const std::string& dictionaryPath);
+
+    // TASK: ENVIRONMENTAL LOGGING (sensor must already be init()'ed), into the telemetry log.
+    // burstSamples > 1 logs the mean of that many forced conversions, with their variance.
+    int monitorEnv(BME280& sensor, int burstSamples = 1);
+
+    // TASK: SYSTEM LOGGING (replaces monitor_cpu.sh): SoC temperature, cpufreq, load, memory,
+    // free space and the firmware throttling flags, read in-process, into the telemetry log
+    // as one Cpu record (cpu_info.csv). 'sources' can point at a fake sysfs / procfs tree.
+    int monitorSys(const SystemSources& sources = SystemSources());
+
+    // TASK: RECORD one sample from the shell scripts into the telemetry log.
+    // source "cpu": data = "<temp C>,<throttled hex>"; source "gps": data = CGPSINFO fix or "No Fix"
+    int recordTelemetry(const std::string& source, const std::string& data);
+
+    // TASK: MODEM UP: radio on (and GNSS), returns once registered
+    // (2 = no port or no answer, 3 = not registered before the deadline)
+    int modemUp(const ModemOptions& options);
+
+    // TASK: GPS FIX: waits for a position, GNSS off, records it (or "No Fix") in the
+    // telemetry log (2 = no port or no answer, 4 = no fix)
+    int gpsFix(const ModemOptions& options);
+
+    // TASK: MODEM DOWN: GNSS off, flight mode (2 = no port or no answer)
+    int modemDown(const ModemOptions& options);
+
+    // TASK: EXPORT the telemetry log to the CSV files we upload
+    // (environmental_data.csv for the last 'days' days, 0 = all; cpu / gps history in full)
+    int exportCsv(int days);
+
+    // TASK: IMPORT existing CSVs into an empty telemetry log (one-off migration)
+    int importCsv();
+
+    // TASK: BUNDLE the small files of the last 'days' day folders into "<day>/<day>.hbn"
+    // (zstd 'level', with the newest root dictionary; trainDict = train a new one first
+    // from those same files). The uploader then leaves the bundled files out.
+    int bundle(int days, bool trainDict, int level);
+
+    struct DailyOptions {
+        bool dryRun = false;
+        std::vector<std::string> skip;        // Stages left out (kept as no-ops, so their dependents still run)
+        std::vector<std::pair<std::string, int>> simulatedMs; // Dry-run durations instead of the defaults
+        std::string stagesScript;             // Empty = scripts/daily_stages.sh next to the build folder
+        std::string daemonSocket = "/tmp/horus.sock"; // Capture / env go through the daemon when it is up
+        std::vector<std::string> forwardArgs; // Stage options (capture, modem, upload...): each stage gets its own
+    };
+
+    // TASK: DAILY wake cycle as a stage graph: the camera, the sensors and the local
+    // data work run while the modem resets, registers and searches for GNSS; the upload
+    // starts once the network is up and the data is ready. Every stage is a child
+    // process with a deadline. Returns 1 if a stage failed or timed out.
+    int daily(const DailyOptions& options);
+
+    // TASK: UPLOAD what changed in the cumulative files and the last 'days' day folders
+    // to S3, resuming whatever the previous run left half-done (state in the FileIndex)
+    int upload(const cloud::S3Config& config, int days, const cloud::UploadOptions& options);
+
+}
+}
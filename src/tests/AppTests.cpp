@@ -0,0 +1,147 @@
+// Command line and task plumbing of horus_app: the checked option parsing, the stage
+// graph of --task daily and the options it hands to each stage.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <climits>
+#include <ctime>
+
+#include "Tests.hpp"
+#include "utils/Args.hpp"
+#include "tasks/TaskGraph.hpp"
+
+namespace horus {
+namespace tests {
+
+namespace {
+
+// Whole-text numbers only; a rejected value leaves the default in place
+void testArgs(const TestContext&) {
+    int value = 7;
+    check(utils::parseInt("12", value) && value == 12, "int 12");
+    check(utils::parseInt("-2", value) && value == -2, "int -2");
+    check(utils::parseInt("+3", value) && value == 3, "int +3");
+    check(utils::parseInt(std::to_string(INT_MAX), value) && value == INT_MAX, "int max");
+    for (const char* bad : { "", "abc", "12ms", "1.5", "0x10", "--raw", "99999999999", "-99999999999", "4 " }) {
+        value = 7;
+        check(!utils::parseInt(bad, value) && value == 7, std::string("int rejects '") + bad + "'");
+    }
+
+    float number = 0.5f;
+    check(utils::parseFloat("0.02", number) && number == 0.02f, "float 0.02");
+    check(utils::parseFloat("-2", number) && number == -2.0f, "float -2");
+    check(utils::parseFloat("1e-3", number) && number == 1e-3f, "float 1e-3");
+    for (const char* bad : { "", "abc", "0.02x", "1e99", "nan", "inf", "1,5" }) {
+        number = 0.5f;
+        check(!utils::parseFloat(bad, number) && number == 0.5f, std::string("float rejects '") + bad + "'");
+    }
+}
+
+const tasks::StageResult* findResult(const std::vector<tasks::StageResult>& results, const std::string& name) {
+    for (const tasks::StageResult& result : results) {
+        if (result.name == name) return &result;
+    }
+    return nullptr;
+}
+
+// Ordering, resources, deadlines and needs on the virtual clock of a dry run, then one
+// real run with a failing and an overdue child; std::cout's format survives the logging
+void testGraph(const TestContext&) {
+    using tasks::Stage;
+    using tasks::StageStatus;
+    const std::vector<std::string> work = { "/bin/true" };
+    const std::ios::fmtflags flags = std::cout.flags();
+    const std::streamsize precision = std::cout.precision();
+
+    // 1. Broken graphs are refused
+    std::string error;
+    tasks::TaskGraph cycle;
+    cycle.add({ "a", work, { "b" }, {}, "", 0, 100 });
+    cycle.add({ "b", work, { "a" }, {}, "", 0, 100 });
+    check(!cycle.validate(error), "cycle refused");
+    tasks::TaskGraph unknown;
+    unknown.add({ "a", work, { "missing" }, {}, "", 0, 100 });
+    check(!unknown.validate(error), "unknown predecessor refused");
+
+    // 2. modem_up waits for the modem held by modem_reset, env overlaps both, the slow
+    // gps stage is cut at its deadline and upload, which needs it, is skipped
+    tasks::TaskGraph graph;
+    graph.add({ "modem_reset", work, {}, {}, "modem", 0, 1000 });
+    graph.add({ "modem_up", work, {}, {}, "modem", 0, 2000 });
+    graph.add({ "env", work, {}, {}, "i2c", 0, 500 });
+    graph.add({ "gps", work, { "modem_up" }, {}, "modem", 1, 5000 });
+    graph.add({ "upload", work, { "env" }, { "gps" }, "", 0, 100 });
+    graph.add({ "bundle", {}, { "env" }, {}, "", 0, 700 });
+    if (!check(graph.validate(error), "valid graph: " + error)) return;
+    std::vector<tasks::StageResult> results = graph.run(true);
+    const tasks::StageResult* reset = findResult(results, "modem_reset");
+    const tasks::StageResult* up = findResult(results, "modem_up");
+    const tasks::StageResult* env = findResult(results, "env");
+    const tasks::StageResult* gps = findResult(results, "gps");
+    const tasks::StageResult* upload = findResult(results, "upload");
+    const tasks::StageResult* bundle = findResult(results, "bundle");
+    if (!check(reset && up && env && gps && upload && bundle, "every stage has a result")) return;
+    check(reset->startMs == 0 && env->startMs == 0 && up->startMs == 1000, "modem held: modem_up at " +
+          std::to_string(up->startMs) + " ms");
+    check(gps->status == StageStatus::TimedOut && gps->endMs == 4000, "deadline: gps ended at " +
+          std::to_string(gps->endMs) + " ms");
+    check(upload->status == StageStatus::Skipped, "needs: upload skipped after the gps timeout");
+    check(bundle->status == StageStatus::Ok && bundle->endMs == 500, "no command: bundle is a join point");
+
+    // 3. Real children: an exit code is kept, an overdue child is terminated, and one
+    // that closes its output but keeps running is waited for without spinning on poll()
+    tasks::TaskGraph real;
+    real.add({ "fails", { "/bin/sh", "-c", "exit 3" }, {}, {}, "", 0, 0 });
+    real.add({ "hangs", { "/bin/sleep", "30" }, {}, {}, "", 1, 0 });
+    real.add({ "after", work, {}, { "fails" }, "", 0, 0 });
+    real.add({ "quiet", { "/bin/sh", "-c", "echo closing; exec >/dev/null 2>&1; sleep 1" }, {}, {}, "", 0, 0 });
+    const std::clock_t cpuStart = std::clock();
+    results = real.run(false);
+    const double cpuMs = 1000.0 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    const tasks::StageResult* fails = findResult(results, "fails");
+    const tasks::StageResult* hangs = findResult(results, "hangs");
+    const tasks::StageResult* after = findResult(results, "after");
+    if (!check(fails && hangs && after, "every real stage has a result")) return;
+    check(fails->status == StageStatus::Failed && fails->exitCode == 3, "exit code " + std::to_string(fails->exitCode));
+    check(hangs->status == StageStatus::TimedOut && hangs->endMs < 3000, "sleep 30 ended after " +
+          std::to_string(hangs->endMs) + " ms");
+    check(after->status == StageStatus::Skipped, "needs: skipped after a failure");
+    const tasks::StageResult* quiet = findResult(results, "quiet");
+    check(quiet && quiet->status == StageStatus::Ok && quiet->endMs >= 1000, "output closed: stage still waited for");
+    check(cpuMs < 300.0, "scheduler CPU while a stage runs with its output closed: " + std::to_string(cpuMs) + " ms");
+
+    // 4. The progress lines and the schedule leave std::cout's number format alone
+    tasks::printSchedule(results, false);
+    check(std::cout.flags() == flags && std::cout.precision() == precision, "std::cout format changed");
+}
+
+// Each stage gets only its own options, once, with their values in both spellings
+void testForward(const TestContext&) {
+    const std::vector<tasks::StageOption> upload = { { "--jobs", true }, { "--part-mb", true }, { "--trace", true } };
+    const std::vector<tasks::StageOption> capture = { { "--raw", false }, { "--roi", true }, { "--trace", true } };
+    const std::vector<std::string> args = { "--days", "3", "--raw", "--jobs", "8", "--roi=0,0,64,64", "--part-mb=16",
+                                            "--trace", "/tmp/t/", "--no-such", "--bucket", "b" };
+
+    std::vector<std::string> rest;
+    const std::vector<std::string> forUpload = tasks::selectOptions(args, upload, &rest);
+    check(forUpload == std::vector<std::string>({ "--jobs", "8", "--part-mb=16", "--trace", "/tmp/t/" }),
+          "upload options");
+    check(rest == std::vector<std::string>({ "--days", "3", "--raw", "--roi=0,0,64,64", "--no-such", "--bucket", "b" }),
+          "options left over for the other stages");
+    check(tasks::selectOptions(args, capture) ==
+          std::vector<std::string>({ "--raw", "--roi=0,0,64,64", "--trace", "/tmp/t/" }),
+          "capture options: a switch does not take the next argument");
+    check(tasks::selectOptions({ "--jobs" }, upload) == std::vector<std::string>({ "--jobs" }), "value missing at the end");
+    check(tasks::selectOptions(args, {}).empty(), "no options for a stage that takes none");
+}
+
+}
+
+void addAppTests(std::vector<TestCase>& tests) {
+    tests.push_back({ "args", testArgs });
+    tests.push_back({ "graph", testGraph });
+    tests.push_back({ "forward", testForward });
+}
+
+}
+}
@@ -0,0 +1,120 @@
+#include "Fixtures.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <jpeglib.h>
+
+namespace horus {
+namespace tests {
+
+std::vector<uint8_t> makeSyntheticBGR(int width, int height) {
+    std::vector<uint8_t> frame(static_cast<size_t>(width) * height * 3);
+    uint32_t noise = 12345;
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = &frame[static_cast<size_t>(y) * width * 3];
+        for (int x = 0; x < width; ++x) {
+            noise = noise * 1664525u + 1013904223u;
+            uint8_t n = static_cast<uint8_t>(noise >> 27); // 0..31
+            row[x * 3 + 0] = static_cast<uint8_t>((x * 255) / width) ^ n;
+            row[x * 3 + 1] = static_cast<uint8_t>((y * 255) / height) + n;
+            row[x * 3 + 2] = static_cast<uint8_t>(((x + y) >> 3) & 0xFF);
+        }
+    }
+    return frame;
+}
+
+imaging::FrameView bgrView(const std::vector<uint8_t>& bgr, int width, int height) {
+    imaging::FrameView frame;
+    frame.width = width;
+    frame.height = height;
+    frame.planes[0] = bgr.data();
+    frame.strides[0] = width * 3;
+    return frame;
+}
+
+bool loadJpegBgr(const std::string& path, imaging::OwnedFrame& frame) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return false;
+    }
+    struct jpeg_decompress_struct cinfo;
+    struct jpeg_error_mgr jerr;
+    cinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&cinfo);
+    jpeg_stdio_src(&cinfo, file);
+    jpeg_read_header(&cinfo, TRUE);
+    cinfo.out_color_space = JCS_RGB;
+    jpeg_start_decompress(&cinfo);
+    frame.allocate(imaging::PixelLayout::BGR888, cinfo.output_width, cinfo.output_height);
+    while (cinfo.output_scanline < cinfo.output_height) {
+        uint8_t* row = frame.plane(0) + static_cast<size_t>(cinfo.output_scanline) * frame.strides[0];
+        jpeg_read_scanlines(&cinfo, &row, 1);
+        for (int x = 0; x < frame.width; ++x) std::swap(row[x * 3], row[x * 3 + 2]);
+    }
+    jpeg_finish_decompress(&cinfo);
+    jpeg_destroy_decompress(&cinfo);
+    fclose(file);
+    return true;
+}
+
+std::vector<utils::BundleInput> makeBundleDay(const std::string& folder, int day) {
+    std::filesystem::create_directories(folder);
+    std::vector<utils::BundleInput> inputs;
+    auto add = [&](const std::string& name, const std::string& text) {
+        std::ofstream(folder + "/" + name) << text;
+        inputs.push_back({ folder + "/" + name, name });
+    };
+    char line[256];
+    std::string csv = "Timestamp,Temperature_C,Humidity_Pct,Pressure_hPa\n";
+    for (int i = 0; i < 96; ++i) {
+        std::snprintf(line, sizeof(line), "2026-01-%02dT%02d:%02d:00,%.2f,%.2f,%.2f\n", day + 1, i / 4, i % 4 * 15,
+                      12.0 + 6.0 * std::sin(i / 15.3) + day * 0.1, 60.0 + 20.0 * std::cos(i / 11.0), 985.0 + i * 0.03);
+        csv += line;
+    }
+    add("environmental_data.csv", csv);
+    std::string log;
+    for (int i = 0; i < 24; ++i) {
+        char stamp[32];
+        std::snprintf(stamp, sizeof(stamp), "2026-01-%02d_%02d-00-%02d", day + 1, i, (i * 7 + day) % 60);
+        std::snprintf(line, sizeof(line),
+                      "{\n  \"timestamp\": \"%s\",\n  \"exposure_us\": %d,\n  \"analogue_gain\": %.3f,\n"
+                      "  \"colour_gains\": [%.4f, %.4f],\n  \"lux\": %.1f,\n  \"sensor\": \"imx708\",\n"
+                      "  \"width\": 4608,\n  \"height\": 2592\n}\n",
+                      stamp, 1000 + i * 37 * (day + 1) % 30000, 1.0 + (i % 8) * 0.125, 1.8 + i * 0.01, 1.5 + day * 0.01,
+                      50.0 + i * 113.7);
+        add(std::string(stamp) + ".json", line);
+        std::snprintf(line, sizeof(line),
+                      "{\n  \"image\": \"%s.jpg\",\n  \"dictionary\": \"tag36h11\",\n  \"markers\": [\n"
+                      "    { \"id\": 2, \"corners\": [[%d, %d], [%d, %d], [%d, %d], [%d, %d]] }\n  ]\n}\n",
+                      stamp, 1200 + i, 800 + day, 1400 + i, 802 + day, 1398 + i, 1000 + day, 1199 + i, 998 + day);
+        add(std::string(stamp) + ".aruco.json", line);
+        std::snprintf(line, sizeof(line), "[%s] [Camera] Converged after %d frames, wrote %s.jpg\n",
+                      stamp, 8 + i % 5, stamp);
+        log += line;
+    }
+    add("horus.log", log);
+    return inputs;
+}
+
+void makeFakeSysfs(const std::string& root) {
+    namespace fs = std::filesystem;
+    auto put = [&](const std::string& path, const std::string& text) {
+        fs::create_directories((fs::path(root) / path).parent_path());
+        std::ofstream(fs::path(root) / path) << text;
+    };
+    put("sys/class/thermal/thermal_zone0/temp", "48312\n");
+    put("sys/class/thermal/thermal_zone1/temp", "51050\n");
+    put("sys/class/thermal/cooling_device0/cur_state", "0\n"); // Not a zone
+    put("sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "1500000\n");
+    put("sys/devices/platform/soc/soc:firmware/get_throttled", "50005\n");
+    put("proc/loadavg", "0.42 0.30 0.21 1/123 4567\n");
+    put("proc/meminfo", "MemTotal:        1872524 kB\nMemFree:          912340 kB\n"
+                        "MemAvailable:    1423004 kB\nBuffers:           41216 kB\n");
+}
+
+}
+}
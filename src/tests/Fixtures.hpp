@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "imaging/Frame.hpp"
+#include "utils/Bundle.hpp"
+
+namespace horus {
+namespace tests {
+
+    // Test data shared by horus_tests and horus_bench: synthetic frames, the bundled
+    // field photos, and the small files / fake trees the storage and system code reads.
+
+    // Full resolution IMX708 still
+    static const int kWidth = 4608;
+    static const int kHeight = 2592;
+
+    // Smooth gradients + some per-pixel texture, so the encoder has real work to do
+    std::vector<uint8_t> makeSyntheticBGR(int width, int height);
+
+    // BGR888 view over a buffer from makeSyntheticBGR()
+    imaging::FrameView bgrView(const std::vector<uint8_t>& bgr, int width, int height);
+
+    // Decodes a JPEG into a BGR frame, as the camera would deliver it
+    bool loadJpegBgr(const std::string& path, imaging::OwnedFrame& frame);
+
+    // One day of small files as the station writes them: the day's CSV, a metadata and a
+    // marker sidecar per capture, the task log. Values drift with 'day' so no two days
+    // are identical.
+    std::vector<utils::BundleInput> makeBundleDay(const std::string& folder, int day);
+
+    // A Raspberry Pi's sysfs / procfs nodes under 'root' (two thermal zones at 48.312 and
+    // 51.05 C, 1500 MHz, load 0.42, 1872524 / 1423004 kB, throttled 0x50005)
+    void makeFakeSysfs(const std::string& root);
+
+}
+}
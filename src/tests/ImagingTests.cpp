@@ -0,0 +1,678 @@
+// Imaging kernels: the YUV420 encode path against the BGR888 one, the strip-parallel
+// encoder against the single-threaded one, exposure fusion, temporal denoise, preview
+// pyramids, the marker family and its detection on drawn markers, marker detection and
+// scene verdicts on the bundled field photos, rate control predictions, ROI crop geometry.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <fstream>
+#include <filesystem>
+#include <functional>
+#include <algorithm>
+
+#include "Tests.hpp"
+#include "Fixtures.hpp"
+#include "imaging/Frame.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "imaging/ParallelJpegEncoder.hpp"
+#include "imaging/ExposureFusion.hpp"
+#include "imaging/TemporalDenoise.hpp"
+#include "imaging/PreviewPyramid.hpp"
+#include "imaging/ArucoDetector.hpp"
+#include "imaging/JpegRateControl.hpp"
+#include "imaging/Roi.hpp"
+#include "imaging/SceneSignature.hpp"
+
+namespace horus {
+namespace tests {
+
+namespace {
+
+using namespace imaging;
+
+// PSNR (dB) between two BGR frames of the same size
+double psnr(const OwnedFrame& a, const OwnedFrame& b) {
+    double sum = 0.0;
+    for (size_t i = 0; i < a.data.size(); ++i) {
+        const double d = static_cast<double>(a.data[i]) - b.data[i];
+        sum += d * d;
+    }
+    const double mse = sum / a.data.size();
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+// The same synthetic frame through the BGR888 path (libjpeg converts and downsamples)
+// and the YUV420 raw path (converted here with the JFIF matrix, 2x2 chroma averages,
+// as the ISP delivers it): both decodes must match each other and the source. Odd sizes
+// and both a packed and a padded stride (copy and zero-copy row paths).
+void testYuv420(const TestContext&) {
+    const std::string folder = scratchFolder("yuv420");
+    for (auto size : { std::make_pair(1536, 864), std::make_pair(641, 479) }) {
+        const int width = size.first;
+        const int height = size.second;
+        std::vector<uint8_t> bgr = makeSyntheticBGR(width, height);
+        OwnedFrame source;
+        copyFrame(bgrView(bgr, width, height), source);
+
+        // 1. BGR -> YCbCr 4:2:0
+        std::vector<float> cb(static_cast<size_t>(width) * height), cr(cb.size());
+        for (int pad : { 0, 64 }) {
+            const int chromaWidth = (width + 1) / 2;
+            const int chromaHeight = (height + 1) / 2;
+            const int strides[3] = { width + pad, chromaWidth + pad / 2, chromaWidth + pad / 2 };
+            std::vector<uint8_t> planes[3];
+            planes[0].assign(static_cast<size_t>(strides[0]) * height, 0);
+            planes[1].assign(static_cast<size_t>(strides[1]) * chromaHeight, 0);
+            planes[2].assign(static_cast<size_t>(strides[2]) * chromaHeight, 0);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    const uint8_t* px = &bgr[(static_cast<size_t>(y) * width + x) * 3];
+                    const float b = px[0], g = px[1], r = px[2];
+                    const float luma = 0.299f * r + 0.587f * g + 0.114f * b;
+                    planes[0][static_cast<size_t>(y) * strides[0] + x] =
+                        static_cast<uint8_t>(std::clamp(std::lround(luma), 0L, 255L));
+                    cb[static_cast<size_t>(y) * width + x] = -0.168736f * r - 0.331264f * g + 0.5f * b + 128.0f;
+                    cr[static_cast<size_t>(y) * width + x] = 0.5f * r - 0.418688f * g - 0.081312f * b + 128.0f;
+                }
+            }
+            for (int y = 0; y < chromaHeight; ++y) {
+                for (int x = 0; x < chromaWidth; ++x) {
+                    float u = 0.0f, v = 0.0f;
+                    for (int i = 0; i < 4; ++i) {
+                        const int sx = std::min(2 * x + (i & 1), width - 1);
+                        const int sy = std::min(2 * y + (i >> 1), height - 1);
+                        u += cb[static_cast<size_t>(sy) * width + sx];
+                        v += cr[static_cast<size_t>(sy) * width + sx];
+                    }
+                    planes[1][static_cast<size_t>(y) * strides[1] + x] =
+                        static_cast<uint8_t>(std::clamp(std::lround(u / 4.0f), 0L, 255L));
+                    planes[2][static_cast<size_t>(y) * strides[2] + x] =
+                        static_cast<uint8_t>(std::clamp(std::lround(v / 4.0f), 0L, 255L));
+                }
+            }
+            FrameView yuv;
+            yuv.layout = PixelLayout::YUV420;
+            yuv.width = width;
+            yuv.height = height;
+            for (int p = 0; p < 3; ++p) {
+                yuv.planes[p] = planes[p].data();
+                yuv.strides[p] = strides[p];
+            }
+
+            // 2. Encode both, decode both
+            const std::string label = std::to_string(width) + "x" + std::to_string(height) +
+                                      (pad ? " padded" : " packed");
+            const FrameView inputs[2] = { source.view(), yuv };
+            OwnedFrame decoded[2];
+            bool encoded = true;
+            for (int i = 0; i < 2; ++i) {
+                std::vector<uint8_t> jpeg;
+                const std::string path = folder + "/" + std::to_string(i) + ".jpg";
+                encoded = encodeJpeg(inputs[i], jpeg) && encoded;
+                std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+                encoded = loadJpegBgr(path, decoded[i]) && encoded;
+            }
+            if (!check(encoded && decoded[0].width == width && decoded[0].height == height &&
+                       decoded[1].width == width && decoded[1].height == height, label + ": encode / decode")) {
+                continue;
+            }
+
+            // 3. The two paths agree, and neither strays from the source
+            const double between = psnr(decoded[0], decoded[1]);
+            const double bgrLoss = psnr(source, decoded[0]);
+            const double yuvLoss = psnr(source, decoded[1]);
+            check(between >= 40.0, label + ": BGR888 vs YUV420 decode " + std::to_string(between) + " dB");
+            check(yuvLoss >= bgrLoss - 0.5, label + ": YUV420 " + std::to_string(yuvLoss) + " dB vs BGR888 " +
+                  std::to_string(bgrLoss) + " dB against the source");
+        }
+    }
+    std::filesystem::remove_all(folder);
+}
+
+// The strip-parallel encoder splices its strips at restart markers: the result must be
+// the very file the single-threaded encoder writes with a restart marker per MCU row,
+// and decode to the same pixels. Full size, odd sizes, frames shorter than one MCU row
+// per strip, and a pool that does not divide the MCU rows evenly; both layouts.
+void testParallelJpeg(const TestContext&) {
+    const std::string folder = scratchFolder("parallel");
+    JpegOptions single;
+    single.restartRows = 1;
+    const std::pair<int, int> sizes[] = { { kWidth, kHeight }, { 641, 479 }, { 33, 17 }, { 100, 8 } };
+    for (unsigned threads : { 3u, 4u }) {
+        utils::ThreadPool pool(threads);
+        for (const auto& size : sizes) {
+            const int width = size.first;
+            const int height = size.second;
+            std::vector<uint8_t> bgr = makeSyntheticBGR(width, height);
+
+            // Planar copy of the same texture for the YUV420 path
+            OwnedFrame yuv;
+            yuv.allocate(PixelLayout::YUV420, width, height);
+            for (int p = 0; p < 3; ++p) {
+                const int rowBytes = planeRowBytes(PixelLayout::YUV420, width, p);
+                for (int y = 0; y < planeRows(PixelLayout::YUV420, height, p); ++y) {
+                    for (int x = 0; x < rowBytes; ++x) {
+                        yuv.plane(p)[static_cast<size_t>(y) * rowBytes + x] = bgr[(static_cast<size_t>(y) * width + x) * 3 + p];
+                    }
+                }
+            }
+
+            for (const FrameView& frame : { bgrView(bgr, width, height), yuv.view() }) {
+                const std::string label = std::to_string(width) + "x" + std::to_string(height) +
+                                          (frame.layout == PixelLayout::YUV420 ? " yuv420" : " bgr888") +
+                                          ", " + std::to_string(threads) + " threads";
+                std::vector<uint8_t> reference, parallel;
+                if (!check(encodeJpeg(frame, reference, single) && encodeJpegParallel(frame, parallel, pool),
+                           label + ": encode")) {
+                    continue;
+                }
+                check(parallel == reference, label + ": " + std::to_string(parallel.size()) + " bytes vs " +
+                      std::to_string(reference.size()) + " single-threaded");
+
+                OwnedFrame decoded[2];
+                const std::vector<uint8_t>* files[2] = { &reference, &parallel };
+                bool loaded = true;
+                for (int i = 0; i < 2; ++i) {
+                    const std::string path = folder + "/" + std::to_string(i) + ".jpg";
+                    std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(files[i]->data()),
+                                                                files[i]->size());
+                    loaded = loadJpegBgr(path, decoded[i]) && loaded;
+                }
+                check(loaded && decoded[1].width == width && decoded[1].height == height &&
+                      decoded[1].data == decoded[0].data, label + ": decode");
+            }
+        }
+    }
+    std::filesystem::remove_all(folder);
+}
+
+// makeSyntheticBGR() texture in either layout (planar: the B, G, R bytes become the Y, U,
+// V samples), every sample passed through 'tone'
+OwnedFrame syntheticFrame(PixelLayout layout, int width, int height,
+                          const std::function<uint8_t(uint8_t)>& tone = [](uint8_t v) { return v; }) {
+    std::vector<uint8_t> bgr = makeSyntheticBGR(width, height);
+    OwnedFrame frame;
+    frame.allocate(layout, width, height);
+    for (int p = 0; p < planeCount(layout); ++p) {
+        const int rowBytes = planeRowBytes(layout, width, p);
+        for (int y = 0; y < planeRows(layout, height, p); ++y) {
+            for (int x = 0; x < rowBytes; ++x) {
+                const size_t src = layout == PixelLayout::BGR888 ? static_cast<size_t>(y) * rowBytes + x
+                                                                 : (static_cast<size_t>(y) * width + x) * 3 + p;
+                frame.plane(p)[static_cast<size_t>(y) * rowBytes + x] = tone(bgr[src]);
+            }
+        }
+    }
+    return frame;
+}
+
+// Exposure fusion: N copies of one frame fuse to that frame exactly (the 8.8 weights
+// sum to 256), also in place; a dark / mid / bright bracket fuses to a blend, every
+// sample between the darkest and the brightest input. Odd sizes, both layouts.
+void testHdr(const TestContext&) {
+    for (PixelLayout layout : { PixelLayout::BGR888, PixelLayout::YUV420 }) {
+        for (auto size : { std::make_pair(641, 479), std::make_pair(33, 17), std::make_pair(100, 8) }) {
+            const std::string label = std::to_string(size.first) + "x" + std::to_string(size.second) +
+                                      (layout == PixelLayout::YUV420 ? " yuv420" : " bgr888");
+            const OwnedFrame frame = syntheticFrame(layout, size.first, size.second);
+            for (size_t count = 1; count <= 3; ++count) {
+                std::vector<FrameView> inputs(count, frame.view());
+                OwnedFrame fused;
+                check(fuseExposures(inputs, fused) && fused.data == frame.data,
+                      label + ": " + std::to_string(count) + " identical frames");
+            }
+            OwnedFrame inPlace = frame;
+            std::vector<FrameView> aliased = { inPlace.view(), frame.view(), frame.view() };
+            check(fuseExposures(aliased, inPlace) && inPlace.data == frame.data, label + ": in place");
+
+            const OwnedFrame bracket[3] = {
+                syntheticFrame(layout, size.first, size.second, [](uint8_t v) { return static_cast<uint8_t>(v / 4); }),
+                frame,
+                syntheticFrame(layout, size.first, size.second,
+                               [](uint8_t v) { return static_cast<uint8_t>(std::min(255, v * 4)); }),
+            };
+            OwnedFrame fused;
+            if (!check(fuseExposures({ bracket[0].view(), bracket[1].view(), bracket[2].view() }, fused) &&
+                       fused.data.size() == frame.data.size(), label + ": bracket")) {
+                continue;
+            }
+            size_t outside = 0;
+            for (size_t i = 0; i < fused.data.size(); ++i) {
+                if (fused.data[i] < bracket[0].data[i] || fused.data[i] > bracket[2].data[i]) ++outside;
+            }
+            check(outside == 0, label + ": " + std::to_string(outside) + " fused samples outside the bracket");
+        }
+    }
+    const OwnedFrame a = syntheticFrame(PixelLayout::BGR888, 64, 32);
+    const OwnedFrame b = syntheticFrame(PixelLayout::BGR888, 64, 30);
+    OwnedFrame fused;
+    check(!fuseExposures({ a.view(), b.view() }, fused), "frames of different sizes are refused");
+}
+
+// Temporal denoise: the average and the median of N copies of one frame are that frame;
+// two frames average to (a + b + 1) / 2; one inverted frame among identical ones is voted
+// out by the median; the accumulator refuses another geometry and frame 257. Odd sizes,
+// both layouts.
+void testDenoise(const TestContext&) {
+    for (PixelLayout layout : { PixelLayout::BGR888, PixelLayout::YUV420 }) {
+        for (auto size : { std::make_pair(641, 479), std::make_pair(33, 17), std::make_pair(100, 8) }) {
+            const std::string label = std::to_string(size.first) + "x" + std::to_string(size.second) +
+                                      (layout == PixelLayout::YUV420 ? " yuv420" : " bgr888");
+            const OwnedFrame frame = syntheticFrame(layout, size.first, size.second);
+            for (int count : { 1, 2, 3, 7, 16 }) {
+                FrameAccumulator accumulator;
+                bool added = true;
+                for (int i = 0; i < count; ++i) added = accumulator.add(frame.view()) && added;
+                OwnedFrame averaged;
+                check(added && accumulator.average(averaged) && averaged.data == frame.data,
+                      label + ": average of " + std::to_string(count) + " identical frames");
+            }
+            for (int count : { 3, 4, 5 }) {
+                std::vector<FrameView> inputs(count, frame.view());
+                OwnedFrame median;
+                check(temporalMedian(inputs, median) && median.data == frame.data,
+                      label + ": median of " + std::to_string(count) + " identical frames");
+            }
+
+            const OwnedFrame inverted =
+                syntheticFrame(layout, size.first, size.second, [](uint8_t v) { return static_cast<uint8_t>(255 - v); });
+            FrameAccumulator accumulator;
+            OwnedFrame averaged;
+            if (check(accumulator.add(frame.view()) && accumulator.add(inverted.view()) &&
+                      accumulator.average(averaged) && averaged.data.size() == frame.data.size(),
+                      label + ": average of two frames")) {
+                size_t wrong = 0;
+                for (size_t i = 0; i < averaged.data.size(); ++i) {
+                    if (averaged.data[i] != (frame.data[i] + inverted.data[i] + 1) / 2) ++wrong;
+                }
+                check(wrong == 0, label + ": " + std::to_string(wrong) + " averaged samples not rounded half up");
+            }
+            OwnedFrame median;
+            check(temporalMedian({ frame.view(), inverted.view(), frame.view(), frame.view(), frame.view() }, median) &&
+                  median.data == frame.data, label + ": median rejects an outlier frame");
+        }
+    }
+    const OwnedFrame a = syntheticFrame(PixelLayout::BGR888, 64, 32);
+    const OwnedFrame b = syntheticFrame(PixelLayout::BGR888, 64, 30);
+    FrameAccumulator accumulator;
+    check(accumulator.add(a.view()) && !accumulator.add(b.view()) && accumulator.count() == 1,
+          "accumulator refuses another geometry");
+    bool added = true;
+    for (int i = 1; i < FrameAccumulator::kMaxFrames; ++i) added = accumulator.add(a.view()) && added;
+    OwnedFrame averaged;
+    check(added && !accumulator.add(a.view()) && accumulator.average(averaged) && averaged.data == a.data,
+          "accumulator holds kMaxFrames frames and refuses one more");
+    check(!temporalMedian({ a.view(), b.view(), a.view() }, averaged), "median refuses another geometry");
+}
+
+// 2x2 box average of every plane with rounding, odd last row / column paired with itself
+OwnedFrame halve(const OwnedFrame& src) {
+    OwnedFrame dst;
+    dst.allocate(src.layout, (src.width + 1) / 2, (src.height + 1) / 2);
+    const FrameView in = src.view();
+    const int channels = src.layout == PixelLayout::BGR888 ? 3 : 1;
+    for (int p = 0; p < planeCount(src.layout); ++p) {
+        const int srcWidth = planeRowBytes(src.layout, src.width, p) / channels;
+        const int srcRows = planeRows(src.layout, src.height, p);
+        const int dstWidth = planeRowBytes(dst.layout, dst.width, p) / channels;
+        for (int y = 0; y < planeRows(dst.layout, dst.height, p); ++y) {
+            const int y0 = 2 * y, y1 = std::min(2 * y + 1, srcRows - 1);
+            for (int x = 0; x < dstWidth; ++x) {
+                const int x0 = 2 * x, x1 = std::min(2 * x + 1, srcWidth - 1);
+                for (int c = 0; c < channels; ++c) {
+                    const auto at = [&](int sx, int sy) {
+                        return in.planes[p][static_cast<size_t>(sy) * in.strides[p] + sx * channels + c];
+                    };
+                    dst.plane(p)[static_cast<size_t>(y) * dst.strides[p] + x * channels + c] =
+                        static_cast<uint8_t>((at(x0, y0) + at(x1, y0) + at(x0, y1) + at(x1, y1) + 2) / 4);
+                }
+            }
+        }
+    }
+    return dst;
+}
+
+// Preview pyramid: a flat frame gives flat previews of ceil(size / factor) at every level;
+// on the synthetic texture each level is the very file encodeJpeg() writes for a box
+// average of the level above, and so is the full picture written in the same pass. Odd
+// sizes, both layouts.
+void testPyramid(const TestContext&) {
+    const std::string folder = scratchFolder("pyramid");
+    const std::string path = folder + "/level.jpg";
+    const auto decode = [&path](const std::vector<uint8_t>& jpeg, OwnedFrame& frame) {
+        std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+        return loadJpegBgr(path, frame);
+    };
+    for (PixelLayout layout : { PixelLayout::BGR888, PixelLayout::YUV420 }) {
+        for (auto size : { std::make_pair(kWidth, kHeight), std::make_pair(641, 479), std::make_pair(33, 17),
+                           std::make_pair(100, 8) }) {
+            const int width = size.first;
+            const int height = size.second;
+            const std::string label = std::to_string(width) + "x" + std::to_string(height) +
+                                      (layout == PixelLayout::YUV420 ? " yuv420" : " bgr888");
+
+            // 1. Flat frame: every level the right size and still flat
+            const OwnedFrame flat = syntheticFrame(layout, width, height, [](uint8_t) { return uint8_t(128); });
+            std::vector<PyramidLevel> levels;
+            if (!check(encodePyramid(flat.view(), kMaxPyramidLevels, levels) &&
+                       levels.size() == static_cast<size_t>(kMaxPyramidLevels), label + ": flat pyramid")) {
+                continue;
+            }
+            for (const PyramidLevel& level : levels) {
+                const std::string name = label + " p" + std::to_string(level.factor);
+                const int expectedWidth = (width + level.factor - 1) / level.factor;
+                const int expectedHeight = (height + level.factor - 1) / level.factor;
+                OwnedFrame decoded;
+                if (!check(level.width == expectedWidth && level.height == expectedHeight && decode(level.jpeg, decoded) &&
+                           decoded.width == expectedWidth && decoded.height == expectedHeight, name + ": size")) {
+                    continue;
+                }
+                const auto range = std::minmax_element(decoded.data.begin(), decoded.data.end());
+                check(*range.first >= 126 && *range.second <= 130, name + ": flat preview spans " +
+                      std::to_string(*range.first) + ".." + std::to_string(*range.second));
+            }
+
+            // 2. Texture: the full picture from the same pass, and the levels against a reference
+            const OwnedFrame frame = syntheticFrame(layout, width, height);
+            std::vector<uint8_t> full, reference;
+            if (!check(encodePyramid(frame.view(), 3, levels, 80, &full) && levels.size() == 3 &&
+                       encodeJpeg(frame.view(), reference), label + ": textured pyramid")) {
+                continue;
+            }
+            check(full == reference, label + ": full picture differs from encodeJpeg()");
+            OwnedFrame expected = frame;
+            JpegOptions preview;
+            preview.quality = 80;
+            for (const PyramidLevel& level : levels) {
+                expected = halve(expected);
+                std::vector<uint8_t> jpeg;
+                check(encodeJpeg(expected.view(), jpeg, preview) && level.jpeg == jpeg,
+                      label + " p" + std::to_string(level.factor) + ": differs from the box average encoded alone");
+            }
+        }
+    }
+    std::filesystem::remove_all(folder);
+}
+
+// Code of marker 'code' turned by 'turns' quarter turns clockwise, in the dictionary's
+// reading order: cell (u, v) goes to (n - 1 - v, u), as in the detector
+uint64_t rotateCode(const MarkerDictionary& dictionary, uint64_t code, int turns) {
+    const int n = dictionary.markerBits;
+    const int bits = n * n;
+    for (int k = 0; k < turns; ++k) {
+        uint64_t rotated = 0;
+        for (int i = 0; i < bits; ++i) {
+            const std::pair<int, int> to(n - 1 - dictionary.bitCells[i].second, dictionary.bitCells[i].first);
+            const int j = static_cast<int>(std::find(dictionary.bitCells.begin(), dictionary.bitCells.end(), to) -
+                                           dictionary.bitCells.begin());
+            if ((code >> (bits - 1 - i)) & 1) rotated |= 1ULL << (bits - 1 - j);
+        }
+        code = rotated;
+    }
+    return code;
+}
+
+// Draws marker 'id' (border included) with 'cellPx' pixel cells at (x, y), turned by
+// 'turns' quarter turns clockwise, on a white luma plane
+void drawMarker(LumaImage& luma, const MarkerDictionary& dictionary, int id, int x, int y, int cellPx, int turns) {
+    const int n = dictionary.markerBits;
+    const int cells = n + 2;
+    std::vector<uint8_t> grid(cells * cells, 0);
+    for (int i = 0; i < n * n; ++i) {
+        const bool white = (dictionary.codes[id] >> (n * n - 1 - i)) & 1;
+        grid[(dictionary.bitCells[i].second + 1) * cells + dictionary.bitCells[i].first + 1] = white ? 255 : 0;
+    }
+    for (int cy = 0; cy < cells; ++cy) {
+        for (int cx = 0; cx < cells; ++cx) {
+            int u = cx, v = cy;
+            for (int k = 0; k < turns; ++k) { // Shown cell (u, v) comes from (v, cells - 1 - u)
+                const int t = u;
+                u = v;
+                v = cells - 1 - t;
+            }
+            for (int py = 0; py < cellPx; ++py) {
+                uint8_t* row = luma.data.data() + static_cast<size_t>(y + cy * cellPx + py) * luma.width;
+                std::fill(row + x + cx * cellPx, row + x + (cx + 1) * cellPx, grid[v * cells + u]);
+            }
+        }
+    }
+}
+
+// The built-in family: 587 codes at least 11 bits apart under every rotation, so
+// 'maxCorrection' errors never reach another marker; IDs from the whole range decode
+// when drawn; the *_yes_aruco photos carry tag36h11 id 2, the *_no_aruco ones carry nothing
+void testAruco(const TestContext& context) {
+    const MarkerDictionary dictionary = builtinDictionary();
+    check(dictionary.codes.size() == 587, "tag36h11 has 587 codes, built in: " + std::to_string(dictionary.codes.size()));
+    int closest = 64;
+    for (size_t a = 0; a < dictionary.codes.size(); ++a) {
+        for (int turns = 1; turns < 4; ++turns) {
+            const uint64_t rotated = rotateCode(dictionary, dictionary.codes[a], turns);
+            for (size_t b = a; b < dictionary.codes.size(); ++b) {
+                closest = std::min(closest, __builtin_popcountll(rotated ^ dictionary.codes[b]));
+            }
+        }
+        for (size_t b = a + 1; b < dictionary.codes.size(); ++b) {
+            closest = std::min(closest, __builtin_popcountll(dictionary.codes[a] ^ dictionary.codes[b]));
+        }
+    }
+    check(closest >= 11, "family distance " + std::to_string(closest) + ", expected 11");
+
+    LumaImage drawn;
+    drawn.width = 480;
+    drawn.height = 160;
+    drawn.data.assign(static_cast<size_t>(drawn.width) * drawn.height, 255);
+    const int ids[] = { 7, 300, 586 };
+    for (int i = 0; i < 3; ++i) drawMarker(drawn, dictionary, ids[i], 40 + i * 150, 48, 8, i);
+    std::vector<MarkerDetection> found = detectMarkers(drawn, dictionary);
+    std::sort(found.begin(), found.end(), [](const MarkerDetection& a, const MarkerDetection& b) { return a.id < b.id; });
+    check(found.size() == 3 && found[0].id == 7 && found[1].id == 300 && found[2].id == 586 &&
+          found[0].hamming == 0 && found[1].hamming == 0 && found[2].hamming == 0,
+          "drawn markers 7, 300 and 586: found " + std::to_string(found.size()));
+
+    const std::string names[] = { "test_1_plastic_yes_aruco", "test_2_no_plastic_yes_aruco",
+                                  "test_1_plastic_no_aruco", "test_2_no_plastic_no_aruco" };
+    for (const std::string& name : names) {
+        LumaImage luma;
+        if (!check(loadJpegLuma(context.fixtures + "/" + name + ".jpg", 4, luma), "load " + name)) continue;
+        std::vector<MarkerDetection> markers = detectMarkers(luma, dictionary);
+        if (name.find("_yes_") != std::string::npos) {
+            check(markers.size() == 1 && markers[0].id == 2, name + ": expected id 2, found " +
+                  std::to_string(markers.size()) + " marker(s)");
+        } else {
+            check(markers.empty(), name + ": expected no marker, found " + std::to_string(markers.size()));
+        }
+    }
+}
+
+// Budgets of 60 % and 30 % of the q90 size: the predicted size within 10 % of the actual
+void testRateControl(const TestContext& context) {
+    std::vector<std::pair<std::string, OwnedFrame>> images(2);
+    images[0].first = "test_1_plastic_yes_aruco";
+    images[1].first = "test_2_no_plastic_no_aruco";
+    for (auto& image : images) {
+        if (!check(loadJpegBgr(context.fixtures + "/" + image.first + ".jpg", image.second), "load " + image.first)) return;
+    }
+    std::vector<uint8_t> bgr = makeSyntheticBGR(kWidth, kHeight);
+
+    auto run = [&](const std::string& name, const FrameView& frame) {
+        std::vector<uint8_t> out;
+        encodeJpeg(frame, out);
+        const size_t reference = out.size();
+        for (double share : { 0.6, 0.3 }) {
+            RateControlOptions options;
+            options.targetBytes = static_cast<size_t>(reference * share);
+            RateControlResult result;
+            encodeJpegBudgeted(frame, out, options, result);
+            const double error = (static_cast<double>(result.actualBytes) / result.predictedBytes - 1.0) * 100.0;
+            check(std::fabs(error) <= 10.0, name + " budget " + std::to_string(options.targetBytes / 1024) +
+                  " KB: prediction off by " + std::to_string(error) + " %");
+        }
+    };
+    for (const auto& image : images) run(image.first, image.second.view());
+    run("synthetic", bgrView(bgr, kWidth, kHeight));
+}
+
+// Every pixel of a crop must be the source pixel at the crop's offset, in both layouts,
+// with padded strides and odd frame sizes
+void testRoi(const TestContext&) {
+    // 1. Parsing, bounds, field-relative coordinates
+    std::vector<Roi> rois;
+    check(parseRois("trunk=0.30,0.15,0.40,0.80; 0.9,0.9,0.5,0.5", rois) && rois.size() == 2 &&
+          rois[0].name == "trunk" && rois[1].name == "roi2" && std::fabs(rois[1].width - 0.1) < 1e-9, "parse");
+    std::vector<Roi> unchanged = rois;
+    check(!parseRois("a=0.1,0.1,0.2", unchanged) && !parseRois("a=0.1,0.1,0,0.2", unchanged) &&
+          !parseRois("../a=0.1,0.1,0.2,0.2", unchanged) && !parseRois("a=2,2,1,1", unchanged) &&
+          !parseRois("a=0.25abc,0.1,0.2,0.2", unchanged) && !parseRois("a=0.1,,0.2,0.2", unchanged) &&
+          !parseRois("p4=0.1,0.1,0.2,0.2", unchanged) &&
+          unchanged.size() == 2, "parse errors");
+    if (rois.size() != 2) return;
+    const Roi bounds = roiBounds(rois);
+    check(std::fabs(bounds.x - 0.3) < 1e-9 && std::fabs(bounds.y - 0.15) < 1e-9 &&
+          std::fabs(bounds.width - 0.7) < 1e-9 && std::fabs(bounds.height - 0.85) < 1e-9, "bounds");
+    const Roi inside = roiWithin(rois[0], bounds);
+    check(std::fabs(inside.x) < 1e-9 && std::fabs(inside.width - 0.4 / 0.7) < 1e-9, "within");
+
+    // 2. Pixel rectangles and zero-copy crops
+    auto value = [](int x, int y, int p) { return static_cast<uint8_t>(x * 7 + y * 13 + p * 101); };
+    uint32_t noise = 12345;
+    auto next = [&] { noise = noise * 1664525u + 1013904223u; return (noise >> 8) / 16777216.0; };
+    for (PixelLayout layout : { PixelLayout::BGR888, PixelLayout::YUV420 }) {
+        for (auto size : { std::make_pair(641, 479), std::make_pair(640, 480), std::make_pair(33, 17) }) {
+            const int width = size.first;
+            const int height = size.second;
+            const std::string label = std::string(layout == PixelLayout::BGR888 ? "BGR888 " : "YUV420 ") +
+                                      std::to_string(width) + "x" + std::to_string(height);
+            const int pixelBytes = layout == PixelLayout::BGR888 ? 3 : 1;
+            std::vector<std::vector<uint8_t>> planes(planeCount(layout));
+            FrameView frame;
+            frame.layout = layout;
+            frame.width = width;
+            frame.height = height;
+            for (int p = 0; p < planeCount(layout); ++p) {
+                frame.strides[p] = planeRowBytes(layout, width, p) + 64; // ISP padding
+                planes[p].assign(static_cast<size_t>(frame.strides[p]) * planeRows(layout, height, p), 0);
+                for (int y = 0; y < planeRows(layout, height, p); ++y) {
+                    for (int x = 0; x < planeRowBytes(layout, width, p); ++x) {
+                        planes[p][static_cast<size_t>(y) * frame.strides[p] + x] = value(x, y, p);
+                    }
+                }
+                frame.planes[p] = planes[p].data();
+            }
+
+            for (int i = 0; i < 50; ++i) {
+                Roi roi;
+                roi.x = next() * 0.9;
+                roi.y = next() * 0.9;
+                roi.width = 0.01 + next() * (1.0 - roi.x);
+                roi.height = 0.01 + next() * (1.0 - roi.y);
+                const PixelRect rect = roiToPixels(roi, width, height);
+                const bool covers = rect.x <= roi.x * width && rect.y <= roi.y * height &&
+                                    rect.x + rect.width >= std::min<double>(width, (roi.x + roi.width) * width) - 1e-6 &&
+                                    rect.y + rect.height >= std::min<double>(height, (roi.y + roi.height) * height) - 1e-6;
+                FrameView crop;
+                if (!check(covers && rect.x % 2 == 0 && rect.y % 2 == 0 && cropFrame(frame, rect, crop),
+                           label + ": rect")) {
+                    continue;
+                }
+                bool same = crop.width == rect.width && crop.height == rect.height;
+                for (int p = 0; p < planeCount(layout) && same; ++p) {
+                    const int shift = layout == PixelLayout::YUV420 && p > 0 ? 1 : 0;
+                    for (int y = 0; y < planeRows(layout, crop.height, p) && same; ++y) {
+                        const uint8_t* row = crop.planes[p] + static_cast<size_t>(y) * crop.strides[p];
+                        for (int x = 0; x < planeRowBytes(layout, crop.width, p); ++x) {
+                            if (row[x] != value(x + (rect.x >> shift) * pixelBytes, y + (rect.y >> shift), p)) {
+                                same = false;
+                                break;
+                            }
+                        }
+                    }
+                }
+                check(same, label + ": pixels");
+            }
+            PixelRect outside = { width - 2, 0, 4, 2 };
+            FrameView crop;
+            check(!cropFrame(frame, outside, crop), label + ": crop outside");
+        }
+    }
+    check(roiPath("/data/2026-01-01/img_x.jpg", "trunk") == "/data/2026-01-01/img_x_trunk.jpg", "path");
+}
+
+// Variants of each photo: the same scene re-encoded, with AE jitter or with sensor noise
+// must be a duplicate, the photo with / without the hand holding a tag must not, and a
+// near-black frame must be dark
+void testScene(const TestContext& context) {
+    const char* names[] = { "test_1_plastic_no_aruco", "test_1_plastic_yes_aruco",
+                            "test_2_no_plastic_no_aruco", "test_2_no_plastic_yes_aruco" };
+    std::vector<OwnedFrame> photos(4);
+    for (int i = 0; i < 4; ++i) {
+        if (!check(loadJpegBgr(context.fixtures + "/" + names[i] + ".jpg", photos[i]), std::string("load ") + names[i])) {
+            return;
+        }
+    }
+
+    SceneOptions options;
+    auto expect = [&](const std::string& what, const SceneSignature& reference, const OwnedFrame& frame,
+                      SceneVerdict wanted) {
+        SceneSignature current;
+        computeSignature(frame.view(), current);
+        SceneDistance distance;
+        SceneVerdict verdict = compareScenes(&reference, current, options, &distance);
+        check(verdict == wanted, what + ": " + sceneVerdictName(verdict) + " (hash " +
+              std::to_string(distance.hashBits) + " bits, histogram " + std::to_string(distance.histogram) + ")");
+    };
+    auto transform = [](const OwnedFrame& src, const std::function<uint8_t(uint8_t)>& f) {
+        OwnedFrame dst = src;
+        for (size_t i = 0; i < dst.data.size(); ++i) dst.data[i] = f(src.data[i]);
+        return dst;
+    };
+
+    const std::string tmp = scratchFolder("scene") + "/requantized.jpg";
+    for (int i = 0; i < 4; ++i) {
+        SceneSignature signature;
+        computeSignature(photos[i].view(), signature);
+        const std::string name = names[i];
+
+        // 1. Same scene
+        JpegOptions low;
+        low.quality = 40;
+        std::vector<uint8_t> jpeg;
+        encodeJpeg(photos[i].view(), jpeg, low);
+        std::ofstream(tmp, std::ios::binary).write(reinterpret_cast<const char*>(jpeg.data()), jpeg.size());
+        OwnedFrame requantized;
+        loadJpegBgr(tmp, requantized);
+        expect(name + " q40 re-encode", signature, requantized, SceneVerdict::Duplicate);
+        expect(name + " +1/8 EV", signature,
+               transform(photos[i], [](uint8_t v) { return static_cast<uint8_t>(std::min(255, v * 12 / 11)); }),
+               SceneVerdict::Duplicate);
+        uint32_t noise = 7;
+        expect(name + " sensor noise", signature, transform(photos[i], [&](uint8_t v) {
+                   noise = noise * 1664525u + 1013904223u;
+                   return static_cast<uint8_t>(std::clamp(static_cast<int>(v) + static_cast<int>(noise >> 28) - 8, 0, 255));
+               }), SceneVerdict::Duplicate);
+
+        // 2. Changed / black
+        expect(name + " tag in or out", signature, photos[i ^ 1], SceneVerdict::New);
+        expect(name + " night", signature,
+               transform(photos[i], [](uint8_t v) { return static_cast<uint8_t>(v / 32); }), SceneVerdict::Dark);
+    }
+    std::filesystem::remove_all(std::filesystem::path(tmp).parent_path());
+}
+
+}
+
+void addImagingTests(std::vector<TestCase>& tests) {
+    tests.push_back({ "yuv420", testYuv420 });
+    tests.push_back({ "parallel", testParallelJpeg });
+    tests.push_back({ "hdr", testHdr });
+    tests.push_back({ "denoise", testDenoise });
+    tests.push_back({ "pyramid", testPyramid });
+    tests.push_back({ "aruco", testAruco });
+    tests.push_back({ "rate", testRateControl });
+    tests.push_back({ "roi", testRoi });
+    tests.push_back({ "scene", testScene });
+}
+
+}
+}
@@ -0,0 +1,253 @@
+// Drivers against their fakes: the BME280 on the register model, the modem sequences on
+// the pty fake, multi-camera scheduling on fake cameras, SystemMonitor on a fake sysfs tree,
+// and the AE/AWB convergence decision on recorded-style metadata sequences.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <algorithm>
+
+#include "Tests.hpp"
+#include "Fixtures.hpp"
+#include "sensors/BME280/bme280.hpp"
+#include "sensors/BME280/SimulatedBME280.hpp"
+#include "sensors/Modem/AtModem.hpp"
+#include "sensors/Modem/FakeModem.hpp"
+#include "sensors/Camera/MultiCapture.hpp"
+#include "sensors/Camera/FakeFrameSource.hpp"
+#include "sensors/Camera/AeConvergence.hpp"
+#include "sensors/System/SystemMonitor.hpp"
+#include "utils/MemoryBudget.hpp"
+#include "utils/ThreadPool.hpp"
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace tests {
+
+namespace {
+
+// Driver on the simulated chip (datasheet 8.2 example: 25.08 C, 100653.27 Pa), then the
+// batched floating-point compensation against the reference integer path
+void testBme280(const TestContext&) {
+    SimulatedBME280 chip;
+    BME280 sensor(chip);
+    BME280Data data;
+    if (!check(sensor.init() && sensor.measure(data), "init/measure on the simulated chip")) return;
+    check(std::fabs(data.temperature - 25.08f) < 0.01f, "temperature " + std::to_string(data.temperature));
+    check(std::fabs(data.pressure - 1006.53f) < 0.01f, "pressure " + std::to_string(data.pressure));
+
+    const size_t count = 200000;
+    std::vector<int32_t> adcT(count), adcP(count), adcH(count);
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < count; ++i) {
+        noise = noise * 1664525u + 1013904223u;
+        adcT[i] = SimulatedBME280::kExampleAdcT + static_cast<int32_t>(noise >> 16) % 60000 - 30000;
+        adcP[i] = SimulatedBME280::kExampleAdcP + static_cast<int32_t>(noise >> 8) % 40000 - 20000;
+        adcH[i] = SimulatedBME280::kExampleAdcH + static_cast<int32_t>(noise & 0xFFFF) % 8000 - 4000;
+    }
+    const BME280Calibration& calib = sensor.calibration();
+    std::vector<float> outT(count), outP(count), outH(count);
+    bme280::compensateBatch(calib, adcT.data(), adcP.data(), adcH.data(), count, outT.data(), outP.data(), outH.data());
+
+    float maxT = 0, maxP = 0, maxH = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int32_t tFine = 0;
+        maxT = std::max(maxT, std::fabs(outT[i] - bme280::compensateTemp(calib, adcT[i], tFine)));
+        maxP = std::max(maxP, std::fabs(outP[i] - bme280::compensatePressure(calib, adcP[i], tFine)));
+        maxH = std::max(maxH, std::fabs(outH[i] - bme280::compensateHumidity(calib, adcH[i], tFine)));
+    }
+    check(maxT < 0.02f && maxP < 0.02f && maxH < 0.02f, "batch vs scalar: " + std::to_string(maxT) + " C, " +
+          std::to_string(maxP) + " hPa, " + std::to_string(maxH) + " %");
+}
+
+// modem_up + gps_fix + modem_down with URCs, polled, and a fix that never comes: the
+// fix is reported when there is one, and the radio goes off right after
+void testModem(const TestContext&) {
+    struct Case {
+        const char* name;
+        FakeModem::Timing timing;
+        int gpsTimeoutMs;
+        bool expectFix;
+    };
+    const Case cases[] = {
+        { "urc", { 300, 1500, 5000, true }, 10000, true },
+        { "polled", { 300, 1500, 5000, false }, 10000, true },
+        { "no fix", { 300, 800, -1, true }, 2000, false },
+    };
+    for (const Case& c : cases) {
+        const std::string name = c.name;
+        FakeModem fake(c.timing);
+        if (!check(fake.start(), name + ": pty")) return;
+        AtModem modem(fake.path());
+        std::string fix;
+        const bool up = modem.open(1000) && modem.sync(3000) && modem.radioOn(true, 10000);
+        const bool found = up && modem.gpsFix(c.gpsTimeoutMs, fix);
+        const int64_t readyMs = fake.radioOnMs();
+        const bool down = modem.radioOff();
+        check(up && down, name + ": radio up / down");
+        check(found == c.expectFix && (!found || fix == FakeModem::kExampleFix), name + ": fix '" + fix + "'");
+        check(fake.radioOnMs() <= readyMs + 200, name + ": radio left on " + std::to_string(fake.radioOnMs()) + " ms");
+    }
+}
+
+// Two fake 12 MP cameras take about as long as one (the warm-ups overlap), and with a
+// budget too small for both the second waits, so the buffers held never exceed it
+void testMultiCamera(const TestContext&) {
+    const std::string folder = scratchFolder("multicam");
+    auto pool = std::make_shared<utils::ThreadPool>(0);
+    CameraOptions options;
+
+    struct Run {
+        double ms;
+        size_t peak;
+        bool ok;
+    };
+    auto run = [&](int cameras, size_t budgetBytes) {
+        std::vector<std::unique_ptr<FakeFrameSource>> fakes;
+        std::vector<FrameSource*> sources;
+        for (int i = 0; i < cameras; ++i) {
+            FakeFrameSource::Settings settings;
+            settings.name = "cam" + std::to_string(i);
+            settings.warmupMs = 800 + 100 * i;
+            fakes.push_back(std::make_unique<FakeFrameSource>(settings, pool));
+            sources.push_back(fakes.back().get());
+        }
+        FakeFrameSource::resetPeak();
+        utils::MemoryBudget budget(budgetBytes);
+        const std::string prefix = folder + "/img_" + std::to_string(cameras) + "_" + std::to_string(budgetBytes >> 20);
+        auto start = std::chrono::steady_clock::now();
+        std::vector<SourceCapture> results = captureAll(sources, options, prefix, ".jpg", budget);
+        Run result = { std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+                       FakeFrameSource::peakBytes(), results.size() == static_cast<size_t>(cameras) };
+        for (const SourceCapture& capture : results) {
+            result.ok = result.ok && capture.ok && fs::file_size(capture.path) > 0;
+        }
+        return result;
+    };
+
+    const size_t perCamera = FakeFrameSource(FakeFrameSource::Settings()).memoryEstimate(options);
+    const size_t tightBytes = perCamera + perCamera / 2; // Room for one camera only
+    Run single = run(1, 1024u << 20);
+    Run pair = run(2, 1024u << 20);
+    Run tight = run(2, tightBytes);
+    check(single.ok && pair.ok && tight.ok, "captures written");
+    check(pair.ms < single.ms * 1.5, "overlap: 1 camera " + std::to_string(single.ms) + " ms, 2 cameras " +
+          std::to_string(pair.ms) + " ms");
+    check(tight.peak <= tightBytes, "budget: peak " + std::to_string(tight.peak >> 20) + " MB");
+    check(tight.ms > single.ms * 1.5, "budget: second camera waited (" + std::to_string(tight.ms) + " ms)");
+    fs::remove_all(folder);
+}
+
+// Readings of a fake sysfs / procfs tree; with nothing readable there is no sample
+void testSystem(const TestContext&) {
+    const std::string root = scratchFolder("sysfs");
+    makeFakeSysfs(root);
+
+    SystemSources sources;
+    sources.root = root;
+    sources.storagePath = root;
+    SystemMonitor monitor(sources);
+    SystemSample sample;
+    if (!check(monitor.sample(sample), "sample of the fake tree")) return;
+    check(sample.thermalZones == 2 && std::fabs(sample.cpuTempC - 51.05) < 1e-9,
+          "thermal: " + std::to_string(sample.cpuTempC) + " C over " + std::to_string(sample.thermalZones) + " zones");
+    check(sample.cpuMHz == 1500.0, "cpufreq " + std::to_string(sample.cpuMHz));
+    check(sample.loadKnown && std::fabs(sample.load1 - 0.42) < 1e-9, "load " + std::to_string(sample.load1));
+    check(sample.memoryKnown && sample.memTotalKb == 1872524 && sample.memAvailableKb == 1423004, "meminfo");
+    check(sample.storageKnown && sample.storageTotalBytes > 0, "storage");
+    check(sample.throttledKnown && sample.throttled == 0x50005, "throttled " + std::to_string(sample.throttled));
+
+    // A missing node is just unknown
+    SystemSources empty;
+    empty.root = root + "/missing";
+    empty.storagePath = root + "/missing";
+    SystemMonitor none(empty);
+    check(!none.sample(sample) && !sample.throttledKnown && sample.thermalZones == 0, "empty tree gives no sample");
+    fs::remove_all(root);
+}
+
+// Frame (1-based) at which push() first says the warm-up can stop, -1 if it never does
+int warmupFrames(ConvergenceDetector& detector, const std::vector<AeMetadata>& frames) {
+    detector.reset();
+    for (size_t i = 0; i < frames.size(); ++i) {
+        if (detector.push(frames[i])) return static_cast<int>(i) + 1;
+    }
+    return -1;
+}
+
+AeMetadata aeFrame(float exposureTime, float analogueGain, AeStatus status = AeStatus::Unknown) {
+    AeMetadata frame;
+    frame.exposureTime = exposureTime;
+    frame.analogueGain = analogueGain;
+    frame.colourGainR = 1.9f;
+    frame.colourGainB = 1.6f;
+    frame.lux = 400.0f;
+    frame.status = status;
+    return frame;
+}
+
+// ConvergenceDetector on metadata sequences shaped like real warm-ups
+void testAeConvergence(const TestContext&) {
+    ConvergenceDetector detector; // stableFrames 3, minFrames 4, maxFrames 60
+
+    // 1. Fast settle: a few big steps, then three frames within 2 % of the fourth
+    std::vector<AeMetadata> settle = { aeFrame(10000, 1.0f), aeFrame(20000, 2.0f), aeFrame(30000, 2.5f),
+                                       aeFrame(33000, 2.6f), aeFrame(33100, 2.6f), aeFrame(33050, 2.61f),
+                                       aeFrame(33080, 2.6f), aeFrame(33060, 2.6f) };
+    check(warmupFrames(detector, settle) == 7 && detector.converged(), "fast settle: done at frame " +
+          std::to_string(detector.frames()));
+
+    // 2. Dawn: exposure falling 1 % a frame. Every neighbour is within tolerance, the run
+    // as a whole is not, so it must not converge before the light stops changing
+    std::vector<AeMetadata> dawn;
+    float exposure = 60000.0f;
+    for (int i = 0; i < 40; ++i, exposure *= 0.99f) dawn.push_back(aeFrame(exposure, 4.0f));
+    for (int i = 0; i < 5; ++i) dawn.push_back(aeFrame(exposure, 4.0f));
+    const int dawnFrames = warmupFrames(detector, dawn);
+    check(dawnFrames > 40 && detector.converged(),
+          "dawn drift: done at frame " + std::to_string(dawnFrames) + ", before the light stopped changing (40)");
+
+    // 3. The cap: a scene that never settles stops at maxFrames, not converged
+    ConvergenceOptions capped;
+    capped.maxFrames = 12;
+    ConvergenceDetector cappedDetector(capped);
+    std::vector<AeMetadata> flicker;
+    for (int i = 0; i < 70; ++i) flicker.push_back(aeFrame(i % 2 ? 20000.0f : 25000.0f, 2.0f));
+    check(warmupFrames(cappedDetector, flicker) == 12 && !cappedDetector.converged(),
+          "maxFrames: done at frame " + std::to_string(cappedDetector.frames()));
+    check(warmupFrames(detector, flicker) == 60 && !detector.converged(), "default maxFrames 60");
+
+    // 4. AE state reported: the first frames repeat the initial exposure while AE is still
+    // searching. Without the state they look converged at frame 4; with it the run only
+    // starts once AE leaves Searching, and Converged alone does not excuse moving values
+    std::vector<AeMetadata> start;
+    for (int i = 0; i < 6; ++i) start.push_back(aeFrame(10000, 1.0f, AeStatus::Searching));
+    start.push_back(aeFrame(18000, 1.8f, AeStatus::Searching));
+    start.push_back(aeFrame(21000, 2.0f, AeStatus::Searching));
+    for (int i = 0; i < 4; ++i) start.push_back(aeFrame(21000.0f + 50.0f * i, 2.0f, AeStatus::Converged));
+    check(warmupFrames(detector, start) == 11 && detector.converged(),
+          "AE searching: done at frame " + std::to_string(detector.frames()) + ", expected 11");
+    std::vector<AeMetadata> unreported = start;
+    for (AeMetadata& frame : unreported) frame.status = AeStatus::Unknown;
+    check(warmupFrames(detector, unreported) == 4, "no AE state: the repeated frames count as stable");
+    std::vector<AeMetadata> moving;
+    for (int i = 0; i < 8; ++i) moving.push_back(aeFrame(10000.0f + 2000.0f * i, 1.0f, AeStatus::Converged));
+    moving.push_back(aeFrame(24000, 1.0f, AeStatus::Converged));
+    check(warmupFrames(detector, moving) == -1, "AE converged but values moving: not converged");
+}
+
+}
+
+void addSensorTests(std::vector<TestCase>& tests) {
+    tests.push_back({ "bme280", testBme280 });
+    tests.push_back({ "modem", testModem });
+    tests.push_back({ "multicam", testMultiCamera });
+    tests.push_back({ "sys", testSystem });
+    tests.push_back({ "ae_convergence", testAeConvergence });
+}
+
+}
+}
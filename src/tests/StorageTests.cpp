@@ -0,0 +1,316 @@
+// Storage: crash safety of the atomic write, the content hash, the telemetry store,
+// the daily bundles, the file index journal and the trace export.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <climits>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "Tests.hpp"
+#include "Fixtures.hpp"
+#include "imaging/JpegEncoder.hpp"
+#include "imaging/ParallelJpegEncoder.hpp"
+#include "utils/FileSystem.hpp"
+#include "utils/FileIndex.hpp"
+#include "utils/Hash.hpp"
+#include "utils/TelemetryLog.hpp"
+#include "utils/Bundle.hpp"
+#include "utils/Trace.hpp"
+#include "utils/ThreadPool.hpp"
+#include "cloud/Uploader.hpp"
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace tests {
+
+namespace {
+
+// A child rewrites the file in a loop and is SIGKILLed at random moments; the target
+// must always be either absent or one complete version, never a partial file
+void testAtomicWrite(const TestContext&) {
+    const std::string folder = scratchFolder("atomic");
+    const std::string target = folder + "/img.jpg";
+    const size_t size = 4 << 20; // A typical full-res JPEG
+    std::vector<uint8_t> versions[2] = { std::vector<uint8_t>(size, 0xAA), std::vector<uint8_t>(size, 0x55) };
+
+    uint32_t seed = 42;
+    for (int k = 0; k < 30; ++k) {
+        fs::remove(target);
+        pid_t child = fork();
+        if (child == 0) {
+            for (int i = 0;; ++i) utils::writeFileAtomic(target, versions[i & 1].data(), size);
+        }
+        seed = seed * 1664525u + 1013904223u;
+        usleep(1000 + (seed >> 8) % 50000);
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+
+        std::ifstream file(target, std::ios::binary);
+        if (!file.is_open()) continue; // Killed before the first rename: fine
+        std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        check(content == versions[0] || content == versions[1], "kill " + std::to_string(k) + ": partial file visible");
+    }
+    utils::removeStaleTempFiles(folder);
+    fs::remove_all(folder);
+}
+
+// Reference values of the xxHash project
+void testHash(const TestContext&) {
+    check(utils::xxh64("", 0) == 0xEF46DB3751D8E999ULL, "xxh64 of \"\"");
+    check(utils::xxh64("abc", 3) == 0x44BC2CF5AD770999ULL, "xxh64 of \"abc\"");
+    std::vector<uint8_t> frame = makeSyntheticBGR(1024, 1024);
+    check(utils::xxh64(frame.data(), frame.size()) != 0, "xxh64 of a frame");
+}
+
+// A month of 15-minute env + cpu records: a torn record is skipped on replay, the
+// rest survives CSV export -> import
+void testTelemetry(const TestContext&) {
+    const std::string folder = scratchFolder("telemetry") + "/log";
+    const std::string csvRoot = fs::path(folder).parent_path().string() + "/csv";
+    const int64_t start = 1767268800000LL; // 2026-01-01 12:00 UTC
+    const int64_t stepMs = 15 * 60 * 1000;
+    {
+        utils::TelemetryLog log(folder, false);
+        for (int64_t t = start; t < start + 30 * 86400000LL; t += stepMs) {
+            utils::TelemetryRecord env;
+            env.source = static_cast<uint16_t>(utils::TelemetrySource::Env);
+            env.timeMs = t;
+            env.values[0] = 20.0f + (t / stepMs) % 100 * 0.1f;
+            env.values[1] = 55.5f;
+            env.values[2] = 985.25f;
+            log.append(env);
+
+            utils::TelemetryRecord cpu;
+            utils::parseCpuFields("52.1,0x50000", cpu);
+            cpu.timeMs = t + 1000;
+            log.append(cpu);
+
+            if ((t - start) % 86400000LL == 0) {
+                utils::TelemetryRecord gps;
+                utils::parseGpsFix("4503.123456,N,00740.654321,E,160126,101500.0,245.3,0.0,12.5", gps);
+                gps.timeMs = t + 2000;
+                log.append(gps);
+            }
+        }
+    }
+
+    utils::TelemetryScanStats stats;
+    auto ignore = [](const utils::TelemetryRecord&) {};
+    utils::scanTelemetry(folder, LLONG_MIN, LLONG_MAX, 0, ignore, &stats);
+    const size_t total = stats.records;
+    check(total == 30 * 96 * 2 + 30, "records written: " + std::to_string(total));
+
+    utils::TelemetryScanStats week;
+    utils::scanTelemetry(folder, start + 10 * 86400000LL, start + 17 * 86400000LL,
+                         static_cast<uint16_t>(utils::TelemetrySource::Env), ignore, &week);
+    check(week.records == 7 * 96, "one week of env records: " + std::to_string(week.records));
+
+    // 1. A torn record: garbage in the middle of a slot of one day file
+    std::vector<fs::path> files;
+    for (const fs::directory_entry& entry : fs::directory_iterator(folder)) files.push_back(entry.path());
+    std::sort(files.begin(), files.end());
+    if (!check(!files.empty(), "day files")) return;
+    {
+        std::fstream file(files[files.size() / 2], std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 10 * 64 + 20);
+        file.write("torn", 4);
+    }
+    utils::scanTelemetry(folder, LLONG_MIN, LLONG_MAX, 0, ignore, &stats);
+    check(stats.torn == 1 && stats.records == total - 1, "torn record skipped: " + std::to_string(stats.torn));
+
+    // 2. CSV layouts survive export -> import
+    utils::exportCsv(folder, csvRoot, 0);
+    const int imported = utils::importCsv(folder + "_reimport", csvRoot);
+    check(imported == static_cast<int>(total - 1), "csv round trip: " + std::to_string(imported) + " rows");
+    fs::remove_all(fs::path(folder).parent_path());
+}
+
+// A day bundled plain and with a dictionary trained on the previous week; every member
+// read back through the index matches its file
+void testBundle(const TestContext&) {
+    const std::string root = scratchFolder("bundle");
+    std::vector<std::string> samples;
+    for (int day = 0; day < 7; ++day) {
+        for (const utils::BundleInput& input : makeBundleDay(root + "/d" + std::to_string(day), day)) {
+            samples.push_back(input.path);
+        }
+    }
+    std::vector<utils::BundleInput> inputs = makeBundleDay(root + "/d7", 7);
+
+    std::vector<uint8_t> dict;
+    check(utils::trainBundleDictionary(samples, 16 * 1024, dict) && !dict.empty(), "dictionary training");
+    const std::vector<uint8_t> none;
+    const std::vector<uint8_t>* variants[] = { &none, &dict };
+    for (const std::vector<uint8_t>* d : variants) {
+        const std::string path = root + (d->empty() ? "/plain.hbn" : "/dict.hbn");
+        const std::string label = d->empty() ? "plain" : "dict";
+        utils::BundleStats stats;
+        if (!check(utils::writeBundle(path, inputs, *d, 19, &stats), label + ": write")) continue;
+        check(stats.files == static_cast<int>(inputs.size()) && stats.bundleBytes < stats.rawBytes, label + ": stats");
+
+        utils::BundleIndex index;
+        if (!check(utils::readBundleIndex(path, index) && index.entries.size() == inputs.size(), label + ": index")) {
+            continue;
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            std::vector<uint8_t> member;
+            std::ifstream file(inputs[i].path, std::ios::binary);
+            std::vector<uint8_t> original((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            check(utils::readBundleMember(path, index, index.entries[i], *d, member) &&
+                  index.entries[i].name == inputs[i].name && member == original, label + ": member " + inputs[i].name);
+        }
+    }
+    fs::remove_all(root);
+}
+
+// The file index journal: states replay in a fresh index (odd keys included), torn and
+// malformed lines are dropped, compaction shrinks the journal and forgets deleted files,
+// an index opened before a compaction appends to the new journal, and a cumulative CSV
+// that grew is planned as its appended tail only
+void testIndex(const TestContext&) {
+    const std::string root = scratchFolder("index");
+    const std::string journal = root + "/.index/files";
+    const auto writeText = [](const std::string& path, const std::string& text) {
+        fs::create_directories(fs::path(path).parent_path());
+        std::ofstream(path, std::ios::binary) << text;
+    };
+    const auto journalSize = [&journal] { return fs::file_size(journal); };
+
+    // 1. Replay
+    const std::string odd = "2026-01-20/a b%c\tsun.jpg";
+    {
+        utils::FileIndex index(journal);
+        check(index.load(root), "empty index");
+        index.recordWrite(odd, 10, 11, 0x1234);
+        index.markUploaded(odd, 10, 0x1234, 0);
+        index.recordWrite("big.jpg", 100, 101, 0xBEEF);
+        index.startMultipart("big.jpg", 100, 101, "upload-1");
+        index.markPart("big.jpg", 1, "\"e1\"");
+        index.markPart("big.jpg", 2, "\"e2\"");
+    }
+    utils::FileIndex replayed(journal);
+    utils::FileState state;
+    check(replayed.load(root) && replayed.find(odd, state) && state.known && state.size == 10 && state.mtimeNs == 11 &&
+          state.hash == 0x1234 && state.uploaded && state.uploadedSize == 10, "replay of an escaped key");
+    check(replayed.find("big.jpg", state) && state.uploadId == "upload-1" && state.multipartSize == 100 &&
+          state.parts.size() == 2 && state.parts[2] == "\"e2\"", "replay of a multipart upload");
+
+    // 2. Malformed lines, and a torn last line (no newline): dropped, the rest kept
+    std::ofstream(journal, std::ios::app) << "W bad%ZZ 1 2 00\nW bad%2 1 2 00\ngarbage\nU\nW nan.jpg x 2 00\n"
+                                           << "U big.jpg 100 nothex 0\nW torn.jpg 1 2 0000000000000001";
+    utils::FileIndex damaged(journal);
+    check(damaged.load(root), "load of a damaged journal");
+    for (const std::string key : { "bad%ZZ", "bad%2", "garbage", "nan.jpg", "torn.jpg" }) {
+        check(!damaged.find(key, state), "malformed line kept: " + key);
+    }
+    check(damaged.find("big.jpg", state) && !state.uploaded && state.parts.size() == 2 &&
+          damaged.find(odd, state) && state.uploaded, "good lines survive the damaged ones");
+
+    // 3. Compaction: 200 rewrites of one file shrink to one line; files gone are dropped
+    writeText(root + "/cpu_info.csv", "t,cpu\n");
+    for (int i = 0; i < 200; ++i) damaged.recordWrite("cpu_info.csv", 6, i, i + 1);
+    const uintmax_t before = journalSize();
+    utils::FileIndex compacting(journal);
+    check(compacting.load(root, true) && journalSize() < before / 10, "compaction shrinks the journal (" +
+          std::to_string(before) + " -> " + std::to_string(journalSize()) + " bytes)");
+    check(compacting.find("cpu_info.csv", state) && state.mtimeNs == 199 && state.hash == 200 &&
+          !compacting.find("big.jpg", state) && !compacting.find(odd, state), "compaction keeps live files only");
+
+    // 4. 'damaged' still has the old journal open: its next line must land in the new one
+    for (int i = 0; i < 200; ++i) compacting.recordWrite("cpu_info.csv", 6, i, i + 1);
+    utils::FileIndex compactor(journal);
+    check(compactor.load(root, true), "second compaction");
+    damaged.recordWrite("cpu_info.csv", 6, 1000, 0xABC);
+    utils::FileIndex fresh(journal);
+    check(fresh.load(root) && fresh.find("cpu_info.csv", state) && state.mtimeNs == 1000 && state.hash == 0xABC,
+          "append after the journal was swapped reaches the new journal");
+
+    // 5. Cumulative CSV: only the appended bytes, until the prefix changes
+    cloud::UploadOptions options;
+    cloud::UploadStats stats;
+    std::vector<cloud::UploadItem> items = cloud::planUploads(root, 1, fresh, options, stats);
+    if (check(items.size() == 1 && items[0].key == "cpu_info.csv" && items[0].offset == 0, "first upload: whole CSV")) {
+        fresh.markUploaded(items[0].key, items[0].size, items[0].hash, items[0].tails);
+    }
+    writeText(root + "/cpu_info.csv", "t,cpu\n1,48.3\n");
+    items = cloud::planUploads(root, 1, fresh, options, stats);
+    if (check(items.size() == 1 && items[0].offset == 6 && items[0].size == 13 && items[0].tails == 1 &&
+              items[0].objectKey == "cpu_info.csv.tail/000000000006", "grown CSV: tail from byte 6")) {
+        fresh.markUploaded(items[0].key, items[0].size, items[0].hash, items[0].tails);
+    }
+    writeText(root + "/cpu_info.csv", "t,cpu\n1,48.3\n2,49.0\n");
+    options.maxTails = 1;
+    items = cloud::planUploads(root, 1, fresh, options, stats);
+    check(items.size() == 1 && items[0].offset == 0 && items[0].objectKey == "cpu_info.csv",
+          "whole CSV again after maxTails tails");
+    options.maxTails = 30;
+    writeText(root + "/cpu_info.csv", "T,cpu\n1,48.3\n2,49.0\n");
+    items = cloud::planUploads(root, 1, fresh, options, stats);
+    check(items.size() == 1 && items[0].offset == 0, "whole CSV again when the uploaded prefix changed");
+    fs::remove_all(root);
+}
+
+#ifdef HORUS_TRACING
+// A trace of the parallel encoder + atomic write read back: valid JSON, one track per
+// thread, and the spans that matter present
+void testTrace(const TestContext&) {
+    const std::string folder = scratchFolder("trace");
+    std::vector<uint8_t> bgr = makeSyntheticBGR(1536, 864);
+    imaging::FrameView frame = bgrView(bgr, 1536, 864);
+
+    utils::resetTrace();
+    utils::setTracing(true);
+    {
+        utils::ThreadPool pool(4);
+        std::vector<uint8_t> out;
+        imaging::encodeJpegParallel(frame, out, pool);
+        utils::writeFileAtomic(folder + "/parallel.jpg", out.data(), out.size());
+    }
+    utils::setTracing(false);
+    const std::string path = folder + "/trace.json";
+    if (!check(utils::writeChromeTrace(path, "tests"), "write trace")) return;
+
+    std::set<std::string> names;
+    std::set<int> threads;
+    try {
+        std::ifstream file(path);
+        nlohmann::json json = nlohmann::json::parse(file);
+        for (const nlohmann::json& event : json.at("traceEvents")) {
+            if (event.at("ph") != "X") continue;
+            names.insert(event.at("name").get<std::string>());
+            threads.insert(event.at("tid").get<int>());
+            check(event.at("dur").get<double>() >= 0.0, "negative duration");
+        }
+    } catch (const std::exception& e) {
+        check(false, std::string("trace json: ") + e.what());
+    }
+    for (const char* name : { "jpeg.encode_parallel", "jpeg.bgr_swap", "jpeg.write_scanlines", "fs.fsync" }) {
+        check(names.count(name) == 1, std::string("span ") + name);
+    }
+    check(threads.size() >= 2, "spans on " + std::to_string(threads.size()) + " thread(s)");
+    fs::remove_all(folder);
+}
+#endif
+
+}
+
+void addStorageTests(std::vector<TestCase>& tests) {
+    tests.push_back({ "atomic", testAtomicWrite });
+    tests.push_back({ "hash", testHash });
+    tests.push_back({ "telemetry", testTelemetry });
+    tests.push_back({ "bundle", testBundle });
+    tests.push_back({ "index", testIndex });
+#ifdef HORUS_TRACING
+    tests.push_back({ "trace", testTrace });
+#endif
+}
+
+}
+}
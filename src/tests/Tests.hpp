@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace horus {
+namespace tests {
+
+    struct TestContext {
+        std::string fixtures = "."; // Folder with the bundled test_*.jpg photos
+    };
+
+    struct TestCase {
+        std::string name;           // Also the ctest name: "horus_tests <name>"
+        std::function<void(const TestContext&)> run;
+    };
+
+    // Records an expectation of the running test; a false one is printed with 'what'
+    // and fails the test. Returns 'pass', so a test can stop when later steps depend on it.
+    bool check(bool pass, const std::string& what);
+    int failureCount();
+
+    // Fresh, empty scratch folder for one test ("/tmp/horus_tests_<name>")
+    std::string scratchFolder(const std::string& name);
+
+    // One list per area, in tests/<Area>Tests.cpp
+    void addImagingTests(std::vector<TestCase>& tests);
+    void addStorageTests(std::vector<TestCase>& tests);
+    void addSensorTests(std::vector<TestCase>& tests);
+    void addCloudTests(std::vector<TestCase>& tests);
+    void addAppTests(std::vector<TestCase>& tests);
+
+}
+}
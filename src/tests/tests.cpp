@@ -0,0 +1,91 @@
+// Horus regression tests.
+// Pass/fail checks of the modules that run off the device: the imaging kernels on
+// synthetic frames and the bundled photos, storage formats, and the drivers against
+// their fakes (register model, pty modem, fake cameras, fake sysfs tree), the uploader
+// against a loopback S3 stand-in, and the command line plumbing of horus_app.
+// Usage: horus_tests [--fixtures <dir>] [name ...]   (no name = all; exit 1 if any fails)
+// CMake registers every test with ctest.
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+
+#include "Tests.hpp"
+
+namespace horus {
+namespace tests {
+
+namespace {
+int gFailures = 0;
+}
+
+bool check(bool pass, const std::string& what) {
+    if (!pass) {
+        std::cout << "  FAILED: " << what << std::endl;
+        ++gFailures;
+    }
+    return pass;
+}
+
+int failureCount() {
+    return gFailures;
+}
+
+std::string scratchFolder(const std::string& name) {
+    namespace fs = std::filesystem;
+    const fs::path folder = fs::temp_directory_path() / ("horus_tests_" + name);
+    std::error_code ec;
+    fs::remove_all(folder, ec);
+    fs::create_directories(folder, ec);
+    return folder.string();
+}
+
+}
+}
+
+int main(int argc, char* argv[]) {
+    using namespace horus::tests;
+    TestContext context;
+    std::vector<std::string> selected;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--fixtures") == 0 && i + 1 < argc) context.fixtures = argv[++i];
+        else selected.push_back(argv[i]);
+    }
+
+    std::vector<TestCase> tests;
+    addImagingTests(tests);
+    addStorageTests(tests);
+    addSensorTests(tests);
+    addCloudTests(tests);
+    addAppTests(tests);
+
+    for (const std::string& name : selected) {
+        if (std::none_of(tests.begin(), tests.end(), [&](const TestCase& t) { return t.name == name; })) {
+            std::cerr << "Unknown test: " << name << std::endl;
+            return 1;
+        }
+    }
+
+    int run = 0;
+    std::vector<std::string> failed;
+    for (const TestCase& test : tests) {
+        if (!selected.empty() && std::find(selected.begin(), selected.end(), test.name) == selected.end()) continue;
+        std::cout << "[ RUN    ] " << test.name << std::endl;
+        const int before = failureCount();
+        auto start = std::chrono::steady_clock::now();
+        test.run(context);
+        const long ms = static_cast<long>(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count());
+        const bool ok = failureCount() == before;
+        std::cout << (ok ? "[     OK ] " : "[ FAILED ] ") << test.name << " (" << ms << " ms)" << std::endl;
+        if (!ok) failed.push_back(test.name);
+        ++run;
+    }
+
+    std::cout << run - static_cast<int>(failed.size()) << "/" << run << " passed" << std::endl;
+    for (const std::string& name : failed) std::cout << "  failed: " << name << std::endl;
+    return failed.empty() ? 0 : 1;
+}
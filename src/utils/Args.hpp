@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <cstdlib>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+
+namespace horus {
+namespace utils {
+
+// Checked numbers from the command line: the whole text must be one base-10 number
+// that fits the type ("12", "-2", "0.5"). Anything else ("", "12ms", "abc", "1e99")
+// returns false and leaves 'value' untouched.
+
+inline bool parseInt(const std::string& text, int& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    const long parsed = std::strtol(text.c_str(), &end, 10);
+    if (*end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX) return false;
+    value = static_cast<int>(parsed);
+    return true;
+}
+
+inline bool parseFloat(const std::string& text, float& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    const float parsed = std::strtof(text.c_str(), &end);
+    if (*end != '\0' || errno == ERANGE || !std::isfinite(parsed)) return false;
+    value = parsed;
+    return true;
+}
+
+inline bool parseDouble(const std::string& text, double& value) {
+    if (text.empty()) return false;
+    char* end = nullptr;
+    errno = 0;
+    const double parsed = std::strtod(text.c_str(), &end);
+    if (*end != '\0' || errno == ERANGE || !std::isfinite(parsed)) return false;
+    value = parsed;
+    return true;
+}
+
+} // namespace utils
+} // namespace horus
@@ -0,0 +1,394 @@
+#include "Bundle.hpp"
+#include "FileSystem.hpp"
+#include "Hash.hpp"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zstd.h>
+#include <zdict.h>
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace utils {
+
+namespace {
+
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 16;
+const size_t kFooterSize = 24;
+const size_t kSampleSize = 4096;
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool readWhole(const std::string& path, std::vector<uint8_t>& data) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+bool readAt(int fd, uint64_t offset, void* data, size_t size) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, static_cast<uint8_t*>(data) + done, size - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// --- Little-endian writer / reader (the Pi and x86 both are) ---
+
+struct Writer {
+    std::vector<uint8_t> out;
+    template <typename T> void put(T value) {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+    void bytes(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        out.insert(out.end(), p, p + size);
+    }
+    void tag(const char* magic) { bytes(magic, 4); }
+};
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    template <typename T> bool get(T& value) {
+        if (end - p < static_cast<ptrdiff_t>(sizeof(T))) return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+    bool tag(const char* magic) {
+        if (end - p < 4 || std::memcmp(p, magic, 4) != 0) return false;
+        p += 4;
+        return true;
+    }
+    bool text(size_t size, std::string& value) {
+        if (end - p < static_cast<ptrdiff_t>(size)) return false;
+        value.assign(reinterpret_cast<const char*>(p), size);
+        p += size;
+        return true;
+    }
+};
+
+} // namespace
+
+bool isBundleMember(const std::string& name) {
+    if (name.empty() || name[0] == '.') return false;
+    return endsWith(name, ".csv") || endsWith(name, ".json") || endsWith(name, ".log") || endsWith(name, ".txt");
+}
+
+std::string bundlePath(const std::string& root, const std::string& day) {
+    return root + "/" + day + "/" + day + ".hbn";
+}
+
+// --- DICTIONARY ---
+
+bool trainBundleDictionary(const std::vector<std::string>& files, size_t dictSize, std::vector<uint8_t>& dict) {
+    // 1. Samples: files cut into 4 KB pieces, so a few long CSVs still give the
+    // trainer hundreds of examples of the same structure
+    std::vector<uint8_t> samples;
+    std::vector<size_t> sizes;
+    std::vector<uint8_t> data;
+    for (const std::string& file : files) {
+        if (!readWhole(file, data)) continue;
+        for (size_t pos = 0; pos < data.size(); pos += kSampleSize) {
+            size_t n = std::min(kSampleSize, data.size() - pos);
+            samples.insert(samples.end(), data.begin() + pos, data.begin() + pos + n);
+            sizes.push_back(n);
+        }
+    }
+    if (sizes.size() < 16 || samples.size() < 4 * dictSize) {
+        std::cerr << "[Bundle] Not enough samples to train a dictionary (" << sizes.size() << " pieces, "
+                  << samples.size() / 1024 << " KB)" << std::endl;
+        return false;
+    }
+
+    // 2. Train
+    dict.resize(dictSize);
+    size_t result = ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sizes.data(),
+                                          static_cast<unsigned>(sizes.size()));
+    if (ZDICT_isError(result)) {
+        std::cerr << "[Bundle] Dictionary training failed: " << ZDICT_getErrorName(result) << std::endl;
+        dict.clear();
+        return false;
+    }
+    dict.resize(result);
+    return true;
+}
+
+std::string findBundleDictionary(const std::string& root) {
+    std::string newest;
+    fs::file_time_type newestTime;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(root, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("bundle-dict-", 0) != 0 || !endsWith(name, ".zdict")) continue;
+        fs::file_time_type time = entry.last_write_time(ec);
+        if (newest.empty() || time > newestTime) {
+            newest = entry.path().string();
+            newestTime = time;
+        }
+    }
+    return newest;
+}
+
+bool loadBundleDictionary(const std::string& path, std::vector<uint8_t>& dict) {
+    if (!readWhole(path, dict) || ZDICT_getDictID(dict.data(), dict.size()) == 0) {
+        std::cerr << "[Bundle] Not a zstd dictionary: " << path << std::endl;
+        dict.clear();
+        return false;
+    }
+    return true;
+}
+
+uint32_t bundleDictionaryId(const std::vector<uint8_t>& dict) {
+    return dict.empty() ? 0 : ZDICT_getDictID(dict.data(), dict.size());
+}
+
+// --- BUNDLE ---
+
+bool writeBundle(const std::string& path, const std::vector<BundleInput>& files,
+                 const std::vector<uint8_t>& dict, int level, BundleStats* stats) {
+    const uint32_t dictId = bundleDictionaryId(dict);
+
+    // 1. The uncompressed stream: one record per member
+    Writer stream;
+    std::vector<BundleEntry> entries;
+    std::vector<uint8_t> data;
+    uint64_t rawBytes = 0;
+    for (const BundleInput& input : files) {
+        struct stat st;
+        if (!readWhole(input.path, data) || stat(input.path.c_str(), &st) != 0) {
+            std::cerr << "[Bundle] Skipping unreadable " << input.path << std::endl;
+            continue;
+        }
+        BundleEntry entry;
+        entry.name = input.name;
+        entry.size = data.size();
+        entry.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        entry.hash = xxh64(data.data(), data.size());
+
+        stream.tag("HBEN");
+        stream.put<uint16_t>(static_cast<uint16_t>(entry.name.size()));
+        stream.put<uint16_t>(0);
+        stream.put<uint64_t>(entry.size);
+        stream.put<int64_t>(entry.mtimeNs);
+        stream.put<uint64_t>(entry.hash);
+        stream.bytes(entry.name.data(), entry.name.size());
+        entry.offset = stream.out.size();
+        stream.bytes(data.data(), data.size());
+        rawBytes += entry.size;
+        entries.push_back(entry);
+    }
+
+    // 2. Chunks, each an independent zstd frame
+    Writer out;
+    out.tag("HBN1");
+    out.put<uint32_t>(kVersion);
+    out.put<uint32_t>(dictId);
+    out.put<uint32_t>(kBundleChunkSize);
+
+    ZSTD_CCtx* cctx = ZSTD_createCCtx();
+    ZSTD_CDict* cdict = dict.empty() ? nullptr : ZSTD_createCDict(dict.data(), dict.size(), level);
+    std::vector<uint64_t> chunkOffsets;
+    std::vector<uint8_t> frame;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < stream.out.size(); pos += kBundleChunkSize) {
+        const size_t rawSize = std::min<size_t>(kBundleChunkSize, stream.out.size() - pos);
+        frame.resize(ZSTD_compressBound(rawSize));
+        size_t packed = cdict
+            ? ZSTD_compress_usingCDict(cctx, frame.data(), frame.size(), stream.out.data() + pos, rawSize, cdict)
+            : ZSTD_compressCCtx(cctx, frame.data(), frame.size(), stream.out.data() + pos, rawSize, level);
+
+        // Incompressible chunk (or an error): keep it as is
+        chunkOffsets.push_back(out.out.size());
+        out.put<uint32_t>(static_cast<uint32_t>(rawSize));
+        if (ZSTD_isError(packed) || packed >= rawSize) {
+            out.put<uint32_t>(static_cast<uint32_t>(rawSize) | kBundleStoredRaw);
+            out.bytes(stream.out.data() + pos, rawSize);
+        } else {
+            out.put<uint32_t>(static_cast<uint32_t>(packed));
+            out.bytes(frame.data(), packed);
+        }
+    }
+
+    // 3. Index, compressed too: names repeat the day prefix and the same few suffixes
+    Writer index;
+    index.tag("HBIX");
+    index.put<uint32_t>(static_cast<uint32_t>(entries.size()));
+    index.put<uint32_t>(static_cast<uint32_t>(chunkOffsets.size()));
+    for (uint64_t offset : chunkOffsets) index.put<uint64_t>(offset);
+    for (const BundleEntry& entry : entries) {
+        index.put<uint16_t>(static_cast<uint16_t>(entry.name.size()));
+        index.bytes(entry.name.data(), entry.name.size());
+        index.put<uint64_t>(entry.offset);
+        index.put<uint64_t>(entry.size);
+        index.put<int64_t>(entry.mtimeNs);
+        index.put<uint64_t>(entry.hash);
+    }
+    frame.resize(ZSTD_compressBound(index.out.size()));
+    size_t indexSize = ZSTD_compressCCtx(cctx, frame.data(), frame.size(), index.out.data(), index.out.size(), level);
+    const double encodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ZSTD_freeCDict(cdict);
+    ZSTD_freeCCtx(cctx);
+    if (ZSTD_isError(indexSize)) {
+        std::cerr << "[Bundle] Index compression failed: " << ZSTD_getErrorName(indexSize) << std::endl;
+        return false;
+    }
+
+    const uint64_t indexOffset = out.out.size();
+    out.bytes(frame.data(), indexSize);
+    out.put<uint64_t>(indexOffset);
+    out.put<uint32_t>(static_cast<uint32_t>(indexSize));
+    out.put<uint32_t>(static_cast<uint32_t>(entries.size()));
+    out.put<uint32_t>(dictId);
+    out.tag("HBNE");
+
+    if (!writeFileAtomic(path, out.out.data(), out.out.size())) return false;
+    if (stats) {
+        stats->files = static_cast<int>(entries.size());
+        stats->rawBytes = rawBytes;
+        stats->bundleBytes = out.out.size();
+        stats->encodeMs = encodeMs;
+        stats->dictId = dictId;
+    }
+    return true;
+}
+
+bool readBundleIndex(const std::string& path, BundleIndex& index) {
+    index = BundleIndex();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    // 1. Header and footer
+    struct stat st;
+    uint8_t header[kHeaderSize];
+    uint8_t footer[kFooterSize];
+    bool ok = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderSize + kFooterSize &&
+              readAt(fd, 0, header, kHeaderSize) && std::memcmp(header, "HBN1", 4) == 0 &&
+              readAt(fd, static_cast<uint64_t>(st.st_size) - kFooterSize, footer, kFooterSize) &&
+              std::memcmp(footer + 20, "HBNE", 4) == 0;
+    uint64_t indexOffset = 0;
+    uint32_t indexSize = 0, count = 0;
+    if (ok) {
+        Reader h = { header + 4, header + kHeaderSize };
+        uint32_t version = 0;
+        h.get(version);
+        h.get(index.dictId);
+        h.get(index.chunkSize);
+        Reader f = { footer, footer + kFooterSize };
+        f.get(indexOffset);
+        f.get(indexSize);
+        f.get(count);
+        ok = version == kVersion && index.chunkSize > 0 &&
+             indexOffset + indexSize + kFooterSize == static_cast<uint64_t>(st.st_size);
+    }
+
+    // 2. Index frame
+    std::vector<uint8_t> packed(ok ? indexSize : 0);
+    ok = ok && readAt(fd, indexOffset, packed.data(), packed.size());
+    close(fd);
+    unsigned long long rawSize = ok ? ZSTD_getFrameContentSize(packed.data(), packed.size()) : 0;
+    ok = ok && rawSize != ZSTD_CONTENTSIZE_UNKNOWN && rawSize != ZSTD_CONTENTSIZE_ERROR && rawSize < (64u << 20);
+    std::vector<uint8_t> raw(ok ? rawSize : 0);
+    if (ok) {
+        size_t n = ZSTD_decompress(raw.data(), raw.size(), packed.data(), packed.size());
+        ok = !ZSTD_isError(n) && n == raw.size();
+    }
+    if (!ok) {
+        std::cerr << "[Bundle] Not a complete bundle: " << path << std::endl;
+        return false;
+    }
+
+    // 3. Chunk table, then the members
+    Reader r = { raw.data(), raw.data() + raw.size() };
+    uint32_t listed = 0, chunkCount = 0;
+    ok = r.tag("HBIX") && r.get(listed) && r.get(chunkCount) && listed == count;
+    for (uint32_t c = 0; ok && c < chunkCount; ++c) {
+        uint64_t offset = 0;
+        ok = r.get(offset) && offset + 8 <= indexOffset;
+        index.chunkOffsets.push_back(offset);
+    }
+    for (uint32_t i = 0; ok && i < count; ++i) {
+        BundleEntry entry;
+        uint16_t nameLength = 0;
+        ok = r.get(nameLength) && r.text(nameLength, entry.name) && r.get(entry.offset) && r.get(entry.size) &&
+             r.get(entry.mtimeNs) && r.get(entry.hash) &&
+             entry.offset + entry.size <= static_cast<uint64_t>(chunkCount) * index.chunkSize;
+        if (ok) index.entries.push_back(entry);
+    }
+    if (!ok) {
+        std::cerr << "[Bundle] Corrupt index: " << path << std::endl;
+        index = BundleIndex();
+        return false;
+    }
+    return true;
+}
+
+bool readBundleMember(const std::string& path, const BundleIndex& index, const BundleEntry& entry,
+                      const std::vector<uint8_t>& dict, std::vector<uint8_t>& data) {
+    data.clear();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    // 1. The chunks the member spans
+    const uint64_t first = entry.offset / index.chunkSize;
+    const uint64_t last = entry.size > 0 ? (entry.offset + entry.size - 1) / index.chunkSize : first;
+    ZSTD_DCtx* dctx = ZSTD_createDCtx();
+    ZSTD_DDict* ddict = dict.empty() ? nullptr : ZSTD_createDDict(dict.data(), dict.size());
+    bool ok = (entry.size == 0 || last < index.chunkOffsets.size()) && bundleDictionaryId(dict) == index.dictId;
+    std::vector<uint8_t> stored, chunk;
+    for (uint64_t c = first; ok && c <= last && data.size() < entry.size; ++c) {
+        uint8_t head[8];
+        ok = readAt(fd, index.chunkOffsets[c], head, sizeof(head));
+        uint32_t rawSize = 0, storedSize = 0;
+        Reader h = { head, head + sizeof(head) };
+        ok = ok && h.get(rawSize) && h.get(storedSize) && rawSize <= index.chunkSize;
+        const uint32_t length = storedSize & ~kBundleStoredRaw;
+        stored.resize(ok ? length : 0);
+        ok = ok && readAt(fd, index.chunkOffsets[c] + sizeof(head), stored.data(), stored.size());
+        if (!ok) break;
+
+        // 2. Decompress, then keep the member's slice of it
+        if (storedSize & kBundleStoredRaw) {
+            ok = length == rawSize;
+            chunk.swap(stored);
+        } else {
+            chunk.resize(rawSize);
+            size_t n = ddict ? ZSTD_decompress_usingDDict(dctx, chunk.data(), rawSize, stored.data(), length, ddict)
+                             : ZSTD_decompressDCtx(dctx, chunk.data(), rawSize, stored.data(), length);
+            ok = !ZSTD_isError(n) && n == rawSize;
+        }
+        const uint64_t chunkStart = c * index.chunkSize;
+        const uint64_t from = std::max(entry.offset, chunkStart) - chunkStart;
+        const uint64_t to = std::min<uint64_t>(entry.offset + entry.size - chunkStart, rawSize);
+        ok = ok && from <= to;
+        if (ok) data.insert(data.end(), chunk.begin() + from, chunk.begin() + to);
+    }
+    ZSTD_freeDDict(ddict);
+    ZSTD_freeDCtx(dctx);
+    close(fd);
+
+    ok = ok && data.size() == entry.size && xxh64(data.data(), data.size()) == entry.hash;
+    if (!ok) {
+        std::cerr << "[Bundle] Could not read " << entry.name << " from " << path << std::endl;
+        data.clear();
+    }
+    return ok;
+}
+
+}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace horus {
+namespace utils {
+
+    // Daily bundle: a day's small files (telemetry CSV, JSON sidecars, logs) in ONE
+    // object, so the upload pays one request and one TLS exchange instead of one per file.
+    //
+    // The members go one after the other into a single stream, each as a record
+    //   "HBEN" u16 nameLength u16 0 u64 size i64 mtimeNs u64 xxh64 name data
+    // and the stream is cut into chunks of 'chunkSize' bytes, each compressed on its own.
+    // Files of a few hundred bytes then share a zstd frame with their neighbours instead
+    // of paying a frame (and gaining nothing) each. A reader can decompress the chunks in
+    // order and walk the records without the index (streaming); the index at the end lets
+    // the cloud side fetch one member with range reads (footer, index, its chunks only).
+    //
+    // File layout (little-endian):
+    //   header  "HBN1" u32 version u32 dictId (0 = none) u32 chunkSize
+    //   chunks  { u32 rawSize u32 storedSize bytes }   storedSize | kBundleStoredRaw = kept as is,
+    //           otherwise one zstd frame (with the dictionary when dictId != 0)
+    //   index   one zstd frame (no dictionary) of
+    //           "HBIX" u32 count u32 chunkCount, chunkCount x u64 chunkOffset (in the file),
+    //           count x { u16 nameLength name u64 offset (of the data, in the stream) u64 size
+    //           i64 mtimeNs u64 xxh64 }
+    //   footer  u64 indexOffset u32 indexSize u32 count u32 dictId "HBNE"   (24 bytes)
+    static const uint32_t kBundleStoredRaw = 0x80000000u;
+    static const uint32_t kBundleChunkSize = 256 * 1024;
+
+    struct BundleEntry {
+        std::string name;        // Key relative to the data root ("2026-01-20/environmental_data.csv")
+        uint64_t offset = 0;     // Of the data in the uncompressed stream
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        uint64_t hash = 0;       // XXH64 of the data
+    };
+
+    struct BundleIndex {
+        uint32_t dictId = 0;
+        uint32_t chunkSize = kBundleChunkSize;
+        std::vector<uint64_t> chunkOffsets; // Chunk n starts at stream byte n * chunkSize
+        std::vector<BundleEntry> entries;
+    };
+
+    struct BundleInput {
+        std::string path;        // On disk
+        std::string name;        // In the bundle
+    };
+
+    struct BundleStats {
+        int files = 0;
+        uint64_t rawBytes = 0;   // Member data
+        uint64_t bundleBytes = 0;
+        double encodeMs = 0.0;   // Compression only (no file I/O)
+        uint32_t dictId = 0;
+    };
+
+    // Files of a day folder that belong in its bundle: text we produce in small pieces
+    bool isBundleMember(const std::string& name);
+
+    // "<root>/<day>/<day>.hbn"
+    std::string bundlePath(const std::string& root, const std::string& day);
+
+    // --- Dictionary ---
+    // Even a solid chunk of one day is short for zstd to learn the CSV header and the
+    // sidecar key names before it is over. A dictionary trained on past days ships that
+    // context once. Stored as "<root>/bundle-dict-<id>.zdict" (uploaded like any loose
+    // file; the cloud side needs every id that a bundle names).
+
+    // Trains on 'files' (split into 4 KB samples). False if there is too little data.
+    bool trainBundleDictionary(const std::vector<std::string>& files, size_t dictSize, std::vector<uint8_t>& dict);
+
+    // Newest "<root>/bundle-dict-*.zdict", empty if none
+    std::string findBundleDictionary(const std::string& root);
+
+    bool loadBundleDictionary(const std::string& path, std::vector<uint8_t>& dict);
+
+    // The id bundles record (0 = not a dictionary)
+    uint32_t bundleDictionaryId(const std::vector<uint8_t>& dict);
+
+    // --- Bundle ---
+
+    // Builds the bundle in memory and commits it with writeFileAtomic(). 'dict' may be empty.
+    bool writeBundle(const std::string& path, const std::vector<BundleInput>& files,
+                     const std::vector<uint8_t>& dict, int level, BundleStats* stats = nullptr);
+
+    // Footer + index only
+    bool readBundleIndex(const std::string& path, BundleIndex& index);
+
+    // One member: only the chunks it spans are read and decompressed; checked against its hash
+    bool readBundleMember(const std::string& path, const BundleIndex& index, const BundleEntry& entry,
+                          const std::vector<uint8_t>& dict, std::vector<uint8_t>& data);
+
+}
+}
@@ -0,0 +1,313 @@
+#include "FileIndex.hpp"
+#include "FileSystem.hpp"
+#include "Hash.hpp"
+#include <iostream>
+#include <sstream>
+#include <filesystem>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace utils {
+
+namespace {
+
+// Keys go in a space-separated line: escape what would break it
+std::string encodeKey(const std::string& key) {
+    static const char digits[] = "0123456789ABCDEF";
+    std::string out;
+    for (unsigned char c : key) {
+        if (c <= ' ' || c == '%' || c >= 0x7F) {
+            out += '%';
+            out += digits[c >> 4];
+            out += digits[c & 0x0F];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    return out;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// False for a '%' not followed by two hex digits (a torn or hand-edited line)
+bool decodeKey(const std::string& text, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (text[i] != '%') {
+            out += text[i];
+            continue;
+        }
+        const int high = i + 2 < text.size() ? hexDigit(text[i + 1]) : -1;
+        const int low = high >= 0 ? hexDigit(text[i + 2]) : -1;
+        if (low < 0) return false;
+        out += static_cast<char>(high << 4 | low);
+        i += 2;
+    }
+    return true;
+}
+
+// Same owner as the data root, so root-run tasks don't lock the horus user out
+void matchOwner(int fd, const fs::path& folder) {
+    struct stat st;
+    if (geteuid() == 0 && stat(folder.c_str(), &st) == 0) {
+        if (fchown(fd, st.st_uid, st.st_gid) != 0) {
+            std::cerr << "[Index] WARNING: chown failed: " << std::strerror(errno) << std::endl;
+        }
+    }
+}
+
+bool writeAll(int fd, const std::string& text) {
+    size_t done = 0;
+    while (done < text.size()) {
+        ssize_t n = write(fd, text.data() + done, text.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+} // namespace
+
+std::string getIndexPath() {
+    return getDataRoot() + "/.index/files";
+}
+
+FileIndex::FileIndex(const std::string& path) : path(path) {}
+
+FileIndex::~FileIndex() {
+    if (fd >= 0) close(fd);
+    if (uploaderFd >= 0) close(uploaderFd); // Drops the uploader lock
+}
+
+bool FileIndex::openJournal() {
+    if (fd >= 0) return true;
+    fs::path folder = fs::path(path).parent_path();
+    std::error_code ec;
+    if (!fs::exists(folder, ec)) {
+        fs::create_directories(folder, ec);
+        int dirFd = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            matchOwner(dirFd, folder.parent_path());
+            close(dirFd);
+        }
+    }
+    bool created = !fs::exists(path, ec);
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Index] ERROR: Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    if (created) matchOwner(fd, folder);
+    return true;
+}
+
+bool FileIndex::claimUploader() {
+    if (!openJournal()) return false;
+    std::string lockPath = path + ".upload.lock";
+    uploaderFd = open(lockPath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (uploaderFd < 0 || flock(uploaderFd, LOCK_EX | LOCK_NB) != 0) {
+        std::cerr << "[Index] ERROR: Another upload is running (" << lockPath << ")" << std::endl;
+        if (uploaderFd >= 0) close(uploaderFd);
+        uploaderFd = -1;
+        return false;
+    }
+    return true;
+}
+
+bool FileIndex::load(const std::string& root, bool compact) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (!openJournal()) return false;
+    flock(fd, LOCK_EX);
+
+    // 1. Replay, minus a torn last line (no newline yet)
+    entries.clear();
+    std::string content;
+    char chunk[65536];
+    ssize_t n;
+    while ((n = pread(fd, chunk, sizeof(chunk), static_cast<off_t>(content.size()))) > 0) {
+        content.append(chunk, static_cast<size_t>(n));
+    }
+    content.resize(content.rfind('\n') + 1); // npos + 1 = 0
+    std::istringstream lines(content);
+    std::string line;
+    while (std::getline(lines, line)) apply(line);
+
+    if (!compact) {
+        flock(fd, LOCK_UN);
+        return true;
+    }
+
+    // 2. Live state only, minus files deleted locally
+    std::error_code ec;
+    std::string text;
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (!root.empty() && !fs::exists(fs::path(root) / it->first, ec)) {
+            it = entries.erase(it);
+            continue;
+        }
+        const std::string key = encodeKey(it->first);
+        const FileState& state = it->second;
+        if (state.known) {
+            text += "W " + key + " " + std::to_string(state.size) + " " + std::to_string(state.mtimeNs) +
+                    " " + hashToHex(state.hash) + "\n";
+        }
+        if (state.uploaded) {
+            text += "U " + key + " " + std::to_string(state.uploadedSize) + " " + hashToHex(state.uploadedHash) +
+                    " " + std::to_string(state.tails) + "\n";
+        }
+        if (!state.uploadId.empty()) {
+            text += "M " + key + " " + std::to_string(state.multipartSize) + " " +
+                    std::to_string(state.multipartMtimeNs) + " " + state.uploadId + "\n";
+            for (const auto& part : state.parts) {
+                text += "P " + key + " " + std::to_string(part.first) + " " + part.second + "\n";
+            }
+        }
+        ++it;
+    }
+    if (text.size() >= content.size()) {
+        flock(fd, LOCK_UN);
+        return true;
+    }
+
+    // 3. Atomic swap while we hold the old file's lock; appenders queued on it see
+    // the inode change and reopen
+    bool ok = writeFileAtomic(path, reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    int oldFd = fd;
+    fd = -1;
+    ok = openJournal() && ok;
+    close(oldFd); // Releases the old lock
+    return ok;
+}
+
+void FileIndex::apply(const std::string& line) {
+    std::istringstream fields(line);
+    std::string type, encoded, key;
+    if (!(fields >> type >> encoded) || !decodeKey(encoded, key)) return;
+
+    if (type == "W") {
+        uint64_t size;
+        int64_t mtimeNs;
+        std::string hex;
+        uint64_t hash;
+        if (!(fields >> size >> mtimeNs >> hex) || !hashFromHex(hex, hash)) return;
+        FileState& state = entries[key];
+        state.known = true;
+        state.size = size;
+        state.mtimeNs = mtimeNs;
+        state.hash = hash;
+    } else if (type == "U") {
+        uint64_t size;
+        std::string hex;
+        uint64_t hash;
+        int tails;
+        if (!(fields >> size >> hex >> tails) || !hashFromHex(hex, hash)) return;
+        FileState& state = entries[key];
+        state.uploaded = true;
+        state.uploadedSize = size;
+        state.uploadedHash = hash;
+        state.tails = tails;
+        state.uploadId.clear();
+        state.parts.clear();
+    } else if (type == "M") {
+        uint64_t size;
+        int64_t mtimeNs;
+        std::string uploadId;
+        if (!(fields >> size >> mtimeNs >> uploadId)) return;
+        FileState& state = entries[key];
+        state.uploadId = uploadId;
+        state.multipartSize = size;
+        state.multipartMtimeNs = mtimeNs;
+        state.parts.clear();
+    } else if (type == "P") {
+        int part;
+        std::string etag;
+        if (!(fields >> part >> etag)) return;
+        auto it = entries.find(key);
+        if (it != entries.end() && !it->second.uploadId.empty()) it->second.parts[part] = etag;
+    } else if (type == "X") {
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            it->second.uploadId.clear();
+            it->second.parts.clear();
+        }
+    }
+}
+
+void FileIndex::append(const std::string& line) {
+    std::lock_guard<std::mutex> guard(mutex);
+    apply(line);
+    if (!openJournal()) return;
+
+    // Lock, and make sure the uploader did not swap the journal while we waited
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        flock(fd, LOCK_EX);
+        struct stat opened, current;
+        if (fstat(fd, &opened) == 0 && stat(path.c_str(), &current) == 0 && opened.st_ino == current.st_ino) break;
+        close(fd);
+        fd = -1;
+        if (!openJournal()) return;
+    }
+    if (!writeAll(fd, line + "\n") || fdatasync(fd) != 0) {
+        std::cerr << "[Index] WARNING: Could not append to " << path << ": " << std::strerror(errno) << std::endl;
+    }
+    flock(fd, LOCK_UN);
+}
+
+bool FileIndex::find(const std::string& key, FileState& state) const {
+    std::lock_guard<std::mutex> guard(mutex);
+    auto it = entries.find(key);
+    if (it == entries.end()) return false;
+    state = it->second;
+    return true;
+}
+
+void FileIndex::recordWrite(const std::string& key, uint64_t size, int64_t mtimeNs, uint64_t hash) {
+    append("W " + encodeKey(key) + " " + std::to_string(size) + " " + std::to_string(mtimeNs) + " " + hashToHex(hash));
+}
+
+void FileIndex::markUploaded(const std::string& key, uint64_t size, uint64_t hash, int tails) {
+    append("U " + encodeKey(key) + " " + std::to_string(size) + " " + hashToHex(hash) + " " + std::to_string(tails));
+}
+
+void FileIndex::startMultipart(const std::string& key, uint64_t size, int64_t mtimeNs, const std::string& uploadId) {
+    append("M " + encodeKey(key) + " " + std::to_string(size) + " " + std::to_string(mtimeNs) + " " + uploadId);
+}
+
+void FileIndex::markPart(const std::string& key, int part, const std::string& etag) {
+    append("P " + encodeKey(key) + " " + std::to_string(part) + " " + etag);
+}
+
+void FileIndex::abandon(const std::string& key) {
+    append("X " + encodeKey(key));
+}
+
+void indexFileWrite(const std::string& path, const uint8_t* data, size_t size) {
+    // 1. Only data we upload: under the data root, not in a hidden folder
+    const std::string root = getDataRoot() + "/";
+    if (path.compare(0, root.size(), root) != 0) return;
+    const std::string key = path.substr(root.size());
+    if (key.empty() || key[0] == '.' || key.find("/.") != std::string::npos) return;
+
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return;
+    const int64_t mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+
+    // 2. Hash while the bytes are still in memory; one line, no replay
+    FileIndex index;
+    index.recordWrite(key, size, mtimeNs, xxh64(data, size));
+}
+
+}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+namespace horus {
+namespace utils {
+
+    // What we know about one file under the data root, keyed by its path relative to
+    // the root ("2026-01-20/img.jpg", "cpu_info.csv")
+    struct FileState {
+        // Last content written locally
+        bool known = false;
+        uint64_t size = 0;
+        int64_t mtimeNs = 0;
+        uint64_t hash = 0;              // XXH64 of the whole file
+
+        // What the bucket holds: bytes [0, uploadedSize) with that prefix's hash. For the
+        // append-only CSVs the bytes after the first full upload go up as 'tails' pieces.
+        bool uploaded = false;
+        uint64_t uploadedSize = 0;
+        uint64_t uploadedHash = 0;
+        int tails = 0;
+
+        // Multipart upload in progress, valid for this exact size / mtime
+        std::string uploadId;
+        uint64_t multipartSize = 0;
+        int64_t multipartMtimeNs = 0;
+        std::map<int, std::string> parts; // Part number -> ETag
+    };
+
+    // "<data root>/.index/files"
+    std::string getIndexPath();
+
+    // Local index of DataCapture, kept at write time. An append-only text journal,
+    // replayed on load:
+    //   W <key> <size> <mtime> <hash>           file written (writeFileAtomic, or hashed by a sync)
+    //   U <key> <size> <hash> <tails>           bucket holds bytes [0, size) of it
+    //   M <key> <size> <mtime> <uploadId>       multipart upload started
+    //   P <key> <part> <etag>                   part stored
+    //   X <key>                                 multipart upload abandoned
+    // Every line is one write() under flock + fdatasync, so capture processes, the
+    // daemon and the uploader can all append. Only the uploader compacts (rename of a
+    // rewritten journal); appenders notice the new inode and reopen.
+    class FileIndex {
+    public:
+        explicit FileIndex(const std::string& path = getIndexPath());
+        ~FileIndex();
+
+        FileIndex(const FileIndex&) = delete;
+        FileIndex& operator=(const FileIndex&) = delete;
+
+        // Replays the journal. With compact = true it is rewritten with only the live
+        // state; entries whose file is gone from 'root' are dropped.
+        bool load(const std::string& root = "", bool compact = false);
+
+        // Sole uploader for the lifetime of this object (false if another one runs)
+        bool claimUploader();
+
+        bool find(const std::string& key, FileState& state) const;
+
+        void recordWrite(const std::string& key, uint64_t size, int64_t mtimeNs, uint64_t hash);
+        void markUploaded(const std::string& key, uint64_t size, uint64_t hash, int tails);
+        void startMultipart(const std::string& key, uint64_t size, int64_t mtimeNs, const std::string& uploadId);
+        void markPart(const std::string& key, int part, const std::string& etag);
+        void abandon(const std::string& key);
+
+    private:
+        void apply(const std::string& line);
+        void append(const std::string& line);
+        bool openJournal();
+
+        std::string path;
+        int fd = -1;
+        int uploaderFd = -1;
+        mutable std::mutex mutex;
+        std::map<std::string, FileState> entries;
+    };
+
+    // Called by writeFileAtomic() with the bytes just written: files under the data root
+    // get one W line (hashed from memory, no re-read). Failures are only logged, the
+    // file itself is already safe.
+    void indexFileWrite(const std::string& path, const uint8_t* data, size_t size);
+
+}
+}
@@ -1,12 +1,23 @@
+#include "FileSystem.hpp"
+#include "FileIndex.hpp"
+#include "Trace.hpp"
 #include <filesystem>
 #include <ctime>
-#include <fstream>
 #include <iostream>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 namespace horus {
 namespace utils {
 
+std::string getDataRoot() {
+    return "/home/horus/DataCapture";
+}
+
 std::string getTodaysFolder(){
     // Get current local time:
     std::time_t t = std::time(nullptr);
@@ -14,7 +25,7 @@ std::string getTodaysFolder(){
     std::strftime(local_time, sizeof(local_time), "%Y-%m-%d", std::localtime(&t));
 
     // Create Path:
-    std::string path = "/home/horus/DataCapture/"+ std::string(local_time);
+    std::string path = getDataRoot() + "/" + std::string(local_time);
     // Create the folder it doesnt exist
     if(!fs::exists(path)){
         fs::create_directories(path);
@@ -22,29 +33,88 @@ std::string getTodaysFolder(){
     return path;
 }
 
-void appendToCSV(const std::string& fullPath, const std::string& timestamp, const std::string& env_data) {
+bool writeFileAtomic(const std::string& path, const uint8_t* data, size_t size, WriteStats* stats) {
+    HORUS_TRACE_SCOPE("fs.write_atomic");
+    auto start = std::chrono::steady_clock::now();
 
-    std::string path = fullPath;
-    
-    
-    // Check if file exists to write header
-    bool fileExists = fs::exists(path);
-    
-    std::ofstream file(path, std::ios::app); // Append mode
+    fs::path target(path);
+    fs::path folder = target.has_parent_path() ? target.parent_path() : fs::path(".");
+    fs::path temp = folder / ("." + target.filename().string() + ".tmp");
 
-    if (file.is_open()) {
-        if (!fileExists) {
-            file << "Timestamp,External_Temperature_C,Humidity_Percent,Pressure_hPa\n"; //First row of the .csv file
+    // 1. Whole buffer in one go (the loop only matters for >2 GB or signals)
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[FileSystem] ERROR: Could not create " << temp << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    size_t written = 0;
+    {
+        HORUS_TRACE_SCOPE("fs.write");
+        while (written < size) {
+            ssize_t n = write(fd, data + written, size - written);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            written += static_cast<size_t>(n);
         }
-        file << timestamp << "," << env_data << "\n";
-        std::cout << "[FileSystem] Data appended to " << path << " successfully." << std::endl;
-        file.close();
-    }else
+    }
+    HORUS_TRACE_COUNTER("fs.bytes", written);
+
+    // 2. Data on the medium before the name points at it
+    bool ok = false;
     {
-        std::cerr << "[FileSystem] ERROR: Could not open file at: " << path << std::endl;
+        HORUS_TRACE_SCOPE("fs.fsync");
+        ok = written == size && fsync(fd) == 0;
     }
-    
+    {
+        HORUS_TRACE_SCOPE("fs.close");
+        ok = close(fd) == 0 && ok;
+    }
+    if (!ok) {
+        std::cerr << "[FileSystem] ERROR: Write failed on " << temp << ": " << std::strerror(errno) << std::endl;
+        unlink(temp.c_str());
+        return false;
+    }
+
+    // 3. Atomic switch, then make the rename itself durable
+    {
+        HORUS_TRACE_SCOPE("fs.rename");
+        if (rename(temp.c_str(), target.c_str()) != 0) {
+            std::cerr << "[FileSystem] ERROR: Could not rename to " << path << ": " << std::strerror(errno) << std::endl;
+            unlink(temp.c_str());
+            return false;
+        }
+        int dirFd = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+
+    if (stats) {
+        stats->bytes = size;
+        stats->writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 4. Tell the sync what changed (no-op outside the data root)
+    HORUS_TRACE_SCOPE("fs.index");
+    indexFileWrite(path, data, size);
+    return true;
 }
 
+int removeStaleTempFiles(const std::string& folder) {
+    int removed = 0;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(folder, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 5 && name[0] == '.' && name.compare(name.size() - 4, 4, ".tmp") == 0) {
+            if (fs::remove(entry.path(), ec)) ++removed;
+        }
+    }
+    if (removed > 0) {
+        std::cout << "[FileSystem] Removed " << removed << " interrupted write(s) in " << folder << std::endl;
+    }
+    return removed;
+}
+
+}
 }
-}
\ No newline at end of file
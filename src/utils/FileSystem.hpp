@@ -1,16 +1,34 @@
 #pragma once
 #include <string>
+#include <cstddef>
+#include <cstdint>
 
 namespace horus {
 namespace utils {
 
+    // Root of everything we record: "/home/horus/DataCapture"
+    std::string getDataRoot();
+
     // Returns a path like: "/home/horus/DataCapture/2026-01-20/"
     // Creates the directory if it doesn't exist.
     std::string getTodaysFolder();
 
-    // Appends a line to a CSV file in today's folder.
-    // If the file doesn't exist, it creates it and adds a header.
-    void appendToCSV(const std::string& fullPath, const std::string& timestamp, const std::string& env_data);
+    struct WriteStats {
+        size_t bytes = 0;
+        double writeMs = 0.0; // write + fsync + rename, i.e. what the storage costs us
+    };
+
+    // Crash-safe file write, for data that must never be seen half-written:
+    // 1. one write() of the whole buffer to ".<name>.tmp" in the same folder
+    // 2. fsync() the temp file
+    // 3. rename() it over 'path' (atomic), then fsync() the folder
+    // After a power cut 'path' is either complete or absent; only the hidden
+    // temp file can be partial (rclone excludes it, removeStaleTempFiles() cleans it).
+    // Files under the data root are then recorded in the FileIndex (size, mtime, hash).
+    bool writeFileAtomic(const std::string& path, const uint8_t* data, size_t size, WriteStats* stats = nullptr);
+
+    // Deletes ".*.tmp" leftovers of interrupted writeFileAtomic() calls. Returns how many.
+    int removeStaleTempFiles(const std::string& folder);
 
 }
 }
\ No newline at end of file
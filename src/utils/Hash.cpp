@@ -0,0 +1,164 @@
+#include "Hash.hpp"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace horus {
+namespace utils {
+
+namespace {
+
+const uint64_t P1 = 11400714785074694791ULL;
+const uint64_t P2 = 14029467366897019727ULL;
+const uint64_t P3 = 1609587929392839161ULL;
+const uint64_t P4 = 9650029242287828579ULL;
+const uint64_t P5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// Little-endian loads (the Pi and x86 both are)
+inline uint64_t read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+inline uint32_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * P2;
+    acc = rotl(acc, 31);
+    return acc * P1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * P1 + P4;
+}
+
+} // namespace
+
+Xxh64::Xxh64(uint64_t seed) : seed(seed) {
+    acc[0] = seed + P1 + P2;
+    acc[1] = seed + P2;
+    acc[2] = seed;
+    acc[3] = seed - P1;
+}
+
+void Xxh64::update(const void* data, size_t size) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total += size;
+
+    // 1. Top up a partial stripe
+    if (buffered > 0) {
+        size_t n = std::min(size, sizeof(buffer) - buffered);
+        std::memcpy(buffer + buffered, p, n);
+        buffered += n;
+        p += n;
+        size -= n;
+        if (buffered < sizeof(buffer)) return;
+        for (int i = 0; i < 4; ++i) acc[i] = round(acc[i], read64(buffer + 8 * i));
+        buffered = 0;
+    }
+
+    // 2. Whole 32-byte stripes straight from the input (four independent lanes)
+    while (size >= 32) {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+        p += 32;
+        size -= 32;
+    }
+
+    // 3. Keep the rest for later
+    std::memcpy(buffer, p, size);
+    buffered = size;
+}
+
+uint64_t Xxh64::digest() const {
+    uint64_t h;
+    if (total >= 32) {
+        h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+        for (int i = 0; i < 4; ++i) h = merge(h, acc[i]);
+    } else {
+        h = seed + P5;
+    }
+    h += total;
+
+    const uint8_t* p = buffer;
+    size_t size = buffered;
+    while (size >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * P1 + P4;
+        p += 8;
+        size -= 8;
+    }
+    if (size >= 4) {
+        h ^= static_cast<uint64_t>(read32(p)) * P1;
+        h = rotl(h, 23) * P2 + P3;
+        p += 4;
+        size -= 4;
+    }
+    while (size > 0) {
+        h ^= *p * P5;
+        h = rotl(h, 11) * P1;
+        ++p;
+        --size;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t xxh64(const void* data, size_t size, uint64_t seed) {
+    Xxh64 state(seed);
+    state.update(data, size);
+    return state.digest();
+}
+
+bool hashFile(const std::string& path, uint64_t limit, uint64_t& hash) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    Xxh64 state;
+    std::vector<uint8_t> chunk(1 << 20);
+    uint64_t done = 0;
+    while (done < limit) {
+        size_t want = static_cast<size_t>(std::min<uint64_t>(chunk.size(), limit - done));
+        ssize_t n = read(fd, chunk.data(), want);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        state.update(chunk.data(), static_cast<size_t>(n));
+        done += static_cast<uint64_t>(n);
+    }
+    close(fd);
+    if (limit != UINT64_MAX && done != limit) return false;
+    hash = state.digest();
+    return true;
+}
+
+std::string hashToHex(uint64_t hash) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex(16, '0');
+    for (int i = 15; i >= 0; --i, hash >>= 4) hex[i] = digits[hash & 0x0F];
+    return hex;
+}
+
+bool hashFromHex(const std::string& hex, uint64_t& hash) {
+    if (hex.size() != 16) return false;
+    hash = 0;
+    for (char c : hex) {
+        int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (digit < 0) return false;
+        hash = (hash << 4) | static_cast<uint64_t>(digit);
+    }
+    return true;
+}
+
+}
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+namespace horus {
+namespace utils {
+
+    // XXH64 (xxHash, 64-bit), streaming. Not cryptographic: it tells "same bytes" from
+    // "changed bytes" at several GB/s, and any xxhash library reproduces it on the cloud side.
+    class Xxh64 {
+    public:
+        explicit Xxh64(uint64_t seed = 0);
+        void update(const void* data, size_t size);
+        uint64_t digest() const;
+
+    private:
+        uint64_t acc[4];
+        uint8_t buffer[32];
+        size_t buffered = 0;
+        uint64_t total = 0;
+        uint64_t seed;
+    };
+
+    uint64_t xxh64(const void* data, size_t size, uint64_t seed = 0);
+
+    // XXH64 of the first 'limit' bytes of a file (UINT64_MAX = whole file).
+    // False if it cannot be read or is shorter than 'limit'.
+    bool hashFile(const std::string& path, uint64_t limit, uint64_t& hash);
+
+    // 16 lower-case hex digits, and back
+    std::string hashToHex(uint64_t hash);
+    bool hashFromHex(const std::string& hex, uint64_t& hash);
+
+}
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <mutex>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+
+namespace horus {
+namespace utils {
+
+// Counting semaphore in bytes: callers reserve what they are about to hold and wait
+// while it doesn't fit next to the others. Served in arrival order, so a large
+// reservation is not starved by a stream of small ones.
+class MemoryBudget {
+public:
+    explicit MemoryBudget(size_t capacityBytes) : capacityBytes(std::max<size_t>(1, capacityBytes)) {}
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    size_t capacity() const { return capacityBytes; }
+
+    // Blocks until 'bytes' fit. More than the capacity is clamped to it (that caller then
+    // runs alone). Returns the bytes reserved: hand exactly those back to release().
+    size_t acquire(size_t bytes) {
+        bytes = std::min(bytes, capacityBytes);
+        std::unique_lock<std::mutex> lock(budgetMutex);
+        const uint64_t ticket = nextTicket++;
+        budgetCv.wait(lock, [&] { return ticket == serving && heldBytes + bytes <= capacityBytes; });
+        ++serving;
+        heldBytes += bytes;
+        peakBytes = std::max(peakBytes, heldBytes);
+        budgetCv.notify_all(); // The next in line may fit too
+        return bytes;
+    }
+
+    void release(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex);
+            heldBytes -= std::min(bytes, heldBytes);
+        }
+        budgetCv.notify_all();
+    }
+
+    size_t held() const {
+        std::lock_guard<std::mutex> lock(budgetMutex);
+        return heldBytes;
+    }
+
+    // Most ever held at once
+    size_t peak() const {
+        std::lock_guard<std::mutex> lock(budgetMutex);
+        return peakBytes;
+    }
+
+private:
+    const size_t capacityBytes;
+    mutable std::mutex budgetMutex;
+    std::condition_variable budgetCv;
+    size_t heldBytes = 0;
+    size_t peakBytes = 0;
+    uint64_t nextTicket = 0;
+    uint64_t serving = 0;
+};
+
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <chrono>
+#include <sys/resource.h>
+
+namespace horus {
+namespace utils {
+
+// Wall-clock + CPU time (user + system, all threads) elapsed since construction.
+// Used to compare the per-task cost of the daemon against fork-per-task runs.
+class TaskTimer {
+public:
+    TaskTimer() : wallStart(std::chrono::steady_clock::now()), cpuStart(processCpuMs()) {}
+
+    double wallMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - wallStart).count();
+    }
+
+    double cpuMs() const { return processCpuMs() - cpuStart; }
+
+    // CPU time of the whole process so far (includes start-up when called from main)
+    static double processCpuMs() {
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+               (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+    }
+
+private:
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+};
+
+}
+}
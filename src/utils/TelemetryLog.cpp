@@ -0,0 +1,512 @@
+#include "TelemetryLog.hpp"
+#include "FileSystem.hpp"
+#include "Trace.hpp"
+#include <iostream>
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <ctime>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace utils {
+
+namespace {
+
+const uint32_t kRecordMagic = 0x31524c54; // "TLR1"
+const char kFileMagic[8] = {'H', 'O', 'R', 'U', 'S', 'T', 'L', 'M'};
+const uint16_t kFileVersion = 1;
+const uint64_t kHeaderSize = 64;
+const uint64_t kRecordSize = sizeof(TelemetryRecord);
+const uint64_t kBlockRecords = 1024; // Preallocation step: 64 KB, ~3 days of 15-min env + cpu
+const int64_t kDayMs = 86400LL * 1000;
+
+// First 64 bytes of every day file
+struct FileHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t reserved;
+    char day[16];
+    uint8_t pad[32];
+};
+static_assert(sizeof(FileHeader) == kHeaderSize, "FileHeader must stay 64 bytes");
+
+// --- CRC-32 (IEEE 802.3, reflected) ---
+struct CrcTable {
+    uint32_t entries[256];
+    CrcTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+uint32_t recordCrc(const TelemetryRecord& record) {
+    static const CrcTable table;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&record);
+    uint32_t c = 0xFFFFFFFFu;
+    for (size_t i = 0; i < offsetof(TelemetryRecord, crc); ++i) {
+        c = table.entries[(c ^ bytes[i]) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
+
+bool isEmptySlot(const TelemetryRecord& record) {
+    static const TelemetryRecord zero; // All members default to 0, and there is no padding
+    return std::memcmp(&record, &zero, sizeof(record)) == 0;
+}
+
+bool isValid(const TelemetryRecord& record) {
+    return record.magic == kRecordMagic && record.crc == recordCrc(record);
+}
+
+int64_t nowMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Local time formatted with strftime (CSV timestamps have always been local)
+std::string formatLocal(int64_t timeMs, const char* format) {
+    std::time_t t = static_cast<std::time_t>(timeMs / 1000);
+    std::tm local;
+    localtime_r(&t, &local);
+    char text[64];
+    std::strftime(text, sizeof(text), format, &local);
+    return text;
+}
+
+std::string localDay(int64_t timeMs) {
+    return formatLocal(timeMs, "%Y-%m-%d");
+}
+
+// Local timestamp text -> Unix ms (trailing zone name, e.g. "CET", is ignored)
+bool parseLocal(const std::string& text, const char* format, int64_t& timeMs) {
+    std::tm local = {};
+    if (!strptime(text.c_str(), format, &local)) return false;
+    local.tm_isdst = -1;
+    std::time_t t = std::mktime(&local);
+    if (t == -1) return false;
+    timeMs = static_cast<int64_t>(t) * 1000;
+    return true;
+}
+
+bool writeAll(int fd, const void* data, size_t size, off_t offset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        ssize_t n = pwrite(fd, bytes, size, offset);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        bytes += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+// Extends the file by one block of zeros: real blocks, not a sparse hole, so later
+// appends never allocate
+bool preallocate(int fd, uint64_t fromSlot) {
+    static const std::vector<uint8_t> zeros(kBlockRecords * kRecordSize, 0);
+    return writeAll(fd, zeros.data(), zeros.size(), static_cast<off_t>(kHeaderSize + fromSlot * kRecordSize));
+}
+
+// The daily routine runs as root, the 15-min monitors as the horus user: whatever
+// root creates is handed to the owner of the folder it lives in
+void matchOwner(int fd, const fs::path& folder) {
+    struct stat st;
+    if (geteuid() == 0 && stat(folder.c_str(), &st) == 0) {
+        if (fchown(fd, st.st_uid, st.st_gid) != 0) {
+            std::cerr << "[Telemetry] WARNING: chown failed: " << std::strerror(errno) << std::endl;
+        }
+    }
+}
+
+} // namespace
+
+std::string getTelemetryFolder() {
+    return getDataRoot() + "/telemetry";
+}
+
+// --- WRITER ---
+
+TelemetryLog::TelemetryLog(const std::string& folder, bool durable) : folder(folder), durable(durable) {}
+
+TelemetryLog::~TelemetryLog() {
+    if (fd >= 0) {
+        if (!durable) fdatasync(fd);
+        close(fd);
+    }
+}
+
+bool TelemetryLog::openDay(const std::string& day) {
+    if (fd >= 0) {
+        if (!durable) fdatasync(fd);
+        close(fd);
+        fd = -1;
+    }
+    currentDay.clear();
+
+    std::error_code ec;
+    if (fs::create_directories(folder, ec)) {
+        int dirFd = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            matchOwner(dirFd, fs::path(folder).parent_path());
+            close(dirFd);
+        }
+    }
+    fs::path path = fs::path(folder) / (day + ".tlm");
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "[Telemetry] ERROR: Could not open " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    flock(fd, LOCK_EX);
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0;
+
+    // 1. New day: header + first block, made durable together with the directory entry
+    if (ok && static_cast<uint64_t>(st.st_size) < kHeaderSize) {
+        FileHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+        header.version = kFileVersion;
+        header.recordSize = kRecordSize;
+        std::strncpy(header.day, day.c_str(), sizeof(header.day) - 1);
+        matchOwner(fd, folder);
+        ok = writeAll(fd, &header, sizeof(header), 0) && preallocate(fd, 0) && fdatasync(fd) == 0;
+        int dirFd = open(folder.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+        st.st_size = static_cast<off_t>(kHeaderSize + kBlockRecords * kRecordSize);
+    }
+
+    // 2. Replay: the first all-zero slot is where the data ends (torn records stay in place)
+    if (ok) {
+        capacity = (static_cast<uint64_t>(st.st_size) - kHeaderSize) / kRecordSize;
+        nextSlot = capacity;
+        void* map = capacity > 0 ? mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        if (map != MAP_FAILED) {
+            const TelemetryRecord* slots = reinterpret_cast<const TelemetryRecord*>(
+                static_cast<const uint8_t*>(map) + kHeaderSize);
+            nextSlot = 0;
+            while (nextSlot < capacity && !isEmptySlot(slots[nextSlot])) ++nextSlot;
+            munmap(map, st.st_size);
+        }
+    }
+    flock(fd, LOCK_UN);
+
+    if (!ok) {
+        std::cerr << "[Telemetry] ERROR: Could not prepare " << path << ": " << std::strerror(errno) << std::endl;
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    currentDay = day;
+    return true;
+}
+
+bool TelemetryLog::append(TelemetryRecord record) {
+    HORUS_TRACE_SCOPE("telemetry.append");
+    if (record.timeMs == 0) record.timeMs = nowMs();
+    const std::string day = localDay(record.timeMs);
+    if (day != currentDay && !openDay(day)) return false;
+
+    record.magic = kRecordMagic;
+    record.crc = recordCrc(record);
+
+    flock(fd, LOCK_EX);
+    // 1. Another process may have appended (or grown the file) since we looked
+    struct stat st;
+    if (fstat(fd, &st) == 0 && static_cast<uint64_t>(st.st_size) > kHeaderSize) {
+        capacity = std::max(capacity, (static_cast<uint64_t>(st.st_size) - kHeaderSize) / kRecordSize);
+    }
+    TelemetryRecord slot;
+    while (nextSlot < capacity &&
+           pread(fd, &slot, sizeof(slot), static_cast<off_t>(kHeaderSize + nextSlot * kRecordSize)) == sizeof(slot) &&
+           !isEmptySlot(slot)) {
+        ++nextSlot;
+    }
+
+    // 2. Day file full: one more zeroed block
+    bool ok = true;
+    if (nextSlot >= capacity) {
+        ok = preallocate(fd, capacity);
+        if (ok) capacity += kBlockRecords;
+    }
+
+    // 3. The record itself: one pwrite into preallocated space
+    ok = ok && writeAll(fd, &record, sizeof(record), static_cast<off_t>(kHeaderSize + nextSlot * kRecordSize));
+    if (ok && durable) ok = fdatasync(fd) == 0;
+    if (ok) ++nextSlot;
+    flock(fd, LOCK_UN);
+
+    if (!ok) {
+        std::cerr << "[Telemetry] ERROR: Append failed (" << currentDay << "): " << std::strerror(errno) << std::endl;
+    }
+    return ok;
+}
+
+// --- READER ---
+
+bool scanTelemetry(const std::string& folder, int64_t fromMs, int64_t toMs, uint16_t source,
+                   const std::function<void(const TelemetryRecord&)>& visit, TelemetryScanStats* stats) {
+    TelemetryScanStats local;
+    TelemetryScanStats& counts = stats ? *stats : local;
+    counts = TelemetryScanStats();
+
+    // 1. Day files that can hold the range (one day of margin for DST / clock steps)
+    const std::string firstDay = fromMs > kDayMs ? localDay(fromMs - kDayMs) : "";
+    const std::string lastDay = toMs < LLONG_MAX - kDayMs ? localDay(toMs + kDayMs) : "~";
+    std::vector<fs::path> files;
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(folder, ec)) {
+        if (entry.path().extension() != ".tlm") continue;
+        const std::string day = entry.path().stem().string();
+        if (day >= firstDay && day <= lastDay) files.push_back(entry.path());
+    }
+    if (ec) {
+        std::cerr << "[Telemetry] ERROR: Could not list " << folder << ": " << ec.message() << std::endl;
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    // 2. Map each file and walk its slots up to the first free one
+    for (const fs::path& path : files) {
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) <= kHeaderSize) {
+            close(fd);
+            continue;
+        }
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) continue;
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+        const FileHeader* header = static_cast<const FileHeader*>(map);
+        if (std::memcmp(header->magic, kFileMagic, sizeof(kFileMagic)) == 0 && header->recordSize == kRecordSize) {
+            ++counts.files;
+            const TelemetryRecord* slots = reinterpret_cast<const TelemetryRecord*>(
+                static_cast<const uint8_t*>(map) + kHeaderSize);
+            const uint64_t slotCount = (static_cast<uint64_t>(st.st_size) - kHeaderSize) / kRecordSize;
+            for (uint64_t i = 0; i < slotCount; ++i) {
+                const TelemetryRecord& record = slots[i];
+                if (record.magic == 0 && isEmptySlot(record)) break;
+                if (!isValid(record)) {
+                    ++counts.torn;
+                    continue;
+                }
+                if (record.timeMs < fromMs || record.timeMs >= toMs) continue;
+                if (source != 0 && record.source != source) continue;
+                ++counts.records;
+                visit(record);
+            }
+        }
+        munmap(map, st.st_size);
+    }
+    return true;
+}
+
+// --- CSV BRIDGE ---
+
+bool parseCpuFields(const std::string& fields, TelemetryRecord& record) {
+    record = TelemetryRecord();
+    record.source = static_cast<uint16_t>(TelemetrySource::Cpu);
+    size_t comma = fields.find(',');
+    if (comma == std::string::npos) return false;
+    try {
+        record.values[0] = std::stod(fields.substr(0, comma));
+        record.aux[0] = static_cast<uint32_t>(std::stoul(fields.substr(comma + 1), nullptr, 16));
+    } catch (const std::exception&) {
+        return false;
+    }
+    // Older rows stop here, or have the extra columns empty
+    size_t extra = fields.find(',', comma + 1);
+    unsigned diskMb = 0;
+    if (extra != std::string::npos && std::sscanf(fields.c_str() + extra, ",%lf,%lf,%lf,%u", &record.values[1],
+                                                   &record.values[2], &record.values[3], &diskMb) == 4) {
+        record.aux[1] = diskMb;
+        record.flags |= kFlagCpuSystem;
+    }
+    return true;
+}
+
+bool parseGpsFix(const std::string& fix, TelemetryRecord& record) {
+    record = TelemetryRecord();
+    record.source = static_cast<uint16_t>(TelemetrySource::Gps);
+
+    // lat, N/S, lon, E/W, date, UTC time, altitude, speed, course
+    std::vector<std::string> fields;
+    std::stringstream ss(fix);
+    std::string field;
+    while (std::getline(ss, field, ',')) fields.push_back(field);
+    if (fields.size() < 9 || fields[0].empty() || fields[2].empty()) return true; // "No Fix": still a record
+
+    try {
+        record.values[0] = std::stod(fields[0]) * (fields[1] == "S" ? -1.0 : 1.0);
+        record.values[1] = std::stod(fields[2]) * (fields[3] == "W" ? -1.0 : 1.0);
+        record.values[2] = fields[6].empty() ? 0.0 : std::stod(fields[6]);
+        record.values[3] = fields[7].empty() ? 0.0 : std::stod(fields[7]);
+        record.aux[0] = static_cast<uint32_t>(std::stoul(fields[4]));
+        record.aux[1] = static_cast<uint32_t>(std::lround(std::stod(fields[5]) * 10.0));
+        record.aux[2] = fields[8].empty() ? 0 : static_cast<uint32_t>(std::lround(std::stod(fields[8]) * 10.0));
+    } catch (const std::exception&) {
+        return false;
+    }
+    record.flags |= kFlagGpsFix;
+    return true;
+}
+
+static std::string formatGpsFix(const TelemetryRecord& record) {
+    if (!(record.flags & kFlagGpsFix)) return "No Fix";
+    std::ostringstream out;
+    out << std::fixed << std::setfill('0') << std::setprecision(6)
+        << std::setw(11) << std::abs(record.values[0]) << (record.values[0] < 0 ? ",S," : ",N,")
+        << std::setw(12) << std::abs(record.values[1]) << (record.values[1] < 0 ? ",W," : ",E,")
+        << std::setw(6) << record.aux[0] << ","
+        << std::setw(6) << record.aux[1] / 10 << "." << record.aux[1] % 10 << ","
+        << std::setprecision(1) << record.values[2] << "," << record.values[3] << ","
+        << record.aux[2] / 10 << "." << record.aux[2] % 10;
+    return out.str();
+}
+
+bool exportCsv(const std::string& folder, const std::string& root, int days) {
+    auto start = std::chrono::steady_clock::now();
+
+    // 1. One pass over the log, rows grouped per output file
+    std::ostringstream cpu, gps;
+    std::map<std::string, std::ostringstream> env;
+    size_t cpuRows = 0, gpsRows = 0;
+    const std::string firstEnvDay = days > 0 ? localDay(nowMs() - (days - 1) * kDayMs) : "";
+
+    TelemetryScanStats stats;
+    bool ok = scanTelemetry(folder, LLONG_MIN, LLONG_MAX, 0, [&](const TelemetryRecord& record) {
+        switch (static_cast<TelemetrySource>(record.source)) {
+        case TelemetrySource::Env: {
+            const std::string day = localDay(record.timeMs);
+            if (day < firstEnvDay) break;
+            std::ostringstream& rows = env[day];
+            rows << formatLocal(record.timeMs, "%FT%H:%M:%S%Z") << ","
+                 << static_cast<float>(record.values[0]) << "," << static_cast<float>(record.values[1]) << ","
+                 << static_cast<float>(record.values[2]) << "\n";
+            break;
+        }
+        case TelemetrySource::Cpu:
+            cpu << formatLocal(record.timeMs, "%Y-%m-%dT%H:%M:%S%Z") << "," << record.values[0]
+                << ",0x" << std::hex << record.aux[0] << std::dec;
+            if (record.flags & kFlagCpuSystem) {
+                cpu << "," << record.values[1] << "," << record.values[2] << "," << record.values[3] << ","
+                    << record.aux[1] << "\n";
+            } else {
+                cpu << ",,,,\n"; // monitor_cpu.sh sample: temperature and throttling only
+            }
+            ++cpuRows;
+            break;
+        case TelemetrySource::Gps:
+            gps << formatLocal(record.timeMs, "%Y-%m-%d %H:%M:%S") << "," << formatGpsFix(record) << "\n";
+            ++gpsRows;
+            break;
+        default:
+            break;
+        }
+    }, &stats);
+    if (!ok) return false;
+
+    // 2. Same files, same headers as the old per-sample appends
+    auto save = [&](const fs::path& path, const std::string& text) {
+        std::error_code ec;
+        fs::create_directories(path.parent_path(), ec);
+        ok = writeFileAtomic(path.string(), reinterpret_cast<const uint8_t*>(text.data()), text.size()) && ok;
+    };
+    for (auto& [day, rows] : env) {
+        save(fs::path(root) / day / "environmental_data.csv",
+             "Timestamp,External_Temperature_C,Humidity_Percent,Pressure_hPa\n" + rows.str());
+    }
+    if (cpuRows > 0) save(fs::path(root) / "cpu_info.csv", "Timestamp,CPU_Temp_C,Throttled_Hex,CPU_MHz,Load_1m,Mem_Avail_MB,Disk_Free_MB\n" + cpu.str());
+    if (gpsRows > 0) save(fs::path(root) / "gps_history.csv", gps.str());
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "[Telemetry] Exported " << stats.records << " record(s) from " << stats.files << " day file(s) ("
+              << env.size() << " env day(s), " << cpuRows << " cpu, " << gpsRows << " gps, "
+              << stats.torn << " torn) in " << ms << " ms" << std::endl;
+    return ok;
+}
+
+int importCsv(const std::string& folder, const std::string& root) {
+    // Importing twice would duplicate every row: only into an empty log
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(folder, ec)) {
+        if (entry.path().extension() == ".tlm") {
+            std::cerr << "[Telemetry] " << folder << " already has data, not importing." << std::endl;
+            return -1;
+        }
+    }
+
+    TelemetryLog log(folder, false);
+    int imported = 0;
+
+    // Calls 'row' with (timestamp, rest of the line) for every data line of 'path'
+    auto readRows = [](const fs::path& path, const std::function<void(const std::string&, const std::string&)>& row) {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t comma = line.find(',');
+            if (comma == std::string::npos || line.rfind("Timestamp", 0) == 0) continue;
+            row(line.substr(0, comma), line.substr(comma + 1));
+        }
+    };
+
+    // 1. Per-day environmental CSVs
+    for (const fs::directory_entry& entry : fs::directory_iterator(root, ec)) {
+        fs::path csv = entry.path() / "environmental_data.csv";
+        if (!entry.is_directory() || !fs::exists(csv)) continue;
+        readRows(csv, [&](const std::string& timestamp, const std::string& rest) {
+            TelemetryRecord record;
+            record.source = static_cast<uint16_t>(TelemetrySource::Env);
+            if (!parseLocal(timestamp, "%Y-%m-%dT%H:%M:%S", record.timeMs)) return;
+            if (std::sscanf(rest.c_str(), "%lf,%lf,%lf", &record.values[0], &record.values[1], &record.values[2]) != 3) return;
+            if (log.append(record)) ++imported;
+        });
+    }
+
+    // 2. Cumulative CPU and GPS logs
+    readRows(fs::path(root) / "cpu_info.csv", [&](const std::string& timestamp, const std::string& rest) {
+        TelemetryRecord record;
+        if (!parseCpuFields(rest, record) || !parseLocal(timestamp, "%Y-%m-%dT%H:%M:%S", record.timeMs)) return;
+        if (log.append(record)) ++imported;
+    });
+    readRows(fs::path(root) / "gps_history.csv", [&](const std::string& timestamp, const std::string& rest) {
+        TelemetryRecord record;
+        if (!parseGpsFix(rest, record) || !parseLocal(timestamp, "%Y-%m-%d %H:%M:%S", record.timeMs)) return;
+        if (log.append(record)) ++imported;
+    });
+
+    std::cout << "[Telemetry] Imported " << imported << " CSV row(s) into " << folder << std::endl;
+    return imported;
+}
+
+}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace horus {
+namespace utils {
+
+    // Who wrote a record. Values are stored on disk: never renumber, only append.
+    enum class TelemetrySource : uint16_t {
+        Env = 1, // BME280: values = temperature C, humidity %, pressure hPa, burst samples;
+                 // aux = variance of the three (float bits) when samples > 1
+        Cpu = 2, // SoC: values[0] = temperature C, aux[0] = throttled bits (vcgencmd get_throttled);
+                 // with kFlagCpuSystem (--task monitor_sys) also values = .., cpu0 MHz, load 1 min,
+                 // available memory MB; aux = .., free MB on the data filesystem
+        Gps = 3  // CGPSINFO fix: values = lat, lon (signed ddmm.mmmmmm), altitude m, speed;
+                 // aux = date ddmmyy, UTC time hhmmss.s x10, course x10. No fix = kFlagGpsFix unset
+    };
+
+    static const uint16_t kFlagGpsFix = 1;
+    static const uint16_t kFlagCpuSystem = 2;
+
+    // One fixed-size, self-checking sample. 64 bytes = one record per cache line,
+    // and a torn write (power cut mid-pwrite) can only damage the record being written.
+    struct TelemetryRecord {
+        uint32_t magic = 0;        // kRecordMagic once written; 0 = free slot (end of data)
+        uint16_t source = 0;       // TelemetrySource
+        uint16_t flags = 0;
+        int64_t timeMs = 0;        // Unix time, milliseconds (UTC)
+        double values[4] = {0, 0, 0, 0};
+        uint32_t aux[3] = {0, 0, 0};
+        uint32_t crc = 0;          // CRC-32 of the 60 bytes above
+    };
+    static_assert(sizeof(TelemetryRecord) == 64, "TelemetryRecord must stay 64 bytes");
+
+    // Where the log lives: "<data root>/telemetry/YYYY-MM-DD.tlm" (local date)
+    std::string getTelemetryFolder();
+
+    // Append-only writer. Day files are preallocated (zero-filled) in blocks, so an
+    // append is ONE 64-byte pwrite into space the filesystem already owns: no size or
+    // metadata change, nothing to re-parse. Appends take an flock, so the daemon and
+    // one-shot tasks can log to the same day.
+    class TelemetryLog {
+    public:
+        // durable = fdatasync after every append (off only for bulk imports / benchmarks)
+        explicit TelemetryLog(const std::string& folder = getTelemetryFolder(), bool durable = true);
+        ~TelemetryLog();
+
+        TelemetryLog(const TelemetryLog&) = delete;
+        TelemetryLog& operator=(const TelemetryLog&) = delete;
+
+        // Fills magic and CRC; 'record.timeMs' = 0 means now
+        bool append(TelemetryRecord record);
+
+    private:
+        bool openDay(const std::string& day);
+
+        std::string folder;
+        bool durable;
+        int fd = -1;
+        std::string currentDay;
+        uint64_t nextSlot = 0;  // First slot believed free
+        uint64_t capacity = 0;  // Slots preallocated in the current file
+    };
+
+    struct TelemetryScanStats {
+        size_t files = 0;
+        size_t records = 0;  // Valid records in range
+        size_t torn = 0;     // Slots with a bad CRC (skipped)
+    };
+
+    // Calls 'visit' for every valid record with fromMs <= timeMs < toMs, file by file
+    // in date order (records within a day are in append order). The day files are
+    // mmap'ed; only files whose date can overlap the range are opened.
+    // source = 0 -> every source.
+    bool scanTelemetry(const std::string& folder, int64_t fromMs, int64_t toMs, uint16_t source,
+                       const std::function<void(const TelemetryRecord&)>& visit,
+                       TelemetryScanStats* stats = nullptr);
+
+    // --- CSV bridge (the layouts we have always uploaded) ---
+
+    // Rebuilds "<root>/cpu_info.csv" and "<root>/gps_history.csv" (whole history) and
+    // "<root>/<day>/environmental_data.csv" for the last 'days' days (0 = all).
+    // Files are written atomically; a source with no record leaves its CSV alone.
+    bool exportCsv(const std::string& folder, const std::string& root, int days);
+
+    // One-off migration: appends the rows of existing CSVs in those layouts to the log.
+    // Returns the number of records imported, -1 on error.
+    int importCsv(const std::string& folder, const std::string& root);
+
+    // "52.1,0x50000" (monitor_cpu.sh fields) -> Cpu record; cpu_info.csv rows with the
+    // monitor_sys columns ("52.1,0x50000,1500,0.12,3120,20480") keep them
+    bool parseCpuFields(const std::string& fields, TelemetryRecord& record);
+
+    // "4503.123456,N,00740.123456,E,160126,101500.0,245.3,0.0,0.0" or "No Fix" -> Gps record
+    bool parseGpsFix(const std::string& fix, TelemetryRecord& record);
+
+}
+}
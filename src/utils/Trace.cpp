@@ -0,0 +1,213 @@
+#include "Trace.hpp"
+#include "FileSystem.hpp"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <filesystem>
+#include <ctime>
+#include <unistd.h>
+#include <sys/utsname.h>
+#include <nlohmann/json.hpp>
+
+namespace fs = std::filesystem;
+namespace horus {
+namespace utils {
+
+std::atomic<bool> gTracingEnabled{false};
+
+namespace {
+
+// One per thread that ever recorded. Only its thread writes; readers take a snapshot
+// of 'written' and read behind it. Held by the registry so the events of pool workers
+// outlive their threads.
+struct TraceRing {
+    uint32_t tid = 0;
+    std::string threadName;               // Guarded by registryMutex()
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<uint64_t> written{0};     // Events ever recorded (ring index = written % size)
+};
+
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::vector<std::shared_ptr<TraceRing>>& registry() {
+    static std::vector<std::shared_ptr<TraceRing>> rings;
+    return rings;
+}
+
+std::atomic<int64_t> originNs{0}; // First setTracing(true): time 0 of the trace
+thread_local std::shared_ptr<TraceRing> localRing;
+thread_local std::string pendingName; // setTraceThreadName() before the first event
+
+TraceRing& threadRing() {
+    if (!localRing) {
+        auto ring = std::make_shared<TraceRing>();
+        ring->events.reset(new TraceEvent[kTraceRingEvents]);
+        std::lock_guard<std::mutex> lock(registryMutex());
+        ring->tid = static_cast<uint32_t>(registry().size() + 1);
+        ring->threadName = !pendingName.empty() ? pendingName : "thread " + std::to_string(ring->tid);
+        registry().push_back(ring);
+        localRing = ring;
+    }
+    return *localRing;
+}
+
+struct ThreadEvents {
+    uint32_t tid;
+    std::string name;
+    std::vector<TraceEvent> events; // Oldest first
+};
+
+// Copies every ring, oldest event first; 'dropped' = events lost to wrap-around
+std::vector<ThreadEvents> snapshot(uint64_t& dropped) {
+    std::vector<ThreadEvents> threads;
+    dropped = 0;
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const std::shared_ptr<TraceRing>& ring : registry()) {
+        const uint64_t written = ring->written.load(std::memory_order_acquire);
+        const uint64_t kept = std::min<uint64_t>(written, kTraceRingEvents);
+        dropped += written - kept;
+        ThreadEvents thread{ ring->tid, ring->threadName, {} };
+        thread.events.reserve(kept);
+        for (uint64_t i = written - kept; i < written; ++i) thread.events.push_back(ring->events[i % kTraceRingEvents]);
+        threads.push_back(std::move(thread));
+    }
+    return threads;
+}
+
+} // namespace
+
+void setTracing(bool enabled) {
+    int64_t unset = 0;
+    if (enabled) originNs.compare_exchange_strong(unset, traceNowNs());
+    gTracingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+void traceRecord(const char* name, int64_t startNs, int64_t value, TraceEventType type) {
+    TraceRing& ring = threadRing();
+    const uint64_t n = ring.written.load(std::memory_order_relaxed);
+    ring.events[n % kTraceRingEvents] = { name, startNs, value, type };
+    ring.written.store(n + 1, std::memory_order_release);
+}
+
+void setTraceThreadName(const std::string& name) {
+    if (!localRing) {
+        pendingName = name;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex());
+    localRing->threadName = name;
+}
+
+std::string traceFilePath(const std::string& target, const std::string& task) {
+    std::error_code ec;
+    const bool folder = fs::is_directory(target, ec) || (!target.empty() && target.back() == '/');
+    if (!folder) return target;
+
+    // One file per run: the stages of --task daily all get the same folder
+    fs::create_directories(target, ec);
+    std::time_t t = std::time(nullptr);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H%M%S", std::localtime(&t));
+    return (fs::path(target) / (task + "-" + stamp + "-" + std::to_string(getpid()) + ".json")).string();
+}
+
+bool writeChromeTrace(const std::string& path, const std::string& task) {
+    uint64_t dropped = 0;
+    const std::vector<ThreadEvents> threads = snapshot(dropped);
+    const int64_t origin = originNs.load();
+    const int pid = static_cast<int>(getpid());
+
+    // 1. Metadata: names in the timeline's left column
+    nlohmann::json events = nlohmann::json::array();
+    events.push_back({ {"name", "process_name"}, {"ph", "M"}, {"pid", pid}, {"tid", 0},
+                       {"args", { {"name", "horus_app " + task} }} });
+    size_t count = 0;
+    for (const ThreadEvents& thread : threads) {
+        events.push_back({ {"name", "thread_name"}, {"ph", "M"}, {"pid", pid}, {"tid", thread.tid},
+                           {"args", { {"name", thread.name} }} });
+
+        // 2. Spans as complete events, counters as counter tracks (times in us)
+        for (const TraceEvent& event : thread.events) {
+            const std::string name = event.name;
+            const std::string category = name.substr(0, name.find('.'));
+            const double ts = (event.startNs - origin) / 1000.0;
+            if (event.type == TraceEventType::Span) {
+                events.push_back({ {"name", name}, {"cat", category}, {"ph", "X"}, {"ts", ts},
+                                   {"dur", event.value / 1000.0}, {"pid", pid}, {"tid", thread.tid} });
+            } else {
+                events.push_back({ {"name", name}, {"cat", category}, {"ph", "C"}, {"ts", ts},
+                                   {"pid", pid}, {"tid", thread.tid}, {"args", { {"value", event.value} }} });
+            }
+            ++count;
+        }
+    }
+
+    // 3. What the run is comparable with
+    struct utsname host;
+    const bool named = uname(&host) == 0;
+    nlohmann::json trace = {
+        {"traceEvents", std::move(events)},
+        {"displayTimeUnit", "ms"},
+        {"otherData", { {"task", task}, {"kernel", named ? host.release : ""},
+                        {"machine", named ? host.machine : ""}, {"dropped", dropped} }}
+    };
+
+    const std::string text = trace.dump();
+    if (!writeFileAtomic(path, reinterpret_cast<const uint8_t*>(text.data()), text.size())) return false;
+    std::cout << "[Trace] " << count << " events from " << threads.size() << " thread(s) -> " << path;
+    if (dropped > 0) std::cout << " (" << dropped << " oldest dropped)";
+    std::cout << std::endl;
+    return true;
+}
+
+void printTraceSummary(int maxNames) {
+    struct Totals {
+        std::string name;
+        int64_t totalNs = 0;
+        int64_t maxNs = 0;
+        int count = 0;
+    };
+    uint64_t dropped = 0;
+    std::map<std::string, Totals> byName;
+    for (const ThreadEvents& thread : snapshot(dropped)) {
+        for (const TraceEvent& event : thread.events) {
+            if (event.type != TraceEventType::Span) continue;
+            Totals& totals = byName[event.name];
+            totals.name = event.name;
+            totals.totalNs += event.value;
+            totals.maxNs = std::max(totals.maxNs, event.value);
+            ++totals.count;
+        }
+    }
+
+    std::vector<Totals> sorted;
+    for (const auto& entry : byName) sorted.push_back(entry.second);
+    std::sort(sorted.begin(), sorted.end(), [](const Totals& a, const Totals& b) { return a.totalNs > b.totalNs; });
+    if (sorted.size() > static_cast<size_t>(maxNames)) sorted.resize(maxNames);
+
+    // Nested spans each count in full: "jpeg.encode" includes its "jpeg.write_scanlines".
+    // Each line is formatted apart, so std::cout keeps its own flags and precision.
+    for (const Totals& totals : sorted) {
+        std::ostringstream line;
+        line << "[Trace] " << std::left << std::setw(24) << totals.name << std::right << std::fixed
+             << std::setprecision(1) << std::setw(9) << totals.totalNs / 1e6 << " ms" << std::setw(6)
+             << totals.count << "x  max " << totals.maxNs / 1e6 << " ms";
+        std::cout << line.str() << std::endl;
+    }
+}
+
+void resetTrace() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    for (const std::shared_ptr<TraceRing>& ring : registry()) ring->written.store(0, std::memory_order_release);
+}
+
+}
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+
+namespace horus {
+namespace utils {
+
+// --- HOT-PATH TRACING ---
+// Scoped spans and counters, recorded into a ring per thread (no lock, no allocation
+// once the thread's ring exists) and exported as Chrome trace JSON, which
+// chrome://tracing and ui.perfetto.dev open as a timeline.
+// Compiled in unless HORUS_TRACING is undefined (CMake option of the same name),
+// off at runtime until setTracing(true): a disabled span costs one relaxed load.
+
+enum class TraceEventType : uint8_t { Span, Counter };
+
+struct TraceEvent {
+    const char* name;    // String literal ("camera.warmup"): only the pointer is kept
+    int64_t startNs;     // Steady clock
+    int64_t value;       // Span: duration in ns, counter: the value
+    TraceEventType type;
+};
+
+// Events per thread ring; once full the oldest are overwritten (and counted as dropped)
+const size_t kTraceRingEvents = 16384;
+
+extern std::atomic<bool> gTracingEnabled;
+
+inline bool tracingEnabled() { return gTracingEnabled.load(std::memory_order_relaxed); }
+void setTracing(bool enabled);
+
+inline int64_t traceNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Appends to the calling thread's ring (created on its first event)
+void traceRecord(const char* name, int64_t startNs, int64_t value, TraceEventType type);
+
+// Label of the calling thread in the trace ("main", "encoder"); default "thread <n>"
+void setTraceThreadName(const std::string& name);
+
+inline void traceCounter(const char* name, int64_t value) {
+    if (tracingEnabled()) traceRecord(name, traceNowNs(), value, TraceEventType::Counter);
+}
+
+// Times its own lifetime. The state is sampled at construction: a span that starts
+// disabled stays silent even if tracing is switched on before it ends.
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name) : name(name), startNs(tracingEnabled() ? traceNowNs() : 0) {}
+    ~TraceSpan() {
+        if (startNs != 0) traceRecord(name, startNs, traceNowNs() - startNs, TraceEventType::Span);
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    int64_t startNs;
+};
+
+// 'target' as given, or a new "<task>-<time>-<pid>.json" in it if it is a folder
+// (an existing one, or any path ending in '/')
+std::string traceFilePath(const std::string& target, const std::string& task);
+
+// Writes every ring as {"traceEvents": [...]} ("X" spans, "C" counters, thread names),
+// with the task and kernel release in "otherData" to compare runs across OS updates.
+// Call once the traced work is done: threads still recording may tear their last event.
+bool writeChromeTrace(const std::string& path, const std::string& task);
+
+// "[Trace] ..." lines: total, count and longest of each span name, busiest first
+void printTraceSummary(int maxNames = 12);
+
+// Clears every ring (threads keep their rings)
+void resetTrace();
+
+}
+}
+
+// One span named 'name' until the end of the enclosing scope
+#ifdef HORUS_TRACING
+#define HORUS_TRACE_CONCAT_(a, b) a##b
+#define HORUS_TRACE_CONCAT(a, b) HORUS_TRACE_CONCAT_(a, b)
+#define HORUS_TRACE_SCOPE(name) ::horus::utils::TraceSpan HORUS_TRACE_CONCAT(horusTraceSpan_, __LINE__)(name)
+#define HORUS_TRACE_COUNTER(name, value) ::horus::utils::traceCounter(name, static_cast<int64_t>(value))
+#else
+#define HORUS_TRACE_SCOPE(name) ((void)0)
+#define HORUS_TRACE_COUNTER(name, value) ((void)0)
+#endif